@@ -31,7 +31,10 @@ SEXP attribute_hidden new_captured_literal(SEXP x) {
     return new_captured_arg(x, R_EmptyEnv);
 }
 
-SEXP attribute_hidden new_captured_promise(SEXP x, SEXP env) {
+// Returns the expression of the promise `x` and stores its
+// environment in `*p_env`. Evaluated arguments are returned as
+// literals with the empty environment.
+static SEXP captured_promise(SEXP x, SEXP env, SEXP* p_env) {
     SEXP expr_env = R_NilValue;
 
     SEXP expr = x;
@@ -46,76 +49,91 @@ SEXP attribute_hidden new_captured_promise(SEXP x, SEXP env) {
 	}
     }
 
-    // Evaluated arguments are returned as literals
     if (expr_env == R_NilValue) {
-        SEXP value = PROTECT(eval(x, env));
-        expr = new_captured_literal(value);
-        UNPROTECT(1);
+        *p_env = R_EmptyEnv;
+        return eval(x, env);
     } else {
         MARK_NOT_MUTABLE(expr);
-        expr = new_captured_arg(expr, expr_env);
+        *p_env = expr_env;
+        return expr;
     }
+}
 
-    return expr;
+SEXP attribute_hidden new_captured_promise(SEXP x, SEXP env) {
+    SEXP expr_env;
+    SEXP expr = PROTECT(captured_promise(x, env, &expr_env));
+    SEXP out = new_captured_arg(expr, expr_env);
+    UNPROTECT(1);
+    return out;
+}
+
+// Compact variant of `captureArgInfo()` for internal callers. Returns
+// the expression of the argument `sym` of `frame` and stores its
+// environment in `*p_env`, without allocating an info list.
+SEXP capturearg_compact(SEXP sym, SEXP frame, SEXP* p_env) {
+    SEXP arg;
+
+    int dd = dotDotVal(sym);
+    if (dd) {
+	arg = capturedot(frame, dd);
+    } else {
+	arg = findVar(sym, frame);
+	if (arg == R_UnboundValue)
+	    error(_("object '%s' not found"), CHAR(PRINTNAME(sym)));
+    }
+
+    if (arg != R_MissingArg && TYPEOF(arg) == PROMSXP) {
+	PROTECT(arg);
+	SEXP expr = captured_promise(arg, frame, p_env);
+	UNPROTECT(1);
+	return expr;
+    }
+
+    *p_env = R_EmptyEnv;
+    return arg;
 }
 
 SEXP attribute_hidden rlang_capturearginfo(SEXP call, SEXP op, SEXP args, SEXP rho)
 {
-    int nProt = 0;
-
     // Unwrap first layer of promise
     SEXP sym = findVarInFrame3(rho, install("arg"), TRUE);
-    PROTECT(sym); ++nProt;
 
     // May be a literal if compiler did not wrap in a promise
     if (TYPEOF(sym) != PROMSXP) {
+	PROTECT(sym);
 	SEXP value = new_captured_literal(sym);
-	UNPROTECT(nProt);
+	UNPROTECT(1);
 	return value;
     }
 
     sym = PREXPR(sym);
 
     if (TYPEOF(sym) != SYMSXP) {
-        UNPROTECT(nProt);
         error(_("\"x\" must be an argument name"));
     }
 
-    SEXP frame = CAR(args);
-    SEXP arg;
+    SEXP env;
+    SEXP expr = PROTECT(capturearg_compact(sym, CAR(args), &env));
+    SEXP value = new_captured_arg(expr, env);
 
-    int dd = dotDotVal(sym);
-    if (dd) {
-	arg = capturedot(frame, dd);
-    } else {
-	arg = findVar(sym, frame);
-	if (arg == R_UnboundValue)
-	    error(_("object '%s' not found"), CHAR(PRINTNAME(sym)));
-    }
-    PROTECT(arg); ++nProt;
-
-    SEXP value;
-    if (arg == R_MissingArg)
-        value = new_captured_literal(arg);
-    else if (TYPEOF(arg) == PROMSXP)
-        value = new_captured_promise(arg, frame);
-    else
-        value = new_captured_literal(arg);
-
-    UNPROTECT(nProt);
+    UNPROTECT(1);
     return value;
 }
 
-SEXP capturedots(SEXP frame) {
-    SEXP dots = PROTECT(findVar(R_DotsSymbol, frame));
+static SEXP frame_dots(SEXP frame) {
+    SEXP dots = findVar(R_DotsSymbol, frame);
 
     if (dots == R_UnboundValue)
 	error(_("'...' used in an incorrect context"));
 
-    if (dots == R_MissingArg) {
-        UNPROTECT(1);
-        return R_NilValue;
-    }
+    if (dots == R_MissingArg)
+	return R_NilValue;
+
+    return dots;
+}
+
+SEXP capturedots(SEXP frame) {
+    SEXP dots = PROTECT(frame_dots(frame));
 
     SEXP out = PROTECT(cons(R_NilValue, R_NilValue));
     SEXP node = out;
@@ -140,6 +158,37 @@ SEXP capturedots(SEXP frame) {
     return CDR(out);
 }
 
+// Compact variant of `capturedots()` for internal callers. The
+// expressions are stored in the CAR of the returned pairlist, tagged
+// with the argument names, and their environments are stored at the
+// same positions in the list `*p_envs`. The caller must protect both.
+SEXP capturedots_compact(SEXP frame, SEXP* p_envs) {
+    SEXP dots = PROTECT(frame_dots(frame));
+    R_xlen_t n = xlength(dots);
+
+    SEXP envs = PROTECT(allocVector(VECSXP, n));
+    SEXP out = PROTECT(allocList((int) n));
+
+    SEXP node = out;
+    for (R_xlen_t i = 0; i < n; ++i, node = CDR(node), dots = CDR(dots)) {
+        SEXP head = CAR(dots);
+        SET_TAG(node, TAG(dots));
+
+        if (TYPEOF(head) == PROMSXP) {
+	    SEXP env;
+	    SETCAR(node, captured_promise(head, frame, &env));
+	    SET_VECTOR_ELT(envs, i, env);
+        } else {
+	    SETCAR(node, head);
+	    SET_VECTOR_ELT(envs, i, R_EmptyEnv);
+        }
+    }
+
+    *p_envs = envs;
+    UNPROTECT(3);
+    return out;
+}
+
 SEXP attribute_hidden rlang_capturedots(SEXP call, SEXP op, SEXP args, SEXP rho)
 {
     SEXP caller_env = CAR(args);
@@ -1,3 +1,4 @@
 #include "export/exported.c"
 #include "export/exported-tests.c"
+#include "export/instrument.c"
 #include "export/init.c"
@@ -20,6 +20,23 @@ r_obj* rlang_test_node_list_clone_until(r_obj* node, r_obj* sentinel) {
   return out;
 }
 
+// `tags` is a list of symbols. With `fresh`, the attributes are set on
+// an unreferenced duplicate of `x` so they are updated in place.
+r_obj* rlang_test_attrib_set_n(r_obj* x, r_obj* tags, r_obj* values, r_obj* fresh) {
+  if (r_lgl_get(fresh, 0)) {
+    x = r_clone(x);
+  }
+  KEEP(x);
+
+  r_obj* out = r_attrib_set_n(x,
+                              r_list_cbegin(tags),
+                              r_list_cbegin(values),
+                              r_length(tags));
+
+  FREE(1);
+  return out;
+}
+
 
 // cnd.c
 
@@ -37,6 +54,27 @@ r_obj* rlang_test_Rf_errorcall(r_obj* call, r_obj* msg) {
   return r_null;
 }
 
+r_obj* rlang_test_cnd_template(r_obj* class,
+                               r_obj* msg,
+                               r_obj* data,
+                               r_obj* control_flow,
+                               r_obj* signal) {
+  struct r_cnd_template* p_tmpl = r_new_cnd_template(class, r_names(data), r_lgl_get(control_flow, 0));
+  KEEP(p_tmpl->shelter);
+
+  r_obj* const * v_data = r_list_cbegin(data);
+
+  if (r_lgl_get(signal, 0)) {
+    r_cnd_template_signal(p_tmpl, msg, v_data);
+    FREE(1);
+    return r_null;
+  }
+
+  r_obj* out = r_cnd_template_new(p_tmpl, msg, v_data);
+  FREE(1);
+  return out;
+}
+
 
 // env.c
 
@@ -89,3 +127,51 @@ r_obj* nms_are_duplicated(r_obj* nms, bool from_last);
 r_obj* rlang_test_nms_are_duplicated(r_obj* nms, r_obj* from_last) {
   return nms_are_duplicated(nms, r_lgl_get(from_last, 0));
 }
+
+void warn_deprecated(const char* id, const char* fmt, ...);
+void signal_soft_deprecated(const char* msg, const char* id, r_obj* env);
+
+r_obj* rlang_test_warn_deprecated(r_obj* id) {
+  warn_deprecated(r_chr_get_c_string(id, 0), "%s", r_chr_get_c_string(id, 0));
+  return r_null;
+}
+r_obj* rlang_test_signal_soft_deprecated(r_obj* id) {
+  signal_soft_deprecated(r_chr_get_c_string(id, 0), NULL, r_empty_env);
+  return r_null;
+}
+
+// internals/quo.c
+
+bool rlang_quosures_is_compact(r_obj* x);
+
+r_obj* rlang_test_quosures_is_compact(r_obj* x) {
+  return r_lgl(rlang_quosures_is_compact(x));
+}
+
+// rlang/session.c
+
+r_obj* rlang_test_is_installed(r_obj* pkg) {
+  return r_lgl(r_is_installed(r_chr_get_c_string(pkg, 0)));
+}
+
+// rlang/api.h
+
+// Round-trips `values` through a dictionary created via the API table
+r_obj* rlang_test_api_dict(r_obj* keys, r_obj* values) {
+  const struct r_api* p_api = r_peek_api();
+  if (!p_api) {
+    r_stop_internal("rlang_test_api_dict", "Incompatible API table.");
+  }
+  if (!r_api_has(p_api, R_API_FEATURE_dict_bulk)) {
+    r_stop_internal("rlang_test_api_dict", "Bulk dictionary operations are not available.");
+  }
+
+  struct r_dict* p_dict = p_api->new_dict(r_length(keys));
+  KEEP(p_dict->shelter);
+
+  p_api->dict_put_n(p_dict, keys, values);
+  r_obj* out = p_api->dict_get_n(p_dict, keys);
+
+  FREE(1);
+  return out;
+}
@@ -24,6 +24,13 @@ r_obj* rlang_cnd_signal(r_obj* cnd) {
   return r_null;
 }
 
+r_obj* ffi_cnd_has_handler(r_obj* classes) {
+  if (r_typeof(classes) != R_TYPE_character) {
+    r_abort("`class` must be a character vector.");
+  }
+  return r_lgl(r_cnd_has_handler(classes));
+}
+
 r_obj* rlang_cnd_type(r_obj* cnd) {
   enum r_condition_type type = r_cnd_type(cnd);
   switch (type) {
@@ -66,6 +73,84 @@ r_obj* rlang_alloc_data_frame(r_obj* n_rows, r_obj* names, r_obj* types) {
   return df;
 }
 
+static
+const void* dyn_df_elts(struct r_dyn_df* p_df, r_ssize i, r_obj* x) {
+  enum r_type type = p_df->v_types[i];
+  if (type == R_TYPE_null) {
+    return NULL;
+  }
+  if (r_typeof(x) != type) {
+    r_abort("Column %d must be of type `%s`.", (int) i + 1, r_type_as_c_string(type));
+  }
+  return r_vec_cbegin0(type, x);
+}
+
+r_obj* rlang_new_dyn_df(r_obj* names, r_obj* types, r_obj* capacity) {
+  if (r_typeof(types) != R_TYPE_integer) {
+    r_abort("`types` must be an integer vector.");
+  }
+  if (!r_is_int(capacity)) {
+    r_abort("`capacity` must be an integer value.");
+  }
+
+  struct r_dyn_df* p_df = r_new_dyn_df(names,
+                                       (enum r_type*) r_int_begin(types),
+                                       r_length(types),
+                                       r_int_get(capacity, 0));
+  return p_df->shelter;
+}
+
+// `row` is a list of one vector per column. Only the first element of
+// each vector is pushed.
+r_obj* rlang_dyn_df_push_row(r_obj* df, r_obj* row) {
+  struct r_dyn_df* p_df = r_shelter_deref(df);
+  if (r_typeof(row) != R_TYPE_list || r_length(row) != p_df->n_cols) {
+    r_abort("`row` must be a list of one vector per column.");
+  }
+
+  r_obj* elts = KEEP(r_alloc_raw(r_ssize_mult(p_df->n_cols, sizeof(void*))));
+  const void** v_elts = (const void**) r_raw_begin(elts);
+
+  for (r_ssize i = 0; i < p_df->n_cols; ++i) {
+    v_elts[i] = dyn_df_elts(p_df, i, r_list_get(row, i));
+  }
+
+  r_dyn_df_push_row(p_df, v_elts);
+
+  FREE(1);
+  return r_null;
+}
+
+// `rows` is a list of one vector per column, of size `n`
+r_obj* rlang_dyn_df_push_rows(r_obj* df, r_obj* rows, r_obj* n) {
+  struct r_dyn_df* p_df = r_shelter_deref(df);
+  if (r_typeof(rows) != R_TYPE_list || r_length(rows) != p_df->n_cols) {
+    r_abort("`rows` must be a list of one vector per column.");
+  }
+  r_ssize c_n = r_int_get(n, 0);
+
+  r_obj* elts = KEEP(r_alloc_raw(r_ssize_mult(p_df->n_cols, sizeof(void*))));
+  const void** v_elts = (const void**) r_raw_begin(elts);
+
+  for (r_ssize i = 0; i < p_df->n_cols; ++i) {
+    r_obj* col = r_list_get(rows, i);
+    v_elts[i] = dyn_df_elts(p_df, i, col);
+    if (v_elts[i] && r_length(col) != c_n) {
+      r_abort("Column %d must be of size %d.", (int) i + 1, (int) c_n);
+    }
+  }
+
+  r_dyn_df_push_rows(p_df, v_elts, c_n);
+
+  FREE(1);
+  return r_null;
+}
+
+r_obj* rlang_dyn_df_unwrap(r_obj* df) {
+  return r_dyn_df_unwrap(r_shelter_deref(df));
+}
+
+
 
 // dict.c
 
@@ -74,17 +159,24 @@ r_obj* wrap_dict(struct r_dict* p_dict) {
   return p_dict->shelter;
 }
 
-r_obj* rlang_new_dict(r_obj* size, r_obj* prevent_resize) {
+r_obj* rlang_new_dict(r_obj* size, r_obj* prevent_resize, r_obj* keep_order) {
   if (!r_is_int(size)) {
     r_abort("`size` must be an integer.");
   }
   if (!r_is_bool(prevent_resize)) {
     r_abort("`prevent_resize` must be a logical value.");
   }
+  if (!r_is_bool(keep_order)) {
+    r_abort("`keep_order` must be a logical value.");
+  }
 
   struct r_dict* dict = r_new_dict(r_int_get(size, 0));
   dict->prevent_resize = r_lgl_get(prevent_resize, 0);
 
+  if (r_lgl_get(keep_order, 0)) {
+    r_dict_keep_order(dict);
+  }
+
   return dict->shelter;
 }
 
@@ -108,6 +200,16 @@ r_obj* rlang_dict_get(r_obj* dict, r_obj* key) {
   return r_dict_get(p_dict, key);
 }
 
+r_obj* rlang_dict_put_n(r_obj* dict, r_obj* keys, r_obj* values) {
+  struct r_dict* p_dict = r_shelter_deref(dict);
+  return r_dict_put_n(p_dict, keys, values);
+}
+
+r_obj* rlang_dict_get_n(r_obj* dict, r_obj* keys) {
+  struct r_dict* p_dict = r_shelter_deref(dict);
+  return r_dict_get_n(p_dict, keys);
+}
+
 r_obj* rlang_dict_resize(r_obj* dict, r_obj* size) {
   if (!r_is_int(size)) {
     r_abort("`size` must be an integer.");
@@ -124,6 +226,16 @@ r_obj* rlang_dict_as_df_list(r_obj* dict) {
 r_obj* rlang_dict_as_list(r_obj* dict) {
   return r_dict_as_list(r_shelter_deref(dict));
 }
+r_obj* rlang_dict_fill(r_obj* dict, r_obj* keys, r_obj* values) {
+  return r_len(r_dict_fill(r_shelter_deref(dict), keys, values));
+}
+r_obj* rlang_dict_keep_order(r_obj* dict) {
+  r_dict_keep_order(r_shelter_deref(dict));
+  return r_null;
+}
+r_obj* rlang_dict_stats(r_obj* dict) {
+  return r_dict_stats(r_shelter_deref(dict));
+}
 
 r_obj* rlang_new_dict_iterator(r_obj* dict) {
   struct r_dict* p_dict = r_shelter_deref(dict);
@@ -155,9 +267,247 @@ r_obj* rlang_dict_it_next(r_obj* dict_it) {
   return r_lgl(r_dict_next(p_dict_it));
 }
 
+r_obj* rlang_new_pdict() {
+  return r_new_pdict();
+}
+r_obj* rlang_pdict_put(r_obj* dict, r_obj* key, r_obj* value) {
+  return r_pdict_put(dict, key, value);
+}
+r_obj* rlang_pdict_del(r_obj* dict, r_obj* key) {
+  return r_pdict_del(dict, key);
+}
+r_obj* rlang_pdict_has(r_obj* dict, r_obj* key) {
+  return r_lgl(r_pdict_has(dict, key));
+}
+r_obj* rlang_pdict_get(r_obj* dict, r_obj* key) {
+  return r_pdict_get(dict, key);
+}
+r_obj* rlang_pdict_size(r_obj* dict) {
+  return r_len(r_pdict_size(dict));
+}
+r_obj* rlang_pdict_as_df_list(r_obj* dict) {
+  return r_pdict_as_df_list(dict);
+}
+
+r_obj* rlang_new_flat_dict(r_obj* size) {
+  if (!r_is_int(size)) {
+    r_abort("`size` must be an integer.");
+  }
+  return r_new_flat_dict(r_int_get(size, 0))->shelter;
+}
+r_obj* rlang_flat_dict_put(r_obj* dict, r_obj* key, r_obj* value) {
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_flat_dict_put(p_dict, key, value));
+}
+r_obj* rlang_flat_dict_del(r_obj* dict, r_obj* key) {
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_flat_dict_del(p_dict, key));
+}
+r_obj* rlang_flat_dict_has(r_obj* dict, r_obj* key) {
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_flat_dict_has(p_dict, key));
+}
+r_obj* rlang_flat_dict_get(r_obj* dict, r_obj* key) {
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+  return r_flat_dict_get(p_dict, key);
+}
+r_obj* rlang_flat_dict_resize(r_obj* dict, r_obj* size) {
+  if (!r_is_int(size)) {
+    r_abort("`size` must be an integer.");
+  }
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+
+  r_flat_dict_resize(p_dict, r_int_get(size, 0));
+  return r_null;
+}
+r_obj* rlang_flat_dict_as_list(r_obj* dict) {
+  struct r_flat_dict* p_dict = r_shelter_deref(dict);
+
+  r_obj* out = KEEP(r_alloc_list(p_dict->n_entries));
+  r_obj* nms = r_alloc_character(p_dict->n_entries);
+  r_attrib_poke_names(out, nms);
+
+  struct r_flat_dict_iterator* p_it = r_new_flat_dict_iterator(p_dict);
+  KEEP(p_it->shelter);
+
+  for (r_ssize i = 0; r_flat_dict_next(p_it); ++i) {
+    r_list_poke(out, i, p_it->value);
+    r_chr_poke(nms, i, r_sym_string(p_it->key));
+  }
+
+  FREE(2);
+  return out;
+}
+
+r_obj* rlang_new_int_dict(r_obj* size) {
+  if (!r_is_int(size)) {
+    r_abort("`size` must be an integer.");
+  }
+  return r_new_int_dict(r_int_get(size, 0))->shelter;
+}
+r_obj* rlang_int_dict_put(r_obj* dict, r_obj* key, r_obj* value) {
+  struct r_int_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_int_dict_put(p_dict, r_as_ssize(key), value));
+}
+r_obj* rlang_int_dict_del(r_obj* dict, r_obj* key) {
+  struct r_int_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_int_dict_del(p_dict, r_as_ssize(key)));
+}
+r_obj* rlang_int_dict_has(r_obj* dict, r_obj* key) {
+  struct r_int_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_int_dict_has(p_dict, r_as_ssize(key)));
+}
+r_obj* rlang_int_dict_get(r_obj* dict, r_obj* key) {
+  struct r_int_dict* p_dict = r_shelter_deref(dict);
+  return r_int_dict_get(p_dict, r_as_ssize(key));
+}
+r_obj* rlang_int_dict_as_list(r_obj* dict) {
+  struct r_int_dict* p_dict = r_shelter_deref(dict);
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_obj* keys = r_alloc_double(p_dict->n_entries);
+  r_list_poke(out, 0, keys);
+  r_obj* values = r_alloc_list(p_dict->n_entries);
+  r_list_poke(out, 1, values);
+
+  double* v_keys = r_dbl_begin(keys);
+
+  struct r_int_dict_iterator* p_it = r_new_int_dict_iterator(p_dict);
+  KEEP(p_it->shelter);
+
+  for (r_ssize i = 0; r_int_dict_next(p_it); ++i) {
+    v_keys[i] = p_it->key;
+    r_list_poke(values, i, p_it->value);
+  }
+
+  FREE(2);
+  return out;
+}
+
+r_obj* rlang_new_str_dict(r_obj* size) {
+  if (!r_is_int(size)) {
+    r_abort("`size` must be an integer.");
+  }
+  return r_new_str_dict(r_int_get(size, 0))->shelter;
+}
+r_obj* rlang_str_dict_put(r_obj* dict, r_obj* key, r_obj* value) {
+  if (!r_is_string(key)) {
+    r_abort("`key` must be a string.");
+  }
+  struct r_str_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_str_dict_put(p_dict, r_chr_get(key, 0), value));
+}
+r_obj* rlang_str_dict_del(r_obj* dict, r_obj* key) {
+  if (!r_is_string(key)) {
+    r_abort("`key` must be a string.");
+  }
+  struct r_str_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_str_dict_del(p_dict, r_chr_get(key, 0)));
+}
+// Looks up from a C string to exercise the non-allocating path
+r_obj* rlang_str_dict_get(r_obj* dict, r_obj* key) {
+  if (!r_is_string(key)) {
+    r_abort("`key` must be a string.");
+  }
+  struct r_str_dict* p_dict = r_shelter_deref(dict);
+
+  r_obj* str = r_chr_get(key, 0);
+  r_obj* out = r_str_dict_get0_c(p_dict, r_str_c_string(str), r_length(str));
+
+  if (!out) {
+    r_abort("Can't find key in dictionary.");
+  }
+  return out;
+}
+r_obj* rlang_str_dict_has(r_obj* dict, r_obj* key) {
+  if (!r_is_string(key)) {
+    r_abort("`key` must be a string.");
+  }
+  struct r_str_dict* p_dict = r_shelter_deref(dict);
+  return r_lgl(r_str_dict_has(p_dict, r_chr_get(key, 0)));
+}
+r_obj* rlang_str_dict_as_list(r_obj* dict) {
+  struct r_str_dict* p_dict = r_shelter_deref(dict);
+
+  r_obj* out = KEEP(r_alloc_list(p_dict->n_entries));
+  r_obj* nms = r_alloc_character(p_dict->n_entries);
+  r_attrib_poke_names(out, nms);
+
+  struct r_str_dict_iterator* p_it = r_new_str_dict_iterator(p_dict);
+  KEEP(p_it->shelter);
+
+  for (r_ssize i = 0; r_str_dict_next(p_it); ++i) {
+    r_list_poke(out, i, p_it->value);
+    r_chr_poke(nms, i, p_it->key);
+  }
+
+  FREE(2);
+  return out;
+}
+
+
+// arena.c
+
+// Collects `x` in an integer dyn array backed by an arena of
+// `arena_size` bytes. With `interleave`, a byte is allocated between
+// each push so the array can't grow in place.
+r_obj* rlang_arena_collect_int(r_obj* x, r_obj* arena_size, r_obj* interleave) {
+  struct r_arena* p_arena = r_new_arena(r_as_ssize(arena_size));
+  KEEP(p_arena->shelter);
+
+  bool c_interleave = r_as_bool(interleave);
+  r_ssize n = r_length(x);
+  const int* v_x = r_int_cbegin(x);
+
+  struct r_dyn_array* p_arr = r_new_dyn_vector_in(p_arena, R_TYPE_integer, 1);
+  for (r_ssize i = 0; i < n; ++i) {
+    r_int_push_back(p_arr, v_x[i]);
+    if (c_interleave) {
+      r_arena_alloc(p_arena, 1);
+    }
+  }
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_list_poke(out, 0, r_arr_unwrap(p_arr));
+  r_list_poke(out, 1, r_len(r_length(r_list_get(p_arena->shelter, 2))));
+
+  r_arena_release(p_arena);
+  if (r_arena_alloc(p_arena, 1) != p_arena->v_first_block) {
+    r_stop_internal("rlang_arena_collect_int", "Arena was not released.");
+  }
+
+  FREE(2);
+  return out;
+}
+
 
 // dyn-array.c
 
+// Collects `x` in an integer dyn array whose first 8 elements live on
+// the stack. Also returns whether the array spilled to the heap.
+r_obj* rlang_sbo_collect_int(r_obj* x) {
+  int storage[8];
+  struct r_dyn_array arr;
+
+  r_keep_t loc;
+  KEEP_HERE(r_null, &loc);
+  r_init_dyn_vector_sbo(&arr, R_TYPE_integer, storage, 8, loc);
+
+  r_ssize n = r_length(x);
+  const int* v_x = r_int_cbegin(x);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_int_push_back(&arr, v_x[i]);
+  }
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_list_poke(out, 0, r_arr_unwrap(&arr));
+  r_list_poke(out, 1, r_lgl(arr.data != r_null));
+
+  FREE(2);
+  return out;
+}
+
 // [[ register() ]]
 r_obj* rlang_new_dyn_vector(r_obj* type,
                             r_obj* capacity) {
@@ -174,6 +524,14 @@ r_obj* rlang_new_dyn_array(r_obj* elt_byte_size,
   return arr->shelter;
 }
 
+// [[ register() ]]
+r_obj* rlang_new_dyn_vector_off_heap(r_obj* type,
+                                     r_obj* capacity) {
+  struct r_dyn_array* arr = r_new_dyn_vector_off_heap(r_chr_as_r_type(type),
+                                                      r_as_ssize(capacity));
+  return arr->shelter;
+}
+
 // [[ register() ]]
 r_obj* rlang_arr_unwrap(r_obj* arr) {
   return r_arr_unwrap(r_shelter_deref(arr));
@@ -229,6 +587,22 @@ r_obj* rlang_arr_push_back(r_obj* arr_sexp, r_obj* x) {
   }
 }
 // [[ register() ]]
+r_obj* rlang_arr_push_back_n(r_obj* arr_sexp, r_obj* x) {
+  struct r_dyn_array* p_arr = r_shelter_deref(arr_sexp);
+
+  if (r_typeof(x) != p_arr->type) {
+    r_stop_internal("rlang_arr_push_back_n", "Incompatible types.");
+  }
+
+  r_ssize n = r_length(x);
+  if (p_arr->type == R_TYPE_raw) {
+    n /= p_arr->elt_byte_size;
+  }
+
+  r_arr_push_back_n(p_arr, r_vec_cbegin(x), n);
+  return r_null;
+}
+// [[ register() ]]
 r_obj* rlang_arr_push_back_bool(r_obj* arr_sexp, r_obj* x_sexp) {
   struct r_dyn_array* arr = r_shelter_deref(arr_sexp);
   bool x = r_as_bool(x_sexp);
@@ -247,6 +621,18 @@ r_obj* rlang_arr_resize(r_obj* arr_sexp, r_obj* capacity_sexp) {
   r_arr_resize(arr, r_as_ssize(capacity_sexp));
   return r_null;
 }
+// [[ register() ]]
+r_obj* rlang_arr_reserve(r_obj* arr_sexp, r_obj* capacity_sexp) {
+  struct r_dyn_array* arr = r_shelter_deref(arr_sexp);
+  r_arr_reserve(arr, r_as_ssize(capacity_sexp));
+  return r_null;
+}
+// [[ register() ]]
+r_obj* rlang_arr_shrink_to_fit(r_obj* arr_sexp) {
+  struct r_dyn_array* arr = r_shelter_deref(arr_sexp);
+  r_arr_shrink_to_fit(arr);
+  return r_null;
+}
 
 
 // dyn-list-of.c
@@ -312,6 +698,16 @@ r_obj* ffi_lof_unwrap(r_obj* lof) {
   return r_lof_unwrap(r_shelter_deref(lof));
 }
 
+// [[ register() ]]
+r_obj* ffi_lof_unwrap_csr(r_obj* lof) {
+  return r_lof_unwrap_csr(r_shelter_deref(lof));
+}
+
+// [[ register() ]]
+r_obj* ffi_csr_as_list(r_obj* csr) {
+  return r_csr_as_list(csr);
+}
+
 // [[ register() ]]
 r_obj* ffi_lof_push_back(r_obj* lof) {
   r_lof_push_back(r_shelter_deref(lof));
@@ -633,6 +1029,72 @@ r_obj* rlang_sexp_address(r_obj* x) {
   return r_str_as_character(r_obj_address(x));
 }
 
+static
+r_obj* sexp_addresses_collect(r_obj* x) {
+  struct r_dyn_array* p_arr = r_new_dyn_array(sizeof(r_obj*), 64);
+  KEEP(p_arr->shelter);
+
+  int flags = R_SEXP_IT_FLAGS_preorder | R_SEXP_IT_FLAGS_skip_env;
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator_opts(x, flags, -1);
+  KEEP(p_it->shelter);
+
+  while (r_sexp_next(p_it)) {
+    r_arr_push_back(p_arr, &p_it->x);
+  }
+
+  r_obj* out = r_arr_unwrap(p_arr);
+  FREE(2);
+  return out;
+}
+
+r_obj* ffi_sexp_addresses(r_obj* x, r_obj* format, r_obj* recursive) {
+  bool c_recursive = r_as_bool(recursive);
+  bool c_string = strcmp(r_chr_get_c_string(format, 0), "string") == 0;
+
+  r_obj* const * v_x;
+  r_ssize n;
+  r_obj* nodes = r_null;
+
+  if (c_recursive) {
+    nodes = sexp_addresses_collect(x);
+    v_x = (r_obj* const *) r_raw_cbegin(nodes);
+    n = r_length(nodes) / sizeof(r_obj*);
+  } else {
+    if (r_typeof(x) != R_TYPE_list && r_typeof(x) != R_TYPE_expression) {
+      r_abort("`x` must be a list.");
+    }
+    v_x = r_list_cbegin(x);
+    n = r_length(x);
+  }
+  KEEP(nodes);
+
+  r_obj* out;
+
+  if (c_string) {
+    out = KEEP(r_alloc_character(n));
+    char buf[R_OBJ_ADDRESS_MAX_SIZE];
+
+    for (r_ssize i = 0; i < n; ++i) {
+      int len = r_obj_address_c(buf, v_x[i]);
+      r_chr_poke(out, i, Rf_mkCharLenCE(buf, len, CE_NATIVE));
+    }
+  } else {
+    out = KEEP(r_alloc_double(n));
+    double* v_out = r_dbl_begin(out);
+
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = (double) (uintptr_t) v_x[i];
+    }
+  }
+
+  if (!c_recursive) {
+    r_attrib_poke_names(out, r_names(x));
+  }
+
+  FREE(2);
+  return out;
+}
+
 r_obj* rlang_poke_type(r_obj* x, r_obj* type) {
   SET_TYPEOF(x, Rf_str2type(r_chr_get_c_string(type, 0)));
   return x;
@@ -743,6 +1205,213 @@ r_obj* rlang_unpreserve(r_obj* x) {
   r_unpreserve(x);
   return r_null;
 }
+r_obj* rlang_preserve_handle(r_obj* x) {
+  return r_len(r_preserve_handle(x));
+}
+r_obj* rlang_release_handle(r_obj* handle) {
+  r_release_handle(r_as_ssize(handle));
+  return r_null;
+}
+r_obj* rlang_mark_shared(r_obj* x) {
+  r_mark_shared(x);
+  return r_null;
+}
+
+
+// vec-chr.c
+
+// Accumulates strings and character vectors from a list
+r_obj* rlang_chr_build(r_obj* x) {
+  struct r_dyn_array* p_arr = r_new_dyn_vector(R_TYPE_character, 1);
+  KEEP(p_arr->shelter);
+
+  r_ssize n = r_length(x);
+  for (r_ssize i = 0; i < n; ++i) {
+    r_chr_push_back_chr(p_arr, r_list_get(x, i));
+  }
+
+  FREE(1);
+  return r_arr_unwrap(p_arr);
+}
+
+// Looks up the elements of `x` in an index of `chr`
+r_obj* rlang_chr_index_find(r_obj* chr, r_obj* x) {
+  struct r_chr_index* p_index = r_new_chr_index(chr);
+  KEEP(p_index->shelter);
+
+  r_ssize n = r_length(x);
+  r_obj* out = KEEP(r_alloc_integer(n));
+  int* v_out = r_int_begin(out);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    v_out[i] = r_chr_index_find(p_index, r_chr_get(x, i));
+  }
+
+  FREE(2);
+  return out;
+}
+r_obj* rlang_chr_detect_str(r_obj* chr, r_obj* x) {
+  return r_int(r_chr_detect_str(chr, r_chr_get(x, 0)));
+}
+r_obj* rlang_chr_has_any(r_obj* chr, r_obj* x) {
+  r_ssize n = r_length(x);
+  const char** v_x = (const char**) R_alloc(n + 1, sizeof(const char*));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    v_x[i] = r_chr_get_c_string(x, i);
+  }
+  v_x[n] = NULL;
+
+  return r_lgl(r_chr_has_any(chr, v_x));
+}
+
+
+// c-core.c
+
+// Copies an integer vector element by element through an R-free array
+r_obj* rlang_c_array_copy(r_obj* x) {
+  r_ssize n = r_length(x);
+  const int* v_x = r_int_cbegin(x);
+
+  struct r_c_array arr;
+  bool ok = r_c_array_init(&arr, sizeof(int), 0);
+
+  for (r_ssize i = 0; ok && i < n; ++i) {
+    ok = r_c_array_push_back(&arr, v_x + i);
+  }
+  if (!ok) {
+    r_c_array_free(&arr);
+    r_abort("Can't grow array.");
+  }
+
+  r_obj* out = r_c_array_as_vector(&arr, R_TYPE_integer);
+  r_c_array_free(&arr);
+  return out;
+}
+
+// Counts the strings of `x` with an R-free map, then removes the
+// strings of `del`. Returns a list of keys and counts.
+r_obj* rlang_c_dict_count(r_obj* x, r_obj* del) {
+  struct r_c_dict dict;
+  bool ok = r_c_dict_init(&dict, R_C_DICT_KEY_str, 0);
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_chr_cbegin(x);
+
+  for (r_ssize i = 0; ok && i < n; ++i) {
+    const char* str = r_str_c_string(v_x[i]);
+    r_ssize* p_count = r_c_dict_emplace_str(&dict, str, strlen(str), NULL);
+
+    ok = p_count != NULL;
+    if (ok) {
+      ++(*p_count);
+    }
+  }
+  if (!ok) {
+    r_c_dict_free(&dict);
+    r_abort("Can't grow dictionary.");
+  }
+
+  r_ssize n_del = r_length(del);
+  r_obj* const * v_del = r_chr_cbegin(del);
+
+  for (r_ssize i = 0; i < n_del; ++i) {
+    const char* str = r_str_c_string(v_del[i]);
+    r_c_dict_del_str(&dict, str, strlen(str));
+  }
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_list_poke(out, 0, r_c_dict_keys(&dict));
+  r_list_poke(out, 1, r_c_dict_values(&dict));
+  r_c_dict_free(&dict);
+
+  FREE(1);
+  return out;
+}
+
+
+// cpp/vec.cpp
+
+r_obj* rlang_vec_sort(r_obj* x, r_obj* stable) {
+  bool c_stable = r_lgl_get(stable, 0);
+  r_obj* out = KEEP(r_clone(x));
+  r_ssize n = r_length(out);
+
+  switch (r_typeof(out)) {
+  case R_TYPE_integer: r_int_sort0(r_int_begin(out), n, c_stable); break;
+  case R_TYPE_double: r_dbl_sort0(r_dbl_begin(out), n, c_stable); break;
+  default: r_stop_unimplemented_type("rlang_vec_sort", r_typeof(out));
+  }
+
+  FREE(1);
+  return out;
+}
+r_obj* rlang_vec_unique(r_obj* x) {
+  r_obj* out = KEEP(r_clone(x));
+  r_ssize n = r_length(out);
+
+  switch (r_typeof(out)) {
+  case R_TYPE_integer: {
+    int* v_out = r_int_begin(out);
+    r_int_sort0(v_out, n, false);
+    n = r_int_unique0(v_out, n) - v_out;
+    break;
+  }
+  case R_TYPE_double: {
+    double* v_out = r_dbl_begin(out);
+    r_dbl_sort0(v_out, n, false);
+    n = r_dbl_unique0(v_out, n) - v_out;
+    break;
+  }
+  case R_TYPE_character: {
+    // Sort a copy of the pointers, the order is by address
+    r_obj** v_ptrs = (r_obj**) R_alloc(n, sizeof(r_obj*));
+    memcpy(v_ptrs, r_chr_cbegin(out), n * sizeof(r_obj*));
+    r_ptr_sort0(v_ptrs, n, false);
+    n = r_ptr_unique0(v_ptrs, n) - v_ptrs;
+    for (r_ssize i = 0; i < n; ++i) {
+      r_chr_poke(out, i, v_ptrs[i]);
+    }
+    break;
+  }
+  default:
+    r_stop_unimplemented_type("rlang_vec_unique", r_typeof(out));
+  }
+
+  FREE(1);
+  return r_vec_resize(out, n);
+}
+r_obj* rlang_vec_order(r_obj* x, r_obj* rank) {
+  r_ssize n = r_length(x);
+  r_obj* out = KEEP(r_alloc_integer(n));
+  int* v_out = r_int_begin(out);
+  bool c_rank = r_lgl_get(rank, 0);
+
+  switch (r_typeof(x)) {
+  case R_TYPE_integer:
+    if (c_rank) r_int_rank0(r_int_cbegin(x), n, v_out);
+    else r_int_order0(r_int_cbegin(x), n, v_out);
+    break;
+  case R_TYPE_double:
+    if (c_rank) r_dbl_rank0(r_dbl_cbegin(x), n, v_out);
+    else r_dbl_order0(r_dbl_cbegin(x), n, v_out);
+    break;
+  default:
+    r_stop_unimplemented_type("rlang_vec_order", r_typeof(x));
+  }
+
+  FREE(1);
+  return out;
+}
+r_obj* rlang_vec_lower_bound(r_obj* x, r_obj* value) {
+  r_ssize n = r_length(x);
+
+  switch (r_typeof(x)) {
+  case R_TYPE_integer: return r_len(r_int_lower_bound0(r_int_cbegin(x), n, r_int_get(value, 0)));
+  case R_TYPE_double: return r_len(r_dbl_lower_bound0(r_dbl_cbegin(x), n, r_dbl_get(value, 0)));
+  default: r_stop_unimplemented_type("rlang_vec_lower_bound", r_typeof(x));
+  }
+}
 
 
 // vec.h
@@ -916,6 +1585,14 @@ r_obj* rlang_vec_resize(r_obj* x, r_obj* n) {
   }
 }
 
+// Compacts a fresh copy so the in-place path is taken
+r_obj* ffi_list_compact_in_place(r_obj* x) {
+  x = KEEP(r_clone(x));
+  r_obj* out = r_list_compact_in_place(x);
+  FREE(1);
+  return out;
+}
+
 r_obj* rlang_list_poke(r_obj* x, r_obj* i, r_obj* value) {
   r_list_poke(x, r_as_ssize(i), value);
   return r_null;
@@ -937,14 +1614,23 @@ r_obj* protect_missing(r_obj* x) {
 }
 
 // [[ register() ]]
-r_obj* ffi_sexp_iterate(r_obj* x, r_obj* fn) {
+r_obj* ffi_sexp_iterate(r_obj* x, r_obj* fn, r_obj* flags, r_obj* max_depth) {
+  if (!r_is_int(flags)) {
+    r_abort("`flags` must be an integer.");
+  }
+  if (!r_is_int(max_depth)) {
+    r_abort("`max_depth` must be an integer.");
+  }
+
   struct r_dyn_array* p_out = r_new_dyn_vector(R_TYPE_list, 256);
   KEEP(p_out->shelter);
 
   struct r_dict* p_dict = r_new_dict(1024);
   KEEP(p_dict->shelter);
 
-  struct r_sexp_iterator* p_it = r_new_sexp_iterator(x);
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator_opts(x,
+                                                          r_int_get(flags, 0),
+                                                          r_int_get(max_depth, 0));
   KEEP(p_it->shelter);
 
   for (int i = 0; r_sexp_next(p_it); ++i) {
@@ -975,9 +1661,9 @@ r_obj* ffi_sexp_iterate(r_obj* x, r_obj* fn) {
     struct r_pair args[] = {
       { r_sym("x"), KEEP(protect_missing(x)) },
       { r_sym("addr"), KEEP(r_str_as_character(r_obj_address(x))) },
-      { r_sym("type"), KEEP(protect_missing(parent)) },
-      { r_sym("depth"), KEEP(r_type_as_character(type)) },
-      { r_sym("parent"), KEEP(r_int(depth)) },
+      { r_sym("type"), KEEP(r_type_as_character(type)) },
+      { r_sym("depth"), KEEP(r_int(depth)) },
+      { r_sym("parent"), KEEP(protect_missing(parent)) },
       { r_sym("rel"), KEEP(r_chr(r_sexp_it_relation_as_c_string(rel))) },
       { r_sym("i"), KEEP(r_int(i + 1)) },
       { r_sym("dir"), KEEP(r_chr(r_sexp_it_direction_as_c_string(dir))) }
@@ -994,3 +1680,92 @@ r_obj* ffi_sexp_iterate(r_obj* x, r_obj* fn) {
   FREE(3);
   return r_arr_unwrap(p_out);
 }
+
+struct sexp_find_info {
+  r_obj* sym;
+  enum r_type type;
+  bool match_type;
+  bool first;
+  struct r_dict* p_envs;
+  struct r_dyn_array* p_out;
+};
+
+static
+enum r_sexp_visit sexp_find_visitor(struct r_sexp_iterator* p_it, void* data) {
+  struct sexp_find_info* p_info = (struct sexp_find_info*) data;
+  r_obj* x = p_it->x;
+
+  if (p_it->dir == R_SEXP_IT_DIRECTION_outgoing) {
+    return R_SEXP_VISIT_continue;
+  }
+
+  if (x == r_global_env) {
+    return R_SEXP_VISIT_skip;
+  }
+
+  // Environments may refer to themselves
+  if (p_it->dir == R_SEXP_IT_DIRECTION_incoming &&
+      p_it->type == R_TYPE_environment &&
+      !r_dict_put(p_info->p_envs, x, r_null)) {
+    return R_SEXP_VISIT_skip;
+  }
+
+  bool match =
+    (p_info->sym == r_null || x == p_info->sym) &&
+    (!p_info->match_type || p_it->type == p_info->type);
+
+  if (!match) {
+    return R_SEXP_VISIT_continue;
+  }
+
+  r_list_push_back(p_info->p_out, x);
+  return p_info->first ? R_SEXP_VISIT_stop : R_SEXP_VISIT_continue;
+}
+
+r_obj* ffi_sexp_find(r_obj* x,
+                     r_obj* sym,
+                     r_obj* type,
+                     r_obj* first,
+                     r_obj* flags,
+                     r_obj* max_depth) {
+  if (sym != r_null && r_typeof(sym) != R_TYPE_symbol) {
+    r_abort("`sym` must be a symbol or `NULL`.");
+  }
+  if (type != r_null && !r_is_string(type)) {
+    r_abort("`type` must be a string or `NULL`.");
+  }
+  if (sym == r_null && type == r_null) {
+    r_abort("Must supply `sym` or `type`.");
+  }
+  if (!r_is_bool(first)) {
+    r_abort("`first` must be `TRUE` or `FALSE`.");
+  }
+  if (!r_is_int(flags)) {
+    r_abort("`flags` must be an integer.");
+  }
+  if (!r_is_int(max_depth)) {
+    r_abort("`max_depth` must be an integer.");
+  }
+
+  struct sexp_find_info info = {
+    .sym = sym,
+    .type = type == r_null ? R_TYPE_null : r_chr_as_r_type(type),
+    .match_type = type != r_null,
+    .first = r_lgl_get(first, 0)
+  };
+
+  info.p_envs = r_new_dict(64);
+  KEEP(info.p_envs->shelter);
+
+  info.p_out = r_new_dyn_vector(R_TYPE_list, 16);
+  KEEP(info.p_out->shelter);
+
+  r_sexp_visit(x,
+               r_int_get(flags, 0),
+               r_int_get(max_depth, 0),
+               &sexp_find_visitor,
+               &info);
+
+  FREE(2);
+  return r_arr_unwrap(info.p_out);
+}
@@ -36,29 +36,57 @@ extern r_obj* r_node_tree_clone(r_obj*);
 extern r_obj* rlang_node_tag(r_obj*);
 extern r_obj* rlang_node_poke_tag(r_obj*, r_obj*);
 extern r_obj* rlang_interp(r_obj*, r_obj*);
+extern r_obj* ffi_exprs_interp(r_obj*, r_obj*);
+extern r_obj* ffi_deparse_is_multiline(r_obj*, r_obj*);
+extern r_obj* ffi_expr_deparse(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_is_function(r_obj*);
 extern r_obj* rlang_is_closure(r_obj*);
 extern r_obj* rlang_is_primitive(r_obj*);
 extern r_obj* rlang_is_primitive_eager(r_obj*);
 extern r_obj* rlang_is_primitive_lazy(r_obj*);
 extern r_obj* ffi_is_formula(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_has_colour();
+extern r_obj* ffi_events_drain(void);
+extern r_obj* ffi_events_enable(r_obj*, r_obj*);
+extern r_obj* ffi_events_push_abort(r_obj*);
+extern r_obj* ffi_mask_ctxt_pronoun(r_obj*);
+extern r_obj* ffi_format_bullets(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_init_timings();
+extern r_obj* ffi_intern_expr(r_obj*, r_obj*);
+extern r_obj* ffi_intern_exprs(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_intern_stats(r_obj*);
+extern r_obj* ffi_new_intern_table(void);
+extern r_obj* ffi_lambda_cache_get(r_obj*);
+extern r_obj* ffi_memo_del(r_obj*, r_obj*);
+extern r_obj* ffi_memo_get(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_memo_put(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_memo_stats(r_obj*);
+extern r_obj* ffi_new_memo(r_obj*, r_obj*);
+extern r_obj* ffi_lambda_cache_put(r_obj*, r_obj*);
 extern r_obj* rlang_is_reference(r_obj*, r_obj*);
 extern r_obj* rlang_sexp_address(r_obj*);
+extern r_obj* ffi_sexp_addresses(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_length(r_obj*);
 extern r_obj* rlang_true_length(r_obj* x);
-extern r_obj* rlang_squash(r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_squash(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_symbol(r_obj*);
 extern r_obj* rlang_sym_as_character(r_obj*);
+extern r_obj* ffi_syms(r_obj*);
+extern r_obj* ffi_syms_as_strings(r_obj*);
 extern r_obj* rlang_tilde_eval(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_unescape_character(r_obj*);
 extern r_obj* rlang_capturearginfo(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_capturedots(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_new_call_node(r_obj*, r_obj*);
 extern r_obj* rlang_cnd_signal(r_obj*);
+extern r_obj* ffi_cnd_has_handler(r_obj*);
 extern r_obj* rlang_r_string(r_obj*);
 extern r_obj* rlang_exprs_interp(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_quos_interp(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_dots_list(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_dots_list_lazy(r_obj*);
+extern r_obj* ffi_dots_frame_missing(r_obj*);
+extern r_obj* ffi_dots_frame_names(r_obj*);
 extern r_obj* rlang_dots_flat_list(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_dots_pairlist(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* r_new_formula(r_obj*, r_obj*, r_obj*);
@@ -66,6 +94,10 @@ extern r_obj* rlang_new_quosure(r_obj*, r_obj*);
 extern r_obj* rlang_enexpr(r_obj*, r_obj*);
 extern r_obj* rlang_ensym(r_obj*, r_obj*);
 extern r_obj* rlang_enquo(r_obj*, r_obj*);
+extern r_obj* ffi_enquos_args(r_obj*, r_obj*);
+extern r_obj* ffi_defer(r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_defer_run(r_obj*);
+extern r_obj* rlang_enquos_args(r_obj*, r_obj*);
 extern r_obj* rlang_get_expression(r_obj*, r_obj*);
 extern r_obj* rlang_vec_alloc(r_obj*, r_obj*);
 extern r_obj* rlang_vec_coerce(r_obj*, r_obj*);
@@ -83,6 +115,7 @@ extern r_obj* rlang_vec_poke_n(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_vec_poke_range(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_quo_get_expr(r_obj*);
 extern r_obj* rlang_quo_set_expr(r_obj*, r_obj*);
+extern r_obj* ffi_quo_squash(r_obj*);
 extern r_obj* rlang_quo_get_env(r_obj*);
 extern r_obj* rlang_quo_set_env(r_obj*, r_obj*);
 extern r_obj* rlang_which_operator(r_obj*);
@@ -91,10 +124,16 @@ extern r_obj* rlang_new_data_mask_compat(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_as_data_mask(r_obj*);
 extern r_obj* rlang_as_data_mask_compat(r_obj*, r_obj*);
 extern r_obj* rlang_data_mask_clean(r_obj*);
+extern r_obj* rlang_data_mask_poke_data(r_obj*, r_obj*);
+extern r_obj* rlang_data_mask_poke_slice(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_as_data_pronoun(r_obj*);
 extern r_obj* rlang_env_get(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_env_get_list(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_env_unlock(r_obj*);
+extern r_obj* ffi_env_depth(r_obj*);
+extern r_obj* ffi_env_parents(r_obj*, r_obj*);
+extern r_obj* ffi_env_tail(r_obj*, r_obj*);
+extern r_obj* ffi_env_as_list(r_obj*, r_obj*);
 extern r_obj* rlang_interrupt();
 extern r_obj* rlang_is_list(r_obj*, r_obj*);
 extern r_obj* rlang_is_atomic(r_obj*, r_obj*);
@@ -109,6 +148,8 @@ extern r_obj* rlang_is_character(r_obj*, r_obj*);
 extern r_obj* rlang_is_raw(r_obj*, r_obj*);
 extern r_obj* rlang_is_data_mask(r_obj*);
 extern r_obj* rlang_data_pronoun_get(r_obj*, r_obj*);
+extern r_obj* ffi_data_pronoun_get(r_obj*, r_obj*);
+extern r_obj* ffi_eval_tidy_list(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_cnd_type(r_obj*);
 extern r_obj* rlang_env_inherits(r_obj*, r_obj*);
 extern r_obj* rlang_eval_top(r_obj*, r_obj*);
@@ -120,6 +161,9 @@ extern r_obj* rlang_is_splice_box(r_obj*);
 extern r_obj* rlang_unbox(r_obj*);
 extern r_obj* rlang_new_function(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_is_string(r_obj*, r_obj*);
+extern r_obj* ffi_call_match(r_obj*, r_obj*);
+extern r_obj* ffi_check_args(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_new_arg_matcher(r_obj*);
 extern r_obj* rlang_new_weakref(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_wref_key(r_obj*);
 extern r_obj* rlang_wref_value(r_obj*);
@@ -135,10 +179,18 @@ extern r_obj* rlang_env_has(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_env_poke(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_env_bind(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_raw_deparse_str(r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_raw_parse_str(r_obj*);
+extern r_obj* ffi_parse_exprs_chr(r_obj*);
 extern r_obj* rlang_env_browse(r_obj*, r_obj*);
 extern r_obj* rlang_env_is_browsed(r_obj*);
 extern r_obj* rlang_ns_registry_env();
-extern r_obj* rlang_hash(r_obj*);
+extern r_obj* rlang_hash(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_hash_list(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_hash_file(r_obj*);
+extern r_obj* ffi_hash_kernel();
+extern r_obj* rlang_hasher_new(r_obj*);
+extern r_obj* rlang_hasher_update(r_obj*, r_obj*);
+extern r_obj* rlang_hasher_digest(r_obj*, r_obj*);
 extern r_obj* rlang_list_poke(r_obj*, r_obj*, r_obj*);
 
 // Library initialisation defined below
@@ -148,6 +200,16 @@ r_obj* rlang_library_unload();
 // For unit tests
 extern r_obj* chr_prepend(r_obj*, r_obj*);
 extern r_obj* chr_append(r_obj*, r_obj*);
+extern r_obj* rlang_chr_build(r_obj*);
+extern r_obj* rlang_vec_sort(r_obj*, r_obj*);
+extern r_obj* rlang_vec_unique(r_obj*);
+extern r_obj* rlang_vec_order(r_obj*, r_obj*);
+extern r_obj* rlang_vec_lower_bound(r_obj*, r_obj*);
+extern r_obj* rlang_chr_index_find(r_obj*, r_obj*);
+extern r_obj* rlang_chr_detect_str(r_obj*, r_obj*);
+extern r_obj* rlang_chr_has_any(r_obj*, r_obj*);
+extern r_obj* rlang_c_array_copy(r_obj*);
+extern r_obj* rlang_c_dict_count(r_obj*, r_obj*);
 extern r_obj* rlang_test_r_warn(r_obj*);
 extern r_obj* rlang_on_exit(r_obj*, r_obj*);
 extern r_obj* rlang_test_base_ns_get(r_obj*);
@@ -155,44 +217,108 @@ extern r_obj* rlang_test_parse(r_obj*);
 extern r_obj* rlang_test_parse_eval(r_obj*, r_obj*);
 extern r_obj* r_peek_frame();
 extern r_obj* rlang_test_node_list_clone_until(r_obj*, r_obj*);
+extern r_obj* rlang_test_attrib_set_n(r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_test_sys_frame(r_obj*);
 extern r_obj* rlang_test_sys_call(r_obj*);
+extern r_obj* rlang_test_warn_deprecated(r_obj*);
+extern r_obj* rlang_test_quosures_is_compact(r_obj*);
+extern r_obj* rlang_test_is_installed(r_obj*);
+extern r_obj* rlang_test_api_dict(r_obj*, r_obj*);
+extern r_obj* rlang_test_signal_soft_deprecated(r_obj*);
 extern r_obj* rlang_test_nms_are_duplicated(r_obj*, r_obj*);
 extern r_obj* rlang_test_Rf_warningcall(r_obj*, r_obj*);
 extern r_obj* rlang_test_Rf_errorcall(r_obj*, r_obj*);
+extern r_obj* rlang_test_cnd_template(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_test_lgl_sum(r_obj*, r_obj*);
 extern r_obj* rlang_test_lgl_which(r_obj*, r_obj*);
-extern r_obj* rlang_new_dict(r_obj*, r_obj*);
+extern r_obj* rlang_new_dict(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_dict_put(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_dict_del(r_obj*, r_obj*);
 extern r_obj* rlang_dict_has(r_obj*, r_obj*);
 extern r_obj* rlang_dict_get(r_obj*, r_obj*);
 extern r_obj* rlang_dict_resize(r_obj*, r_obj*);
+extern r_obj* rlang_dict_put_n(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_dict_get_n(r_obj*, r_obj*);
 extern r_obj* rlang_precious_dict();
 extern r_obj* rlang_preserve(r_obj*);
 extern r_obj* rlang_unpreserve(r_obj*);
+extern r_obj* rlang_preserve_handle(r_obj*);
+extern r_obj* rlang_release_handle(r_obj*);
+extern r_obj* rlang_mark_shared(r_obj*);
 extern r_obj* rlang_alloc_data_frame(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_new_dyn_df(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_dyn_df_push_row(r_obj*, r_obj*);
+extern r_obj* rlang_dyn_df_push_rows(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_dyn_df_unwrap(r_obj*);
 extern r_obj* rlang_vec_resize(r_obj*, r_obj*);
+extern r_obj* ffi_list_compact_in_place(r_obj*);
+extern r_obj* rlang_arena_collect_int(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_sbo_collect_int(r_obj*);
 extern r_obj* rlang_new_dyn_vector(r_obj*, r_obj*);
 extern r_obj* rlang_new_dyn_array(r_obj*, r_obj*);
+extern r_obj* rlang_new_dyn_vector_off_heap(r_obj*, r_obj*);
 extern r_obj* rlang_arr_info(r_obj*);
 extern r_obj* rlang_arr_push_back(r_obj*, r_obj*);
+extern r_obj* rlang_arr_push_back_n(r_obj*, r_obj*);
 extern r_obj* rlang_arr_push_back_bool(r_obj*, r_obj*);
 extern r_obj* rlang_arr_pop_back(r_obj*);
 extern r_obj* rlang_arr_resize(r_obj*, r_obj*);
+extern r_obj* rlang_arr_reserve(r_obj*, r_obj*);
+extern r_obj* rlang_arr_shrink_to_fit(r_obj*);
 extern r_obj* rlang_new_dict_iterator(r_obj*);
 extern r_obj* rlang_dict_it_info(r_obj*);
+extern r_obj* rlang_new_pdict();
+extern r_obj* rlang_pdict_put(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_pdict_del(r_obj*, r_obj*);
+extern r_obj* rlang_pdict_has(r_obj*, r_obj*);
+extern r_obj* rlang_pdict_get(r_obj*, r_obj*);
+extern r_obj* rlang_pdict_size(r_obj*);
+extern r_obj* rlang_pdict_as_df_list(r_obj*);
+extern r_obj* rlang_new_flat_dict(r_obj*);
+extern r_obj* rlang_flat_dict_put(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_flat_dict_del(r_obj*, r_obj*);
+extern r_obj* rlang_flat_dict_has(r_obj*, r_obj*);
+extern r_obj* rlang_flat_dict_get(r_obj*, r_obj*);
+extern r_obj* rlang_flat_dict_resize(r_obj*, r_obj*);
+extern r_obj* rlang_flat_dict_as_list(r_obj*);
+extern r_obj* rlang_new_int_dict(r_obj*);
+extern r_obj* rlang_int_dict_put(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_int_dict_del(r_obj*, r_obj*);
+extern r_obj* rlang_int_dict_has(r_obj*, r_obj*);
+extern r_obj* rlang_int_dict_get(r_obj*, r_obj*);
+extern r_obj* rlang_int_dict_as_list(r_obj*);
+extern r_obj* rlang_new_str_dict(r_obj*);
+extern r_obj* rlang_str_dict_put(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_str_dict_del(r_obj*, r_obj*);
+extern r_obj* rlang_str_dict_has(r_obj*, r_obj*);
+extern r_obj* rlang_str_dict_get(r_obj*, r_obj*);
+extern r_obj* rlang_str_dict_as_list(r_obj*);
 extern r_obj* rlang_dict_it_next(r_obj*);
 extern r_obj* rlang_dict_as_df_list(r_obj*);
 extern r_obj* rlang_dict_as_list(r_obj*);
+extern r_obj* rlang_dict_fill(r_obj*, r_obj*, r_obj*);
+extern r_obj* rlang_dict_keep_order(r_obj*);
+extern r_obj* rlang_dict_stats(r_obj*);
 extern r_obj* rlang_ptr_new_dyn_list_of(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_ptr_lof_info(r_obj*);
 extern r_obj* rlang_ptr_lof_push_back(r_obj*);
 extern r_obj* rlang_ptr_lof_arr_push_back(r_obj*, r_obj*, r_obj*);
 extern r_obj* rlang_ptr_lof_unwrap(r_obj*);
-extern r_obj* ffi_sexp_iterate(r_obj*, r_obj*);
+extern r_obj* ffi_trace_add_namespaces(r_obj*, r_obj*);
+extern r_obj* ffi_trace_back(r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_trace_prof_start(r_obj*);
+extern r_obj* ffi_trace_prof_stop();
+extern r_obj* ffi_trace_prof_tick();
+extern r_obj* ffi_sexp_find(r_obj*, r_obj*, r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_sexp_iterate(r_obj*, r_obj*, r_obj*, r_obj*);
+extern r_obj* ffi_obj_size(r_obj*, r_obj*);
+extern r_obj* ffi_obj_strip(r_obj*, r_obj*);
+extern r_obj* ffi_instrument_counts();
+extern r_obj* ffi_instrument_enable(r_obj*);
+extern r_obj* ffi_instrument_reset();
+extern r_obj* ffi_instrument_stats();
 
-static const R_CallMethodDef r_callables[] = {
+static R_CallMethodDef r_callables[] = {
   {"r_init_library",                    (DL_FUNC) &r_init_library, 1},
   {"rlang_library_load",                (DL_FUNC) &rlang_library_load, 1},
   {"rlang_library_unload",              (DL_FUNC) &rlang_library_unload, 0},
@@ -205,12 +331,33 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_duplicate",                   (DL_FUNC) &rlang_duplicate, 2},
   {"rlang_node_tree_clone",             (DL_FUNC) &r_node_tree_clone, 1},
   {"rlang_interp",                      (DL_FUNC) &rlang_interp, 2},
+  {"ffi_exprs_interp",                  (DL_FUNC) &ffi_exprs_interp, 2},
+  {"ffi_deparse_is_multiline",          (DL_FUNC) &ffi_deparse_is_multiline, 2},
+  {"ffi_expr_deparse",                  (DL_FUNC) &ffi_expr_deparse, 5},
   {"rlang_is_function",                 (DL_FUNC) &rlang_is_function, 1},
   {"rlang_is_closure",                  (DL_FUNC) &rlang_is_closure, 1},
   {"rlang_is_primitive",                (DL_FUNC) &rlang_is_primitive, 1},
   {"rlang_is_primitive_eager",          (DL_FUNC) &rlang_is_primitive_eager, 1},
   {"rlang_is_primitive_lazy",           (DL_FUNC) &rlang_is_primitive_lazy, 1},
   {"ffi_is_formula",                    (DL_FUNC) &ffi_is_formula, 3},
+  {"ffi_has_colour",                    (DL_FUNC) &ffi_has_colour, 0},
+  {"ffi_events_drain",                  (DL_FUNC) &ffi_events_drain, 0},
+  {"ffi_events_enable",                 (DL_FUNC) &ffi_events_enable, 2},
+  {"ffi_events_push_abort",             (DL_FUNC) &ffi_events_push_abort, 1},
+  {"ffi_format_bullets",                (DL_FUNC) &ffi_format_bullets, 3},
+  {"ffi_mask_ctxt_pronoun",             (DL_FUNC) &ffi_mask_ctxt_pronoun, 1},
+  {"ffi_init_timings",                  (DL_FUNC) &ffi_init_timings, 0},
+  {"ffi_intern_expr",                   (DL_FUNC) &ffi_intern_expr, 2},
+  {"ffi_intern_exprs",                  (DL_FUNC) &ffi_intern_exprs, 3},
+  {"ffi_intern_stats",                  (DL_FUNC) &ffi_intern_stats, 1},
+  {"ffi_new_intern_table",              (DL_FUNC) &ffi_new_intern_table, 0},
+  {"ffi_lambda_cache_get",              (DL_FUNC) &ffi_lambda_cache_get, 1},
+  {"ffi_lambda_cache_put",              (DL_FUNC) &ffi_lambda_cache_put, 2},
+  {"ffi_memo_del",                      (DL_FUNC) &ffi_memo_del, 2},
+  {"ffi_memo_get",                      (DL_FUNC) &ffi_memo_get, 3},
+  {"ffi_memo_put",                      (DL_FUNC) &ffi_memo_put, 3},
+  {"ffi_memo_stats",                    (DL_FUNC) &ffi_memo_stats, 1},
+  {"ffi_new_memo",                      (DL_FUNC) &ffi_new_memo, 2},
   {"rlang_is_reference",                (DL_FUNC) &rlang_is_reference, 2},
   {"rlang_length",                      (DL_FUNC) &rlang_length, 1},
   {"rlang_true_length",                 (DL_FUNC) &rlang_true_length, 1},
@@ -232,6 +379,10 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_new_node",                    (DL_FUNC) &r_new_node, 2},
   {"rlang_nms_are_duplicated",          (DL_FUNC) &rlang_test_nms_are_duplicated, 2},
   {"rlang_env_clone",                   (DL_FUNC) &r_env_clone, 2},
+  {"ffi_env_as_list",                   (DL_FUNC) &ffi_env_as_list, 2},
+  {"ffi_env_depth",                     (DL_FUNC) &ffi_env_depth, 1},
+  {"ffi_env_parents",                   (DL_FUNC) &ffi_env_parents, 2},
+  {"ffi_env_tail",                      (DL_FUNC) &ffi_env_tail, 2},
   {"rlang_env_unbind",                  (DL_FUNC) &rlang_env_unbind, 3},
   {"rlang_env_poke_parent",             (DL_FUNC) &rlang_env_poke_parent, 2},
   {"rlang_env_frame",                   (DL_FUNC) &rlang_env_frame, 1},
@@ -244,18 +395,32 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_unmark_object",               (DL_FUNC) &rlang_unmark_object, 1},
   {"rlang_node_tag",                    (DL_FUNC) &rlang_node_tag, 1},
   {"rlang_node_poke_tag",               (DL_FUNC) &rlang_node_poke_tag, 2},
-  {"rlang_squash",                      (DL_FUNC) &rlang_squash, 4},
+  {"rlang_squash",                      (DL_FUNC) &rlang_squash, 5},
   {"rlang_sexp_address",                (DL_FUNC) &rlang_sexp_address, 1},
+  {"ffi_sexp_addresses",                (DL_FUNC) &ffi_sexp_addresses, 3},
   {"rlang_symbol",                      (DL_FUNC) &rlang_symbol, 1},
   {"rlang_sym_as_character",            (DL_FUNC) &rlang_sym_as_character, 1},
+  {"ffi_syms",                          (DL_FUNC) &ffi_syms, 1},
+  {"ffi_syms_as_strings",               (DL_FUNC) &ffi_syms_as_strings, 1},
   // No longer necessary but keep this around for a while in case
   // quosures ended up saved as RDS.
   {"rlang_tilde_eval",                  (DL_FUNC) &rlang_tilde_eval, 3},
   {"rlang_unescape_character",          (DL_FUNC) &rlang_unescape_character, 1},
   {"rlang_new_call",                    (DL_FUNC) &rlang_new_call_node, 2},
   {"rlang_cnd_signal",                  (DL_FUNC) &rlang_cnd_signal, 1},
+  {"ffi_cnd_has_handler",               (DL_FUNC) &ffi_cnd_has_handler, 1},
   {"rlang_test_chr_prepend",            (DL_FUNC) &chr_prepend, 2},
   {"rlang_test_chr_append",             (DL_FUNC) &chr_append, 2},
+  {"c_ptr_chr_build",                   (DL_FUNC) &rlang_chr_build, 1},
+  {"c_ptr_vec_sort",                    (DL_FUNC) &rlang_vec_sort, 2},
+  {"c_ptr_vec_unique",                  (DL_FUNC) &rlang_vec_unique, 1},
+  {"c_ptr_vec_order",                   (DL_FUNC) &rlang_vec_order, 2},
+  {"c_ptr_vec_lower_bound",             (DL_FUNC) &rlang_vec_lower_bound, 2},
+  {"c_ptr_chr_index_find",              (DL_FUNC) &rlang_chr_index_find, 2},
+  {"c_ptr_chr_detect_str",              (DL_FUNC) &rlang_chr_detect_str, 2},
+  {"c_ptr_chr_has_any",                 (DL_FUNC) &rlang_chr_has_any, 2},
+  {"c_ptr_c_array_copy",                (DL_FUNC) &rlang_c_array_copy, 1},
+  {"c_ptr_c_dict_count",                (DL_FUNC) &rlang_c_dict_count, 2},
   {"rlang_test_r_warn",                 (DL_FUNC) &rlang_test_r_warn, 1},
   {"rlang_test_r_on_exit",              (DL_FUNC) &rlang_on_exit, 2},
   {"rlang_test_base_ns_get",            (DL_FUNC) &rlang_test_base_ns_get, 1},
@@ -264,16 +429,26 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_test_parse_eval",             (DL_FUNC) &rlang_test_parse_eval, 2},
   {"rlang_test_node_list_clone_until",  (DL_FUNC) &rlang_test_node_list_clone_until, 2},
   {"rlang_test_attrib_set",             (DL_FUNC) &r_attrib_set, 3},
+  {"rlang_test_attrib_set_n",           (DL_FUNC) &rlang_test_attrib_set_n, 4},
   {"rlang_test_sys_frame",              (DL_FUNC) &rlang_test_sys_frame, 1},
   {"rlang_test_sys_call",               (DL_FUNC) &rlang_test_sys_call, 1},
+  {"rlang_test_warn_deprecated",        (DL_FUNC) &rlang_test_warn_deprecated, 1},
+  {"rlang_test_quosures_is_compact",    (DL_FUNC) &rlang_test_quosures_is_compact, 1},
+  {"rlang_test_is_installed",           (DL_FUNC) &rlang_test_is_installed, 1},
+  {"rlang_test_api_dict",               (DL_FUNC) &rlang_test_api_dict, 2},
+  {"rlang_test_signal_soft_deprecated", (DL_FUNC) &rlang_test_signal_soft_deprecated, 1},
   {"rlang_test_Rf_warningcall",         (DL_FUNC) &rlang_test_Rf_warningcall, 2},
   {"rlang_test_Rf_errorcall",           (DL_FUNC) &rlang_test_Rf_errorcall, 2},
+  {"rlang_test_cnd_template",           (DL_FUNC) &rlang_test_cnd_template, 5},
   {"rlang_test_lgl_sum",                (DL_FUNC) &rlang_test_lgl_sum, 2},
   {"rlang_test_lgl_which",              (DL_FUNC) &rlang_test_lgl_which, 2},
   {"rlang_r_string",                    (DL_FUNC) &rlang_r_string, 1},
   {"rlang_exprs_interp",                (DL_FUNC) &rlang_exprs_interp, 6},
   {"rlang_quos_interp",                 (DL_FUNC) &rlang_quos_interp, 6},
   {"rlang_dots_list",                   (DL_FUNC) &rlang_dots_list, 7},
+  {"ffi_dots_list_lazy",                (DL_FUNC) &ffi_dots_list_lazy, 1},
+  {"ffi_dots_frame_missing",            (DL_FUNC) &ffi_dots_frame_missing, 1},
+  {"ffi_dots_frame_names",              (DL_FUNC) &ffi_dots_frame_names, 1},
   {"rlang_dots_flat_list",              (DL_FUNC) &rlang_dots_flat_list, 7},
   {"rlang_dots_pairlist",               (DL_FUNC) &rlang_dots_pairlist, 7},
   {"rlang_new_formula",                 (DL_FUNC) &r_new_formula, 3},
@@ -281,6 +456,9 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_enexpr",                      (DL_FUNC) &rlang_enexpr, 2},
   {"rlang_ensym",                       (DL_FUNC) &rlang_ensym, 2},
   {"rlang_enquo",                       (DL_FUNC) &rlang_enquo, 2},
+  {"ffi_enquos_args",                   (DL_FUNC) &ffi_enquos_args, 2},
+  {"ffi_defer",                         (DL_FUNC) &ffi_defer, 4},
+  {"ffi_defer_run",                     (DL_FUNC) &ffi_defer_run, 1},
   {"rlang_get_expression",              (DL_FUNC) &rlang_get_expression, 2},
   {"rlang_vec_alloc",                   (DL_FUNC) &rlang_vec_alloc, 2},
   {"rlang_vec_coerce",                  (DL_FUNC) &rlang_vec_coerce, 2},
@@ -291,6 +469,7 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_quo_is_null",                 (DL_FUNC) &rlang_quo_is_null, 1},
   {"rlang_quo_get_expr",                (DL_FUNC) &rlang_quo_get_expr, 1},
   {"rlang_quo_set_expr",                (DL_FUNC) &rlang_quo_set_expr, 2},
+  {"ffi_quo_squash",                    (DL_FUNC) &ffi_quo_squash, 1},
   {"rlang_quo_get_env",                 (DL_FUNC) &rlang_quo_get_env, 1},
   {"rlang_quo_set_env",                 (DL_FUNC) &rlang_quo_set_env, 2},
   {"rlang_vec_poke_n",                  (DL_FUNC) &rlang_vec_poke_n, 5},
@@ -301,7 +480,11 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_as_data_mask",                (DL_FUNC) &rlang_as_data_mask, 1},
   {"rlang_is_data_mask",                (DL_FUNC) &rlang_is_data_mask, 1},
   {"rlang_data_pronoun_get",            (DL_FUNC) &rlang_data_pronoun_get, 2},
+  {"ffi_data_pronoun_get",              (DL_FUNC) &ffi_data_pronoun_get, 2},
+  {"ffi_eval_tidy_list",                (DL_FUNC) &ffi_eval_tidy_list, 3},
   {"rlang_data_mask_clean",             (DL_FUNC) &rlang_data_mask_clean, 1},
+  {"rlang_data_mask_poke_data",         (DL_FUNC) &rlang_data_mask_poke_data, 2},
+  {"rlang_data_mask_poke_slice",        (DL_FUNC) &rlang_data_mask_poke_slice, 3},
   {"rlang_as_data_pronoun",             (DL_FUNC) &rlang_as_data_pronoun, 1},
   {"rlang_env_binding_types",           (DL_FUNC) &r_env_binding_types, 2},
   {"rlang_env_get",                     (DL_FUNC) &rlang_env_get, 4},
@@ -328,6 +511,9 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_is_splice_box",               (DL_FUNC) &rlang_is_splice_box, 1},
   {"rlang_new_function",                (DL_FUNC) &rlang_new_function, 3},
   {"rlang_is_string",                   (DL_FUNC) &rlang_is_string, 2},
+  {"ffi_call_match",                    (DL_FUNC) &ffi_call_match, 2},
+  {"ffi_check_args",                    (DL_FUNC) &ffi_check_args, 6},
+  {"ffi_new_arg_matcher",               (DL_FUNC) &ffi_new_arg_matcher, 1},
   {"rlang_new_weakref",                 (DL_FUNC) &rlang_new_weakref, 4},
   {"rlang_wref_key",                    (DL_FUNC) &rlang_wref_key, 1},
   {"rlang_wref_value",                  (DL_FUNC) &rlang_wref_value, 1},
@@ -343,42 +529,109 @@ static const R_CallMethodDef r_callables[] = {
   {"rlang_env_poke",                    (DL_FUNC) &rlang_env_poke, 5},
   {"rlang_env_bind",                    (DL_FUNC) &rlang_env_bind, 5},
   {"rlang_raw_deparse_str",             (DL_FUNC) &rlang_raw_deparse_str, 3},
+  {"ffi_raw_parse_str",                 (DL_FUNC) &ffi_raw_parse_str, 1},
+  {"ffi_parse_exprs_chr",               (DL_FUNC) &ffi_parse_exprs_chr, 1},
   {"rlang_env_browse",                  (DL_FUNC) &rlang_env_browse, 2},
   {"rlang_env_is_browsed",              (DL_FUNC) &rlang_env_is_browsed, 1},
   {"rlang_ns_registry_env",             (DL_FUNC) &rlang_ns_registry_env, 0},
-  {"rlang_hash",                        (DL_FUNC) &rlang_hash, 1},
-  {"rlang_new_dict",                    (DL_FUNC) &rlang_new_dict, 2},
+  {"rlang_hash",                        (DL_FUNC) &rlang_hash, 5},
+  {"rlang_hash_list",                   (DL_FUNC) &rlang_hash_list, 3},
+  {"ffi_hash_kernel",                   (DL_FUNC) &ffi_hash_kernel, 0},
+  {"rlang_hash_file",                   (DL_FUNC) &rlang_hash_file, 1},
+  {"rlang_hasher_new",                  (DL_FUNC) &rlang_hasher_new, 1},
+  {"rlang_hasher_update",               (DL_FUNC) &rlang_hasher_update, 2},
+  {"rlang_hasher_digest",               (DL_FUNC) &rlang_hasher_digest, 2},
+  {"rlang_new_dict",                    (DL_FUNC) &rlang_new_dict, 3},
   {"rlang_dict_put",                    (DL_FUNC) &rlang_dict_put, 3},
   {"rlang_dict_del",                    (DL_FUNC) &rlang_dict_del, 2},
   {"rlang_dict_has",                    (DL_FUNC) &rlang_dict_has, 2},
   {"rlang_dict_get",                    (DL_FUNC) &rlang_dict_get, 2},
   {"rlang_dict_resize",                 (DL_FUNC) &rlang_dict_resize, 2},
+  {"c_ptr_dict_put_n",                  (DL_FUNC) &rlang_dict_put_n, 3},
+  {"c_ptr_dict_get_n",                  (DL_FUNC) &rlang_dict_get_n, 2},
   {"c_ptr_precious_dict",               (DL_FUNC) &rlang_precious_dict, 0},
   {"c_ptr_preserve",                    (DL_FUNC) &rlang_preserve, 1},
   {"c_ptr_unpreserve",                  (DL_FUNC) &rlang_unpreserve, 1},
+  {"c_ptr_preserve_handle",             (DL_FUNC) &rlang_preserve_handle, 1},
+  {"c_ptr_release_handle",              (DL_FUNC) &rlang_release_handle, 1},
+  {"c_ptr_mark_shared",                 (DL_FUNC) &rlang_mark_shared, 1},
   {"c_ptr_alloc_data_frame",            (DL_FUNC) &rlang_alloc_data_frame, 3},
+  {"c_ptr_new_dyn_df",                  (DL_FUNC) &rlang_new_dyn_df, 3},
+  {"c_ptr_dyn_df_push_row",             (DL_FUNC) &rlang_dyn_df_push_row, 2},
+  {"c_ptr_dyn_df_push_rows",            (DL_FUNC) &rlang_dyn_df_push_rows, 3},
+  {"c_ptr_dyn_df_unwrap",               (DL_FUNC) &rlang_dyn_df_unwrap, 1},
   {"c_ptr_list_compact",                (DL_FUNC) &r_list_compact, 1},
+  {"ffi_list_compact_in_place",         (DL_FUNC) &ffi_list_compact_in_place, 1},
   {"c_ptr_vec_resize",                  (DL_FUNC) &rlang_vec_resize, 2},
+  {"c_ptr_arena_collect_int",           (DL_FUNC) &rlang_arena_collect_int, 3},
+  {"c_ptr_sbo_collect_int",             (DL_FUNC) &rlang_sbo_collect_int, 1},
   {"c_ptr_new_dyn_vector",              (DL_FUNC) &rlang_new_dyn_vector, 2},
   {"c_ptr_new_dyn_array",               (DL_FUNC) &rlang_new_dyn_array, 2},
+  {"c_ptr_new_dyn_vector_off_heap",     (DL_FUNC) &rlang_new_dyn_vector_off_heap, 2},
   {"c_ptr_arr_unwrap",                  (DL_FUNC) &rlang_arr_unwrap, 1},
   {"c_ptr_arr_info",                    (DL_FUNC) &rlang_arr_info, 1},
   {"c_ptr_arr_push_back",               (DL_FUNC) &rlang_arr_push_back, 2},
+  {"c_ptr_arr_push_back_n",             (DL_FUNC) &rlang_arr_push_back_n, 2},
   {"c_ptr_arr_push_back_bool",          (DL_FUNC) &rlang_arr_push_back_bool, 2},
   {"c_ptr_arr_pop_back",                (DL_FUNC) &rlang_arr_pop_back, 1},
   {"c_ptr_arr_resize",                  (DL_FUNC) &rlang_arr_resize, 2},
+  {"c_ptr_arr_reserve",                 (DL_FUNC) &rlang_arr_reserve, 2},
+  {"c_ptr_arr_shrink_to_fit",           (DL_FUNC) &rlang_arr_shrink_to_fit, 1},
   {"c_ptr_list_poke",                   (DL_FUNC) &rlang_list_poke, 3},
   {"c_ptr_new_dict_iterator",           (DL_FUNC) &rlang_new_dict_iterator, 1},
   {"c_ptr_dict_it_info",                (DL_FUNC) &rlang_dict_it_info, 1},
+  {"c_ptr_new_pdict",                   (DL_FUNC) &rlang_new_pdict, 0},
+  {"c_ptr_pdict_put",                   (DL_FUNC) &rlang_pdict_put, 3},
+  {"c_ptr_pdict_del",                   (DL_FUNC) &rlang_pdict_del, 2},
+  {"c_ptr_pdict_has",                   (DL_FUNC) &rlang_pdict_has, 2},
+  {"c_ptr_pdict_get",                   (DL_FUNC) &rlang_pdict_get, 2},
+  {"c_ptr_pdict_size",                  (DL_FUNC) &rlang_pdict_size, 1},
+  {"c_ptr_pdict_as_df_list",            (DL_FUNC) &rlang_pdict_as_df_list, 1},
+  {"c_ptr_new_flat_dict",               (DL_FUNC) &rlang_new_flat_dict, 1},
+  {"c_ptr_flat_dict_put",               (DL_FUNC) &rlang_flat_dict_put, 3},
+  {"c_ptr_flat_dict_del",               (DL_FUNC) &rlang_flat_dict_del, 2},
+  {"c_ptr_flat_dict_has",               (DL_FUNC) &rlang_flat_dict_has, 2},
+  {"c_ptr_flat_dict_get",               (DL_FUNC) &rlang_flat_dict_get, 2},
+  {"c_ptr_flat_dict_resize",            (DL_FUNC) &rlang_flat_dict_resize, 2},
+  {"c_ptr_flat_dict_as_list",           (DL_FUNC) &rlang_flat_dict_as_list, 1},
+  {"c_ptr_new_int_dict",                (DL_FUNC) &rlang_new_int_dict, 1},
+  {"c_ptr_int_dict_put",                (DL_FUNC) &rlang_int_dict_put, 3},
+  {"c_ptr_int_dict_del",                (DL_FUNC) &rlang_int_dict_del, 2},
+  {"c_ptr_int_dict_has",                (DL_FUNC) &rlang_int_dict_has, 2},
+  {"c_ptr_int_dict_get",                (DL_FUNC) &rlang_int_dict_get, 2},
+  {"c_ptr_int_dict_as_list",            (DL_FUNC) &rlang_int_dict_as_list, 1},
+  {"c_ptr_new_str_dict",                (DL_FUNC) &rlang_new_str_dict, 1},
+  {"c_ptr_str_dict_put",                (DL_FUNC) &rlang_str_dict_put, 3},
+  {"c_ptr_str_dict_del",                (DL_FUNC) &rlang_str_dict_del, 2},
+  {"c_ptr_str_dict_has",                (DL_FUNC) &rlang_str_dict_has, 2},
+  {"c_ptr_str_dict_get",                (DL_FUNC) &rlang_str_dict_get, 2},
+  {"c_ptr_str_dict_as_list",            (DL_FUNC) &rlang_str_dict_as_list, 1},
   {"c_ptr_dict_next",                   (DL_FUNC) &rlang_dict_it_next, 1},
   {"c_ptr_dict_as_df_list",             (DL_FUNC) &rlang_dict_as_df_list, 1},
   {"c_ptr_dict_as_list",                (DL_FUNC) &rlang_dict_as_list, 1},
+  {"c_ptr_dict_fill",                   (DL_FUNC) &rlang_dict_fill, 3},
+  {"c_ptr_dict_keep_order",             (DL_FUNC) &rlang_dict_keep_order, 1},
+  {"c_ptr_dict_stats",                  (DL_FUNC) &rlang_dict_stats, 1},
   {"ffi_new_dyn_list_of",               (DL_FUNC) &ffi_new_dyn_list_of, 3},
   {"ffi_lof_info",                      (DL_FUNC) &ffi_lof_info, 1},
   {"ffi_lof_unwrap",                    (DL_FUNC) &ffi_lof_unwrap, 1},
+  {"ffi_lof_unwrap_csr",                (DL_FUNC) &ffi_lof_unwrap_csr, 1},
+  {"ffi_csr_as_list",                   (DL_FUNC) &ffi_csr_as_list, 1},
   {"ffi_lof_push_back",                 (DL_FUNC) &ffi_lof_push_back, 1},
   {"ffi_lof_arr_push_back",             (DL_FUNC) &ffi_lof_arr_push_back, 3},
-  {"ffi_sexp_iterate",                  (DL_FUNC) &ffi_sexp_iterate, 2},
+  {"ffi_trace_add_namespaces",          (DL_FUNC) &ffi_trace_add_namespaces, 2},
+  {"ffi_trace_back",                    (DL_FUNC) &ffi_trace_back, 4},
+  {"ffi_trace_prof_start",              (DL_FUNC) &ffi_trace_prof_start, 1},
+  {"ffi_trace_prof_stop",               (DL_FUNC) &ffi_trace_prof_stop, 0},
+  {"ffi_trace_prof_tick",               (DL_FUNC) &ffi_trace_prof_tick, 0},
+  {"ffi_sexp_find",                     (DL_FUNC) &ffi_sexp_find, 6},
+  {"ffi_sexp_iterate",                  (DL_FUNC) &ffi_sexp_iterate, 4},
+  {"ffi_obj_size",                      (DL_FUNC) &ffi_obj_size, 2},
+  {"ffi_obj_strip",                     (DL_FUNC) &ffi_obj_strip, 2},
+  {"ffi_instrument_counts",             (DL_FUNC) &ffi_instrument_counts, 0},
+  {"ffi_instrument_enable",             (DL_FUNC) &ffi_instrument_enable, 1},
+  {"ffi_instrument_reset",              (DL_FUNC) &ffi_instrument_reset, 0},
+  {"ffi_instrument_stats",              (DL_FUNC) &ffi_instrument_stats, 0},
   {NULL, NULL, 0}
 };
 
@@ -418,6 +671,52 @@ extern void rlang_print_backtrace(bool full);
 // From xxhash.h
 extern uint64_t XXH3_64bits(const void*, size_t);
 
+// Exported with a single `R_GetCCallable()` lookup, see "rlang/api.h"
+static const struct r_api rlang_api = {
+  .abi_version = R_API_ABI_VERSION,
+  .size = sizeof(struct r_api),
+  .features = R_API_FEATURE_dict_bulk | R_API_FEATURE_dyn_array_bulk,
+
+  .new_dict = &r_new_dict,
+  .dict_put = &r_dict_put,
+  .dict_del = &r_dict_del,
+  .dict_has = &r_dict_has,
+  .dict_get0 = &r_dict_get0,
+  .dict_put_n = &r_dict_put_n,
+  .dict_get_n = &r_dict_get_n,
+
+  .new_dyn_vector = &r_new_dyn_vector,
+  .new_dyn_array = &r_new_dyn_array,
+  .arr_push_back = &r_arr_push_back,
+  .arr_push_back_n = &r_arr_push_back_n,
+  .arr_reserve = &r_arr_reserve,
+  .arr_unwrap = &r_arr_unwrap,
+
+  .xxh3_64bits = &XXH3_64bits,
+  .hasher_new = &rlang_hasher_new,
+  .hasher_update = &rlang_hasher_update,
+  .hasher_digest = &rlang_hasher_digest,
+
+  .alloc_environment = &r_alloc_environment,
+  .env_clone = &r_env_clone,
+  .env_poke_lazy = &r_env_poke_lazy,
+  .env_inherits = &r_env_inherits,
+
+  .eval_with_x = &r_eval_with_x,
+  .eval_with_xy = &r_eval_with_xy,
+  .eval_tidy = &rlang_eval_tidy,
+  .as_function = &r_as_function,
+
+  .new_quosure = &rlang_new_quosure,
+  .is_quosure = &rlang_is_quosure,
+  .quo_get_expr = &rlang_quo_get_expr,
+  .quo_get_env = &rlang_quo_get_env
+};
+
+const struct r_api* rlang_get_api(void) {
+  return &rlang_api;
+}
+
 r_visible
 void R_init_rlang(DllInfo* dll) {
   R_RegisterCCallable("rlang", "rlang_new_quosure", (DL_FUNC) &rlang_new_quosure);
@@ -430,11 +729,18 @@ void R_init_rlang(DllInfo* dll) {
   R_RegisterCCallable("rlang", "rlang_as_data_mask_3.0.0", (DL_FUNC) &rlang_as_data_mask);
   R_RegisterCCallable("rlang", "rlang_new_data_mask_3.0.0", (DL_FUNC) &rlang_new_data_mask);
   R_RegisterCCallable("rlang", "rlang_eval_tidy", (DL_FUNC) &rlang_eval_tidy);
+  R_RegisterCCallable("rlang", "rlang_data_mask_poke_data", (DL_FUNC) &rlang_data_mask_poke_data);
+  R_RegisterCCallable("rlang", "rlang_data_mask_poke_slice", (DL_FUNC) &rlang_data_mask_poke_slice);
 
-  r_obj* r_as_function(r_obj* x, const char* arg);
   R_RegisterCCallable("rlang", "rlang_as_function", (DL_FUNC) &r_as_function);
 
   R_RegisterCCallable("rlang", "rlang_xxh3_64bits", (DL_FUNC) &XXH3_64bits);
+  R_RegisterCCallable("rlang", "rlang_hash_list", (DL_FUNC) &rlang_hash_list);
+  R_RegisterCCallable("rlang", "rlang_hasher_new", (DL_FUNC) &rlang_hasher_new);
+  R_RegisterCCallable("rlang", "rlang_hasher_update", (DL_FUNC) &rlang_hasher_update);
+  R_RegisterCCallable("rlang", "rlang_hasher_digest", (DL_FUNC) &rlang_hasher_digest);
+
+  R_RegisterCCallable("rlang", "rlang_api", (DL_FUNC) &rlang_get_api);
 
   // Maturing
   R_RegisterCCallable("rlang", "rlang_is_splice_box", (DL_FUNC) &is_splice_box);
@@ -446,6 +752,7 @@ void R_init_rlang(DllInfo* dll) {
 
   // Experimental
   R_RegisterCCallable("rlang", "rlang_squash_if", (DL_FUNC) &r_squash_if);
+  R_RegisterCCallable("rlang", "rlang_enquos_args", (DL_FUNC) &rlang_enquos_args);
 
   // Compatibility
   R_RegisterCCallable("rlang", "rlang_as_data_mask", (DL_FUNC) &rlang_as_data_mask_compat);
@@ -454,6 +761,27 @@ void R_init_rlang(DllInfo* dll) {
   // Only for debugging - no stability guaranteed
   R_RegisterCCallable("rlang", "rlang_print_backtrace", (DL_FUNC) &rlang_print_backtrace);
 
+  void rlang_init_attr_altrep(DllInfo* dll);
+  rlang_init_attr_altrep(dll);
+
+  void rlang_init_dots_altrep(DllInfo* dll);
+  rlang_init_dots_altrep(dll);
+
+  void rlang_init_eval_tidy_altrep(DllInfo* dll);
+  rlang_init_eval_tidy_altrep(dll);
+
+  void rlang_init_quo_altrep(DllInfo* dll);
+  rlang_init_quo_altrep(dll);
+
+  void rlang_init_squash_altrep(DllInfo* dll);
+  rlang_init_squash_altrep(dll);
+
+  r_init_altrep_dyn_array(dll);
+  r_init_altrep_dyn_list_of(dll);
+
+  void rlang_instrument_callables(R_CallMethodDef* callables);
+  rlang_instrument_callables(r_callables);
+
   R_registerRoutines(dll, NULL, r_callables, NULL, externals);
   R_useDynamicSymbols(dll, FALSE);
 }
@@ -463,10 +791,18 @@ void R_init_rlang(DllInfo* dll) {
 void rlang_init_internal(r_obj* ns);
 
 r_obj* rlang_library_load(r_obj* ns) {
-  rlang_init_internal(ns);
+  R_INIT_TIMED("rlang_init_internal", rlang_init_internal(ns));
   return r_null;
 }
 
+r_obj* ffi_init_timings() {
+  return r_init_timings();
+}
+
+r_obj* ffi_has_colour() {
+  return r_lgl(r_has_colour());
+}
+
 r_obj* rlang_library_unload() {
   return r_null;
 }
@@ -0,0 +1,298 @@
+#include <rlang.h>
+#include <R_ext/Rdynload.h>
+
+/*
+ * Per entry point instrumentation of the `.Call()` routines. Each
+ * registered routine is wrapped in a trampoline that attributes the
+ * library counters of `r_instr_counts` to the routine. When counting
+ * is disabled, the trampoline forwards its arguments directly.
+ *
+ * Trampolines can't carry data so they are generated at compile time
+ * for each arity, in numbered slots. At load time, each routine is
+ * assigned the next free slot of its arity. Routines with more
+ * arguments than `INSTR_MAX_ARITY` or that don't fit in the slots are
+ * registered as is and are not counted. Increase the number of slots
+ * below when adding routines.
+ *
+ * Counts are inclusive: they include the allocations of routines
+ * called from R code evaluated by the routine, e.g. by `eval_tidy()`.
+ * A routine that exits with a longjump still counts as called but
+ * its allocations are not attributed.
+ */
+
+#define INSTR_MAX_ARITY 7
+
+struct instr_slot {
+  DL_FUNC fn;
+  const char* name;
+
+  double n_calls;
+  double n_vectors;
+  double n_nodes;
+  double n_environments;
+  int protect_max;
+};
+
+static
+void instr_call_enter(struct instr_slot* p_slot,
+                        struct r_instr_counts* p_start,
+                        int* p_depth) {
+  ++p_slot->n_calls;
+  *p_start = r_instr_counts;
+  *p_depth = r_instr_protect_depth();
+  r_instr_counts.protect_max = *p_depth;
+}
+static
+void instr_call_exit(struct instr_slot* p_slot,
+                     struct r_instr_counts* p_start,
+                     int depth) {
+  p_slot->n_vectors += r_instr_counts.n_vectors - p_start->n_vectors;
+  p_slot->n_nodes += r_instr_counts.n_nodes - p_start->n_nodes;
+  p_slot->n_environments += r_instr_counts.n_environments - p_start->n_environments;
+
+  int protect_max = r_instr_counts.protect_max - depth;
+  if (protect_max > p_slot->protect_max) {
+    p_slot->protect_max = protect_max;
+  }
+
+  // Restore the high-water mark of the calling routine
+  if (p_start->protect_max > r_instr_counts.protect_max) {
+    r_instr_counts.protect_max = p_start->protect_max;
+  }
+}
+
+#define INSTR_PARAMS_0 void
+#define INSTR_PARAMS_1 r_obj* x1
+#define INSTR_PARAMS_2 INSTR_PARAMS_1, r_obj* x2
+#define INSTR_PARAMS_3 INSTR_PARAMS_2, r_obj* x3
+#define INSTR_PARAMS_4 INSTR_PARAMS_3, r_obj* x4
+#define INSTR_PARAMS_5 INSTR_PARAMS_4, r_obj* x5
+#define INSTR_PARAMS_6 INSTR_PARAMS_5, r_obj* x6
+#define INSTR_PARAMS_7 INSTR_PARAMS_6, r_obj* x7
+
+#define INSTR_ARGS_0
+#define INSTR_ARGS_1 x1
+#define INSTR_ARGS_2 INSTR_ARGS_1, x2
+#define INSTR_ARGS_3 INSTR_ARGS_2, x3
+#define INSTR_ARGS_4 INSTR_ARGS_3, x4
+#define INSTR_ARGS_5 INSTR_ARGS_4, x5
+#define INSTR_ARGS_6 INSTR_ARGS_5, x6
+#define INSTR_ARGS_7 INSTR_ARGS_6, x7
+
+typedef r_obj* (*instr_fn_0)(INSTR_PARAMS_0);
+typedef r_obj* (*instr_fn_1)(INSTR_PARAMS_1);
+typedef r_obj* (*instr_fn_2)(INSTR_PARAMS_2);
+typedef r_obj* (*instr_fn_3)(INSTR_PARAMS_3);
+typedef r_obj* (*instr_fn_4)(INSTR_PARAMS_4);
+typedef r_obj* (*instr_fn_5)(INSTR_PARAMS_5);
+typedef r_obj* (*instr_fn_6)(INSTR_PARAMS_6);
+typedef r_obj* (*instr_fn_7)(INSTR_PARAMS_7);
+
+// Number of slots per arity, in multiples of 8
+#define INSTR_SLOTS_0(M) INSTR_8(M, 0, 0, 0) INSTR_8(M, 0, 0, 1) INSTR_8(M, 0, 0, 2)
+#define INSTR_SLOTS_1(M) INSTR_64(M, 1, 0) INSTR_64(M, 1, 1) INSTR_64(M, 1, 2)
+#define INSTR_SLOTS_2(M) INSTR_64(M, 2, 0) INSTR_64(M, 2, 1) INSTR_64(M, 2, 2)
+#define INSTR_SLOTS_3(M) INSTR_64(M, 3, 0)
+#define INSTR_SLOTS_4(M) INSTR_8(M, 4, 0, 0) INSTR_8(M, 4, 0, 1) INSTR_8(M, 4, 0, 2)
+#define INSTR_SLOTS_5(M) INSTR_8(M, 5, 0, 0) INSTR_8(M, 5, 0, 1)
+#define INSTR_SLOTS_6(M) INSTR_8(M, 6, 0, 0) INSTR_8(M, 6, 0, 1)
+#define INSTR_SLOTS_7(M) INSTR_8(M, 7, 0, 0) INSTR_8(M, 7, 0, 1)
+
+#define INSTR_8(M, K, A, B)                                             \
+  M(K, A, B, 0) M(K, A, B, 1) M(K, A, B, 2) M(K, A, B, 3)               \
+  M(K, A, B, 4) M(K, A, B, 5) M(K, A, B, 6) M(K, A, B, 7)
+#define INSTR_64(M, K, A)                                               \
+  INSTR_8(M, K, A, 0) INSTR_8(M, K, A, 1) INSTR_8(M, K, A, 2)           \
+  INSTR_8(M, K, A, 3) INSTR_8(M, K, A, 4) INSTR_8(M, K, A, 5)           \
+  INSTR_8(M, K, A, 6) INSTR_8(M, K, A, 7)
+
+#define INSTR_COUNT(K, A, B, C) + 1
+#define INSTR_SIZE(K) (0 INSTR_SLOTS_##K(INSTR_COUNT))
+
+static struct instr_slot instr_slots_0[INSTR_SIZE(0)];
+static struct instr_slot instr_slots_1[INSTR_SIZE(1)];
+static struct instr_slot instr_slots_2[INSTR_SIZE(2)];
+static struct instr_slot instr_slots_3[INSTR_SIZE(3)];
+static struct instr_slot instr_slots_4[INSTR_SIZE(4)];
+static struct instr_slot instr_slots_5[INSTR_SIZE(5)];
+static struct instr_slot instr_slots_6[INSTR_SIZE(6)];
+static struct instr_slot instr_slots_7[INSTR_SIZE(7)];
+
+#define INSTR_DEFINE(K, A, B, C)                                        \
+  static                                                                \
+  r_obj* instr_tramp_##K##_##A##B##C(INSTR_PARAMS_##K) {                \
+    struct instr_slot* p_slot = &instr_slots_##K[A * 64 + B * 8 + C];   \
+    instr_fn_##K fn = (instr_fn_##K) p_slot->fn;                        \
+                                                                        \
+    if (!r_instr_enabled) {                                             \
+      return fn(INSTR_ARGS_##K);                                        \
+    }                                                                   \
+                                                                        \
+    struct r_instr_counts start;                                        \
+    int depth;                                                          \
+    instr_call_enter(p_slot, &start, &depth);                           \
+    r_obj* out = fn(INSTR_ARGS_##K);                                    \
+    instr_call_exit(p_slot, &start, depth);                             \
+    return out;                                                         \
+  }
+
+#define INSTR_ENTRY(K, A, B, C) (DL_FUNC) &instr_tramp_##K##_##A##B##C,
+
+INSTR_SLOTS_0(INSTR_DEFINE)
+INSTR_SLOTS_1(INSTR_DEFINE)
+INSTR_SLOTS_2(INSTR_DEFINE)
+INSTR_SLOTS_3(INSTR_DEFINE)
+INSTR_SLOTS_4(INSTR_DEFINE)
+INSTR_SLOTS_5(INSTR_DEFINE)
+INSTR_SLOTS_6(INSTR_DEFINE)
+INSTR_SLOTS_7(INSTR_DEFINE)
+
+static const DL_FUNC instr_tramps_0[] = { INSTR_SLOTS_0(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_1[] = { INSTR_SLOTS_1(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_2[] = { INSTR_SLOTS_2(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_3[] = { INSTR_SLOTS_3(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_4[] = { INSTR_SLOTS_4(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_5[] = { INSTR_SLOTS_5(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_6[] = { INSTR_SLOTS_6(INSTR_ENTRY) };
+static const DL_FUNC instr_tramps_7[] = { INSTR_SLOTS_7(INSTR_ENTRY) };
+
+static struct instr_slot* const instr_slots[INSTR_MAX_ARITY + 1] = {
+  instr_slots_0, instr_slots_1, instr_slots_2, instr_slots_3,
+  instr_slots_4, instr_slots_5, instr_slots_6, instr_slots_7
+};
+static const DL_FUNC* const instr_tramps[INSTR_MAX_ARITY + 1] = {
+  instr_tramps_0, instr_tramps_1, instr_tramps_2, instr_tramps_3,
+  instr_tramps_4, instr_tramps_5, instr_tramps_6, instr_tramps_7
+};
+static const int instr_sizes[INSTR_MAX_ARITY + 1] = {
+  INSTR_SIZE(0), INSTR_SIZE(1), INSTR_SIZE(2), INSTR_SIZE(3),
+  INSTR_SIZE(4), INSTR_SIZE(5), INSTR_SIZE(6), INSTR_SIZE(7)
+};
+
+// Slots in registration order
+#define INSTR_N_SLOTS (INSTR_SIZE(0) + INSTR_SIZE(1) + INSTR_SIZE(2) + \
+                       INSTR_SIZE(3) + INSTR_SIZE(4) + INSTR_SIZE(5) + \
+                       INSTR_SIZE(6) + INSTR_SIZE(7))
+static struct instr_slot* instr_order[INSTR_N_SLOTS];
+static int instr_n = 0;
+
+
+// Replaces the routines of `callables` by their trampolines. The
+// routines controlling the instrumentation are not counted.
+void rlang_instrument_callables(R_CallMethodDef* callables) {
+  int n_used[INSTR_MAX_ARITY + 1] = { 0 };
+
+  for (R_CallMethodDef* p_def = callables; p_def->name; ++p_def) {
+    int k = p_def->numArgs;
+    if (k < 0 || k > INSTR_MAX_ARITY || n_used[k] == instr_sizes[k]) {
+      continue;
+    }
+    if (strncmp(p_def->name, "ffi_instrument_", 15) == 0) {
+      continue;
+    }
+
+    int j = n_used[k]++;
+    struct instr_slot* p_slot = &instr_slots[k][j];
+    p_slot->fn = p_def->fun;
+    p_slot->name = p_def->name;
+    instr_order[instr_n++] = p_slot;
+
+    p_def->fun = instr_tramps[k][j];
+  }
+}
+
+
+r_obj* ffi_instrument_enable(r_obj* enable) {
+  if (!r_is_bool(enable)) {
+    r_stop_internal("ffi_instrument_enable", "`enable` must be a logical value.");
+  }
+  bool old = r_instr_enabled;
+  r_instr_enabled = r_lgl_get(enable, 0);
+  return r_lgl(old);
+}
+
+r_obj* ffi_instrument_reset() {
+  r_instr_counts = (struct r_instr_counts) { 0 };
+
+  for (int i = 0; i < instr_n; ++i) {
+    struct instr_slot* p_slot = instr_order[i];
+    p_slot->n_calls = 0;
+    p_slot->n_vectors = 0;
+    p_slot->n_nodes = 0;
+    p_slot->n_environments = 0;
+    p_slot->protect_max = 0;
+  }
+  return r_null;
+}
+
+// Totals of the library counters since the last reset. Unlike the
+// sums of the per entry point counts, nested entry points are only
+// counted once.
+r_obj* ffi_instrument_counts() {
+  const char* nms[] = { "vectors", "nodes", "environments" };
+
+  r_obj* out = KEEP(r_alloc_double(R_ARR_SIZEOF(nms)));
+  r_attrib_poke_names(out, r_chr_n(nms, R_ARR_SIZEOF(nms)));
+
+  double* v_out = r_dbl_begin(out);
+  v_out[0] = r_instr_counts.n_vectors;
+  v_out[1] = r_instr_counts.n_nodes;
+  v_out[2] = r_instr_counts.n_environments;
+
+  FREE(1);
+  return out;
+}
+
+enum instr_col {
+  INSTR_COL_entry = 0,
+  INSTR_COL_calls,
+  INSTR_COL_vectors,
+  INSTR_COL_nodes,
+  INSTR_COL_environments,
+  INSTR_COL_protect_max,
+  INSTR_COL_SIZE
+};
+
+// Returns the routines that were called since the last reset
+r_obj* ffi_instrument_stats() {
+  r_ssize n = 0;
+  for (int i = 0; i < instr_n; ++i) {
+    n += instr_order[i]->n_calls > 0;
+  }
+
+  const char* nms[INSTR_COL_SIZE] = {
+    "entry", "calls", "vectors", "nodes", "environments", "protect_max"
+  };
+  const enum r_type types[INSTR_COL_SIZE] = {
+    R_TYPE_character, R_TYPE_double, R_TYPE_double,
+    R_TYPE_double, R_TYPE_double, R_TYPE_integer
+  };
+  r_obj* df_nms = KEEP(r_chr_n(nms, INSTR_COL_SIZE));
+  r_obj* out = KEEP(r_alloc_df_list(n, df_nms, types, INSTR_COL_SIZE));
+  r_init_data_frame(out, n);
+
+  r_obj* entry = r_list_get(out, INSTR_COL_entry);
+  double* v_calls = r_dbl_begin(r_list_get(out, INSTR_COL_calls));
+  double* v_vectors = r_dbl_begin(r_list_get(out, INSTR_COL_vectors));
+  double* v_nodes = r_dbl_begin(r_list_get(out, INSTR_COL_nodes));
+  double* v_envs = r_dbl_begin(r_list_get(out, INSTR_COL_environments));
+  int* v_protect = r_int_begin(r_list_get(out, INSTR_COL_protect_max));
+
+  for (int i = 0, j = 0; i < instr_n; ++i) {
+    struct instr_slot* p_slot = instr_order[i];
+    if (p_slot->n_calls == 0) {
+      continue;
+    }
+
+    r_chr_poke(entry, j, r_str(p_slot->name));
+    v_calls[j] = p_slot->n_calls;
+    v_vectors[j] = p_slot->n_vectors;
+    v_nodes[j] = p_slot->n_nodes;
+    v_envs[j] = p_slot->n_environments;
+    v_protect[j] = p_slot->protect_max;
+    ++j;
+  }
+
+  FREE(2);
+  return out;
+}
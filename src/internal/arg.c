@@ -1,34 +1,20 @@
 #include <rlang.h>
 #include "nse-inject.h"
 #include "utils.h"
+#include "vec.h"
 
 // Capture
 
-r_obj* rlang_ns_get(const char* name);
+r_obj* capturearg_compact(r_obj* sym, r_obj* frame, r_obj** p_env);
 
 r_obj* capture(r_obj* sym, r_obj* frame, r_obj** arg_env) {
-  static r_obj* capture_call = NULL;
-  if (!capture_call) {
-    r_obj* args = KEEP(r_new_node(r_null, r_null));
-    capture_call = r_new_call(rlang_ns_get("captureArgInfo"), args);
-    r_preserve(capture_call);
-    r_mark_shared(capture_call);
-    FREE(1);
-  }
-
   if (r_typeof(sym) != SYMSXP) {
     r_abort("`arg` must be a symbol");
   }
 
-  r_node_poke_cadr(capture_call, sym);
-  r_obj* arg_info = KEEP(r_eval(capture_call, frame));
-  r_obj* expr = r_list_get(arg_info, 0);
-  r_obj* env = r_list_get(arg_info, 1);
-
-  // Unquoting rearranges the expression
-  // FIXME: Only duplicate the call tree, not the leaves
-  expr = KEEP(r_copy(expr));
-  expr = call_interp(expr, env);
+  r_obj* env;
+  r_obj* expr = KEEP(capturearg_compact(sym, frame, &env));
+  expr = KEEP(call_interp_cow(expr, env));
 
   if (arg_env) {
     *arg_env = env;
@@ -75,9 +61,49 @@ r_obj* rlang_enquo(r_obj* sym, r_obj* frame) {
   return quo;
 }
 
+static r_obj* enquos_args_class = NULL;
+
+// Captures the arguments named `args` of `frame` in a single call
+r_obj* rlang_enquos_args(r_obj* args, r_obj* frame) {
+  if (r_typeof(args) != R_TYPE_character) {
+    r_abort("`args` must be a character vector.");
+  }
+  if (r_typeof(frame) != R_TYPE_environment) {
+    r_stop_internal("rlang_enquos_args", "`frame` must be an environment.");
+  }
+
+  r_ssize n = r_length(args);
+  r_obj* const * v_args = r_chr_cbegin(args);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* arg = v_args[i];
+    if (arg == r_globals.na_str || arg == r_globals.empty_str) {
+      r_abort("`args` can't contain missing or empty names.");
+    }
+
+    r_obj* env;
+    r_obj* expr = KEEP(capture(r_str_as_symbol(arg), frame, &env));
+    r_list_poke(out, i, forward_quosure(expr, env));
+    FREE(1);
+  }
+
+  r_attrib_poke_names(out, args);
+  r_attrib_poke_class(out, enquos_args_class);
+
+  FREE(1);
+  return out;
+}
+r_obj* ffi_enquos_args(r_obj* args, r_obj* frame) {
+  return rlang_enquos_args(args, frame);
+}
+
 static r_obj* stop_arg_match_call = NULL;
 static r_obj* arg_nm_sym = NULL;
-void arg_match0_abort(const char* msg, r_obj* env);
+static void arg_match0_abort(const char* msg, r_obj* arg_nm);
+static r_obj* arg_match(r_obj* arg, r_obj* values, r_obj* arg_nm);
+static r_obj* arg_match_matcher(r_obj* arg, r_obj* matcher, r_obj* arg_nm);
 
 r_obj* rlang_ext_arg_match0(r_obj* args) {
   args = r_node_cdr(args);
@@ -86,8 +112,28 @@ r_obj* rlang_ext_arg_match0(r_obj* args) {
   r_obj* values = r_node_car(args); args = r_node_cdr(args);
   r_obj* env = r_node_car(args);
 
+  return arg_match(arg, values, env);
+}
+
+// `arg_nm` is either a string or the frame of `arg_match0()`. In the
+// latter case the label is only evaluated when an error is thrown.
+static
+r_obj* arg_nm_get(r_obj* arg_nm) {
+  if (r_typeof(arg_nm) == R_TYPE_environment) {
+    return r_eval(arg_nm_sym, arg_nm);
+  } else {
+    return arg_nm;
+  }
+}
+
+static
+r_obj* arg_match(r_obj* arg, r_obj* values, r_obj* arg_nm) {
+  if (r_typeof(values) == R_TYPE_list && r_inherits(values, "rlang_arg_matcher")) {
+    return arg_match_matcher(arg, values, arg_nm);
+  }
+
   if (r_typeof(arg) != R_TYPE_character) {
-    arg_match0_abort("`%s` must be a character vector.", env);
+    arg_match0_abort("`%s` must be a character vector.", arg_nm);
   }
   if (r_typeof(values) != R_TYPE_character) {
     r_abort("`values` must be a character vector.");
@@ -96,10 +142,10 @@ r_obj* rlang_ext_arg_match0(r_obj* args) {
   r_ssize arg_len = r_length(arg);
   r_ssize values_len = r_length(values);
   if (values_len == 0) {
-    arg_match0_abort("`values` must have at least one element.", env);
+    arg_match0_abort("`values` must have at least one element.", arg_nm);
   }
   if (arg_len != 1 && arg_len != values_len) {
-    arg_match0_abort("`%s` must be a string or have the same length as `values`.", env);
+    arg_match0_abort("`%s` must be a string or have the same length as `values`.", arg_nm);
   }
 
   // Simple case: one argument, we check if it's one of the values.
@@ -111,7 +157,7 @@ r_obj* rlang_ext_arg_match0(r_obj* args) {
       }
     }
 
-    r_obj* arg_nm = KEEP(r_eval(arg_nm_sym, env));
+    arg_nm = KEEP(arg_nm_get(arg_nm));
     r_eval_with_xyz(stop_arg_match_call, arg, values, arg_nm, rlang_ns_env);
 
     r_stop_unreached("rlang_ext2_arg_match0");
@@ -156,7 +202,7 @@ r_obj* rlang_ext_arg_match0(r_obj* args) {
 
     if (!matched) {
       arg = KEEP(r_str_as_character(r_chr_get(arg, 0)));
-      r_obj* arg_nm = KEEP(r_eval(arg_nm_sym, env));
+      arg_nm = KEEP(arg_nm_get(arg_nm));
       r_eval_with_xyz(stop_arg_match_call, arg, values, arg_nm, rlang_ns_env);
 
       r_stop_unreached("rlang_ext2_arg_match0");
@@ -167,8 +213,9 @@ r_obj* rlang_ext_arg_match0(r_obj* args) {
   return(r_str_as_character(r_chr_get(arg, 0)));
 }
 
-void arg_match0_abort(const char* msg, r_obj* env) {
-  r_obj* arg_nm = KEEP(r_eval(arg_nm_sym, env));
+static
+void arg_match0_abort(const char* msg, r_obj* arg_nm) {
+  arg_nm = KEEP(arg_nm_get(arg_nm));
 
   if (r_typeof(arg_nm) != R_TYPE_character || r_length(arg_nm) != 1) {
     r_abort(msg, "<arg_nm>");
@@ -178,9 +225,354 @@ void arg_match0_abort(const char* msg, r_obj* env) {
   r_abort(msg, arg_nm_chr);
 }
 
+
+// Matchers
+
+// A matcher is a list of `values` and of an external pointer to a
+// dictionary that maps each value to its location. The dictionary is
+// built lazily so that matchers can be created at build time and
+// serialised in the namespace of a package. External pointers are
+// reset to `NULL` when they are unserialised.
+
+static r_obj* arg_matcher_names = NULL;
+static r_obj* arg_matcher_class = NULL;
+
+static
+struct r_flat_dict* arg_matcher_dict(r_obj* matcher) {
+  r_obj* xptr = r_list_get(matcher, 1);
+
+  struct r_flat_dict* p_dict = R_ExternalPtrAddr(xptr);
+  if (p_dict) {
+    return p_dict;
+  }
+
+  r_obj* values = r_list_get(matcher, 0);
+  r_ssize n = r_length(values);
+  r_obj* const * v_values = r_chr_cbegin(values);
+
+  p_dict = r_new_flat_dict(n);
+  KEEP(p_dict->shelter);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* loc = KEEP(r_int(i));
+    if (!r_flat_dict_put(p_dict, v_values[i], loc)) {
+      r_abort("`values` can't contain duplicates.");
+    }
+    FREE(1);
+  }
+
+  R_SetExternalPtrProtected(xptr, p_dict->shelter);
+  R_SetExternalPtrAddr(xptr, p_dict);
+
+  FREE(1);
+  return p_dict;
+}
+
+r_obj* ffi_new_arg_matcher(r_obj* values) {
+  if (r_typeof(values) != R_TYPE_character) {
+    r_abort("`values` must be a character vector.");
+  }
+  if (r_length(values) == 0) {
+    r_abort("`values` must have at least one element.");
+  }
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_list_poke(out, 0, values);
+  r_list_poke(out, 1, R_MakeExternalPtr(NULL, r_null, r_null));
+
+  r_attrib_poke(out, r_syms.names, arg_matcher_names);
+  r_attrib_poke(out, r_syms.class, arg_matcher_class);
+
+  // Check for duplicates eagerly
+  arg_matcher_dict(out);
+
+  FREE(1);
+  return out;
+}
+
+static
+r_obj* arg_match_matcher(r_obj* arg, r_obj* matcher, r_obj* arg_nm) {
+  r_obj* values = r_list_get(matcher, 0);
+
+  if (r_typeof(arg) != R_TYPE_character) {
+    arg_match0_abort("`%s` must be a character vector.", arg_nm);
+  }
+
+  r_ssize arg_len = r_length(arg);
+  r_ssize values_len = r_length(values);
+  if (arg_len != 1 && arg_len != values_len) {
+    arg_match0_abort("`%s` must be a string or have the same length as `values`.", arg_nm);
+  }
+
+  struct r_flat_dict* p_dict = arg_matcher_dict(matcher);
+
+  if (arg_len == 1) {
+    if (r_flat_dict_has(p_dict, r_chr_get(arg, 0))) {
+      return arg;
+    }
+
+    arg_nm = KEEP(arg_nm_get(arg_nm));
+    r_eval_with_xyz(stop_arg_match_call, arg, values, arg_nm, rlang_ns_env);
+
+    r_stop_unreached("arg_match_matcher");
+  }
+
+  r_obj* const* v_arg = r_chr_cbegin(arg);
+  r_obj* const* v_values = r_chr_cbegin(values);
+
+  // Skip the common prefix, typically the whole vector when `arg` is
+  // the default value of a formal argument
+  r_ssize i = 0;
+  for (; i < arg_len; ++i) {
+    if (v_arg[i] != v_values[i]) {
+      break;
+    }
+  }
+
+  if (i < arg_len) {
+    // Since `arg` and `values` have the same length, `arg` is a
+    // permutation if each of its elements is found exactly once
+    r_obj* seen = KEEP(r_alloc_raw0(values_len));
+    unsigned char* v_seen = r_raw_begin(seen);
+    memset(v_seen, 1, i);
+
+    for (; i < arg_len; ++i) {
+      r_obj* loc = r_flat_dict_get0(p_dict, v_arg[i]);
+
+      if (!loc || v_seen[r_int_get(loc, 0)]) {
+        arg = KEEP(r_str_as_character(v_arg[0]));
+        arg_nm = KEEP(arg_nm_get(arg_nm));
+        r_eval_with_xyz(stop_arg_match_call, arg, values, arg_nm, rlang_ns_env);
+
+        r_stop_unreached("arg_match_matcher");
+      }
+
+      v_seen[r_int_get(loc, 0)] = 1;
+    }
+
+    FREE(1);
+  }
+
+  return r_str_as_character(v_arg[0]);
+}
+
+
+// Checking
+
+enum arg_check_type {
+  ARG_CHECK_string,
+  ARG_CHECK_bool,
+  ARG_CHECK_character,
+  ARG_CHECK_logical,
+  ARG_CHECK_integer,
+  ARG_CHECK_integerish,
+  ARG_CHECK_double,
+  ARG_CHECK_list,
+  ARG_CHECK_arg_match
+};
+
+struct arg_check_info {
+  const char* name;
+  const char* desc;
+  enum arg_check_type type;
+};
+
+static
+const struct arg_check_info arg_check_infos[] = {
+  { "string", "a single string", ARG_CHECK_string },
+  { "bool", "`TRUE` or `FALSE`", ARG_CHECK_bool },
+  { "character", "a character vector", ARG_CHECK_character },
+  { "logical", "a logical vector", ARG_CHECK_logical },
+  { "integer", "an integer vector", ARG_CHECK_integer },
+  { "integerish", "an integerish vector", ARG_CHECK_integerish },
+  { "double", "a double vector", ARG_CHECK_double },
+  { "list", "a list", ARG_CHECK_list },
+  { "arg_match", "a character vector", ARG_CHECK_arg_match }
+};
+#define ARG_CHECK_INFOS_SIZE R_ARR_SIZEOF(arg_check_infos)
+
+static
+const struct arg_check_info* arg_check_info(r_obj* type) {
+  const char* c_type = r_str_c_string(type);
+
+  for (size_t i = 0; i < ARG_CHECK_INFOS_SIZE; ++i) {
+    if (strcmp(c_type, arg_check_infos[i].name) == 0) {
+      return &arg_check_infos[i];
+    }
+  }
+
+  r_abort("`types` can't contain unknown type \"%s\".", c_type);
+}
+
+static
+bool arg_check_type(r_obj* x, enum arg_check_type type, r_ssize size) {
+  switch (type) {
+  case ARG_CHECK_string: return r_is_character(x, 1) && r_chr_get(x, 0) != r_globals.na_str;
+  case ARG_CHECK_bool: return r_is_logical(x, 1) && r_lgl_get(x, 0) != r_globals.na_lgl;
+  case ARG_CHECK_character: return r_is_character(x, size);
+  case ARG_CHECK_logical: return r_is_logical(x, size);
+  case ARG_CHECK_integer: return r_is_integer(x, size, -1);
+  case ARG_CHECK_integerish: return r_is_integerish(x, size, -1);
+  case ARG_CHECK_double: return r_is_double(x, size, -1);
+  case ARG_CHECK_list: return r_typeof(x) == R_TYPE_list && (size < 0 || r_length(x) == size);
+  case ARG_CHECK_arg_match: return true;
+  default: r_stop_unreached("arg_check_type");
+  }
+}
+
+static
+r_ssize arg_check_size(r_obj* sizes, r_ssize i) {
+  switch (r_typeof(sizes)) {
+  case R_TYPE_logical: {
+    int size = r_lgl_get(sizes, i);
+    if (size == r_globals.na_lgl) {
+      return -1;
+    }
+    break;
+  }
+  case R_TYPE_integer: {
+    int size = r_int_get(sizes, i);
+    if (size == r_globals.na_int) {
+      return -1;
+    }
+    return size;
+  }
+  case R_TYPE_double: {
+    double size = r_dbl_get(sizes, i);
+    if (isnan(size)) {
+      return -1;
+    }
+    return (r_ssize) size;
+  }
+  default:
+    break;
+  }
+
+  r_abort("`size` must be an integer vector.");
+}
+
+static
+void arg_check_recyclable(r_obj* x, r_ssize n, const char* arg) {
+  r_ssize x_n = r_length(x);
+  if (x_n != 1 && x_n != n) {
+    r_abort("`%s` must have size 1 or %d, not %d.", arg, (int) n, (int) x_n);
+  }
+}
+
+static inline
+r_ssize recycled(r_obj* x, r_ssize i) {
+  return r_length(x) == 1 ? 0 : i;
+}
+
+r_obj* ffi_check_args(r_obj* args,
+                      r_obj* types,
+                      r_obj* sizes,
+                      r_obj* allow_na,
+                      r_obj* allow_null,
+                      r_obj* values) {
+  if (r_typeof(args) != R_TYPE_list) {
+    r_abort("`args` must be a list.");
+  }
+  r_ssize n = r_length(args);
+
+  r_obj* nms = r_names(args);
+  if (nms == r_null) {
+    r_abort("`args` must be named.");
+  }
+
+  if (r_typeof(types) != R_TYPE_character) {
+    r_abort("`types` must be a character vector.");
+  }
+  if (r_typeof(allow_na) != R_TYPE_logical) {
+    r_abort("`allow_na` must be a logical vector.");
+  }
+  if (r_typeof(allow_null) != R_TYPE_logical) {
+    r_abort("`allow_null` must be a logical vector.");
+  }
+  if (values != r_null && (r_typeof(values) != R_TYPE_list || r_length(values) != n)) {
+    r_abort("`values` must be `NULL` or a list of the same size as `args`.");
+  }
+
+  arg_check_recyclable(types, n, "types");
+  arg_check_recyclable(sizes, n, "size");
+  arg_check_recyclable(allow_na, n, "allow_na");
+  arg_check_recyclable(allow_null, n, "allow_null");
+
+  r_obj* const * v_args = r_list_cbegin(args);
+  r_obj* const * v_nms = r_chr_cbegin(nms);
+  r_obj* const * v_types = r_chr_cbegin(types);
+  const int* v_allow_na = r_lgl_cbegin(allow_na);
+  const int* v_allow_null = r_lgl_cbegin(allow_null);
+
+  // Only copied if a matched argument needs to be normalised
+  r_obj* out = args;
+  r_keep_t out_pi;
+  KEEP_HERE(out, &out_pi);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* x = v_args[i];
+    const char* nm = r_str_c_string(v_nms[i]);
+    const struct arg_check_info* info = arg_check_info(v_types[recycled(types, i)]);
+
+    if (x == r_null) {
+      if (v_allow_null[recycled(allow_null, i)]) {
+        continue;
+      }
+      if (info->type != ARG_CHECK_arg_match) {
+        r_abort("`%s` must be %s, not `NULL`.", nm, info->desc);
+      }
+    }
+
+    if (info->type == ARG_CHECK_arg_match) {
+      if (values == r_null) {
+        r_abort("`values` must be supplied to check `%s`.", nm);
+      }
+      r_obj* arg_nm = KEEP(r_str_as_character(v_nms[i]));
+      r_obj* matched = arg_match(x, r_list_get(values, i), arg_nm);
+      FREE(1);
+
+      if (matched != x) {
+        if (out == args) {
+          out = r_clone(args);
+          KEEP_AT(out, out_pi);
+        }
+        r_list_poke(out, i, matched);
+      }
+      continue;
+    }
+
+    r_ssize size = arg_check_size(sizes, recycled(sizes, i));
+
+    if (!arg_check_type(x, info->type, size)) {
+      const char* or_null = v_allow_null[recycled(allow_null, i)] ? " or `NULL`" : "";
+
+      if (size < 0 || info->type == ARG_CHECK_string || info->type == ARG_CHECK_bool) {
+        r_abort("`%s` must be %s%s.", nm, info->desc, or_null);
+      } else {
+        r_abort("`%s` must be %s of size %d%s.", nm, info->desc, (int) size, or_null);
+      }
+    }
+
+    if (!v_allow_na[recycled(allow_na, i)] &&
+        info->type != ARG_CHECK_list &&
+        r_vec_find_na(x, 0) != r_length(x)) {
+      r_abort("`%s` can't contain missing values.", nm);
+    }
+  }
+
+  FREE(1);
+  return out;
+}
+
+#undef ARG_CHECK_INFOS_SIZE
+
 void rlang_init_arg(r_obj* ns) {
   stop_arg_match_call = r_parse("stop_arg_match(x, y, z)");
   r_preserve(stop_arg_match_call);
 
   arg_nm_sym = r_sym("arg_nm");
+
+  arg_matcher_names = r_preserve_global(r_chr_n((const char* []) { "values", "dict" }, 2));
+  arg_matcher_class = r_preserve_global(r_chr("rlang_arg_matcher"));
+  enquos_args_class = r_preserve_global(r_chr_n((const char* []) { "quosures", "list" }, 2));
 }
@@ -254,6 +254,10 @@ bool is_unary_plusminus(r_obj* x) {
  * @lower_root: The expression whose RHS is attached to the LHS of @lower_pivot.
  * @root_parent: Node whose CAR should be reattached to @upper_pivot
  *   after rotation.
+ * @p_injections: Set of the calls that contain an injection site,
+ *   computed once before expanding. Expansion skips the operands
+ *   that are not in the set instead of rescanning them. This field is
+ *   not reset by initialise_rotation_info().
  */
 struct ast_rotation_info {
   enum r_operator upper_pivot_op;
@@ -263,6 +267,7 @@ struct ast_rotation_info {
   r_obj* upper_root;
   r_obj* lower_root;
   r_obj* root_parent;
+  struct r_dict* p_injections;
 };
 
 static void initialise_rotation_info(struct ast_rotation_info* info) {
@@ -278,6 +283,98 @@ static void initialise_rotation_info(struct ast_rotation_info* info) {
 static r_obj* node_list_interp_fixup(r_obj* x, r_obj* parent, r_obj* env,
                                      struct ast_rotation_info* rotation_info,
                                      bool expand_lhs);
+static r_obj* fixup_interp_impl(r_obj* x, r_obj* env, struct r_dict* p_injections);
+
+struct injections_frame {
+  r_obj* call;
+  r_obj* node;
+  bool found;
+};
+
+/**
+ * fixup_injections() - Find the calls that contain an injection site
+ *
+ * @x: An expression.
+ *
+ * Visits each call of @x once in post-order and adds the calls that
+ * are injection sites, or that have a descendant that is, to the
+ * returned set. The subtrees of injection sites are visited too
+ * because rotations expand the operand of `!!` as an operation.
+ * Operators that might need a fixup are not sites by themselves.
+ */
+static struct r_dict* fixup_injections(r_obj* x) {
+  struct r_dict* p_injections = r_new_dict(16);
+  KEEP(p_injections->shelter);
+
+  struct r_dyn_array* p_stack = r_new_dyn_array(sizeof(struct injections_frame), 16);
+  KEEP(p_stack->shelter);
+
+  struct injections_frame root = { .call = x, .node = x, .found = false };
+  if (r_typeof(x) == R_TYPE_call) {
+    r_arr_push_back(p_stack, &root);
+  }
+
+  while (p_stack->count) {
+    struct injections_frame* p_frame = r_arr_last(p_stack);
+
+    if (p_frame->node == r_null) {
+      struct injections_frame frame = *p_frame;
+      r_arr_pop_back(p_stack);
+
+      if (frame.found) {
+        r_dict_put(p_injections, frame.call, r_true);
+        if (p_stack->count) {
+          ((struct injections_frame*) r_arr_last(p_stack))->found = true;
+        }
+      }
+      continue;
+    }
+
+    r_obj* arg = r_node_car(p_frame->node);
+    p_frame->node = r_node_cdr(p_frame->node);
+
+    if (r_typeof(arg) != R_TYPE_call) {
+      continue;
+    }
+
+    struct injection_info info = which_expansion_op_impl(arg, false, false);
+    bool plain_fixup = info.op == INJECTION_OP_fixup && info.operand == r_null;
+
+    bool site =
+      (info.op != INJECTION_OP_none && !plain_fixup) ||
+      r_typeof(r_node_car(arg)) == R_TYPE_character;
+
+    // Invalidates `p_frame`
+    struct injections_frame frame = { .call = arg, .node = arg, .found = site };
+    r_arr_push_back(p_stack, &frame);
+  }
+
+  FREE(2);
+  return p_injections;
+}
+
+/**
+ * fixup_expand() - Expand an operand
+ *
+ * @x: An operand of a problematic operation.
+ * @env: The unquoting environment.
+ * @info: See &struct ast_rotation_info.
+ *
+ * Operands without injection sites are returned as is. Nested
+ * problematic operations reuse the set of injections of @info.
+ */
+static r_obj* fixup_expand(r_obj* x, r_obj* env, struct ast_rotation_info* info) {
+  if (r_typeof(x) != R_TYPE_call || !r_dict_has(info->p_injections, x)) {
+    return x;
+  }
+
+  struct injection_info injection = which_expansion_op(x, false);
+  if (injection.op == INJECTION_OP_fixup && injection.operand == r_null) {
+    return fixup_interp_impl(x, env, info->p_injections);
+  } else {
+    return call_interp_impl(x, env, injection);
+  }
+}
 
 /**
  * maybe_rotate() - Rotate if we found a pivot
@@ -333,13 +430,26 @@ static r_obj* maybe_rotate(r_obj* op, r_obj* env, struct ast_rotation_info* info
  * there is a &struct ast_rotation_info on the stack.
  */
 r_obj* fixup_interp(r_obj* x, r_obj* env) {
-  // Happens with constructed calls without arguments such as `/`()
-  if (r_node_cdr(x) == r_null) {
+  struct r_dict* p_injections = fixup_injections(x);
+  KEEP(p_injections->shelter);
+
+  r_obj* out = fixup_interp_impl(x, env, p_injections);
+
+  FREE(1);
+  return out;
+}
+
+static r_obj* fixup_interp_impl(r_obj* x, r_obj* env, struct r_dict* p_injections) {
+  // Happens with constructed calls without arguments such as `/`().
+  // Operations without injections, e.g. the LHS of a long chain of
+  // `+` calls, don't need any changes.
+  if (r_node_cdr(x) == r_null || !r_dict_has(p_injections, x)) {
     return x;
   }
 
   struct ast_rotation_info rotation_info;
   initialise_rotation_info(&rotation_info);
+  rotation_info.p_injections = p_injections;
 
   // Look for problematic !! calls and expand arguments on the way.
   // If a pivot is found rotate it around `x`.
@@ -359,23 +469,29 @@ r_obj* fixup_interp(r_obj* x, r_obj* env) {
  * subsequent `!!` call.
  */
 r_obj* fixup_interp_first(r_obj* x, r_obj* env) {
+  struct ast_rotation_info rotation_info;
+  initialise_rotation_info(&rotation_info);
+
+  rotation_info.p_injections = fixup_injections(x);
+  KEEP(rotation_info.p_injections->shelter);
+
   r_obj* parent = NULL; // `parent` will always be initialised in the loop
   r_obj* target = x;
   while (is_problematic_op((parent = target, target = r_node_cadr(target)))
          && !is_unary(target)) {
     r_obj* rhs = r_node_cddr(target);
-    r_node_poke_car(rhs, call_interp(r_node_car(rhs), env));
+    r_node_poke_car(rhs, fixup_expand(r_node_car(rhs), env, &rotation_info));
   };
 
   // Unquote target
   r_node_poke_cadr(parent, r_eval(target, env));
 
   // Expand the new root but no need to expand LHS as we just unquoted it
-  struct ast_rotation_info rotation_info;
-  initialise_rotation_info(&rotation_info);
-
   node_list_interp_fixup(x, NULL, env, &rotation_info, false);
-  return maybe_rotate(x, env, &rotation_info);
+  r_obj* out = maybe_rotate(x, env, &rotation_info);
+
+  FREE(1);
+  return out;
 }
 
 /**
@@ -453,7 +569,7 @@ static void find_lower_pivot(r_obj* x, r_obj* parent_node, r_obj* env,
   // consecutive rotations needed. The upper pivot's RHS will be
   // expanded after the current rotation is complete.
   if (x != info->upper_pivot) {
-    r_node_poke_car(rhs_node, call_interp(r_node_car(rhs_node), env));
+    r_node_poke_car(rhs_node, fixup_expand(r_node_car(rhs_node), env, info));
   }
 
   r_obj* lhs = r_node_car(lhs_node);
@@ -513,7 +629,7 @@ static r_obj* node_list_interp_fixup(r_obj* x, r_obj* parent, r_obj* env,
 
   if (expand_lhs) {
     // Expand the LHS normally, it never needs changes in the AST
-    r_node_poke_car(lhs_node, call_interp(r_node_car(lhs_node), env));
+    r_node_poke_car(lhs_node, fixup_expand(r_node_car(lhs_node), env, info));
   }
 
   node_list_interp_fixup_rhs(rhs, rhs_node, x, env, info);
@@ -538,6 +654,11 @@ static void node_list_interp_fixup_rhs(r_obj* rhs, r_obj* rhs_node, r_obj* paren
     return;
   }
 
+  // Nothing to expand or rotate
+  if (!r_dict_has(info->p_injections, rhs)) {
+    return;
+  }
+
   // An upper pivot is an operand of a !! call that is a binary
   // operation whose precedence is problematic (between prec(`!`) and
   // prec(`!!`))
@@ -579,5 +700,5 @@ static void node_list_interp_fixup_rhs(r_obj* rhs, r_obj* rhs_node, r_obj* paren
 
   // RHS is not a binary operation that might need changes in the AST
   // so expand it as usual
-  r_node_poke_car(rhs_node, call_interp(rhs, env));
+  r_node_poke_car(rhs_node, fixup_expand(rhs, env, info));
 }
@@ -1,5 +1,6 @@
 #include <rlang.h>
 #include "internal.h"
+#include "utils.h"
 #include "vec.h"
 
 static r_obj* c_fn = NULL;
@@ -34,9 +35,7 @@ r_obj* rlang_names2(r_obj* x, r_obj* env) {
   }
 
   if (nms == r_null) {
-    r_ssize n = r_length(x);
-    nms = KEEP(r_alloc_character(n));
-    r_chr_fill(nms, r_globals.empty_str, n);
+    nms = KEEP(rlang_new_empty_names(r_length(x)));
   } else {
     nms = KEEP(rlang_replace_na(nms, r_chrs.empty_string));
   }
@@ -72,7 +71,14 @@ static inline r_obj* eval_as_character(r_obj* x, r_obj* env);
 static inline r_obj* set_names_dispatch(r_obj* x, r_obj* nm, r_obj* env);
 static inline r_ssize length_dispatch(r_obj* x, r_obj* env);
 
+static r_obj* set_names_bare(r_obj* x, r_obj* nm, r_obj* env);
+
 r_obj* rlang_set_names(r_obj* x, r_obj* mold, r_obj* nm, r_obj* env) {
+  r_obj* out = set_names_bare(x, nm, env);
+  if (out) {
+    return out;
+  }
+
   int n_kept = 0;
 
   r_obj* dots = KEEP_N(rlang_dots(env), &n_kept);
@@ -122,6 +128,46 @@ r_obj* rlang_set_names(r_obj* x, r_obj* mold, r_obj* nm, r_obj* env) {
   return x;
 }
 
+// `names<-()` shallow duplicates referenced vectors using ALTREP
+// wrappers from this size on. Below that, or when `x` is only
+// referenced by the promise of `set_names()`, setting the names
+// directly is as cheap and avoids evaluating R calls.
+#define SET_NAMES_WRAPPER_SIZE 64
+
+// Returns `NULL` when the inputs need dispatch or conversion
+static
+r_obj* set_names_bare(r_obj* x, r_obj* nm, r_obj* env) {
+  if (r_is_object(x) || !r_is_vector(x, -1)) {
+    return NULL;
+  }
+  if (nm != r_null && (r_typeof(nm) != R_TYPE_character || r_attrib(nm) != r_null)) {
+    return NULL;
+  }
+  if (r_env_find(env, r_syms.dots) != r_missing_arg) {
+    return NULL;
+  }
+
+  r_ssize n = r_length(x);
+  if (nm != r_null && r_length(nm) != n) {
+    r_abort("`nm` must be `NULL` or a character vector the same length as `x`");
+  }
+
+  if (MAYBE_SHARED(x) || x == nm) {
+    if (n >= SET_NAMES_WRAPPER_SIZE) {
+      return NULL;
+    }
+    x = r_clone(x);
+  }
+
+  KEEP(x);
+  r_attrib_poke_names(x, nm);
+
+  FREE(1);
+  return x;
+}
+
+#undef SET_NAMES_WRAPPER_SIZE
+
 static
 r_obj* eval_fn_dots(r_obj* fn, r_obj* x, r_obj* dots, r_obj* env) {
   r_obj* args = KEEP(r_new_node(r_syms.dot_x, dots));
@@ -189,6 +235,155 @@ r_ssize length_dispatch(r_obj* x, r_obj* env) {
 }
 
 
+/*
+ * Empty names of unnamed vectors. Above `EMPTY_NAMES_ALTREP_MIN_SIZE`
+ * they are ALTREP vectors that only store their length in `data1`.
+ * Elements are returned without allocating. The vector is
+ * materialised in `data2` when its data pointer is requested or when
+ * an element is modified. Consumers that check names, like
+ * `nms_which_duplicated()`, can skip unmaterialised vectors with
+ * `rlang_is_empty_names()`.
+ */
+
+#define EMPTY_NAMES_ALTREP_MIN_SIZE 256
+
+static
+r_obj* empty_names_alloc(r_ssize n) {
+  r_obj* out = KEEP(r_alloc_character(n));
+  r_chr_fill(out, r_globals.empty_str, n);
+  FREE(1);
+  return out;
+}
+
+#if R_HAS_ALTREP
+
+static R_altrep_class_t empty_names_class;
+
+static
+R_xlen_t empty_names_length(r_obj* x) {
+  return r_as_ssize(R_altrep_data1(x));
+}
+
+static
+r_obj* empty_names_materialise(r_obj* x) {
+  r_obj* out = R_altrep_data2(x);
+  if (out != r_null) {
+    return out;
+  }
+
+  out = KEEP(empty_names_alloc(empty_names_length(x)));
+  R_set_altrep_data2(x, out);
+
+  FREE(1);
+  return out;
+}
+
+static
+r_obj* empty_names_elt(r_obj* x, R_xlen_t i) {
+  r_obj* data = R_altrep_data2(x);
+  if (data == r_null) {
+    return r_globals.empty_str;
+  }
+  return r_chr_get(data, i);
+}
+
+static
+void empty_names_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_chr_poke(empty_names_materialise(x), i, value);
+}
+
+static
+void* empty_names_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(empty_names_materialise(x));
+}
+
+static
+const void* empty_names_dataptr_or_null(r_obj* x) {
+  r_obj* data = R_altrep_data2(x);
+  if (data == r_null) {
+    return NULL;
+  }
+  return DATAPTR_RO(data);
+}
+
+static
+int empty_names_no_na(r_obj* x) {
+  return R_altrep_data2(x) == r_null;
+}
+
+static
+int empty_names_is_sorted(r_obj* x) {
+  return (R_altrep_data2(x) == r_null) ? SORTED_INCR : UNKNOWN_SORTEDNESS;
+}
+
+// Unmaterialised copies share the length
+static
+r_obj* empty_names_duplicate(r_obj* x, Rboolean deep) {
+  if (R_altrep_data2(x) != r_null) {
+    return NULL;
+  }
+  return R_new_altrep(empty_names_class, R_altrep_data1(x), r_null);
+}
+
+static
+Rboolean empty_names_inspect(r_obj* x,
+                             int pre,
+                             int deep,
+                             int pvec,
+                             void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_empty_names (len=%ld, materialised=%s)\n",
+          (long) empty_names_length(x),
+          R_altrep_data2(x) == r_null ? "F" : "T");
+  return TRUE;
+}
+
+r_obj* rlang_new_empty_names(r_ssize n) {
+  if (n < EMPTY_NAMES_ALTREP_MIN_SIZE) {
+    return empty_names_alloc(n);
+  }
+
+  r_obj* data1 = KEEP(r_len(n));
+  r_obj* out = R_new_altrep(empty_names_class, data1, r_null);
+
+  FREE(1);
+  return out;
+}
+
+bool rlang_is_empty_names(r_obj* x) {
+  return
+    ALTREP(x) &&
+    R_altrep_inherits(x, empty_names_class) &&
+    R_altrep_data2(x) == r_null;
+}
+
+void rlang_init_attr_altrep(DllInfo* dll) {
+  empty_names_class = R_make_altstring_class("rlang_empty_names", "rlang", dll);
+
+  R_set_altrep_Length_method(empty_names_class, &empty_names_length);
+  R_set_altrep_Inspect_method(empty_names_class, &empty_names_inspect);
+  R_set_altrep_Duplicate_method(empty_names_class, &empty_names_duplicate);
+  R_set_altvec_Dataptr_method(empty_names_class, &empty_names_dataptr);
+  R_set_altvec_Dataptr_or_null_method(empty_names_class, &empty_names_dataptr_or_null);
+  R_set_altstring_Elt_method(empty_names_class, &empty_names_elt);
+  R_set_altstring_Set_elt_method(empty_names_class, &empty_names_set_elt);
+  R_set_altstring_No_NA_method(empty_names_class, &empty_names_no_na);
+  R_set_altstring_Is_sorted_method(empty_names_class, &empty_names_is_sorted);
+}
+
+#else
+
+r_obj* rlang_new_empty_names(r_ssize n) {
+  return empty_names_alloc(n);
+}
+bool rlang_is_empty_names(r_obj* x) {
+  return false;
+}
+void rlang_init_attr_altrep(DllInfo* dll) { }
+
+#endif
+
+#undef EMPTY_NAMES_ALTREP_MIN_SIZE
+
 void rlang_init_attr(r_obj* ns) {
   c_fn = r_eval(r_sym("c"), r_base_env);
 
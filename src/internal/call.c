@@ -1,6 +1,48 @@
 #include <rlang.h>
 #include "internal.h"
 
+/*
+ * Code generators call `call2()` with `.ns` in tight loops. The
+ * `ns::fn` heads are cached by function symbol in a dictionary whose
+ * values are pairlists of heads for each namespace, usually a single
+ * one. Symbols are never collected so the cache doesn't need to be
+ * invalidated. The heads are shared across calls and are marked as
+ * not mutable so that R duplicates them before modification.
+ */
+
+#define CALL2_HEAD_CACHE_INIT_SIZE 256
+#define CALL2_HEAD_CACHE_MAX_SIZE 4096
+
+static struct r_dict* p_call2_head_cache = NULL;
+static r_ssize call2_head_cache_size = 0;
+
+static
+r_obj* call2_ns_head(r_obj* ns, r_obj* fn) {
+  r_obj* heads = r_dict_get0(p_call2_head_cache, fn);
+  if (heads == NULL) {
+    heads = r_null;
+  }
+
+  for (r_obj* node = heads; node != r_null; node = r_node_cdr(node)) {
+    r_obj* head = r_node_car(node);
+    if (r_node_cadr(head) == ns) {
+      return head;
+    }
+  }
+
+  r_obj* head = KEEP(r_call3(r_syms.colon2, ns, fn));
+
+  if (call2_head_cache_size < CALL2_HEAD_CACHE_MAX_SIZE) {
+    r_mark_shared(head);
+    heads = KEEP(r_new_node(head, heads));
+    r_dict_put(p_call2_head_cache, fn, heads);
+    ++call2_head_cache_size;
+    FREE(1);
+  }
+
+  FREE(1);
+  return head;
+}
 
 static bool is_callable(r_obj* x) {
   switch (r_typeof(x)) {
@@ -25,8 +67,6 @@ r_obj* rlang_call2(r_obj* fn, r_obj* args, r_obj* ns) {
     r_abort("Can't create call to non-callable object");
   }
 
-  int n_kept = 0;
-
   if (ns != r_null) {
     if (!r_is_string(ns)) {
       r_abort("`ns` must be a string");
@@ -34,14 +74,11 @@ r_obj* rlang_call2(r_obj* fn, r_obj* args, r_obj* ns) {
     if (r_typeof(fn) != R_TYPE_symbol) {
       r_abort("`fn` must be a string or symbol when a namespace is supplied");
     }
-    ns = r_sym(r_chr_get_c_string(ns, 0));
-    fn = KEEP_N(r_call3(r_syms.colon2, ns, fn), &n_kept);
+    ns = r_str_as_symbol(r_chr_get(ns, 0));
+    fn = call2_ns_head(ns, fn);
   }
 
-  r_obj* out = r_new_call(fn, args);
-
-  FREE(n_kept);
-  return out;
+  return r_new_call(fn, args);
 }
 
 r_obj* rlang_ext2_call2(r_obj* call, r_obj* op, r_obj* args, r_obj* env) {
@@ -56,3 +93,175 @@ r_obj* rlang_ext2_call2(r_obj* call, r_obj* op, r_obj* args, r_obj* env) {
   FREE(3);
   return out;
 }
+
+
+/*
+ * Matches the arguments of `call` to the formals of the closure `fn`
+ * like `match.call()`. Tagged arguments are matched exactly, then
+ * partially to the formals before `...`, and the remaining untagged
+ * arguments are matched by position to the formals before `...`.
+ * Unmatched arguments are spliced in place of `...` in their
+ * original order. The arguments of the output are in the order of
+ * the formals.
+ *
+ * Returns `NULL` when the call can't be matched without going
+ * through R: arguments forwarded with `...`, empty arguments, calls
+ * with more than `CALL_MATCH_MAX_ARGS` arguments, and matching
+ * errors. The caller should then use `match.call()`, which also
+ * produces the errors.
+ */
+
+#define CALL_MATCH_MAX_ARGS 64
+
+static
+bool call_match_is_prefix(r_obj* tag, r_obj* formal) {
+  const char* tag_str = r_sym_c_string(tag);
+  const char* formal_str = r_sym_c_string(formal);
+  return strncmp(formal_str, tag_str, strlen(tag_str)) == 0;
+}
+
+r_obj* ffi_call_match(r_obj* call, r_obj* fn) {
+  if (r_typeof(call) != R_TYPE_call || r_typeof(fn) != R_TYPE_closure) {
+    return r_null;
+  }
+
+  r_obj* formals = FORMALS(fn);
+  r_ssize n_formals = r_length(formals);
+  r_ssize n_args = r_length(r_node_cdr(call));
+
+  if (n_formals > CALL_MATCH_MAX_ARGS || n_args > CALL_MATCH_MAX_ARGS) {
+    return r_null;
+  }
+
+  r_obj* v_formals[CALL_MATCH_MAX_ARGS];
+  r_obj* v_args[CALL_MATCH_MAX_ARGS];
+  r_ssize v_matched[CALL_MATCH_MAX_ARGS];
+  bool v_exact[CALL_MATCH_MAX_ARGS];
+  bool v_used[CALL_MATCH_MAX_ARGS];
+
+  r_ssize i_dots = -1;
+  r_ssize n_before_dots = n_formals;
+
+  r_obj* node = formals;
+  for (r_ssize i = 0; i < n_formals; ++i, node = r_node_cdr(node)) {
+    v_formals[i] = r_node_tag(node);
+    v_matched[i] = -1;
+    v_exact[i] = false;
+
+    if (v_formals[i] == r_syms.dots && i_dots < 0) {
+      i_dots = i;
+      n_before_dots = i;
+    }
+  }
+
+  node = r_node_cdr(call);
+  for (r_ssize j = 0; j < n_args; ++j, node = r_node_cdr(node)) {
+    r_obj* arg = r_node_car(node);
+    if (arg == r_syms.dots || arg == r_missing_arg) {
+      return r_null;
+    }
+    v_args[j] = node;
+    v_used[j] = false;
+  }
+
+  // Exact matching
+  for (r_ssize j = 0; j < n_args; ++j) {
+    r_obj* tag = r_node_tag(v_args[j]);
+    if (tag == r_null) {
+      continue;
+    }
+
+    for (r_ssize i = 0; i < n_formals; ++i) {
+      if (i == i_dots || v_formals[i] != tag) {
+        continue;
+      }
+      if (v_matched[i] >= 0) {
+        return r_null;
+      }
+      v_matched[i] = j;
+      v_exact[i] = true;
+      v_used[j] = true;
+      break;
+    }
+  }
+
+  // Partial matching of the formals before `...`
+  for (r_ssize j = 0; j < n_args; ++j) {
+    r_obj* tag = r_node_tag(v_args[j]);
+    if (v_used[j] || tag == r_null) {
+      continue;
+    }
+
+    for (r_ssize i = 0; i < n_before_dots; ++i) {
+      if (v_exact[i] || !call_match_is_prefix(tag, v_formals[i])) {
+        continue;
+      }
+      if (v_used[j] || v_matched[i] >= 0) {
+        return r_null;
+      }
+      v_matched[i] = j;
+      v_used[j] = true;
+    }
+  }
+
+  // Positional matching of the formals before `...`
+  r_ssize pos = 0;
+  for (r_ssize i = 0; i < n_before_dots; ++i) {
+    if (v_matched[i] >= 0) {
+      continue;
+    }
+    while (pos < n_args && (v_used[pos] || r_node_tag(v_args[pos]) != r_null)) {
+      ++pos;
+    }
+    if (pos == n_args) {
+      break;
+    }
+    v_matched[i] = pos;
+    v_used[pos] = true;
+  }
+
+  // Unused arguments are an error without `...`
+  if (i_dots < 0) {
+    for (r_ssize j = 0; j < n_args; ++j) {
+      if (!v_used[j]) {
+        return r_null;
+      }
+    }
+  }
+
+  // Every argument is either matched or spliced at `...`
+  r_obj* out = KEEP(r_new_call(r_node_car(call), r_alloc_pairlist(n_args)));
+  r_obj* out_node = r_node_cdr(out);
+
+  for (r_ssize i = 0; i < n_formals; ++i) {
+    if (i == i_dots) {
+      for (r_ssize j = 0; j < n_args; ++j) {
+        if (v_used[j]) {
+          continue;
+        }
+        r_obj* arg = v_args[j];
+        r_node_poke_car(out_node, r_node_car(arg));
+        r_node_poke_tag(out_node, r_node_tag(arg));
+        out_node = r_node_cdr(out_node);
+      }
+      continue;
+    }
+
+    if (v_matched[i] < 0) {
+      continue;
+    }
+
+    r_obj* arg = v_args[v_matched[i]];
+    r_node_poke_car(out_node, r_node_car(arg));
+    r_node_poke_tag(out_node, v_formals[i]);
+    out_node = r_node_cdr(out_node);
+  }
+
+  FREE(1);
+  return out;
+}
+
+void rlang_init_call(r_obj* ns) {
+  p_call2_head_cache = r_new_dict(CALL2_HEAD_CACHE_INIT_SIZE);
+  r_preserve(p_call2_head_cache->shelter);
+}
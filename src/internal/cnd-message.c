@@ -0,0 +1,120 @@
+#include <rlang.h>
+#include <string.h>
+
+/*
+ * Bullets are assembled in a single byte buffer. Strings are
+ * translated to UTF-8 so that the result can be marked as such. The
+ * symbols of the bullets, which depend on cli and crayon, are
+ * computed on the R side and passed as a named character vector.
+ */
+
+enum bullet_kind {
+  BULLET_none = 0,
+  BULLET_break,
+  BULLET_info,
+  BULLET_cross,
+  BULLET_tick,
+  BULLET_bullet,
+  BULLET_warning
+};
+
+static
+enum bullet_kind bullet_kind(r_obj* name) {
+  const char* c_name = r_str_c_string(name);
+
+  if (c_name[0] == '\0') {
+    return BULLET_none;
+  }
+  if (c_name[1] == '\0') {
+    switch (c_name[0]) {
+    case ' ': return BULLET_break;
+    case 'i': return BULLET_info;
+    case 'x': return BULLET_cross;
+    case 'v': return BULLET_tick;
+    case '*': return BULLET_bullet;
+    case '!': return BULLET_warning;
+    }
+  }
+
+  r_abort("Bullet names must be one of \"i\", \"x\", \"v\", \"*\", \"!\", or \" \".");
+}
+
+static inline
+void buf_push_str(struct r_dyn_array* p_buf, r_obj* str) {
+  const char* c_str = (str == r_globals.na_str) ? "NA" : Rf_translateCharUTF8(str);
+  r_arr_push_back_n(p_buf, c_str, strlen(c_str));
+}
+static inline
+void buf_push_c(struct r_dyn_array* p_buf, const char* c_str) {
+  r_arr_push_back_n(p_buf, c_str, strlen(c_str));
+}
+
+// `symbols` contains the info, cross, tick, bullet and warning
+// symbols in that order
+r_obj* ffi_format_bullets(r_obj* x, r_obj* symbols, r_obj* header) {
+  if (r_typeof(x) != R_TYPE_character) {
+    r_abort("`x` must be a character vector.");
+  }
+  if (r_typeof(symbols) != R_TYPE_character || r_length(symbols) != 5) {
+    r_stop_internal("ffi_format_bullets", "`symbols` must be a character vector of size 5.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_chr_cbegin(x);
+  r_obj* const * v_symbols = r_chr_cbegin(symbols);
+
+  bool has_header = r_as_bool(header);
+  r_ssize start = has_header ? 1 : 0;
+  if (n <= start) {
+    return x;
+  }
+
+  r_obj* nms = r_names(x);
+  r_obj* const * v_nms = (nms == r_null) ? NULL : r_chr_cbegin(nms);
+
+  // Treat unnamed vectors as all bullets
+  bool all_bullets = true;
+  if (v_nms) {
+    for (r_ssize i = start; i < n; ++i) {
+      if (v_nms[i] != r_globals.empty_str) {
+        all_bullets = false;
+        break;
+      }
+    }
+  }
+
+  struct r_dyn_array* p_buf = r_new_dyn_vector(R_TYPE_raw, 256);
+  KEEP(p_buf->shelter);
+
+  if (has_header) {
+    buf_push_str(p_buf, v_x[0]);
+  }
+
+  for (r_ssize i = start; i < n; ++i) {
+    if (i) {
+      buf_push_c(p_buf, "\n");
+    }
+
+    enum bullet_kind kind = all_bullets ? BULLET_bullet : bullet_kind(v_nms[i]);
+
+    switch (kind) {
+    case BULLET_none:
+      break;
+    case BULLET_break:
+      buf_push_c(p_buf, "  ");
+      break;
+    default:
+      buf_push_str(p_buf, v_symbols[kind - BULLET_info]);
+      buf_push_c(p_buf, " ");
+      break;
+    }
+
+    buf_push_str(p_buf, v_x[i]);
+  }
+
+  const char* v_buf = (const char*) r_arr_cbegin(p_buf);
+  r_obj* out = r_str_as_character(Rf_mkCharLenCE(v_buf, p_buf->count, CE_UTF8));
+
+  FREE(1);
+  return out;
+}
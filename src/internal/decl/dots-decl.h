@@ -2,14 +2,32 @@ static r_obj* as_label_call;
 static r_obj* empty_spliced_arg;
 static r_obj* splice_box_attrib;
 static r_obj* quosures_attrib;
-static r_obj* auto_name_call;
+static struct rlang_addr_cache* p_auto_name_cache;
 static r_obj* glue_unquote_fn;
+static struct rlang_addr_cache* p_glue_templates;
+static r_obj* glue_template_none;
+static r_obj* glue_template_fallback;
 
 r_obj* rlang_ns_get(const char* name);
 
+static
+r_obj* glue_template(r_obj* str);
+
+static
+r_obj* glue_template_compile(r_obj* str);
+
+static
+r_obj* glue_template_interp(r_obj* tmpl, r_obj* env);
+
+static
+const char* glue_template_format(r_obj* x, char* buf, size_t n);
+
 static
 bool should_auto_name(r_obj* named);
 
+static
+r_obj* auto_name_label(r_obj* x);
+
 static
 int arg_match_ignore_empty(r_obj* ignore_empty);
 
@@ -0,0 +1,140 @@
+#include <rlang.h>
+
+/*
+ * Exit handlers of a frame are stored in the `rlang_deferred`
+ * attribute of the frame as a pairlist whose elements are
+ * `(expr . env)` cells. A single `on.exit()` hook is registered with
+ * the first handler of a frame. It runs the handlers in order and
+ * removes the attribute. Further handlers are added to the list
+ * without evaluating R code.
+ *
+ * The global environment never exits. Its handlers are stored in the
+ * `handlers` attribute as a list of `list(expr = , envir = )`, the
+ * layout of withr, so that `withr::deferred_run()` can run them.
+ */
+
+static r_obj* deferred_sym = NULL;
+static r_obj* global_handlers_sym = NULL;
+static r_obj* global_handler_nms = NULL;
+static r_obj* defer_run_call = NULL;
+static r_obj* defer_run_native = NULL;
+static r_obj* defer_eval_call = NULL;
+
+static
+void defer_register_hook(r_obj* frame) {
+  r_obj* hook = KEEP(r_call3(defer_run_call, defer_run_native, frame));
+  r_on_exit(hook, frame);
+  FREE(1);
+}
+
+static
+void defer_global(r_obj* expr, r_obj* env, bool front) {
+  r_obj* handlers = r_attrib_get(r_global_env, global_handlers_sym);
+  if (handlers == r_null) {
+    r_inform("%s\n%s\n%s",
+             "Setting deferred event(s) on global environment.",
+             "  * Execute (and clear) with `withr::deferred_run()`.",
+             "  * Clear (without executing) with `withr::deferred_clear()`.");
+  }
+
+  r_obj* handler = KEEP(r_alloc_list(2));
+  r_list_poke(handler, 0, expr);
+  r_list_poke(handler, 1, env);
+  r_attrib_poke_names(handler, global_handler_nms);
+
+  r_ssize n = r_length(handlers);
+  r_obj* out = KEEP(r_alloc_list(n + 1));
+  r_ssize offset = front ? 1 : 0;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i + offset, r_list_get(handlers, i));
+  }
+  r_list_poke(out, front ? 0 : n, handler);
+
+  r_attrib_poke(r_global_env, global_handlers_sym, out);
+  FREE(2);
+}
+
+void rlang_defer(r_obj* expr, r_obj* env, r_obj* frame, bool front) {
+  if (r_typeof(frame) != R_TYPE_environment) {
+    r_abort("`envir` must be an environment.");
+  }
+
+  if (frame == r_global_env) {
+    defer_global(expr, env, front);
+    return;
+  }
+
+  r_obj* handlers = r_attrib_get(frame, deferred_sym);
+  r_obj* handler = KEEP(r_new_node(expr, env));
+  r_obj* node = KEEP(r_new_node(handler, r_null));
+
+  if (handlers == r_null) {
+    r_attrib_poke(frame, deferred_sym, node);
+    defer_register_hook(frame);
+  } else if (front) {
+    r_node_poke_cdr(node, handlers);
+    r_attrib_poke(frame, deferred_sym, node);
+  } else {
+    r_node_poke_cdr(r_pairlist_tail(handlers), node);
+  }
+
+  FREE(2);
+}
+
+r_obj* ffi_defer(r_obj* expr, r_obj* env, r_obj* frame, r_obj* front) {
+  if (!r_is_bool(front)) {
+    r_stop_internal("ffi_defer", "`front` must be a logical value.");
+  }
+  rlang_defer(expr, env, frame, r_lgl_get(front, 0));
+  return r_null;
+}
+
+#if R_VERSION >= R_Version(3, 4, 0)
+static
+r_obj* defer_eval_body(void* data) {
+  r_obj* handler = (r_obj*) data;
+  return r_eval(r_node_car(handler), r_node_cdr(handler));
+}
+static
+r_obj* defer_eval_error(r_obj* cnd, void* data) {
+  return r_null;
+}
+#endif
+
+// Errors don't prevent the other handlers from running
+static
+void defer_eval(r_obj* handler) {
+#if R_VERSION >= R_Version(3, 4, 0)
+  R_tryCatchError(&defer_eval_body, handler, &defer_eval_error, NULL);
+#else
+  r_eval_with_xy(defer_eval_call, r_node_car(handler), r_node_cdr(handler), r_base_env);
+#endif
+}
+
+r_obj* ffi_defer_run(r_obj* frame) {
+  r_obj* handlers = KEEP(r_attrib_get(frame, deferred_sym));
+  r_attrib_poke(frame, deferred_sym, r_null);
+
+  for (r_obj* node = handlers; node != r_null; node = r_node_cdr(node)) {
+    defer_eval(r_node_car(node));
+  }
+
+  FREE(1);
+  return r_null;
+}
+
+
+void rlang_init_defer(r_obj* ns) {
+  deferred_sym = r_sym("rlang_deferred");
+  global_handlers_sym = r_sym("handlers");
+
+  const char* nms[] = { "expr", "envir" };
+  global_handler_nms = r_preserve_global(r_chr_n(nms, R_ARR_SIZEOF(nms)));
+
+  defer_run_call = r_base_ns_get(".Call");
+  defer_run_native = rlang_ns_get("ffi_defer_run");
+
+  defer_eval_call = r_parse("tryCatch(eval(x, y), error = identity)");
+  r_preserve(defer_eval_call);
+}
@@ -0,0 +1,1513 @@
+#include <rlang.h>
+#include <math.h>
+#include <string.h>
+#include "deparse.h"
+#include "parse.h"
+#include "quo.h"
+
+/*
+ * Native implementation of the line builder of `new_lines()` in
+ * R/deparse.R, used by `expr_deparse()` when the output is not
+ * coloured. The R implementation is the reference and both must
+ * produce the same lines. Line breaking follows `line_push()`:
+ *
+ * - Text is appended to the last line until it overflows `width`.
+ * - Sticky text is never separated from the preceding text.
+ * - When the last line has a boundary, the text that follows the
+ *   boundary is moved to the next line along with the new text.
+ *
+ * Lines are built as UTF-8 bytes. Widths are counted in characters
+ * like `nchar()`.
+ *
+ * When a sink function is supplied, complete lines are passed to it
+ * in chunks of `DEPARSE_SINK_CHUNK_SIZE` lines instead of being
+ * collected. Memory usage is then bounded by the chunk size and the
+ * nesting depth of the expression rather than by the size of the
+ * output.
+ *
+ * Common leaves are deparsed in C: symbols, scalars that `deparse()`
+ * formats in a predictable way, and the elements of logical, integer,
+ * raw and string vectors. The other leaves are deparsed with the same
+ * R helpers as the R implementation.
+ */
+
+static r_obj* deparse_call = NULL;
+static r_obj* deparse_keep_integer_call = NULL;
+static r_obj* type_sum_call = NULL;
+static r_obj* atom_elements_call = NULL;
+static r_obj* needs_backticks_call = NULL;
+static r_obj* sym_paren = NULL;
+static r_obj* sink_call = NULL;
+
+#define DEPARSE_SINK_CHUNK_SIZE 64
+
+struct deparse_indent {
+  bool reset;
+  int n_sticky;
+};
+
+struct deparse_lines {
+  r_obj* shelter;
+
+  struct r_dyn_array* p_lines;
+  struct r_dyn_array* p_last;
+  struct r_dyn_array* p_buf;
+  struct r_dyn_array* p_indent_status;
+
+  // Distinguishes an empty last line from no last line
+  bool has_last;
+
+  double width;
+  r_ssize max_elements;
+  bool quo;
+
+  // A function called with chunks of complete lines, or `r_null`
+  r_obj* sink;
+
+  // Byte offset in the last line, or -1 for no boundary
+  r_ssize boundary;
+  bool next_sticky;
+
+  int indent;
+  bool next_indent_sticky;
+};
+
+static void lines_deparse(struct deparse_lines* p, r_obj* x);
+static void sexp_deparse(struct deparse_lines* p, r_obj* x);
+
+
+// Character buffers -------------------------------------------------
+
+static inline
+const char* buf_chars(struct r_dyn_array* p_buf) {
+  return (const char*) p_buf->v_data;
+}
+static inline
+void buf_append(struct r_dyn_array* p_buf, const char* text, r_ssize n) {
+  if (n) {
+    r_arr_push_back_n(p_buf, text, n);
+  }
+}
+static inline
+void buf_append_c(struct r_dyn_array* p_buf, const char* text) {
+  buf_append(p_buf, text, strlen(text));
+}
+static
+void buf_append_spaces(struct r_dyn_array* p_buf, int n) {
+  for (int i = 0; i < n; ++i) {
+    buf_append(p_buf, " ", 1);
+  }
+}
+
+static
+r_ssize utf8_nchar(const char* text, r_ssize n) {
+  r_ssize out = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    // Count all bytes except continuation bytes
+    out += (((unsigned char) text[i]) & 0xC0) != 0x80;
+  }
+  return out;
+}
+
+static inline
+r_ssize trim_trailing_spaces(const char* text, r_ssize n) {
+  while (n && text[n - 1] == ' ') {
+    --n;
+  }
+  return n;
+}
+
+static
+bool is_spaces(const char* text, r_ssize n) {
+  for (r_ssize i = 0; i < n; ++i) {
+    if (text[i] != ' ') {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Same as `has_overflown()`
+static
+bool has_overflown(struct deparse_lines* p,
+                   const char* line,
+                   r_ssize n_line,
+                   const char* text,
+                   r_ssize n_text) {
+  n_text = trim_trailing_spaces(text, n_text);
+  r_ssize n = utf8_nchar(line, n_line) + utf8_nchar(text, n_text);
+  return n > p->width && !is_spaces(line, n_line);
+}
+
+
+// Lines -------------------------------------------------------------
+
+static
+struct deparse_lines new_deparse_lines(double width,
+                                       r_ssize max_elements,
+                                       bool quo,
+                                       r_obj* sink) {
+  r_obj* shelter = KEEP(r_alloc_list(4));
+
+  struct r_dyn_array* p_lines = r_new_dyn_vector(R_TYPE_character, 8);
+  r_list_poke(shelter, 0, p_lines->shelter);
+
+  struct r_dyn_array* p_last = r_new_dyn_vector(R_TYPE_raw, 128);
+  r_list_poke(shelter, 1, p_last->shelter);
+
+  struct r_dyn_array* p_buf = r_new_dyn_vector(R_TYPE_raw, 128);
+  r_list_poke(shelter, 2, p_buf->shelter);
+
+  struct r_dyn_array* p_indent_status = r_new_dyn_array(sizeof(struct deparse_indent), 8);
+  r_list_poke(shelter, 3, p_indent_status->shelter);
+
+  struct deparse_lines lines = {
+    .shelter = shelter,
+    .p_lines = p_lines,
+    .p_last = p_last,
+    .p_buf = p_buf,
+    .p_indent_status = p_indent_status,
+    .has_last = false,
+    .width = width,
+    .max_elements = max_elements,
+    .quo = quo,
+    .sink = sink,
+    .boundary = -1,
+    .next_sticky = false,
+    .indent = 0,
+    .next_indent_sticky = false
+  };
+
+  FREE(1);
+  return lines;
+}
+
+static
+int lines_get_indent(struct deparse_lines* p) {
+  if (p->indent < 0) {
+    r_warn("Internal error: Negative indent while deparsing");
+    return 0;
+  } else {
+    return p->indent;
+  }
+}
+
+static
+void lines_flush(struct deparse_lines* p) {
+  struct r_dyn_array* p_lines = p->p_lines;
+  r_ssize n = p_lines->count;
+
+  r_obj* chunk = KEEP(r_alloc_character(n));
+  r_obj* const * v_lines = r_chr_cbegin(p_lines->data);
+  for (r_ssize i = 0; i < n; ++i) {
+    r_chr_poke(chunk, i, v_lines[i]);
+  }
+  p_lines->count = 0;
+
+  r_eval_with_xy(sink_call, chunk, p->sink, r_base_env);
+  FREE(1);
+}
+
+static
+void lines_push_line(struct deparse_lines* p, const char* line, r_ssize n) {
+  r_chr_push_back(p->p_lines, Rf_mkCharLenCE(line, n, CE_UTF8));
+
+  if (p->sink != r_null && p->p_lines->count >= DEPARSE_SINK_CHUNK_SIZE) {
+    lines_flush(p);
+  }
+}
+
+// Returns `r_null` when the lines are passed to a sink
+static
+void lines_get(struct deparse_lines* p, r_obj** out) {
+  if (p->has_last) {
+    lines_push_line(p, buf_chars(p->p_last), p->p_last->count);
+    p->has_last = false;
+  }
+
+  if (p->sink == r_null) {
+    *out = r_arr_unwrap(p->p_lines);
+    return;
+  }
+
+  if (p->p_lines->count) {
+    lines_flush(p);
+  }
+  *out = r_null;
+}
+
+// Same as `push_one()` and `line_push()`
+static
+void lines_push(struct deparse_lines* p, const char* text, r_ssize n_text) {
+  bool sticky = p->next_sticky;
+  p->next_sticky = false;
+
+  struct r_dyn_array* p_last = p->p_last;
+
+  if (!p->has_last) {
+    p_last->count = 0;
+    buf_append(p_last, text, n_text);
+    p->has_last = true;
+
+    if (sticky) {
+      p->boundary = p_last->count;
+    }
+    return;
+  }
+
+  const char* line = buf_chars(p_last);
+  r_ssize n_line = p_last->count;
+
+  if (!has_overflown(p, line, n_line, text, n_text)) {
+    buf_append(p_last, text, n_text);
+
+    if (sticky) {
+      p->boundary = p_last->count;
+    }
+    return;
+  }
+
+  int indent = lines_get_indent(p);
+
+  struct r_dyn_array* p_next = p->p_buf;
+  p_next->count = 0;
+
+  if (p->boundary >= 0 && n_line != p->boundary) {
+    const char* second = line + p->boundary;
+    r_ssize n_second = n_line - p->boundary;
+
+    // Trim leading spaces after boundary
+    while (n_second && *second == ' ') {
+      ++second;
+      --n_second;
+    }
+    buf_append_spaces(p_next, indent);
+    buf_append(p_next, second, n_second);
+
+    if (sticky || !has_overflown(p, buf_chars(p_next), p_next->count, text, n_text)) {
+      lines_push_line(p, line, trim_trailing_spaces(line, p->boundary));
+    } else {
+      lines_push_line(p, line, n_line);
+      p_next->count = 0;
+      buf_append_spaces(p_next, indent);
+    }
+    buf_append(p_next, text, n_text);
+  } else if (sticky) {
+    buf_append(p_last, text, n_text);
+    p->boundary = p_last->count;
+    return;
+  } else {
+    lines_push_line(p, line, trim_trailing_spaces(line, n_line));
+    buf_append_spaces(p_next, indent);
+    buf_append(p_next, text, n_text);
+  }
+
+  // The next line becomes the last line and the old last line is
+  // reused as scratch buffer
+  p->p_last = p_next;
+  p->p_buf = p_last;
+
+  p->boundary = -1;
+  p->next_indent_sticky = false;
+}
+static inline
+void lines_push_c(struct deparse_lines* p, const char* text) {
+  lines_push(p, text, strlen(text));
+}
+static
+void lines_push_chr(struct deparse_lines* p, r_obj* x) {
+  if (r_typeof(x) != R_TYPE_character) {
+    r_stop_internal("lines_push_chr", "Expected a character vector.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_chr_cbegin(x);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    lines_push_c(p, Rf_translateCharUTF8(v_x[i]));
+  }
+}
+
+static
+void lines_push_newline(struct deparse_lines* p) {
+  if (p->has_last) {
+    lines_push_line(p, buf_chars(p->p_last), p->p_last->count);
+  }
+
+  p->p_last->count = 0;
+  buf_append_spaces(p->p_last, lines_get_indent(p));
+  p->has_last = true;
+
+  p->next_sticky = false;
+  p->next_indent_sticky = false;
+}
+
+static inline
+void lines_make_next_sticky(struct deparse_lines* p) {
+  p->next_sticky = true;
+}
+static inline
+void lines_set_boundary(struct deparse_lines* p) {
+  p->boundary = p->has_last ? p->p_last->count : -1;
+}
+static
+void lines_push_sticky(struct deparse_lines* p, const char* text) {
+  p->next_sticky = true;
+  lines_push_c(p, text);
+  lines_set_boundary(p);
+}
+
+static
+void lines_increase_indent(struct deparse_lines* p) {
+  struct r_dyn_array* p_status = p->p_indent_status;
+
+  if (p->next_indent_sticky && p_status->count) {
+    struct deparse_indent* p_top = (struct deparse_indent*) r_arr_last(p_status);
+    ++p_top->n_sticky;
+  } else {
+    p->indent += 2;
+    struct deparse_indent status = { .reset = false, .n_sticky = 0 };
+    r_arr_push_back(p_status, &status);
+    p->next_indent_sticky = true;
+  }
+}
+static
+void lines_decrease_indent(struct deparse_lines* p) {
+  struct r_dyn_array* p_status = p->p_indent_status;
+
+  if (!p_status->count) {
+    r_warn("Internal error: Detected NULL `status` while deparsing");
+    return;
+  }
+  struct deparse_indent* p_top = (struct deparse_indent*) r_arr_last(p_status);
+
+  // Decrease indent level only once for all the openers that were
+  // on a single line
+  if (!p_top->reset) {
+    p->indent -= 2;
+    p_top->reset = true;
+    p->next_indent_sticky = false;
+  }
+
+  if (p_top->n_sticky >= 1) {
+    --p_top->n_sticky;
+  } else {
+    --p_status->count;
+    p->next_indent_sticky = false;
+  }
+}
+
+
+// Leaves ------------------------------------------------------------
+
+static
+r_obj* deparse_eval(r_obj* call, r_obj* x) {
+  return r_eval_with_x(call, x, rlang_ns_env);
+}
+
+static
+void lines_push_type_sum(struct deparse_lines* p, r_obj* x, const char* suffix) {
+  r_obj* type_sum = KEEP(deparse_eval(type_sum_call, x));
+  if (r_typeof(type_sum) != R_TYPE_character || r_length(type_sum) < 1) {
+    r_stop_internal("lines_push_type_sum", "Unexpected type summary.");
+  }
+
+  struct r_dyn_array* p_buf = p->p_buf;
+  p_buf->count = 0;
+  buf_append_c(p_buf, "<");
+  buf_append_c(p_buf, Rf_translateCharUTF8(r_chr_get(type_sum, 0)));
+  buf_append_c(p_buf, suffix);
+
+  // Copy out of the scratch buffer which `lines_push()` might reuse
+  r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+  lines_push(p, r_str_c_string(text), r_length(text));
+
+  FREE(2);
+}
+
+static
+const char* reserved_words[] = {
+  "NULL",
+  "NA",
+  "TRUE",
+  "FALSE",
+  "Inf",
+  "NaN",
+  "NA_integer_",
+  "NA_real_",
+  "NA_character_",
+  "NA_complex_",
+  "function",
+  "while",
+  "repeat",
+  "for",
+  "if",
+  "in",
+  "else",
+  "next",
+  "break"
+};
+
+static inline
+bool is_ascii_alpha(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+static inline
+bool is_ascii_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+// Same as `needs_backticks()`. Character classes are locale dependent
+// so non-ASCII names are checked in R.
+bool deparse_needs_backticks(const char* str, r_ssize n) {
+  if (!n) {
+    return false;
+  }
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (((unsigned char) str[i]) > 0x7F) {
+      r_obj* x = KEEP(r_str_as_character(Rf_mkCharCE(str, CE_UTF8)));
+      bool out = r_is_true(deparse_eval(needs_backticks_call, x));
+      FREE(1);
+      return out;
+    }
+  }
+
+  for (r_ssize i = 0; i < R_ARR_SIZEOF(reserved_words); ++i) {
+    if (strcmp(str, reserved_words[i]) == 0) {
+      return true;
+    }
+  }
+
+  char start = str[0];
+  if (!is_ascii_alpha(start) && start != '.') {
+    return true;
+  }
+
+  if (n == 1) {
+    return false;
+  }
+
+  // .0 double literals
+  if (start == '.' && is_ascii_digit(str[1])) {
+    return true;
+  }
+
+  for (r_ssize i = 1; i < n; ++i) {
+    char c = str[i];
+    if (!is_ascii_alpha(c) && !is_ascii_digit(c) && c != '_' && c != '.') {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static
+void sym_deparse(struct deparse_lines* p, r_obj* x) {
+  const char* str = Rf_translateCharUTF8(PRINTNAME(x));
+  r_ssize n = strlen(str);
+
+  if (!deparse_needs_backticks(str, n)) {
+    lines_push(p, str, n);
+    return;
+  }
+
+  struct r_dyn_array* p_buf = p->p_buf;
+  p_buf->count = 0;
+  buf_append_c(p_buf, "`");
+  buf_append(p_buf, str, n);
+  buf_append_c(p_buf, "`");
+
+  r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+  lines_push(p, r_str_c_string(text), r_length(text));
+  FREE(1);
+}
+
+// Quotes strings that `deparse()` doesn't need to escape other than
+// the quote and backslash characters
+static
+bool str_deparse(struct r_dyn_array* p_buf, r_obj* str) {
+  const char* c_str = r_str_c_string(str);
+
+  for (const char* p_c = c_str; *p_c; ++p_c) {
+    if (*p_c < 0x20 || *p_c > 0x7E) {
+      return false;
+    }
+  }
+
+  buf_append_c(p_buf, "\"");
+  for (const char* p_c = c_str; *p_c; ++p_c) {
+    if (*p_c == '"' || *p_c == '\\') {
+      buf_append_c(p_buf, "\\");
+    }
+    buf_append(p_buf, p_c, 1);
+  }
+  buf_append_c(p_buf, "\"");
+
+  return true;
+}
+
+// Formats integral doubles like `deparse()` with the default
+// `scipen` of zero. Fixed notation is used unless the scientific
+// notation is narrower.
+static
+bool dbl_deparse(struct r_dyn_array* p_buf, double x) {
+  if (isnan(x)) {
+    buf_append_c(p_buf, R_IsNA(x) ? "NA_real_" : "NaN");
+    return true;
+  }
+  if (!isfinite(x)) {
+    buf_append_c(p_buf, x > 0 ? "Inf" : "-Inf");
+    return true;
+  }
+  if (x != floor(x) || fabs(x) >= 1e15) {
+    return false;
+  }
+
+  r_obj* scipen = r_peek_option("scipen");
+  if (scipen != r_null && (r_length(scipen) != 1 || Rf_asReal(scipen) != 0)) {
+    return false;
+  }
+
+  if (x == 0) {
+    buf_append_c(p_buf, "0");
+    return true;
+  }
+
+  char digits[32];
+  snprintf(digits, sizeof(digits), "%.0f", fabs(x));
+  int n_digits = strlen(digits);
+
+  int n_sig = n_digits;
+  while (n_sig > 1 && digits[n_sig - 1] == '0') {
+    --n_sig;
+  }
+
+  if (x < 0) {
+    buf_append_c(p_buf, "-");
+  }
+
+  // The exponent of doubles below 1e15 takes four characters
+  int sci_width = (n_sig > 1 ? n_sig + 1 : 1) + 4;
+  if (n_digits <= sci_width) {
+    buf_append(p_buf, digits, n_digits);
+    return true;
+  }
+
+  buf_append(p_buf, digits, 1);
+  if (n_sig > 1) {
+    buf_append_c(p_buf, ".");
+    buf_append(p_buf, digits + 1, n_sig - 1);
+  }
+
+  char exponent[8];
+  snprintf(exponent, sizeof(exponent), "e+%02d", n_digits - 1);
+  buf_append_c(p_buf, exponent);
+
+  return true;
+}
+
+bool deparse_scalar(struct r_dyn_array* p_buf, r_obj* x) {
+  if (r_attrib(x) != r_null) {
+    return false;
+  }
+
+  char num[32];
+
+  switch (r_typeof(x)) {
+  case R_TYPE_logical: {
+    int elt = r_lgl_get(x, 0);
+    buf_append_c(p_buf, elt == r_globals.na_lgl ? "NA" : (elt ? "TRUE" : "FALSE"));
+    return true;
+  }
+  case R_TYPE_integer: {
+    int elt = r_int_get(x, 0);
+    if (elt == r_globals.na_int) {
+      buf_append_c(p_buf, "NA_integer_");
+    } else {
+      snprintf(num, sizeof(num), "%dL", elt);
+      buf_append_c(p_buf, num);
+    }
+    return true;
+  }
+  case R_TYPE_double:
+    return dbl_deparse(p_buf, r_dbl_get(x, 0));
+  case R_TYPE_character: {
+    r_obj* elt = r_chr_get(x, 0);
+    if (elt == r_globals.na_str) {
+      buf_append_c(p_buf, "NA_character_");
+      return true;
+    }
+    return str_deparse(p_buf, elt);
+  }
+  default:
+    return false;
+  }
+}
+
+// Same as `atom_elements()` for the types that are formatted in C.
+// Returns `r_null` for the other types.
+static
+r_obj* atom_elements(r_obj* x, r_ssize n) {
+  enum r_type type = r_typeof(x);
+  switch (type) {
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_raw:
+  case R_TYPE_character:
+    break;
+  default:
+    return r_null;
+  }
+
+  r_obj* out = KEEP(r_alloc_character(n));
+
+  struct r_dyn_array* p_buf = r_new_dyn_vector(R_TYPE_raw, 32);
+  KEEP(p_buf->shelter);
+
+  char num[32];
+
+  for (r_ssize i = 0; i < n; ++i) {
+    p_buf->count = 0;
+
+    switch (type) {
+    case R_TYPE_logical: {
+      int elt = r_lgl_get(x, i);
+      buf_append_c(p_buf, elt == r_globals.na_lgl ? "NA" : (elt ? "TRUE" : "FALSE"));
+      break;
+    }
+    case R_TYPE_integer: {
+      int elt = r_int_get(x, i);
+      if (elt == r_globals.na_int) {
+        buf_append_c(p_buf, "NA");
+      } else {
+        snprintf(num, sizeof(num), "%dL", elt);
+        buf_append_c(p_buf, num);
+      }
+      break;
+    }
+    case R_TYPE_raw:
+      snprintf(num, sizeof(num), "%02x", (unsigned int) ((unsigned char*) r_raw_begin(x))[i]);
+      buf_append_c(p_buf, num);
+      break;
+    case R_TYPE_character: {
+      r_obj* elt = r_chr_get(x, i);
+      if (elt == r_globals.na_str) {
+        buf_append_c(p_buf, "NA");
+      } else if (!str_deparse(p_buf, elt)) {
+        FREE(2);
+        return r_null;
+      }
+      break;
+    }
+    default:
+      r_stop_internal("atom_elements", "Unexpected type.");
+    }
+
+    r_chr_poke(out, i, Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+  }
+
+  FREE(2);
+  return out;
+}
+
+static
+bool is_scalar_deparsable(r_obj* x) {
+  if (r_typeof(x) == R_TYPE_raw || r_length(x) != 1) {
+    return false;
+  }
+
+  // Same as `!is_named(x)`
+  r_obj* nms = r_names(x);
+  if (nms == r_null) {
+    return true;
+  }
+  r_obj* nm = r_chr_get(nms, 0);
+  return nm == r_globals.na_str || nm == r_globals.empty_str;
+}
+
+static
+void atom_deparse(struct deparse_lines* p, r_obj* x) {
+  if (is_scalar_deparsable(x)) {
+    struct r_dyn_array* p_buf = p->p_buf;
+    p_buf->count = 0;
+
+    if (deparse_scalar(p_buf, x)) {
+      r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+      lines_push(p, r_str_c_string(text), r_length(text));
+      FREE(1);
+    } else {
+      r_obj* text = KEEP(deparse_eval(deparse_call, x));
+      lines_push_chr(p, text);
+      FREE(1);
+    }
+    return;
+  }
+
+  r_ssize n = r_length(x);
+  bool truncated = p->max_elements >= 0 && n > p->max_elements;
+  if (truncated) {
+    n = p->max_elements;
+  }
+
+  lines_push_type_sum(p, x, ": ");
+  lines_increase_indent(p);
+
+  r_obj* elts = KEEP(atom_elements(x, n));
+  if (elts == r_null) {
+    r_obj* subset = KEEP(truncated ? Rf_xlengthgets(x, n) : x);
+    elts = deparse_eval(atom_elements_call, subset);
+    FREE(2);
+    KEEP(elts);
+  }
+
+  if (r_typeof(elts) != R_TYPE_character || r_length(elts) != n) {
+    r_stop_internal("atom_deparse", "Unexpected elements.");
+  }
+  r_obj* const * v_elts = r_chr_cbegin(elts);
+
+  r_obj* nms = r_names(x);
+  r_obj* const * v_nms = (nms == r_null) ? NULL : r_chr_cbegin(nms);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* nm = v_nms ? v_nms[i] : r_globals.empty_str;
+    if (nm != r_globals.na_str && nm != r_globals.empty_str) {
+      struct r_dyn_array* p_buf = p->p_buf;
+      p_buf->count = 0;
+      buf_append_c(p_buf, Rf_translateCharUTF8(nm));
+      buf_append_c(p_buf, " = ");
+
+      r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+      lines_push(p, r_str_c_string(text), r_length(text));
+      lines_make_next_sticky(p);
+      FREE(1);
+    }
+
+    lines_push_c(p, Rf_translateCharUTF8(v_elts[i]));
+
+    if (i < n - 1 || truncated) {
+      lines_push_sticky(p, ", ");
+    }
+  }
+
+  if (truncated) {
+    lines_push_c(p, "...");
+  }
+
+  lines_push_sticky(p, ">");
+  lines_decrease_indent(p);
+
+  FREE(1);
+}
+
+static
+void list_deparse(struct deparse_lines* p, r_obj* x) {
+  r_ssize n = r_length(x);
+  r_obj* nms = r_names(x);
+
+  if (!n && nms != r_null) {
+    lines_push_c(p, "<named list>");
+    return;
+  }
+
+  lines_push_c(p, "<list: ");
+  lines_increase_indent(p);
+
+  bool truncated = p->max_elements >= 0 && n > p->max_elements;
+  if (truncated) {
+    n = p->max_elements;
+  }
+
+  r_obj* const * v_x = r_list_cbegin(x);
+  r_obj* const * v_nms = (nms == r_null) ? NULL : r_chr_cbegin(nms);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* nm = v_nms ? v_nms[i] : r_globals.empty_str;
+    if (nm != r_globals.na_str && nm != r_globals.empty_str) {
+      struct r_dyn_array* p_buf = p->p_buf;
+      p_buf->count = 0;
+      buf_append_c(p_buf, Rf_translateCharUTF8(nm));
+      buf_append_c(p_buf, " = ");
+
+      r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+      lines_push(p, r_str_c_string(text), r_length(text));
+      lines_make_next_sticky(p);
+      FREE(1);
+    }
+
+    lines_deparse(p, v_x[i]);
+
+    if (i < n - 1 || truncated) {
+      lines_push_sticky(p, ", ");
+    }
+  }
+
+  if (truncated) {
+    lines_push_c(p, "...");
+  }
+
+  lines_push_sticky(p, ">");
+  lines_decrease_indent(p);
+}
+
+
+// Calls -------------------------------------------------------------
+
+static
+void fmls_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_sticky(p, "(");
+  lines_increase_indent(p);
+
+  while (x != r_null) {
+    sym_deparse(p, r_node_tag(x));
+
+    r_obj* car = r_node_car(x);
+    if (car != r_missing_arg) {
+      lines_push_sticky(p, " = ");
+      lines_make_next_sticky(p);
+      lines_deparse(p, car);
+    }
+
+    x = r_node_cdr(x);
+    if (x != r_null) {
+      lines_push_sticky(p, ", ");
+    }
+  }
+
+  lines_push_sticky(p, ")");
+  lines_decrease_indent(p);
+}
+
+static
+void fn_call_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_c(p, "function");
+
+  x = r_node_cdr(x);
+  fmls_deparse(p, r_node_car(x));
+
+  lines_push_sticky(p, " ");
+  lines_increase_indent(p);
+
+  x = r_node_cdr(x);
+  lines_deparse(p, r_node_car(x));
+  lines_decrease_indent(p);
+}
+
+static
+void fn_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_c(p, "<function");
+
+  fmls_deparse(p, FORMALS(x));
+
+  lines_push_sticky(p, " ");
+  lines_increase_indent(p);
+
+  lines_deparse(p, r_fn_body(x));
+  lines_push_sticky(p, ">");
+  lines_decrease_indent(p);
+}
+
+static
+void while_deparse(struct deparse_lines* p, r_obj* x) {
+  x = r_node_cdr(x);
+  lines_push_c(p, "while (");
+  lines_deparse(p, r_node_car(x));
+
+  x = r_node_cdr(x);
+  lines_push_c(p, ") ");
+  lines_deparse(p, r_node_car(x));
+}
+static
+void for_deparse(struct deparse_lines* p, r_obj* x) {
+  x = r_node_cdr(x);
+  lines_push_c(p, "for (");
+  lines_deparse(p, r_node_car(x));
+
+  x = r_node_cdr(x);
+  lines_push_c(p, " in ");
+  lines_deparse(p, r_node_car(x));
+
+  x = r_node_cdr(x);
+  lines_push_c(p, ") ");
+  lines_deparse(p, r_node_car(x));
+}
+static
+void if_deparse(struct deparse_lines* p, r_obj* x) {
+  x = r_node_cdr(x);
+  lines_push_c(p, "if (");
+  lines_deparse(p, r_node_car(x));
+
+  x = r_node_cdr(x);
+  lines_push_c(p, ") ");
+  lines_deparse(p, r_node_car(x));
+
+  x = r_node_cdr(x);
+  if (x != r_null) {
+    lines_push_c(p, " else ");
+    lines_deparse(p, r_node_car(x));
+  }
+}
+
+static void call_deparse(struct deparse_lines* p, r_obj* x);
+
+// Wrap if the call lower in the AST is not supposed to have
+// precedence
+static
+void operand_deparse(struct deparse_lines* p, r_obj* x, r_obj* parent, bool lhs) {
+  bool wrap;
+  if (lhs) {
+    wrap = !r_lhs_call_has_precedence(x, parent);
+  } else {
+    wrap = !r_rhs_call_has_precedence(x, parent);
+  }
+
+  if (wrap) {
+    lines_push_c(p, "(");
+    lines_make_next_sticky(p);
+  }
+
+  lines_deparse(p, x);
+
+  if (wrap) {
+    lines_push_sticky(p, ")");
+  }
+}
+
+static
+void binary_op_deparse(struct deparse_lines* p,
+                       r_obj* x,
+                       const char* space,
+                       bool sticky_rhs) {
+  // Constructed call without second argument
+  if (r_node_cddr(x) == r_null) {
+    call_deparse(p, x);
+    return;
+  }
+
+  r_obj* outer = x;
+  const char* op = Rf_translateCharUTF8(PRINTNAME(r_node_car(x)));
+
+  x = r_node_cdr(x);
+  operand_deparse(p, r_node_car(x), outer, true);
+
+  struct r_dyn_array* p_buf = p->p_buf;
+  p_buf->count = 0;
+  buf_append_c(p_buf, space);
+  buf_append_c(p_buf, op);
+  buf_append_c(p_buf, space);
+
+  r_obj* text = KEEP(Rf_mkCharLenCE(buf_chars(p_buf), p_buf->count, CE_UTF8));
+  lines_push_sticky(p, r_str_c_string(text));
+  FREE(1);
+
+  if (sticky_rhs) {
+    lines_make_next_sticky(p);
+  }
+
+  x = r_node_cdr(x);
+
+  lines_increase_indent(p);
+  operand_deparse(p, r_node_car(x), outer, false);
+  lines_decrease_indent(p);
+}
+
+static
+void unary_op_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_c(p, Rf_translateCharUTF8(PRINTNAME(r_node_car(x))));
+  lines_deparse(p, r_node_cadr(x));
+}
+
+static
+void args_deparse(struct deparse_lines* p,
+                  r_obj* x,
+                  const char* open,
+                  const char* close) {
+  lines_push_sticky(p, open);
+  lines_increase_indent(p);
+
+  while (x != r_null) {
+    r_obj* tag = r_node_tag(x);
+    if (tag != r_null) {
+      sym_deparse(p, tag);
+      lines_push_sticky(p, " = ");
+      lines_make_next_sticky(p);
+    }
+    lines_deparse(p, r_node_car(x));
+
+    x = r_node_cdr(x);
+    if (x != r_null) {
+      lines_push_sticky(p, ", ");
+    }
+  }
+
+  lines_push_sticky(p, close);
+  lines_decrease_indent(p);
+}
+
+static
+void brackets_deparse(struct deparse_lines* p,
+                      r_obj* x,
+                      const char* open,
+                      const char* close) {
+  x = r_node_cdr(x);
+  lines_deparse(p, r_node_car(x));
+  args_deparse(p, r_node_cdr(x), open, close);
+}
+
+static
+void parens_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_c(p, "(");
+  lines_deparse(p, r_node_cadr(x));
+  lines_push_c(p, ")");
+}
+
+static
+void braces_deparse(struct deparse_lines* p, r_obj* x) {
+  lines_push_c(p, "{");
+  lines_increase_indent(p);
+
+  x = r_node_cdr(x);
+
+  // No need for a newline if the block is empty. Like the R
+  // implementation, the indentation is not decreased in that case.
+  if (x == r_null) {
+    lines_push_c(p, " }");
+    return;
+  }
+
+  while (x != r_null) {
+    lines_push_newline(p);
+    lines_deparse(p, r_node_car(x));
+    x = r_node_cdr(x);
+  }
+
+  lines_decrease_indent(p);
+  lines_push_newline(p);
+  lines_push_c(p, "}");
+}
+
+// Same as `op_deparse()`
+static
+void op_deparse(struct deparse_lines* p, enum r_operator op, r_obj* x) {
+  switch (op) {
+  case R_OP_FUNCTION: fn_call_deparse(p, x); return;
+  case R_OP_WHILE: while_deparse(p, x); return;
+  case R_OP_FOR: for_deparse(p, x); return;
+  case R_OP_REPEAT: lines_push_c(p, "repeat "); lines_deparse(p, r_node_cadr(x)); return;
+  case R_OP_IF: if_deparse(p, x); return;
+  case R_OP_NEXT: lines_push_c(p, "next"); return;
+  case R_OP_BREAK: lines_push_c(p, "break"); return;
+
+  case R_OP_QUESTION:
+  case R_OP_ASSIGN1:
+  case R_OP_ASSIGN2:
+  case R_OP_ASSIGN_EQUAL:
+  case R_OP_COLON_EQUAL:
+  case R_OP_TILDE:
+  case R_OP_OR1:
+  case R_OP_OR2:
+  case R_OP_AND1:
+  case R_OP_AND2:
+  case R_OP_GREATER:
+  case R_OP_GREATER_EQUAL:
+  case R_OP_LESS:
+  case R_OP_LESS_EQUAL:
+  case R_OP_EQUAL:
+  case R_OP_NOT_EQUAL:
+  case R_OP_PLUS:
+  case R_OP_MINUS:
+  case R_OP_TIMES:
+  case R_OP_RATIO:
+  case R_OP_MODULO:
+  case R_OP_SPECIAL: binary_op_deparse(p, x, " ", false); return;
+
+  case R_OP_COLON1:
+  case R_OP_HAT:
+  case R_OP_DOLLAR:
+  case R_OP_AT: binary_op_deparse(p, x, "", false); return;
+
+  case R_OP_COLON2:
+  case R_OP_COLON3: binary_op_deparse(p, x, "", true); return;
+
+  case R_OP_QUESTION_UNARY:
+  case R_OP_TILDE_UNARY:
+  case R_OP_BANG1:
+  case R_OP_BANG3:
+  case R_OP_BANG2:
+  case R_OP_PLUS_UNARY:
+  case R_OP_MINUS_UNARY: unary_op_deparse(p, x); return;
+
+  case R_OP_BRACKETS1: brackets_deparse(p, x, "[", "]"); return;
+  case R_OP_BRACKETS2: brackets_deparse(p, x, "[[", "]]"); return;
+  case R_OP_PARENTHESES: parens_deparse(p, x); return;
+  case R_OP_BRACES: braces_deparse(p, x); return;
+
+  case R_OP_NONE:
+  case R_OP_MAX:
+    break;
+  }
+
+  r_abort("Internal error: Unexpected operator while deparsing");
+}
+
+// Same as `call_delimited_type()`
+static
+void call_head_deparse(struct deparse_lines* p, r_obj* car) {
+  if (r_typeof(car) != R_TYPE_call) {
+    lines_deparse(p, car);
+    return;
+  }
+
+  switch (r_which_operator(car)) {
+  case R_OP_NONE:
+  case R_OP_DOLLAR:
+  case R_OP_AT:
+  case R_OP_COLON2:
+  case R_OP_COLON3:
+  case R_OP_BRACKETS1:
+  case R_OP_BRACKETS2:
+  case R_OP_PARENTHESES:
+  case R_OP_BRACES:
+    lines_deparse(p, car);
+    return;
+
+  case R_OP_FUNCTION: {
+    r_obj* parens = KEEP(r_call2(sym_paren, car));
+    lines_deparse(p, parens);
+    FREE(1);
+    return;
+  }
+
+  case R_OP_BREAK:
+  case R_OP_NEXT:
+  case R_OP_MAX:
+    r_abort("Internal error: Unexpected operator while deparsing");
+
+  default:
+    lines_deparse(p, r_node_car(car));
+    args_deparse(p, r_node_cdr(car), "(", ")");
+    return;
+  }
+}
+
+static
+void call_deparse(struct deparse_lines* p, r_obj* x) {
+  call_head_deparse(p, r_node_car(x));
+  args_deparse(p, r_node_cdr(x), "(", ")");
+}
+
+
+// Dispatch ----------------------------------------------------------
+
+// Same as `sexp_deparse()`
+static
+void sexp_deparse(struct deparse_lines* p, r_obj* x) {
+  if (r_is_object(x)) {
+    lines_push_type_sum(p, x, ">");
+    return;
+  }
+
+  switch (r_typeof(x)) {
+  case R_TYPE_symbol: sym_deparse(p, x); return;
+  case R_TYPE_closure: fn_deparse(p, x); return;
+  case R_TYPE_dots: lines_push_c(p, "<...>"); return;
+  case R_TYPE_any: lines_push_c(p, "<any>"); return;
+  case R_TYPE_environment: lines_push_c(p, "<environment>"); return;
+  case R_TYPE_pointer: lines_push_c(p, "<pointer>"); return;
+  case R_TYPE_promise: lines_push_c(p, "<promise>"); return;
+  case R_TYPE_weakref: lines_push_c(p, "<weakref>"); return;
+  case R_TYPE_null: lines_push_c(p, "NULL"); return;
+
+  case R_TYPE_call: {
+    enum r_operator op = r_which_operator(x);
+    if (op == R_OP_NONE) {
+      call_deparse(p, x);
+    } else {
+      op_deparse(p, op, x);
+    }
+    return;
+  }
+
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_character:
+  case R_TYPE_raw:
+    atom_deparse(p, x);
+    return;
+
+  case R_TYPE_list:
+    list_deparse(p, x);
+    return;
+
+  default: {
+    r_obj* text = KEEP(deparse_eval(deparse_keep_integer_call, x));
+    lines_push_chr(p, text);
+    FREE(1);
+    return;
+  }}
+}
+
+// Same as the deparser of `new_quo_deparser()` without colours
+static
+void lines_deparse(struct deparse_lines* p, r_obj* x) {
+  if (p->quo && rlang_is_quosure(x)) {
+    lines_push_c(p, "^");
+    lines_make_next_sticky(p);
+    x = rlang_quo_get_expr_(x);
+  }
+  sexp_deparse(p, x);
+}
+
+r_obj* ffi_expr_deparse(r_obj* x,
+                        r_obj* width,
+                        r_obj* max_elements,
+                        r_obj* quo,
+                        r_obj* sink) {
+  double c_width = Rf_asReal(width);
+
+  r_ssize c_max_elements = -1;
+  if (max_elements != r_null) {
+    c_max_elements = r_as_ssize(max_elements);
+  }
+
+  if (sink != r_null && !r_is_function(sink)) {
+    r_stop_internal("ffi_expr_deparse", "`sink` must be a function or `NULL`.");
+  }
+
+  struct deparse_lines lines = new_deparse_lines(c_width, c_max_elements, r_as_bool(quo), sink);
+  KEEP(lines.shelter);
+
+  lines_deparse(&lines, x);
+
+  r_obj* out;
+  lines_get(&lines, &out);
+
+  FREE(1);
+  return out;
+}
+
+// Label budget ------------------------------------------------------
+
+/*
+ * `deparse_one()` collapses the arguments of calls that `deparse()`
+ * spreads over several lines. To avoid deparsing huge calls only to
+ * throw the result away, a bounded walk first looks for a point where
+ * `deparse()` is bound to break the first line.
+ *
+ * `deparse()` breaks lines after the separator of call arguments and
+ * after the elements of atomic vectors, as soon as the current line is
+ * longer than the cutoff. The walk keeps a lower bound of the length
+ * of the first line: separators and brackets are counted exactly and
+ * leaves count for one character. Nodes whose layout isn't known,
+ * such as operators or vectors with attributes, don't count but their
+ * operands are still walked in order. The walk gives up after
+ * `DEPARSE_BUDGET_MAX_NODES` nodes, so its cost is bounded by the
+ * cutoff and not by the size of the expression.
+ */
+
+#define DEPARSE_BUDGET_MAX_NODES 1024
+
+enum budget_status {
+  BUDGET_continue = 0,
+  BUDGET_multiline,
+  BUDGET_exhausted
+};
+
+struct deparse_budget {
+  r_ssize cutoff;
+  r_ssize n;
+  r_ssize n_nodes;
+};
+
+static enum budget_status budget_walk(struct deparse_budget* p, r_obj* x);
+
+static inline
+enum budget_status budget_push(struct deparse_budget* p, r_ssize n) {
+  p->n += n;
+  return BUDGET_continue;
+}
+static inline
+enum budget_status budget_break(struct deparse_budget* p) {
+  return p->n > p->cutoff ? BUDGET_multiline : BUDGET_continue;
+}
+
+static
+enum budget_status budget_atom(struct deparse_budget* p, r_obj* x) {
+  r_obj* attrib = r_attrib(x);
+  if (attrib != r_null && (r_node_tag(attrib) != r_syms.names || r_node_cdr(attrib) != r_null)) {
+    return BUDGET_continue;
+  }
+
+  r_ssize n = r_length(x);
+  if (n < 2) {
+    return budget_push(p, n);
+  }
+
+  // Integer sequences are deparsed as `from:to`
+  if (r_typeof(x) == R_TYPE_integer) {
+    const int* v_x = r_int_cbegin(x);
+    if (v_x[0] != r_globals.na_int && v_x[1] != r_globals.na_int &&
+        (v_x[1] - v_x[0] == 1 || v_x[1] - v_x[0] == -1)) {
+      return budget_push(p, 1);
+    }
+  }
+
+  // `c(`
+  budget_push(p, 2);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (++p->n_nodes > DEPARSE_BUDGET_MAX_NODES) {
+      return BUDGET_exhausted;
+    }
+
+    // The element and its separator
+    budget_push(p, i < n - 1 ? 3 : 1);
+
+    enum budget_status status = budget_break(p);
+    if (status) {
+      return status;
+    }
+  }
+
+  return budget_push(p, 1);
+}
+
+static
+enum budget_status budget_args(struct deparse_budget* p, r_obj* node) {
+  while (node != r_null) {
+    if (r_node_tag(node) != r_null) {
+      // `tag = `
+      budget_push(p, 4);
+    }
+
+    r_obj* arg = r_node_car(node);
+    if (arg != r_syms.missing) {
+      enum budget_status status = budget_walk(p, arg);
+      if (status) {
+        return status;
+      }
+    }
+
+    node = r_node_cdr(node);
+    if (node != r_null) {
+      budget_push(p, 2);
+
+      enum budget_status status = budget_break(p);
+      if (status) {
+        return status;
+      }
+    }
+  }
+
+  return BUDGET_continue;
+}
+
+static
+enum budget_status budget_call(struct deparse_budget* p, r_obj* x) {
+  r_obj* head = r_node_car(x);
+
+  // Operators have their own layout. Only their operands are walked.
+  if (r_which_operator(x) != R_OP_NONE) {
+    for (r_obj* node = r_node_cdr(x); node != r_null; node = r_node_cdr(node)) {
+      r_obj* arg = r_node_car(node);
+      if (arg == r_syms.missing) {
+        continue;
+      }
+      enum budget_status status = budget_walk(p, arg);
+      if (status) {
+        return status;
+      }
+    }
+    return BUDGET_continue;
+  }
+
+  switch (r_typeof(head)) {
+  case R_TYPE_symbol:
+    budget_push(p, 1);
+    break;
+  case R_TYPE_call: {
+    enum budget_status status = budget_walk(p, head);
+    if (status) {
+      return status;
+    }
+    break;
+  }
+  default:
+    // Inlined functions are deparsed in full
+    return BUDGET_continue;
+  }
+
+  // `(`
+  budget_push(p, 1);
+
+  enum budget_status status = budget_args(p, r_node_cdr(x));
+  if (status) {
+    return status;
+  }
+
+  // `)`
+  return budget_push(p, 1);
+}
+
+static
+enum budget_status budget_walk(struct deparse_budget* p, r_obj* x) {
+  if (++p->n_nodes > DEPARSE_BUDGET_MAX_NODES) {
+    return BUDGET_exhausted;
+  }
+
+  switch (r_typeof(x)) {
+  case R_TYPE_symbol:
+    return budget_push(p, 1);
+
+  case R_TYPE_call:
+    return budget_call(p, x);
+
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_character:
+  case R_TYPE_raw:
+    return budget_atom(p, x);
+
+  default:
+    return BUDGET_continue;
+  }
+}
+
+// Returns `TRUE` when `deparse(x, width.cutoff = cutoff)` is known to
+// return several lines. `FALSE` means that the number of lines is not
+// known.
+r_obj* ffi_deparse_is_multiline(r_obj* x, r_obj* cutoff) {
+  struct deparse_budget budget = {
+    .cutoff = r_as_ssize(cutoff),
+    .n = 0,
+    .n_nodes = 0
+  };
+  return r_lgl(budget_walk(&budget, x) == BUDGET_multiline);
+}
+
+void rlang_init_deparse(r_obj* ns) {
+  deparse_call = r_parse("deparse(x)");
+  r_preserve_global(deparse_call);
+
+  deparse_keep_integer_call = r_parse("deparse(x, control = 'keepInteger')");
+  r_preserve_global(deparse_keep_integer_call);
+
+  type_sum_call = r_parse("rlang_type_sum(x)");
+  r_preserve_global(type_sum_call);
+
+  atom_elements_call = r_parse("atom_elements(x)");
+  r_preserve_global(atom_elements_call);
+
+  needs_backticks_call = r_parse("needs_backticks(x)");
+  r_preserve_global(needs_backticks_call);
+
+  sym_paren = r_sym("(");
+
+  sink_call = r_parse("y(x)");
+  r_preserve_global(sink_call);
+}
@@ -0,0 +1,13 @@
+#ifndef RLANG_INTERNAL_DEPARSE_H
+#define RLANG_INTERNAL_DEPARSE_H
+
+
+// Same as `needs_backticks()` in R/deparse.R
+bool deparse_needs_backticks(const char* str, r_ssize n);
+
+// Appends the output of `deparse(x)` to `p_buf` for the scalars
+// that are formatted in C. Returns `false` for other objects.
+bool deparse_scalar(struct r_dyn_array* p_buf, r_obj* x);
+
+
+#endif
@@ -1,6 +1,10 @@
 #include <rlang.h>
+#include "deparse.h"
 #include "dots.h"
+#include "events.h"
+#include "memo.h"
 #include "nse-inject.h"
+#include "quo.h"
 #include "internal.h"
 #include "squash.h"
 #include "utils.h"
@@ -118,12 +122,22 @@ void require_glue() {
 
 static
 r_obj* glue_unquote(r_obj* lhs, r_obj* env) {
-  if (r_typeof(lhs) != R_TYPE_character ||
-      r_length(lhs) != 1 ||
-      !has_curly(r_chr_get_c_string(lhs, 0))) {
+  if (r_typeof(lhs) != R_TYPE_character || r_length(lhs) != 1) {
     return lhs;
   }
 
+  r_obj* tmpl = glue_template(r_chr_get(lhs, 0));
+
+  if (tmpl == glue_template_none) {
+    return lhs;
+  }
+  if (tmpl != glue_template_fallback) {
+    r_obj* out = glue_template_interp(tmpl, env);
+    if (out != NULL) {
+      return out;
+    }
+  }
+
   if (!has_glue) {
     require_glue();
   }
@@ -134,6 +148,264 @@ r_obj* glue_unquote(r_obj* lhs, r_obj* env) {
   return lhs;
 }
 
+/**
+ * Name templates like `"{name}_mean"` are usually evaluated many
+ * times with the same string, e.g. once per group or per column. They
+ * are compiled once into a list of segments cached by CHARSXP:
+ *
+ * - Literal text as a string.
+ * - `{var}` as the symbol `var`.
+ * - `{{var}}` as `list(var)`.
+ *
+ * Templates that don't contain curlies are cached as
+ * `glue_template_none`. Templates with any other syntax (expressions,
+ * escaped or unbalanced curlies, newlines that glue would trim) are
+ * cached as `glue_template_fallback` and go through glue. The cache
+ * is flushed when it reaches `GLUE_TEMPLATES_MAX_SIZE` entries.
+ */
+
+#define GLUE_TEMPLATES_MAX_SIZE 1024
+#define GLUE_TEMPLATE_BUF_SIZE 256
+
+static
+r_obj* glue_template(r_obj* str) {
+  r_obj* tmpl = rlang_addr_cache_get0(p_glue_templates, str);
+  if (tmpl != NULL) {
+    return tmpl;
+  }
+
+  tmpl = KEEP(glue_template_compile(str));
+  rlang_addr_cache_put(p_glue_templates, str, tmpl);
+
+  FREE(1);
+  return tmpl;
+}
+
+static inline
+bool is_ident_start(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '.';
+}
+static inline
+bool is_ident_char(char c) {
+  return is_ident_start(c) || (c >= '0' && c <= '9') || c == '_';
+}
+
+static
+const char* glue_template_reserved[] = {
+  "if", "else", "repeat", "while", "function", "for", "in", "next",
+  "break", "TRUE", "FALSE", "NULL", "Inf", "NaN", "NA", "NA_integer_",
+  "NA_real_", "NA_character_", "NA_complex_"
+};
+
+// Returns `NULL` if `[start, end)` is not a plain symbol that can be
+// looked up without parsing
+static
+r_obj* glue_template_sym(const char* start, const char* end) {
+  r_ssize n = end - start;
+  char buf[GLUE_TEMPLATE_BUF_SIZE];
+
+  if (n == 0 || n >= GLUE_TEMPLATE_BUF_SIZE) {
+    return NULL;
+  }
+
+  // Dots lookups, `..1`, and numbers like `.5`
+  if (start[0] == '.' && n > 1 && (start[1] == '.' || (start[1] >= '0' && start[1] <= '9'))) {
+    return NULL;
+  }
+
+  memcpy(buf, start, n);
+  buf[n] = '\0';
+
+  int n_reserved = sizeof(glue_template_reserved) / sizeof(glue_template_reserved[0]);
+  for (int i = 0; i < n_reserved; ++i) {
+    if (strcmp(buf, glue_template_reserved[i]) == 0) {
+      return NULL;
+    }
+  }
+
+  return r_sym(buf);
+}
+
+static
+r_obj* glue_template_compile(r_obj* str) {
+  if (!has_curly(r_str_c_string(str))) {
+    return glue_template_none;
+  }
+  if (Rf_getCharCE(str) == CE_BYTES) {
+    return glue_template_fallback;
+  }
+
+  // Literals are stored in UTF-8 like the output of glue
+  const char* c_str = Rf_translateCharUTF8(str);
+
+  struct r_dyn_array* p_segs = r_new_dyn_vector(R_TYPE_list, 4);
+  KEEP(p_segs->shelter);
+
+  const char* p = c_str;
+  const char* lit = c_str;
+
+  while (*p != '\0') {
+    if (*p == '}' || *p == '\n' || *p == '\\') {
+      goto fallback;
+    }
+    if (*p != '{') {
+      ++p;
+      continue;
+    }
+
+    if (p != lit) {
+      r_obj* lit_str = KEEP(r_alloc_character(1));
+      r_chr_poke(lit_str, 0, Rf_mkCharLenCE(lit, p - lit, CE_UTF8));
+      r_list_push_back(p_segs, lit_str);
+      FREE(1);
+    }
+
+    bool embrace = p[1] == '{';
+    p += embrace ? 2 : 1;
+
+    const char* start = p;
+    if (!is_ident_start(*p)) {
+      goto fallback;
+    }
+    while (is_ident_char(*p)) {
+      ++p;
+    }
+
+    if (p[0] != '}' || (embrace && p[1] != '}')) {
+      goto fallback;
+    }
+
+    r_obj* sym = glue_template_sym(start, p);
+    if (sym == NULL) {
+      goto fallback;
+    }
+
+    if (embrace) {
+      r_obj* embraced = KEEP(r_alloc_list(1));
+      r_list_poke(embraced, 0, sym);
+      r_list_push_back(p_segs, embraced);
+      FREE(1);
+    } else {
+      r_list_push_back(p_segs, sym);
+    }
+
+    p += embrace ? 2 : 1;
+    lit = p;
+  }
+
+  if (p != lit) {
+    r_obj* lit_str = KEEP(r_alloc_character(1));
+    r_chr_poke(lit_str, 0, Rf_mkCharLenCE(lit, p - lit, CE_UTF8));
+    r_list_push_back(p_segs, lit_str);
+    FREE(1);
+  }
+
+  r_obj* out = r_arr_unwrap(p_segs);
+  FREE(1);
+  return out;
+
+fallback:
+  FREE(1);
+  return glue_template_fallback;
+}
+
+// Returns `NULL` when a value can't be formatted without glue, in
+// which case the whole template is evaluated by glue
+static
+r_obj* glue_template_interp(r_obj* tmpl, r_obj* env) {
+  r_ssize n = r_length(tmpl);
+  r_obj* const * v_tmpl = r_list_cbegin(tmpl);
+
+  r_keep_t loc;
+  KEEP_HERE(r_null, &loc);
+
+  char storage[GLUE_TEMPLATE_BUF_SIZE];
+  struct r_dyn_array arr;
+  r_init_dyn_vector_sbo(&arr, R_TYPE_raw, storage, GLUE_TEMPLATE_BUF_SIZE, loc);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* seg = v_tmpl[i];
+    const char* piece = NULL;
+    char int_buf[32];
+
+    // Pieces point into the CHARSXPs of these values, which stay
+    // protected until the piece is copied into the buffer
+    int n_kept = 0;
+
+    switch (r_typeof(seg)) {
+    case R_TYPE_character:
+      piece = Rf_translateCharUTF8(r_chr_get(seg, 0));
+      break;
+
+    case R_TYPE_symbol: {
+      r_obj* value = KEEP_N(r_eval(seg, env), &n_kept);
+      piece = glue_template_format(value, int_buf, sizeof(int_buf));
+      break;
+    }
+
+    case R_TYPE_list: {
+      r_obj* expr = KEEP_N(rlang_enexpr(r_list_get(seg, 0), env), &n_kept);
+      r_obj* label = KEEP_N(r_as_label(expr), &n_kept);
+      piece = Rf_translateCharUTF8(r_chr_get(label, 0));
+
+      // glue interprets curlies in the output of the first pass
+      if (has_curly(piece) || strchr(piece, '}') != NULL) {
+        piece = NULL;
+      }
+      break;
+    }
+
+    default:
+      r_stop_internal("glue_template_interp", "Unexpected segment type.");
+    }
+
+    if (piece == NULL) {
+      FREE(n_kept + 1);
+      return NULL;
+    }
+
+    r_arr_push_back_n(&arr, piece, strlen(piece));
+    FREE(n_kept);
+  }
+
+  r_arr_push_back_n(&arr, NULL, 1);
+
+  r_obj* out = r_alloc_character(1);
+  r_chr_poke(out, 0, Rf_mkCharCE((const char*) arr.v_data, CE_UTF8));
+
+  FREE(1);
+  return out;
+}
+
+// Formats strings and integers like `as.character()` does. Other
+// values, including `NA`, are formatted by glue.
+static
+const char* glue_template_format(r_obj* x, char* buf, size_t n) {
+  if (r_is_object(x) || r_length(x) != 1) {
+    return NULL;
+  }
+
+  switch (r_typeof(x)) {
+  case R_TYPE_character: {
+    r_obj* str = r_chr_get(x, 0);
+    if (str == r_globals.na_str) {
+      return NULL;
+    }
+    return Rf_translateCharUTF8(str);
+  }
+  case R_TYPE_integer: {
+    int value = r_int_get(x, 0);
+    if (value == r_globals.na_int) {
+      return NULL;
+    }
+    snprintf(buf, n, "%d", value);
+    return buf;
+  }
+  default:
+    return NULL;
+  }
+}
+
 static
 r_obj* def_unquote_name(r_obj* expr, r_obj* env) {
   int n_kept = 0;
@@ -333,17 +605,11 @@ static inline
 bool should_ignore(int ignore_empty, r_ssize i, r_ssize n) {
   return ignore_empty == 1 || (i == n - 1 && ignore_empty == -1);
 }
-static inline
-r_obj* dot_get_expr(r_obj* dot) {
-  return r_list_get(dot, 0);
-}
-static inline
-r_obj* dot_get_env(r_obj* dot) {
-  return r_list_get(dot, 1);
-}
-
+// Dots are captured in the compact format of `capturedots_compact()`:
+// expressions in the CAR of the nodes and environments in the
+// parallel list `envs`
 static
-r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
+r_obj* dots_unquote(r_obj* dots, r_obj* envs, struct dots_capture_info* capture_info) {
   capture_info->count = 0;
   r_ssize n = r_length(dots);
   bool unquote_names = capture_info->unquote_names;
@@ -354,15 +620,12 @@ r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
     capture_info->type == DOTS_COLLECT_value &&
     should_auto_name(capture_info->named);
 
+  r_obj* const * v_envs = r_list_cbegin(envs);
+
   r_obj* node = dots;
   for (r_ssize i = 0; node != r_null; ++i, node = r_node_cdr(node)) {
-    r_obj* elt = r_node_car(node);
-    r_obj* expr = dot_get_expr(elt);
-    r_obj* env = dot_get_env(elt);
-
-    // Unquoting rearranges expressions
-    // FIXME: Only duplicate the call tree, not the leaves
-    expr = KEEP(r_copy(expr));
+    r_obj* expr = r_node_car(node);
+    r_obj* env = v_envs[i];
 
     if (unquote_names && r_is_call(expr, ":=")) {
       if (r_node_tag(node) != r_null) {
@@ -392,7 +655,16 @@ r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
       );
     }
 
-    struct injection_info info = which_expansion_op(expr, unquote_names);
+    // Expressions are interpolated with copy-on-write by
+    // `call_interp_cow()`, which signals deprecation warnings for
+    // injection sites. Detect quietly here so these are only signalled
+    // once.
+    struct injection_info info = which_expansion_op_impl(expr, unquote_names, false);
+    if (capture_info->type == DOTS_COLLECT_value || info.op == INJECTION_OP_uqs) {
+      info = which_expansion_op(expr, unquote_names);
+    }
+    KEEP(expr);
+
     enum dots_op dots_op = info.op + (INJECTION_OP_MAX * capture_info->type);
 
     r_obj* name = r_node_tag(node);
@@ -413,7 +685,7 @@ r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
     case DOTS_OP_expr_fixup:
     case DOTS_OP_expr_dot_data:
     case DOTS_OP_expr_curly:
-      expr = call_interp_impl(expr, env, info);
+      expr = call_interp_cow(expr, env);
       capture_info->count += 1;
       break;
     case DOTS_OP_expr_uqs:
@@ -424,7 +696,7 @@ r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
     case DOTS_OP_quo_fixup:
     case DOTS_OP_quo_dot_data:
     case DOTS_OP_quo_curly: {
-      expr = KEEP(call_interp_impl(expr, env, info));
+      expr = KEEP(call_interp_cow(expr, env));
       expr = forward_quosure(expr, env);
       FREE(1);
       capture_info->count += 1;
@@ -460,8 +732,8 @@ r_obj* dots_unquote(r_obj* dots, struct dots_capture_info* capture_info) {
         KEEP_AT(expr, i);
       } else {
         if (needs_autoname && r_node_tag(node) == r_null) {
-          r_obj* label = KEEP(r_as_label(orig));
-          r_node_poke_tag(node, r_str_as_symbol(r_chr_get(label, 0)));
+          r_obj* label = KEEP(auto_name_label(orig));
+          r_node_poke_tag(node, r_str_as_symbol(label));
           FREE(1);
         }
         capture_info->count += 1;
@@ -554,14 +826,200 @@ bool should_auto_name(r_obj* named) {
   r_abort("`.named` must be a scalar logical");
 }
 
+/*
+ * Auto-naming labels unnamed arguments with `as_label()`. The labels
+ * of symbols, scalars, and simple calls like `f(x, 1)` are formatted
+ * in C. Other labels are computed in R and cached by address of the
+ * expression, because wrappers that are called repeatedly auto-name
+ * the same defused expressions over and over.
+ *
+ * To avoid keeping the expressions alive, the cache is dropped at the
+ * next garbage collection, see `struct rlang_addr_cache`.
+ */
+
+#define AUTO_NAME_CACHE_MAX_SIZE 1024
+#define AUTO_NAME_BUF_SIZE 64
+#define AUTO_NAME_MAX_ARGS 4
+
+// Deparsed calls are never broken into multiple lines below this
+// width. `deparse_one()` uses a cutoff of 60 characters.
+#define AUTO_NAME_MAX_WIDTH 50
+
+static
+void auto_name_push_sym(struct r_dyn_array* p_buf, r_obj* sym) {
+  const char* str = Rf_translateCharUTF8(PRINTNAME(sym));
+  r_ssize n = strlen(str);
+
+  bool backticks = deparse_needs_backticks(str, n);
+  if (backticks) {
+    r_arr_push_back_n(p_buf, "`", 1);
+  }
+  r_arr_push_back_n(p_buf, str, n);
+  if (backticks) {
+    r_arr_push_back_n(p_buf, "`", 1);
+  }
+}
+
+// Same as `deparse_one()` for calls to a named function whose
+// arguments are symbols or scalars
+static
+bool auto_name_call_label(struct r_dyn_array* p_buf, r_obj* x) {
+  r_obj* head = r_node_car(x);
+  if (r_typeof(head) != R_TYPE_symbol ||
+      r_attrib(x) != r_null ||
+      r_which_operator(x) != R_OP_NONE) {
+    return false;
+  }
+
+  auto_name_push_sym(p_buf, head);
+  r_arr_push_back_n(p_buf, "(", 1);
+
+  r_obj* node = r_node_cdr(x);
+  for (int i = 0; node != r_null; ++i, node = r_node_cdr(node)) {
+    if (i == AUTO_NAME_MAX_ARGS) {
+      return false;
+    }
+    if (i) {
+      r_arr_push_back_n(p_buf, ", ", 2);
+    }
+
+    r_obj* tag = r_node_tag(node);
+    if (tag != r_null) {
+      if (tag == r_missing_arg) {
+        return false;
+      }
+      auto_name_push_sym(p_buf, tag);
+      r_arr_push_back_n(p_buf, " = ", 3);
+    }
+
+    r_obj* arg = r_node_car(node);
+    switch (r_typeof(arg)) {
+    case R_TYPE_symbol:
+      if (arg == r_missing_arg) {
+        return false;
+      }
+      auto_name_push_sym(p_buf, arg);
+      break;
+    case R_TYPE_logical:
+    case R_TYPE_integer:
+    case R_TYPE_double:
+    case R_TYPE_character:
+      if (r_length(arg) != 1 || !deparse_scalar(p_buf, arg)) {
+        return false;
+      }
+      break;
+    default:
+      return false;
+    }
+
+    if (p_buf->count > AUTO_NAME_MAX_WIDTH) {
+      return false;
+    }
+  }
+
+  r_arr_push_back_n(p_buf, ")", 1);
+  return p_buf->count <= AUTO_NAME_MAX_WIDTH;
+}
+
+// Returns `NULL` if the label needs to be computed in R
+static
+r_obj* auto_name_label_fast(r_obj* x) {
+  if (x == r_missing_arg) {
+    return r_str("<empty>");
+  }
+
+  switch (r_typeof(x)) {
+  case R_TYPE_null:
+    return r_str("NULL");
+  case R_TYPE_symbol:
+    return Rf_mkCharCE(Rf_translateCharUTF8(PRINTNAME(x)), CE_UTF8);
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_character:
+  case R_TYPE_call:
+    break;
+  default:
+    return NULL;
+  }
+
+  r_keep_t loc;
+  KEEP_HERE(r_null, &loc);
+
+  char storage[AUTO_NAME_BUF_SIZE];
+  struct r_dyn_array arr;
+  r_init_dyn_vector_sbo(&arr, R_TYPE_raw, storage, AUTO_NAME_BUF_SIZE, loc);
+
+  bool ok;
+  if (r_typeof(x) == R_TYPE_call) {
+    ok = auto_name_call_label(&arr, x);
+  } else {
+    ok = r_length(x) == 1 && deparse_scalar(&arr, x);
+  }
+
+  r_obj* out = NULL;
+  if (ok) {
+    out = Rf_mkCharLenCE((const char*) arr.v_data, arr.count, CE_UTF8);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Same as `as_label()`. Returns a CHARSXP.
+static
+r_obj* auto_name_label(r_obj* x) {
+  while (rlang_is_quosure(x)) {
+    x = rlang_quo_get_expr_(x);
+  }
+
+  r_obj* label = auto_name_label_fast(x);
+  if (label) {
+    return label;
+  }
+
+  label = rlang_addr_cache_get0(p_auto_name_cache, x);
+  if (label) {
+    return label;
+  }
+
+  r_obj* out = KEEP(r_as_label(x));
+  label = r_chr_get(out, 0);
+  rlang_addr_cache_put(p_auto_name_cache, x, label);
+
+  FREE(1);
+  return label;
+}
+
 static
 r_obj* maybe_auto_name(r_obj* x, r_obj* named) {
   r_obj* names = r_names(x);
 
-  if (should_auto_name(named) && (names == r_null || r_chr_has(names, ""))) {
-    x = r_eval_with_x(auto_name_call, x, r_base_env);
+  if (!should_auto_name(named) || !(names == r_null || r_chr_detect_str(names, r_globals.empty_str) >= 0)) {
+    return x;
   }
 
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  // Callers might still refer to the old names
+  if (names == r_null) {
+    names = KEEP(r_alloc_character(n));
+  } else {
+    names = KEEP(r_clone(names));
+  }
+  r_obj* const * v_names = r_chr_cbegin(names);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* nm = v_names[i];
+    if (nm == r_globals.empty_str || nm == r_globals.na_str) {
+      r_chr_poke(names, i, auto_name_label(v_x[i]));
+    }
+  }
+
+  r_attrib_poke_names(x, names);
+
+  FREE(1);
   return x;
 }
 
@@ -594,7 +1052,40 @@ void check_named_splice(r_obj* node) {
   }
 }
 
+// When the dots consist of a single spliced list, e.g. `list2(!!!x)`,
+// the list is cloned as a whole instead of being copied element by
+// element
+static
+r_obj* dots_as_list_spliced(r_obj* dots, struct dots_capture_info* capture_info) {
+  check_named_splice(dots);
+
+  r_obj* x = rlang_unbox(r_node_car(dots));
+  r_obj* nms = r_names(x);
+
+  r_obj* out = KEEP(r_clone(x));
+  r_poke_attrib(out, r_null);
+
+  if (nms != r_null) {
+    r_attrib_poke_names(out, nms);
+  } else if (capture_info->type != DOTS_COLLECT_value) {
+    nms = KEEP(r_alloc_character(r_length(out)));
+    r_attrib_poke_names(out, nms);
+    FREE(1);
+  }
+
+  FREE(1);
+  return out;
+}
+
 r_obj* dots_as_list(r_obj* dots, struct dots_capture_info* capture_info) {
+  if (capture_info->splice &&
+      dots != r_null &&
+      r_node_cdr(dots) == r_null &&
+      is_splice_box(r_node_car(dots)) &&
+      r_node_car(dots) != empty_spliced_arg) {
+    return dots_as_list_spliced(dots, capture_info);
+  }
+
   int n_kept = 0;
 
   r_obj* out = KEEP_N(r_alloc_list(capture_info->count), &n_kept);
@@ -647,6 +1138,84 @@ r_obj* dots_as_list(r_obj* dots, struct dots_capture_info* capture_info) {
   return out;
 }
 
+// Calls that may be injection operators or otherwise need the full
+// `dots_unquote()` treatment
+static
+const char* dots_special_calls[] = { "!", "{", ":=", "<-" };
+
+// Cheap pre-scan of captured dots. Dots are injection-free when none
+// of them is empty or a call to an operator handled during unquoting.
+static
+bool dots_are_injection_free(r_obj* dots) {
+  int n_special = sizeof(dots_special_calls) / sizeof(dots_special_calls[0]);
+
+  for (r_obj* node = dots; node != r_null; node = r_node_cdr(node)) {
+    r_obj* expr = r_node_car(node);
+
+    if (expr == r_syms.missing) {
+      return false;
+    }
+    if (r_typeof(expr) == R_TYPE_call &&
+        r_is_symbol_any(r_node_car(expr), dots_special_calls, n_special)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Straight path for injection-free dots collected by value. Arguments
+// are evaluated and stored in a preallocated list in a single pass.
+// Splice boxes are still supported but then require going through
+// `dots_as_list()`.
+static
+r_obj* dots_values_fast(r_obj* dots, r_obj* envs, struct dots_capture_info* capture_info) {
+  int n_kept = 0;
+  capture_info->count = 0;
+
+  r_obj* out = KEEP_N(r_alloc_list(r_length(dots)), &n_kept);
+  r_obj* out_names = r_null;
+
+  r_obj* const * v_envs = r_list_cbegin(envs);
+
+  r_obj* node = dots;
+  for (r_ssize i = 0; node != r_null; ++i, node = r_node_cdr(node)) {
+    r_obj* value = r_node_car(node);
+    r_obj* env = v_envs[i];
+
+    if (env != r_empty_env) {
+      value = r_eval(value, env);
+    }
+    KEEP(value);
+
+    if (is_splice_box(value)) {
+      value = dots_big_bang_value(capture_info, rlang_unbox(value), env, false);
+    } else {
+      capture_info->count += 1;
+    }
+
+    r_node_poke_car(node, value);
+    r_list_poke(out, i, value);
+    FREE(1);
+
+    r_obj* tag = r_node_tag(node);
+    if (tag != r_null) {
+      if (out_names == r_null) {
+        out_names = KEEP_N(r_alloc_character(r_length(out)), &n_kept);
+        r_attrib_push(out, r_syms.names, out_names);
+      }
+      r_chr_poke(out_names, i, r_sym_string(tag));
+    }
+  }
+
+  if (capture_info->needs_expansion) {
+    out = dots_as_list(dots, capture_info);
+  }
+
+  FREE(n_kept);
+  return out;
+}
+
 r_obj* dots_as_pairlist(r_obj* dots, struct dots_capture_info* capture_info) {
   r_obj* out = KEEP(r_new_node(r_null, dots));
   r_obj* prev = out;
@@ -694,18 +1263,23 @@ static
 r_obj* dots_keep(r_obj* dots, r_obj* nms, bool first) {
   r_ssize n = r_length(dots);
 
-  r_obj* dups = KEEP(nms_are_duplicated(nms, !first));
-  r_ssize out_n = n - r_lgl_sum(dups, false);
+  r_obj* dups = KEEP(nms_which_duplicated(nms, !first));
+  if (dups == r_null && r_names(dots) == nms) {
+    FREE(1);
+    return dots;
+  }
+
+  const int* p_dups = dups == r_null ? NULL : r_lgl_cbegin(dups);
+  r_ssize out_n = dups == r_null ? n : n - r_lgl_sum(dups, false);
 
   r_obj* out = KEEP(r_alloc_list(out_n));
   r_obj* out_nms = KEEP(r_alloc_character(out_n));
   r_attrib_push(out, r_syms.names, out_nms);
 
   r_obj* const * p_nms = r_chr_cbegin(nms);
-  const int* p_dups = r_lgl_cbegin(dups);
 
   for (r_ssize i = 0, out_i = 0; i < n; ++i) {
-    if (!p_dups[i]) {
+    if (!p_dups || !p_dups[i]) {
       r_list_poke(out, out_i, r_list_get(dots, i));
       r_chr_poke(out_nms, out_i, p_nms[i]);
       ++out_i;
@@ -721,9 +1295,9 @@ r_obj* abort_dots_homonyms_call = NULL;
 
 static
 void dots_check_homonyms(r_obj* dots, r_obj* nms) {
-  r_obj* dups = KEEP(nms_are_duplicated(nms, false));
+  r_obj* dups = KEEP(nms_which_duplicated(nms, false));
 
-  if (r_lgl_sum(dups, false)) {
+  if (dups != r_null) {
     r_eval_with_xy(abort_dots_homonyms_call, dots, dups, r_base_env);
     r_abort("Internal error: `dots_check_homonyms()` should have failed earlier");
   }
@@ -733,13 +1307,17 @@ void dots_check_homonyms(r_obj* dots, r_obj* nms) {
 
 
 // From capture.c
-r_obj* capturedots(r_obj* frame);
+r_obj* capturedots_compact(r_obj* frame, r_obj** p_envs);
 
 static
 r_obj* dots_capture(struct dots_capture_info* capture_info, r_obj* frame_env) {
-  r_obj* dots = KEEP(capturedots(frame_env));
-  dots = dots_unquote(dots, capture_info);
-  FREE(1);
+  r_obj* envs;
+  r_obj* dots = KEEP(capturedots_compact(frame_env, &envs));
+  KEEP(envs);
+
+  dots = dots_unquote(dots, envs, capture_info);
+
+  FREE(2);
   return dots;
 }
 
@@ -826,12 +1404,15 @@ r_obj* rlang_quos_interp(r_obj* frame_env,
   dots = KEEP(dots_as_list(dots, &capture_info));
   dots = KEEP(dots_finalise(&capture_info, dots));
 
-  r_obj* attrib = KEEP(r_new_node(r_names(dots), r_clone(quosures_attrib)));
+  r_obj* names = r_names(dots);
+  dots = KEEP(rlang_quosures_compact(dots));
+
+  r_obj* attrib = KEEP(r_new_node(names, r_clone(quosures_attrib)));
   r_node_poke_tag(attrib, r_syms.names);
   r_poke_attrib(dots, attrib);
   r_mark_object(dots);
 
-  FREE(4);
+  FREE(5);
   return dots;
 }
 
@@ -858,6 +1439,8 @@ r_obj* dots_values_impl(r_obj* frame_env,
                         r_obj* homonyms,
                         r_obj* check_assign,
                         bool splice) {
+  RLANG_EVENT_ENTER(dots_values, 0);
+
   struct dots_capture_info capture_info;
   capture_info = init_capture_info(DOTS_COLLECT_value,
                                    named,
@@ -868,18 +1451,33 @@ r_obj* dots_values_impl(r_obj* frame_env,
                                    check_assign,
                                    &dots_big_bang_coerce,
                                    splice);
-  r_obj* dots;
-  dots = KEEP(dots_capture(&capture_info, frame_env));
-
-  if (capture_info.needs_expansion) {
-    dots = KEEP(dots_as_list(dots, &capture_info));
+  r_obj* envs;
+  r_obj* dots = KEEP(capturedots_compact(frame_env, &envs));
+  KEEP(envs);
+
+  // Auto-naming needs the defused expressions and takes the slow path
+  bool fast =
+    r_typeof(named) == R_TYPE_logical &&
+    r_length(named) == 1 &&
+    !r_lgl_get(named, 0) &&
+    dots_are_injection_free(dots);
+
+  if (fast) {
+    dots = KEEP(dots_values_fast(dots, envs, &capture_info));
   } else {
-    dots = KEEP(r_vec_coerce(dots, R_TYPE_list));
+    dots = dots_unquote(dots, envs, &capture_info);
+
+    if (capture_info.needs_expansion) {
+      dots = KEEP(dots_as_list(dots, &capture_info));
+    } else {
+      dots = KEEP(r_vec_coerce(dots, R_TYPE_list));
+    }
   }
 
   dots = dots_finalise(&capture_info, dots);
+  RLANG_EVENT_EXIT(dots_values, r_length(dots));
 
-  FREE(2);
+  FREE(3);
   return dots;
 }
 
@@ -942,6 +1540,169 @@ r_obj* rlang_dots_list(r_obj* frame_env,
                           check_assign,
                           true);
 }
+
+// Lazy dots -------------------------------------------------------------
+
+// Returns a list of the promises and literals stored in the `...` of
+// `frame_env`, with names. A trailing empty argument is ignored, other
+// empty arguments are an error.
+static
+r_obj* dots_promises(r_obj* frame_env) {
+  r_obj* dots = r_env_find(frame_env, r_syms.dots);
+  if (dots == r_syms.unbound) {
+    r_abort("`...` used in an incorrect context.");
+  }
+  if (dots == r_missing_arg) {
+    dots = r_null;
+  }
+
+  r_ssize n = r_length(dots);
+  r_obj* last = n ? r_node_car(r_pairlist_tail(dots)) : r_null;
+  if (last == r_missing_arg && r_node_tag(r_pairlist_tail(dots)) == r_null) {
+    --n;
+  }
+
+  r_obj* out = KEEP(r_alloc_list(n));
+  r_obj* nms = KEEP(r_alloc_character(n));
+  r_attrib_poke_names(out, nms);
+
+  for (r_ssize i = 0; i < n; ++i, dots = r_node_cdr(dots)) {
+    r_obj* elt = r_node_car(dots);
+    if (elt == r_missing_arg) {
+      r_abort("Argument %d is empty", (int) i + 1);
+    }
+    r_list_poke(out, i, elt);
+
+    r_obj* tag = r_node_tag(dots);
+    if (tag != r_null) {
+      r_chr_poke(nms, i, r_sym_string(tag));
+    }
+  }
+
+  FREE(2);
+  return out;
+}
+
+static inline
+r_obj* dots_force(r_obj* elt) {
+  if (r_typeof(elt) == R_TYPE_promise) {
+    // Forcing through `eval()` caches the value in the promise
+    return r_eval(elt, r_empty_env);
+  } else {
+    return elt;
+  }
+}
+
+#if R_HAS_ALTLIST
+
+// The promises are stored in `data1` and their values in the `data2`
+// cache, with `r_syms.unbound` marking unforced elements. Once all
+// elements are forced, `data1` is set to `NULL`.
+static
+R_altrep_class_t lazy_dots_class;
+
+static
+R_xlen_t lazy_dots_length(r_obj* x) {
+  return r_length(R_altrep_data2(x));
+}
+
+static
+r_obj* lazy_dots_elt(r_obj* x, R_xlen_t i) {
+  r_obj* cache = R_altrep_data2(x);
+  r_obj* out = r_list_get(cache, i);
+
+  if (out == r_syms.unbound) {
+    out = dots_force(r_list_get(R_altrep_data1(x), i));
+    r_list_poke(cache, i, out);
+  }
+
+  return out;
+}
+
+static
+r_obj* lazy_dots_materialise(r_obj* x) {
+  r_obj* cache = R_altrep_data2(x);
+  if (R_altrep_data1(x) == r_null) {
+    return cache;
+  }
+
+  r_ssize n = r_length(cache);
+  for (r_ssize i = 0; i < n; ++i) {
+    lazy_dots_elt(x, i);
+  }
+
+  R_set_altrep_data1(x, r_null);
+  return cache;
+}
+
+static
+void lazy_dots_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_list_poke(lazy_dots_materialise(x), i, value);
+}
+
+static
+void* lazy_dots_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(lazy_dots_materialise(x));
+}
+
+static
+Rboolean lazy_dots_inspect(r_obj* x,
+                           int pre,
+                           int deep,
+                           int pvec,
+                           void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_lazy_dots (len=%ld, materialised=%s)\n",
+          (long) lazy_dots_length(x),
+          R_altrep_data1(x) == r_null ? "T" : "F");
+  return TRUE;
+}
+
+r_obj* ffi_dots_list_lazy(r_obj* frame_env) {
+  r_obj* promises = KEEP(dots_promises(frame_env));
+  r_ssize n = r_length(promises);
+
+  r_obj* cache = KEEP(r_alloc_list(n));
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(cache, i, r_syms.unbound);
+  }
+
+  r_obj* out = KEEP(R_new_altrep(lazy_dots_class, promises, cache));
+  r_attrib_poke_names(out, r_names(promises));
+
+  FREE(3);
+  return out;
+}
+
+void rlang_init_dots_altrep(DllInfo* dll) {
+  lazy_dots_class = R_make_altlist_class("rlang_lazy_dots", "rlang", dll);
+
+  R_set_altrep_Length_method(lazy_dots_class, &lazy_dots_length);
+  R_set_altrep_Inspect_method(lazy_dots_class, &lazy_dots_inspect);
+  R_set_altvec_Dataptr_method(lazy_dots_class, &lazy_dots_dataptr);
+  R_set_altlist_Elt_method(lazy_dots_class, &lazy_dots_elt);
+  R_set_altlist_Set_elt_method(lazy_dots_class, &lazy_dots_set_elt);
+}
+
+#else
+
+// ALTREP lists require R 4.3.0. Force everything on older versions.
+r_obj* ffi_dots_list_lazy(r_obj* frame_env) {
+  r_obj* out = KEEP(dots_promises(frame_env));
+
+  r_ssize n = r_length(out);
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i, dots_force(r_list_get(out, i)));
+  }
+
+  FREE(1);
+  return out;
+}
+
+void rlang_init_dots_altrep(DllInfo* dll) { }
+
+#endif
+
+
 r_obj* rlang_dots_flat_list(r_obj* frame_env,
                             r_obj* named,
                             r_obj* ignore_empty,
@@ -980,6 +1741,8 @@ r_obj* dots_values_node_impl(r_obj* frame_env,
                              r_obj* homonyms,
                              r_obj* check_assign,
                              bool splice) {
+  RLANG_EVENT_ENTER(dots_values, 0);
+
   struct dots_capture_info capture_info;
   capture_info = init_capture_info(DOTS_COLLECT_value,
                                    named,
@@ -1018,11 +1781,68 @@ r_obj* rlang_dots_pairlist(r_obj* frame_env,
                                true);
 }
 
+
+/*
+ * These inspect the `...` of a frame without looking at the values of
+ * the arguments. Promises are not forced and empty arguments are
+ * detected as the missing argument stored in the dots, so an argument
+ * forwarded from a missing argument of another function is not
+ * empty. Only the result is allocated.
+ */
+
+static
+r_obj* frame_dots_node(r_obj* frame, const char* fn) {
+  if (r_typeof(frame) != R_TYPE_environment) {
+    r_stop_internal(fn, "`frame` must be an environment.");
+  }
+
+  r_obj* dots = r_env_find(frame, r_syms.dots);
+
+  if (dots == r_syms.unbound) {
+    r_abort("No `...` in this frame.");
+  }
+  if (r_typeof(dots) != R_TYPE_dots) {
+    return r_null;
+  }
+
+  return dots;
+}
+
+r_obj* ffi_dots_frame_names(r_obj* frame) {
+  r_obj* dots = frame_dots_node(frame, "ffi_dots_frame_names");
+  r_ssize n = r_length(dots);
+
+  r_obj* out = KEEP(r_alloc_character(n));
+
+  for (r_ssize i = 0; i < n; ++i, dots = r_node_cdr(dots)) {
+    r_obj* tag = r_node_tag(dots);
+    r_chr_poke(out, i, tag == r_null ? r_globals.empty_str : PRINTNAME(tag));
+  }
+
+  FREE(1);
+  return out;
+}
+
+r_obj* ffi_dots_frame_missing(r_obj* frame) {
+  r_obj* dots = frame_dots_node(frame, "ffi_dots_frame_missing");
+  r_ssize n = r_length(dots);
+
+  r_obj* out = KEEP(r_alloc_logical(n));
+  int* v_out = r_lgl_begin(out);
+
+  for (r_ssize i = 0; i < n; ++i, dots = r_node_cdr(dots)) {
+    v_out[i] = r_node_car(dots) == r_syms.missing;
+  }
+
+  FREE(1);
+  return out;
+}
+
 void rlang_init_dots(r_obj* ns) {
   glue_unquote_fn = r_eval(r_sym("glue_unquote"), ns);
 
-  auto_name_call = r_parse("rlang:::quos_auto_name(x)");
-  r_preserve(auto_name_call);
+  p_auto_name_cache = rlang_new_addr_cache(AUTO_NAME_CACHE_MAX_SIZE, true);
+  r_preserve(p_auto_name_cache->shelter);
 
   abort_dots_homonyms_call = r_parse("rlang:::abort_dots_homonyms(x, y)");
   r_preserve(abort_dots_homonyms_call);
@@ -1063,11 +1883,20 @@ void rlang_init_dots(r_obj* ns) {
 
   as_label_call = r_parse("as_label(x)");
   r_preserve(as_label_call);
+
+  p_glue_templates = rlang_new_addr_cache(GLUE_TEMPLATES_MAX_SIZE, false);
+  r_preserve(p_glue_templates->shelter);
+
+  glue_template_none = r_true;
+  glue_template_fallback = r_false;
 }
 
 static r_obj* as_label_call = NULL;
 static r_obj* empty_spliced_arg = NULL;
 static r_obj* splice_box_attrib = NULL;
 static r_obj* quosures_attrib = NULL;
-static r_obj* auto_name_call = NULL;
+static struct rlang_addr_cache* p_auto_name_cache = NULL;
 static r_obj* glue_unquote_fn = NULL;
+static struct rlang_addr_cache* p_glue_templates = NULL;
+static r_obj* glue_template_none = NULL;
+static r_obj* glue_template_fallback = NULL;
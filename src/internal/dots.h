@@ -9,6 +9,9 @@ enum dots_collect {
 };
 #define DOTS_COLLECT_MAX 3
 
+// Registers the ALTREP class of lazy dots lists
+void rlang_init_dots_altrep(DllInfo* dll);
+
 enum dots_op {
   DOTS_OP_expr_none,
   DOTS_OP_expr_uq,
@@ -3,6 +3,7 @@
 
 
 static r_obj* rlang_env_get_sym(r_obj* env, r_obj* nm, bool inherit, r_obj* closure_env);
+static r_obj* env_get_list_inherit(r_obj* env, r_obj* nms, r_obj* closure_env);
 
 r_obj* rlang_env_get(r_obj* env, r_obj* nm, r_obj* inherit, r_obj* closure_env) {
   if (r_typeof(env) != R_TYPE_environment) {
@@ -57,6 +58,10 @@ r_obj* rlang_env_get_list(r_obj* env, r_obj* nms, r_obj* inherit, r_obj* closure
   bool c_inherit = r_lgl_get(inherit, 0);
   r_ssize n = r_length(nms);
 
+  if (c_inherit) {
+    return env_get_list_inherit(env, nms, closure_env);
+  }
+
   r_obj* out = KEEP(r_alloc_list(n));
   r_attrib_poke_names(out, nms);
 
@@ -72,6 +77,78 @@ r_obj* rlang_env_get_list(r_obj* env, r_obj* nms, r_obj* inherit, r_obj* closure
   return out;
 }
 
+/*
+ * Walks the chain of environments once for the whole batch of names.
+ * The names that are still unresolved are looked up in each frame
+ * before moving on to the parent. Promises are forced afterwards, in
+ * the order of `nms`, and `default` is evaluated at most once.
+ */
+static
+r_obj* env_get_list_inherit(r_obj* env, r_obj* nms, r_obj* closure_env) {
+  r_ssize n = r_length(nms);
+  r_obj* const * v_nms = r_chr_cbegin(nms);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+  r_attrib_poke_names(out, nms);
+
+  r_obj* pending = KEEP(r_alloc_raw(n * sizeof(r_ssize)));
+  r_ssize* v_pending = r_raw_begin(pending);
+  r_ssize n_pending = n;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    v_pending[i] = i;
+  }
+
+  while (n_pending && env != r_empty_env) {
+    r_ssize n_remaining = 0;
+
+    for (r_ssize j = 0; j < n_pending; ++j) {
+      r_ssize i = v_pending[j];
+      r_obj* sym = r_str_as_symbol(v_nms[i]);
+      r_obj* value = r_env_find(env, sym);
+
+      if (value == r_syms.unbound) {
+        v_pending[n_remaining++] = i;
+      } else {
+        r_list_poke(out, i, value);
+      }
+    }
+
+    n_pending = n_remaining;
+    env = r_env_parent(env);
+  }
+
+  // Flag the missing elements so they can be told apart from
+  // resolved ones when promises are forced
+  for (r_ssize j = 0; j < n_pending; ++j) {
+    r_list_poke(out, v_pending[j], r_syms.unbound);
+  }
+
+  r_obj* deflt = NULL;
+  r_keep_t deflt_shelter;
+  KEEP_HERE(r_null, &deflt_shelter);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* value = r_list_get(out, i);
+
+    if (r_typeof(value) == R_TYPE_promise) {
+      r_list_poke(out, i, r_eval(value, r_empty_env));
+      continue;
+    }
+
+    if (value == r_syms.unbound) {
+      if (!deflt) {
+        deflt = r_eval(r_sym("default"), closure_env);
+        KEEP_AT(deflt, deflt_shelter);
+      }
+      r_list_poke(out, i, deflt);
+    }
+  }
+
+  FREE(3);
+  return out;
+}
+
 r_obj* rlang_env_has(r_obj* env, r_obj* nms, r_obj* inherit) {
   if (r_typeof(env) != R_TYPE_environment) {
     r_abort("`env` must be an environment.");
@@ -10,6 +10,83 @@ r_obj* rlang_env_unlock(r_obj* env) {
   return FRAME_IS_LOCKED(env) == 0 ? r_true : r_false;
 }
 
+r_obj* ffi_env_as_list(r_obj* env, r_obj* eval_active) {
+  if (r_typeof(env) != R_TYPE_environment) {
+    r_abort("`env` must be an environment.");
+  }
+  if (!r_is_bool(eval_active)) {
+    r_abort("`eval_active` must be `TRUE` or `FALSE`.");
+  }
+  return r_env_as_list_opts(env, r_lgl_get(eval_active, 0));
+}
+
+
+static
+void check_env(r_obj* env) {
+  if (r_typeof(env) != R_TYPE_environment) {
+    r_abort("`env` must be an environment.");
+  }
+}
+
+r_obj* ffi_env_depth(r_obj* env) {
+  check_env(env);
+
+  int n = 0;
+  while (env != r_empty_env) {
+    env = r_env_parent(env);
+    ++n;
+  }
+
+  return r_int(n);
+}
+
+// Parents of `env` up to `last` included, or up to the empty
+// environment if `last` is not an ancestor
+r_obj* ffi_env_parents(r_obj* env, r_obj* last) {
+  check_env(env);
+  if (last != r_null && r_typeof(last) != R_TYPE_environment) {
+    r_abort("`last` must be `NULL` or an environment");
+  }
+
+  if (env == r_empty_env) {
+    return r_alloc_list(0);
+  }
+
+  r_ssize n = 0;
+  r_obj* parent = env;
+  do {
+    parent = r_env_parent(parent);
+    ++n;
+  } while (parent != last && parent != r_empty_env);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    env = r_env_parent(env);
+    r_list_poke(out, i, env);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Last environment before `last` or the empty environment
+r_obj* ffi_env_tail(r_obj* env, r_obj* last) {
+  check_env(env);
+  if (env == r_empty_env) {
+    r_abort("The empty environment has no parent");
+  }
+
+  r_obj* parent = r_env_parent(env);
+
+  while (parent != last && parent != r_empty_env) {
+    env = parent;
+    parent = r_env_parent(parent);
+  }
+
+  return env;
+}
+
 
 void r_env_unbind_anywhere(r_obj* env, r_obj* sym) {
   while (env != r_empty_env) {
@@ -22,8 +99,12 @@ void r_env_unbind_anywhere(r_obj* env, r_obj* sym) {
   }
 }
 
+// Below this number of names, removing them one at a time is cheaper
+// than building a dictionary of symbols
+#define ENV_UNBIND_BULK_THRESHOLD 16
+
 static
-void env_unbind_names(r_obj* env, r_obj* names, bool inherit) {
+void env_unbind_names_loop(r_obj* env, r_obj* names, bool inherit) {
   r_obj* const * p_names = r_chr_cbegin(names);
   r_ssize n = r_length(names);
 
@@ -40,6 +121,51 @@ void env_unbind_names(r_obj* env, r_obj* names, bool inherit) {
   }
 }
 
+/*
+ * Removes the names found in each frame. With `inherit`, the chain of
+ * environments is walked once and the search stops when all names
+ * have been found. Duplicate names unbind several levels
+ * with `inherit` and go through the loop to preserve that behaviour.
+ * Locked environments also go through the loop so that R signals its
+ * error even when the names are not bound.
+ */
+static
+void env_unbind_names(r_obj* env, r_obj* names, bool inherit) {
+  r_ssize n = r_length(names);
+
+  if (n < ENV_UNBIND_BULK_THRESHOLD ||
+      (!inherit && R_EnvironmentIsLocked(env))) {
+    env_unbind_names_loop(env, names, inherit);
+    return;
+  }
+
+  r_obj* const * p_names = r_chr_cbegin(names);
+
+  struct r_dict* p_syms = r_new_dict(n);
+  KEEP(p_syms->shelter);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* sym = r_str_as_symbol(p_names[i]);
+
+    if (!r_dict_put(p_syms, sym, r_null) && inherit) {
+      env_unbind_names_loop(env, names, inherit);
+      FREE(1);
+      return;
+    }
+  }
+
+  if (inherit) {
+    while (env != r_empty_env && p_syms->n_entries) {
+      r_env_unbind_dict(env, p_syms);
+      env = r_env_parent(env);
+    }
+  } else {
+    r_env_unbind_dict(env, p_syms);
+  }
+
+  FREE(1);
+}
+
 void r_env_unbind_names(r_obj* env, r_obj* names) {
   env_unbind_names(env, names, false);
 }
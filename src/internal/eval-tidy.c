@@ -1,10 +1,40 @@
 #include <rlang.h>
+#include "events.h"
 #include "internal.h"
 
 
 static r_obj* quo_mask_flag_sym = NULL;
 static r_obj* data_mask_flag_sym = NULL;
 
+/*
+ * The bookkeeping of a data mask is stored in a single binding of the
+ * mask, the data mask flag. Its value is a list of the mask itself,
+ * the top of the mask, the environment of the `.env` pronoun, the
+ * pronoun or `NULL` if it hasn't been created yet, and the names of
+ * the columns or `r_syms.unbound` if the mask wasn't created from a
+ * list. The `.env` pronoun is bound to a promise that creates it on
+ * first access, since most expressions never refer to it.
+ */
+
+enum mask_slot {
+  MASK_SLOT_mask = 0,
+  MASK_SLOT_top,
+  MASK_SLOT_ctxt_env,
+  MASK_SLOT_ctxt_pronoun,
+  MASK_SLOT_names,
+  MASK_SLOT_SIZE
+};
+
+// Returns `NULL` if `mask` is not a data mask
+static inline
+r_obj* mask_slot(r_obj* mask) {
+  r_obj* slot = r_env_find(mask, data_mask_flag_sym);
+  if (r_typeof(slot) != R_TYPE_list || r_length(slot) != MASK_SLOT_SIZE) {
+    return NULL;
+  }
+  return slot;
+}
+
 enum rlang_mask_type {
   RLANG_MASK_DATA,     // Full data mask
   RLANG_MASK_QUOSURE,  // Quosure mask with only `~` binding
@@ -25,6 +55,9 @@ static struct rlang_mask_info mask_info(r_obj* mask) {
 
   flag = r_env_find_anywhere(mask, data_mask_flag_sym);
   if (flag != r_syms.unbound) {
+    if (r_typeof(flag) == R_TYPE_list && r_length(flag) == MASK_SLOT_SIZE) {
+      flag = r_list_get(flag, MASK_SLOT_mask);
+    }
     return (struct rlang_mask_info) { flag, RLANG_MASK_DATA };
   }
 
@@ -41,17 +74,34 @@ static r_obj* data_pronoun_class = NULL;
 static r_obj* ctxt_pronoun_class = NULL;
 static r_obj* data_mask_env_sym = NULL;
 
-static r_obj* rlang_new_data_pronoun(r_obj* mask) {
-  r_obj* pronoun = KEEP(r_alloc_list(1));
+/*
+ * Data pronouns wrap either an environment, typically a data mask, or
+ * a list. Lists are wrapped as is and their columns are looked up by
+ * name. Small lists are scanned linearly. A dictionary of the names
+ * of larger lists is created on the first lookup and cached in the
+ * pronoun, so that creating a pronoun doesn't depend on the number
+ * of columns.
+ */
+
+enum data_pronoun_slot {
+  DATA_PRONOUN_data = 0,
+  DATA_PRONOUN_index,
+  DATA_PRONOUN_SIZE
+};
+
+#define DATA_PRONOUN_INDEX_THRESHOLD 16
+
+static r_obj* rlang_new_data_pronoun(r_obj* data) {
+  r_obj* pronoun = KEEP(r_alloc_list(DATA_PRONOUN_SIZE));
 
-  r_list_poke(pronoun, 0, mask);
+  r_list_poke(pronoun, DATA_PRONOUN_data, data);
   r_attrib_poke(pronoun, r_syms.class, data_pronoun_class);
 
   FREE(1);
   return pronoun;
 }
-static r_obj* rlang_new_ctxt_pronoun(r_obj* top) {
-  r_obj* pronoun = KEEP(r_alloc_environment(0, r_env_parent(top)));
+static r_obj* rlang_new_ctxt_pronoun(r_obj* env) {
+  r_obj* pronoun = KEEP(r_alloc_environment(0, env));
 
   r_attrib_poke(pronoun, r_syms.class, ctxt_pronoun_class);
 
@@ -59,19 +109,73 @@ static r_obj* rlang_new_ctxt_pronoun(r_obj* top) {
   return pronoun;
 }
 
+// Forces the `.env` promise of a data mask
+r_obj* ffi_mask_ctxt_pronoun(r_obj* slot) {
+  if (r_typeof(slot) != R_TYPE_list || r_length(slot) != MASK_SLOT_SIZE) {
+    r_stop_internal("ffi_mask_ctxt_pronoun", "Data mask is corrupt.");
+  }
+
+  r_obj* pronoun = r_list_get(slot, MASK_SLOT_ctxt_pronoun);
+  if (pronoun == r_null) {
+    pronoun = rlang_new_ctxt_pronoun(r_list_get(slot, MASK_SLOT_ctxt_env));
+    r_list_poke(slot, MASK_SLOT_ctxt_pronoun, pronoun);
+  }
+
+  return pronoun;
+}
+
+static
+void mask_slot_poke_ctxt_env(r_obj* slot, r_obj* env) {
+  r_list_poke(slot, MASK_SLOT_ctxt_env, env);
+
+  r_obj* pronoun = r_list_get(slot, MASK_SLOT_ctxt_pronoun);
+  if (pronoun != r_null) {
+    r_env_poke_parent(pronoun, env);
+  }
+}
+
 void poke_ctxt_env(r_obj* mask, r_obj* env) {
-  r_obj* ctxt_pronoun = r_env_find(mask, data_mask_env_sym);
+  r_obj* slot = mask_slot(mask);
 
-  if (ctxt_pronoun == r_syms.unbound) {
+  if (!slot) {
     r_abort("Internal error: Can't find context pronoun in data mask");
   }
 
-  r_env_poke_parent(ctxt_pronoun, env);
+  mask_slot_poke_ctxt_env(slot, env);
 }
 
 
 static r_obj* empty_names_chr;
 
+/*
+ * Names vectors recently checked for uniqueness, so that masks
+ * repeatedly created over the same data, e.g. one per group, don't
+ * hash the names each time. The cache keeps its names alive, so their
+ * address can't be reused, and marks them as shared, so that they are
+ * copied rather than modified in place.
+ */
+#define UNIQUE_NAMES_CACHE_SIZE 16
+static r_obj* unique_names_cache = NULL;
+static r_ssize unique_names_cache_i = 0;
+
+static inline
+bool unique_names_cache_has(r_obj* names) {
+  r_obj* const * v_cache = r_list_cbegin(unique_names_cache);
+
+  for (r_ssize i = 0; i < UNIQUE_NAMES_CACHE_SIZE; ++i) {
+    if (v_cache[i] == names) {
+      return true;
+    }
+  }
+  return false;
+}
+static inline
+void unique_names_cache_push(r_obj* names) {
+  r_mark_shared(names);
+  r_list_poke(unique_names_cache, unique_names_cache_i, names);
+  unique_names_cache_i = (unique_names_cache_i + 1) % UNIQUE_NAMES_CACHE_SIZE;
+}
+
 static void check_unique_names(r_obj* x) {
   // Allow empty lists
   if (!r_length(x)) {
@@ -82,9 +186,13 @@ static void check_unique_names(r_obj* x) {
   if (names == r_null) {
     r_abort("`data` must be uniquely named but does not have names");
   }
+  if (unique_names_cache_has(names)) {
+    return;
+  }
   if (vec_find_first_duplicate(names, empty_names_chr, NULL)) {
     r_abort("`data` must be uniquely named but has duplicate columns");
   }
+  unique_names_cache_push(names);
 }
 r_obj* rlang_as_data_pronoun(r_obj* x) {
   int n_kept = 0;
@@ -99,8 +207,13 @@ r_obj* rlang_as_data_pronoun(r_obj* x) {
     x = KEEP_N(r_vec_coerce(x, R_TYPE_list), &n_kept);
     // fallthrough
   case R_TYPE_list:
-    check_unique_names(x);
-    x = KEEP_N(r_list_as_environment(x, r_empty_env), &n_kept);
+    if (r_length(x) && r_names(x) == r_null) {
+      r_abort("`data` must be uniquely named but does not have names");
+    }
+    // The names of larger lists are checked when they are indexed
+    if (r_length(x) <= DATA_PRONOUN_INDEX_THRESHOLD) {
+      check_unique_names(x);
+    }
     break;
   case R_TYPE_environment:
     break;
@@ -116,6 +229,7 @@ r_obj* rlang_as_data_pronoun(r_obj* x) {
 
 
 static r_obj* data_mask_top_env_sym = NULL;
+static r_obj* ctxt_pronoun_promise_call = NULL;
 
 static void check_data_mask_input(r_obj* env, const char* arg) {
   if (r_typeof(env) != R_TYPE_environment) {
@@ -135,26 +249,7 @@ static void check_data_mask_top(r_obj* bottom, r_obj* top) {
   r_abort("Can't create data mask because `top` is not a parent of `bottom`");
 }
 
-static r_obj* env_sym = NULL;
-static r_obj* old_sym = NULL;
-static r_obj* mask_sym = NULL;
-
 static r_obj* tilde_fn = NULL;
-static r_obj* restore_mask_fn = NULL;
-
-static void on_exit_restore_lexical_env(r_obj* mask, r_obj* old, r_obj* frame) {
-  r_obj* fn = KEEP(r_clone(restore_mask_fn));
-
-  r_obj* env = KEEP(r_alloc_environment(2, r_base_env));
-  r_env_poke(env, mask_sym, mask);
-  r_env_poke(env, old_sym, old);
-  r_fn_poke_env(fn, env);
-
-  r_obj* call = KEEP(r_new_call(fn, r_null));
-  r_on_exit(call, frame);
-
-  FREE(3);
-}
 
 r_obj* rlang_new_data_mask(r_obj* bottom, r_obj* top) {
   r_obj* data_mask;
@@ -179,12 +274,15 @@ r_obj* rlang_new_data_mask(r_obj* bottom, r_obj* top) {
     check_data_mask_top(bottom, top);
   }
 
-  r_obj* ctxt_pronoun = KEEP(rlang_new_ctxt_pronoun(top));
+  r_obj* slot = KEEP(r_alloc_list(MASK_SLOT_SIZE));
+  r_list_poke(slot, MASK_SLOT_mask, data_mask);
+  r_list_poke(slot, MASK_SLOT_top, top);
+  r_list_poke(slot, MASK_SLOT_ctxt_env, r_env_parent(top));
+  r_list_poke(slot, MASK_SLOT_names, r_syms.unbound);
 
   r_env_poke(data_mask, r_syms.tilde, tilde_fn);
-  r_env_poke(data_mask, data_mask_flag_sym, data_mask);
-  r_env_poke(data_mask, data_mask_env_sym, ctxt_pronoun);
-  r_env_poke(data_mask, data_mask_top_env_sym, top);
+  r_env_poke(data_mask, data_mask_flag_sym, slot);
+  r_env_poke_lazy(data_mask, data_mask_env_sym, ctxt_pronoun_promise_call, data_mask);
 
   FREE(2);
   return data_mask;
@@ -200,13 +298,14 @@ static r_obj* mask_find(r_obj* env, r_obj* sym) {
     r_abort("Internal error: Data pronoun must be subset with a symbol");
   }
 
-  r_obj* top_env = r_env_find(env, data_mask_top_env_sym);
-  if (r_typeof(top_env) == R_TYPE_environment) {
+  r_obj* slot = mask_slot(env);
+  r_obj* top_env;
+  if (slot) {
     // Start lookup in the parent if the pronoun wraps a data mask
+    top_env = r_list_get(slot, MASK_SLOT_top);
     env = r_env_parent(env);
   } else {
-    // Data pronouns created from lists or data frames are converted
-    // to a simple environment whose ancestry shouldn't be looked up.
+    // The ancestry of other environments shouldn't be looked up
     top_env = env;
   }
   int n_kept = 0;
@@ -236,12 +335,97 @@ static r_obj* mask_find(r_obj* env, r_obj* sym) {
   FREE(n_kept);
   return r_syms.unbound;
 }
-r_obj* rlang_data_pronoun_get(r_obj* pronoun, r_obj* sym) {
-  if (r_typeof(pronoun) != R_TYPE_environment) {
-    r_abort("Internal error: Data pronoun must wrap an environment");
+// Symbols are created from strings translated to the native
+// encoding. Names in other encodings must be translated to match the
+// print name of the symbol.
+static inline
+r_obj* data_pronoun_key(r_obj* str) {
+  if (Rf_getCharCE(str) == CE_NATIVE) {
+    return str;
+  } else {
+    return PRINTNAME(r_str_as_symbol(str));
+  }
+}
+
+static
+r_obj* data_pronoun_list_scan(r_obj* x, r_obj* key) {
+  r_obj* names = r_names(x);
+  if (names == r_null) {
+    return r_syms.unbound;
+  }
+
+  r_ssize n = r_length(names);
+  r_obj* const * v_names = r_chr_cbegin(names);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_names[i] == key || data_pronoun_key(v_names[i]) == key) {
+      return r_list_get(x, i);
+    }
+  }
+
+  return r_syms.unbound;
+}
+
+static
+struct r_dict* data_pronoun_index(r_obj* pronoun, r_obj* x) {
+  r_obj* index = r_list_get(pronoun, DATA_PRONOUN_index);
+
+  // The pointer to the dictionary is stale if the pronoun was copied
+  // or serialised
+  if (index != r_null) {
+    struct r_dict* p_dict = r_raw_begin(r_list_get(index, 0));
+    if (p_dict->shelter == index) {
+      return p_dict;
+    }
+  }
+
+  r_obj* names = r_names(x);
+  r_ssize n = r_length(names);
+  r_obj* const * v_names = r_chr_cbegin(names);
+
+  struct r_dict* p_dict = r_new_dict(n);
+  KEEP(p_dict->shelter);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* nm = v_names[i];
+    if (nm == r_globals.empty_str || nm == r_globals.na_str) {
+      continue;
+    }
+    if (!r_dict_put(p_dict, data_pronoun_key(nm), r_list_get(x, i))) {
+      r_abort("`data` must be uniquely named but has duplicate columns");
+    }
+  }
+
+  r_list_poke(pronoun, DATA_PRONOUN_index, p_dict->shelter);
+
+  FREE(1);
+  return p_dict;
+}
+
+static
+r_obj* data_pronoun_list_find(r_obj* pronoun, r_obj* x, r_obj* sym) {
+  r_obj* key = PRINTNAME(sym);
+
+  if (pronoun == r_null || r_length(x) <= DATA_PRONOUN_INDEX_THRESHOLD) {
+    return data_pronoun_list_scan(x, key);
+  }
+
+  r_obj* out = r_dict_get0(data_pronoun_index(pronoun, x), key);
+  return out ? out : r_syms.unbound;
+}
+
+static
+r_obj* data_pronoun_find(r_obj* pronoun, r_obj* data, r_obj* sym) {
+  switch (r_typeof(data)) {
+  case R_TYPE_environment: return mask_find(data, sym);
+  case R_TYPE_list: return data_pronoun_list_find(pronoun, data, sym);
+  default: r_abort("Internal error: Data pronoun must wrap an environment or a list");
   }
+}
 
-  r_obj* obj = mask_find(pronoun, sym);
+static
+r_obj* data_pronoun_get(r_obj* pronoun, r_obj* data, r_obj* sym) {
+  r_obj* obj = data_pronoun_find(pronoun, data, sym);
 
   if (obj == r_syms.unbound) {
     r_obj* call = KEEP(r_parse("rlang:::abort_data_pronoun(x)"));
@@ -253,6 +437,29 @@ r_obj* rlang_data_pronoun_get(r_obj* pronoun, r_obj* sym) {
   return obj;
 }
 
+// Takes the environment or list wrapped by a pronoun
+r_obj* rlang_data_pronoun_get(r_obj* data, r_obj* sym) {
+  return data_pronoun_get(r_null, data, sym);
+}
+
+// Called by the `$` and `[[` methods of the data pronoun. Validating
+// and converting the name here rather than in R keeps subsetting
+// cheap in tight loops over `.data$col`.
+r_obj* ffi_data_pronoun_get(r_obj* x, r_obj* nm) {
+  if (!r_is_string(nm)) {
+    r_abort("Must subset the data pronoun with a string.");
+  }
+  if (r_typeof(x) != R_TYPE_list || r_length(x) < 1) {
+    r_stop_internal("ffi_data_pronoun_get", "Data pronoun is corrupt.");
+  }
+
+  // Pronouns created by older versions only have the data slot
+  r_obj* pronoun = r_length(x) == DATA_PRONOUN_SIZE ? x : r_null;
+
+  r_obj* sym = r_str_as_symbol(r_chr_get(nm, 0));
+  return data_pronoun_get(pronoun, r_list_get(x, DATA_PRONOUN_data), sym);
+}
+
 static void warn_env_as_mask_once() {
   const char* msg =
     "Passing an environment as data mask is deprecated.\n"
@@ -272,8 +479,19 @@ static void warn_env_as_mask_once() {
 
 static r_obj* data_pronoun_sym = NULL;
 static r_ssize mask_length(r_ssize n);
+static void data_mask_poke_columns(r_obj* bottom, r_obj* data);
+
+static r_obj* as_data_mask_impl(r_obj* data);
 
 r_obj* rlang_as_data_mask(r_obj* data) {
+  RLANG_EVENT_ENTER(as_data_mask, r_length(data));
+  r_obj* out = as_data_mask_impl(data);
+  RLANG_EVENT_EXIT(as_data_mask, r_length(out));
+  return out;
+}
+
+static
+r_obj* as_data_mask_impl(r_obj* data) {
   if (mask_info(data).type == RLANG_MASK_DATA) {
     return data;
   }
@@ -284,6 +502,7 @@ r_obj* rlang_as_data_mask(r_obj* data) {
   int n_kept = 0;
 
   r_obj* bottom = NULL;
+  r_obj* names = NULL;
 
   switch (r_typeof(data)) {
   case R_TYPE_environment:
@@ -304,26 +523,16 @@ r_obj* rlang_as_data_mask(r_obj* data) {
   case R_TYPE_list: {
     check_unique_names(data);
 
-    r_obj* names = r_names(data);
-
+    // Columns are bound eagerly. Symbols are looked up by R in the
+    // frame of `bottom`, so a column has to be bound before it can be
+    // found and promises or active bindings would cost an insertion
+    // too. Callers evaluating in many masks should reuse a single one
+    // with `rlang_data_mask_poke_data()`.
     r_ssize n_mask = mask_length(r_length(data));
     bottom = KEEP_N(r_alloc_environment(n_mask, r_empty_env), &n_kept);
+    data_mask_poke_columns(bottom, data);
 
-    if (names != r_null) {
-      r_ssize n = r_length(data);
-
-      r_obj* const * p_names = r_chr_cbegin(names);
-      r_obj* const * p_data = r_list_cbegin(data);
-
-      for (r_ssize i = 0; i < n; ++i) {
-        // Ignore empty or missing names
-        r_obj* nm = p_names[i];
-        if (r_str_is_name(nm)) {
-          r_env_poke(bottom, r_str_as_symbol(nm), p_data[i]);
-        }
-      }
-    }
-
+    names = r_names(data);
     break;
   }
 
@@ -336,16 +545,480 @@ r_obj* rlang_as_data_mask(r_obj* data) {
   r_obj* data_pronoun = KEEP_N(rlang_as_data_pronoun(data_mask), &n_kept);
   r_env_poke(bottom, data_pronoun_sym, data_pronoun);
 
+  // Remember the columns so they can be unbound when the mask is
+  // reused with other data
+  if (names != NULL) {
+    r_list_poke(mask_slot(data_mask), MASK_SLOT_names, names);
+  }
+
   FREE(n_kept);
   return data_mask;
 }
 
+static
+void data_mask_poke_columns(r_obj* bottom, r_obj* data) {
+  r_obj* names = r_names(data);
+  if (names == r_null) {
+    return;
+  }
+
+  r_ssize n = r_length(data);
+
+  r_obj* const * p_names = r_chr_cbegin(names);
+  r_obj* const * p_data = r_list_cbegin(data);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    // Ignore empty or missing names
+    r_obj* nm = p_names[i];
+    if (r_str_is_name(nm)) {
+      r_env_poke(bottom, r_str_as_symbol(nm), p_data[i]);
+    }
+  }
+}
+
+static
+void data_mask_unbind_columns(r_obj* bottom, r_obj* names) {
+  if (names == r_null) {
+    return;
+  }
+
+  r_ssize n = r_length(names);
+  r_obj* const * v_names = r_chr_cbegin(names);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* nm = v_names[i];
+    if (r_str_is_name(nm)) {
+      r_env_unbind(bottom, r_str_as_symbol(nm));
+    }
+  }
+}
+
+static
+bool data_mask_same_names(r_obj* x, r_obj* y) {
+  if (x == y) {
+    return true;
+  }
+  if (r_typeof(x) != R_TYPE_character || r_typeof(y) != R_TYPE_character) {
+    return false;
+  }
+
+  r_ssize n = r_length(x);
+  if (r_length(y) != n) {
+    return false;
+  }
+
+  // Strings are interned so comparing pointers is enough
+  r_obj* const * v_x = r_chr_cbegin(x);
+  r_obj* const * v_y = r_chr_cbegin(y);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_x[i] != v_y[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// The bindings of `rlang_new_data_mask()`. The rest of the bookkeeping
+// lives in the slot bound to the flag.
+static
+bool is_data_mask_object(r_obj* sym) {
+  return
+    sym == data_mask_flag_sym ||
+    sym == r_syms.tilde ||
+    sym == data_mask_env_sym;
+}
+
+// Reuses a mask created by `as_data_mask()` with new `data`, e.g. the
+// next group of a data frame. The environments and pronouns of the
+// mask are kept alive. When `data` has the same names as the previous
+// data, the columns are rebound in place and the bottom environment
+// keeps its hash table. Objects created in the mask by previous
+// evaluations are removed.
+r_obj* rlang_data_mask_poke_data(r_obj* mask, r_obj* data) {
+  r_obj* slot = (r_typeof(mask) == R_TYPE_environment) ? mask_slot(mask) : NULL;
+  if (!slot || r_list_get(slot, MASK_SLOT_mask) != mask) {
+    r_abort("`mask` must be a data mask.");
+  }
+
+  r_obj* bottom = r_env_parent(mask);
+  r_obj* data_pronoun = r_env_find(bottom, data_pronoun_sym);
+
+  if (r_list_get(slot, MASK_SLOT_top) != bottom ||
+      r_typeof(data_pronoun) != R_TYPE_list) {
+    r_abort("`mask` must be created by `as_data_mask()`.");
+  }
+  KEEP(data_pronoun);
+
+  if (r_typeof(data) != R_TYPE_list) {
+    r_abort("`data` must be a list or data frame.");
+  }
+  check_unique_names(data);
+
+  r_obj* names = r_names(data);
+  r_obj* old_names = r_list_get(slot, MASK_SLOT_names);
+
+  if (!data_mask_same_names(old_names, names)) {
+    if (old_names == r_syms.unbound) {
+      // The mask was created from an environment
+      old_names = r_env_names(bottom);
+    }
+    KEEP(old_names);
+    data_mask_unbind_columns(bottom, old_names);
+    r_list_poke(slot, MASK_SLOT_names, names);
+    FREE(1);
+  }
+
+  data_mask_poke_columns(bottom, data);
+
+  // Restore the pronoun in case it was overridden or unbound above
+  r_env_poke(bottom, data_pronoun_sym, data_pronoun);
+
+  r_obj* mask_names = KEEP(r_env_names(mask));
+  r_ssize n = r_length(mask_names);
+  r_obj* const * v_mask_names = r_chr_cbegin(mask_names);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* sym = r_str_as_symbol(v_mask_names[i]);
+    if (!is_data_mask_object(sym)) {
+      r_env_unbind(mask, sym);
+    }
+  }
+
+  FREE(2);
+  return mask;
+}
+
 static
 r_ssize mask_length(r_ssize n) {
   r_ssize n_grown = r_double_as_ssize(r_double_mult(r_ssize_as_double(n), 1.05));
   return r_ssize_max(n_grown, r_ssize_add(n, 20));
 }
 
+static
+r_obj* vec_slice_locs(r_obj* x, r_obj* locs) {
+  enum r_type type = r_typeof(x);
+  r_ssize n = r_length(locs);
+  const int* v_locs = r_int_cbegin(locs);
+
+  r_obj* out = KEEP(r_alloc_vector(type, n));
+
+  switch (type) {
+  case R_TYPE_logical: {
+    const int* v_x = r_lgl_cbegin(x);
+    int* v_out = r_lgl_begin(out);
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = v_x[v_locs[i] - 1];
+    }
+    break;
+  }
+  case R_TYPE_integer: {
+    const int* v_x = r_int_cbegin(x);
+    int* v_out = r_int_begin(out);
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = v_x[v_locs[i] - 1];
+    }
+    break;
+  }
+  case R_TYPE_double: {
+    const double* v_x = r_dbl_cbegin(x);
+    double* v_out = r_dbl_begin(out);
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = v_x[v_locs[i] - 1];
+    }
+    break;
+  }
+  case R_TYPE_complex: {
+    const r_complex_t* v_x = r_cpl_cbegin(x);
+    r_complex_t* v_out = r_cpl_begin(out);
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = v_x[v_locs[i] - 1];
+    }
+    break;
+  }
+  case R_TYPE_raw: {
+    const unsigned char* v_x = r_raw_cbegin(x);
+    unsigned char* v_out = r_raw_begin(out);
+    for (r_ssize i = 0; i < n; ++i) {
+      v_out[i] = v_x[v_locs[i] - 1];
+    }
+    break;
+  }
+  case R_TYPE_character:
+    for (r_ssize i = 0; i < n; ++i) {
+      r_chr_poke(out, i, r_chr_get(x, v_locs[i] - 1));
+    }
+    break;
+  case R_TYPE_list:
+    for (r_ssize i = 0; i < n; ++i) {
+      r_list_poke(out, i, r_list_get(x, v_locs[i] - 1));
+    }
+    break;
+  default:
+    r_stop_unimplemented_type("vec_slice_locs", type);
+  }
+
+  FREE(1);
+  return out;
+}
+
+#if R_HAS_ALTREP
+
+// Views of a group of rows store their parent column in `data1` and
+// the 1-based locations of the rows in `data2`. Elements are read from
+// the parent until a pointer to the data is requested. The view is
+// then materialised: `data1` is set to the slice and `data2` to `NULL`.
+static R_altrep_class_t mask_view_lgl_class;
+static R_altrep_class_t mask_view_int_class;
+static R_altrep_class_t mask_view_dbl_class;
+static R_altrep_class_t mask_view_cpl_class;
+static R_altrep_class_t mask_view_raw_class;
+static R_altrep_class_t mask_view_chr_class;
+
+static inline
+r_ssize mask_view_loc(r_obj* locs, R_xlen_t i) {
+  return locs == r_null ? i : r_int_get(locs, i) - 1;
+}
+
+static
+R_xlen_t mask_view_length(r_obj* x) {
+  r_obj* locs = R_altrep_data2(x);
+  return r_length(locs == r_null ? R_altrep_data1(x) : locs);
+}
+
+static
+r_obj* mask_view_materialise(r_obj* x) {
+  r_obj* locs = R_altrep_data2(x);
+  if (locs == r_null) {
+    return R_altrep_data1(x);
+  }
+
+  r_obj* out = KEEP(vec_slice_locs(R_altrep_data1(x), locs));
+  R_set_altrep_data1(x, out);
+  R_set_altrep_data2(x, r_null);
+
+  FREE(1);
+  return out;
+}
+
+static
+void* mask_view_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(mask_view_materialise(x));
+}
+
+static
+const void* mask_view_dataptr_or_null(r_obj* x) {
+  if (R_altrep_data2(x) == r_null) {
+    return DATAPTR_RO(R_altrep_data1(x));
+  } else {
+    return NULL;
+  }
+}
+
+static
+int mask_view_lgl_elt(r_obj* x, R_xlen_t i) {
+  return LOGICAL_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+int mask_view_int_elt(r_obj* x, R_xlen_t i) {
+  return INTEGER_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+double mask_view_dbl_elt(r_obj* x, R_xlen_t i) {
+  return REAL_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+r_complex_t mask_view_cpl_elt(r_obj* x, R_xlen_t i) {
+  return COMPLEX_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+Rbyte mask_view_raw_elt(r_obj* x, R_xlen_t i) {
+  return RAW_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+r_obj* mask_view_chr_elt(r_obj* x, R_xlen_t i) {
+  return STRING_ELT(R_altrep_data1(x), mask_view_loc(R_altrep_data2(x), i));
+}
+static
+void mask_view_chr_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_chr_poke(mask_view_materialise(x), i, value);
+}
+
+static
+Rboolean mask_view_inspect(r_obj* x,
+                           int pre,
+                           int deep,
+                           int pvec,
+                           void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_mask_view (len=%ld, materialised=%s)\n",
+          (long) mask_view_length(x),
+          R_altrep_data2(x) == r_null ? "T" : "F");
+  return TRUE;
+}
+
+static
+r_obj* mask_view(r_obj* x, r_obj* locs) {
+  R_altrep_class_t cls;
+
+  switch (r_typeof(x)) {
+  case R_TYPE_logical: cls = mask_view_lgl_class; break;
+  case R_TYPE_integer: cls = mask_view_int_class; break;
+  case R_TYPE_double: cls = mask_view_dbl_class; break;
+  case R_TYPE_complex: cls = mask_view_cpl_class; break;
+  case R_TYPE_raw: cls = mask_view_raw_class; break;
+  case R_TYPE_character: cls = mask_view_chr_class; break;
+  default: return vec_slice_locs(x, locs);
+  }
+
+  // Make sure the parent is copied rather than modified in place
+  // while the view depends on it
+  r_mark_shared(x);
+
+  return R_new_altrep(cls, x, locs);
+}
+
+static
+void init_mask_view_class(R_altrep_class_t cls) {
+  R_set_altrep_Length_method(cls, &mask_view_length);
+  R_set_altrep_Inspect_method(cls, &mask_view_inspect);
+  R_set_altvec_Dataptr_method(cls, &mask_view_dataptr);
+  R_set_altvec_Dataptr_or_null_method(cls, &mask_view_dataptr_or_null);
+}
+
+void rlang_init_eval_tidy_altrep(DllInfo* dll) {
+  mask_view_lgl_class = R_make_altlogical_class("rlang_mask_view_lgl", "rlang", dll);
+  mask_view_int_class = R_make_altinteger_class("rlang_mask_view_int", "rlang", dll);
+  mask_view_dbl_class = R_make_altreal_class("rlang_mask_view_dbl", "rlang", dll);
+  mask_view_cpl_class = R_make_altcomplex_class("rlang_mask_view_cpl", "rlang", dll);
+  mask_view_raw_class = R_make_altraw_class("rlang_mask_view_raw", "rlang", dll);
+  mask_view_chr_class = R_make_altstring_class("rlang_mask_view_chr", "rlang", dll);
+
+  init_mask_view_class(mask_view_lgl_class);
+  init_mask_view_class(mask_view_int_class);
+  init_mask_view_class(mask_view_dbl_class);
+  init_mask_view_class(mask_view_cpl_class);
+  init_mask_view_class(mask_view_raw_class);
+  init_mask_view_class(mask_view_chr_class);
+
+  R_set_altlogical_Elt_method(mask_view_lgl_class, &mask_view_lgl_elt);
+  R_set_altinteger_Elt_method(mask_view_int_class, &mask_view_int_elt);
+  R_set_altreal_Elt_method(mask_view_dbl_class, &mask_view_dbl_elt);
+  R_set_altcomplex_Elt_method(mask_view_cpl_class, &mask_view_cpl_elt);
+  R_set_altraw_Elt_method(mask_view_raw_class, &mask_view_raw_elt);
+  R_set_altstring_Elt_method(mask_view_chr_class, &mask_view_chr_elt);
+  R_set_altstring_Set_elt_method(mask_view_chr_class, &mask_view_chr_set_elt);
+}
+
+#else
+
+static
+r_obj* mask_view(r_obj* x, r_obj* locs) {
+  return vec_slice_locs(x, locs);
+}
+
+void rlang_init_eval_tidy_altrep(DllInfo* dll) { }
+
+#endif
+
+// Slices a column like `[` would for a bare vector. Attributes are
+// kept, except for names which are sliced too.
+static
+r_obj* mask_slice(r_obj* x, r_obj* locs, r_ssize i) {
+  switch (r_typeof(x)) {
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_raw:
+  case R_TYPE_character:
+  case R_TYPE_list:
+    break;
+  default:
+    r_abort("Column %d of `data` must be a vector, not %s.",
+            (int) i + 1,
+            r_type_as_c_string(r_typeof(x)));
+  }
+
+  if (r_attrib_get(x, R_DimSymbol) != r_null || r_inherits(x, "data.frame")) {
+    r_abort("Can't slice column %d of `data` because it is a matrix or data frame.",
+            (int) i + 1);
+  }
+
+  r_obj* out = KEEP(mask_view(x, locs));
+
+  r_obj* attrib = r_attrib(x);
+  if (attrib != r_null) {
+    attrib = KEEP(r_clone(attrib));
+
+    for (r_obj* node = attrib; node != r_null; node = r_node_cdr(node)) {
+      if (r_node_tag(node) == r_syms.names) {
+        r_node_poke_car(node, mask_view(r_node_car(node), locs));
+      }
+    }
+
+    r_poke_attrib(out, attrib);
+    if (r_is_object(x)) {
+      r_mark_object(out);
+    }
+    FREE(1);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Like `rlang_data_mask_poke_data()` but with the rows of `data` at
+// the 1-based locations `locs`. Bare vectors are bound as views of
+// the columns of `data`, so that columns that are never touched by
+// the evaluated expressions are not copied.
+r_obj* rlang_data_mask_poke_slice(r_obj* mask, r_obj* data, r_obj* locs) {
+  if (r_typeof(data) != R_TYPE_list) {
+    r_abort("`data` must be a list or data frame.");
+  }
+  if (r_typeof(locs) != R_TYPE_integer) {
+    r_abort("`locs` must be an integer vector.");
+  }
+
+  r_ssize n = r_length(data);
+  r_obj* const * v_data = r_list_cbegin(data);
+
+  if (n) {
+    r_ssize size = r_length(v_data[0]);
+    for (r_ssize i = 1; i < n; ++i) {
+      if (r_length(v_data[i]) != size) {
+        r_abort("The columns of `data` must have the same size.");
+      }
+    }
+
+    // Also expands ALTREP sequences so views can index them directly
+    r_ssize n_locs = r_length(locs);
+    const int* v_locs = r_int_cbegin(locs);
+
+    for (r_ssize i = 0; i < n_locs; ++i) {
+      int loc = v_locs[i];
+      if (loc == r_globals.na_int || loc < 1 || loc > size) {
+        r_abort("`locs` must be locations between 1 and %d.", (int) size);
+      }
+    }
+  }
+
+  // The views index into `locs` until they are materialised
+  r_mark_shared(locs);
+
+  r_obj* slice = KEEP(r_alloc_list(n));
+  r_attrib_poke_names(slice, r_names(data));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(slice, i, mask_slice(v_data[i], locs, i));
+  }
+
+  rlang_data_mask_poke_data(mask, slice);
+
+  FREE(1);
+  return mask;
+}
+
 // For compatibility of the exported C callable
 // TODO: warn
 r_obj* rlang_new_data_mask_compat(r_obj* bottom, r_obj* top, r_obj* parent) {
@@ -376,11 +1049,13 @@ static r_obj* base_tilde_eval(r_obj* tilde, r_obj* quo_env) {
 }
 
 r_obj* env_get_top_binding(r_obj* mask) {
-  r_obj* top = r_env_find(mask, data_mask_top_env_sym);
+  r_obj* slot = mask_slot(mask);
 
-  if (top == r_syms.unbound) {
+  if (!slot) {
     r_abort("Internal error: Can't find .top pronoun in data mask");
   }
+
+  r_obj* top = r_list_get(slot, MASK_SLOT_top);
   if (r_typeof(top) != R_TYPE_environment) {
     r_abort("Internal error: Unexpected .top pronoun type");
   }
@@ -389,9 +1064,130 @@ r_obj* env_get_top_binding(r_obj* mask) {
 }
 
 
+/**
+ * Byte-compiled evaluation in masks
+ *
+ * With `options(rlang_compile_quosures = TRUE)`, calls evaluated in
+ * a mask are compiled with `compiler::compile()`. The code is cached
+ * by the address of the call, as with the injection cache the keys
+ * are held strongly and only shared calls are cached.
+ *
+ * The compiler decides at compile time whether a function like `+`
+ * can be inlined by looking it up from the evaluation environment.
+ * The code is compiled in the mask and is only reused in masks that
+ * have the same column names, so that a column never masks a
+ * function that was inlined.
+ */
+
+#define MASK_CODE_CACHE_INIT_SIZE 64
+#define MASK_CODE_CACHE_MAX_SIZE 1024
+
+static r_obj* mask_code_cache = NULL;
+static struct r_dict* p_mask_code_cache = NULL;
+static r_obj* compile_quosures_sym = NULL;
+static r_obj* compile_quosure_fn = NULL;
+
+static
+void mask_code_cache_flush() {
+  p_mask_code_cache = r_new_dict(MASK_CODE_CACHE_INIT_SIZE);
+  r_list_poke(mask_code_cache, 0, p_mask_code_cache->shelter);
+}
+
+static inline
+bool mask_compile_enabled() {
+  r_obj* opt = Rf_GetOption1(compile_quosures_sym);
+  return
+    r_typeof(opt) == R_TYPE_logical &&
+    r_length(opt) == 1 &&
+    r_lgl_get(opt, 0) == 1;
+}
+
+// Returns the column names the code compiled in `mask` depends on,
+// or `NULL` if the mask can't be described by its column names
+static
+r_obj* mask_code_signature(r_obj* mask) {
+  if (r_env_find(mask, quo_mask_flag_sym) == mask) {
+    return r_null;
+  }
+
+  r_obj* slot = mask_slot(mask);
+  if (!slot) {
+    return NULL;
+  }
+
+  r_obj* names = r_list_get(slot, MASK_SLOT_names);
+  if (names == r_syms.unbound) {
+    return NULL;
+  } else {
+    return names;
+  }
+}
+
+static
+r_obj* mask_eval(r_obj* expr, r_obj* mask) {
+  if (r_typeof(expr) != R_TYPE_call || !MAYBE_SHARED(expr) || !mask_compile_enabled()) {
+    return r_eval(expr, mask);
+  }
+
+  r_obj* signature = mask_code_signature(mask);
+  if (signature == NULL) {
+    return r_eval(expr, mask);
+  }
+
+  // Entries are `list(code, signature)`
+  r_obj* entry = r_dict_get0(p_mask_code_cache, expr);
+
+  if (!entry) {
+    entry = KEEP(r_alloc_list(2));
+    r_list_poke(entry, 0, r_null);
+
+    if (p_mask_code_cache->n_entries >= MASK_CODE_CACHE_MAX_SIZE) {
+      mask_code_cache_flush();
+    }
+    r_dict_put(p_mask_code_cache, expr, entry);
+    FREE(1);
+  }
+
+  r_obj* code = r_list_get(entry, 0);
+
+  if (code == r_null || !data_mask_same_names(r_list_get(entry, 1), signature)) {
+    code = r_eval_with_xy(compile_quosure_fn, expr, mask, r_base_env);
+    r_list_poke(entry, 0, code);
+    r_list_poke(entry, 1, signature);
+  }
+
+  return r_eval(code, mask);
+}
+
+
 static r_obj* env_poke_parent_fn = NULL;
 static r_obj* env_poke_fn = NULL;
 
+struct tilde_eval_data {
+  r_obj* expr;
+  r_obj* mask;
+  r_obj* top;
+  r_obj* old;
+};
+
+static
+r_obj* tilde_eval_impl(void* p_data) {
+  struct tilde_eval_data* p_tilde = (struct tilde_eval_data*) p_data;
+  return mask_eval(p_tilde->expr, p_tilde->mask);
+}
+
+static
+void tilde_eval_cleanup(void* p_data) {
+  struct tilde_eval_data* p_tilde = (struct tilde_eval_data*) p_data;
+
+  r_obj* slot = mask_slot(p_tilde->mask);
+  if (slot) {
+    mask_slot_poke_ctxt_env(slot, p_tilde->old);
+  }
+
+  r_env_poke_parent(p_tilde->top, p_tilde->old);
+}
+
 r_obj* rlang_tilde_eval(r_obj* tilde, r_obj* current_frame, r_obj* caller_frame) {
   // Remove srcrefs from system call
   r_attrib_poke(tilde, r_syms.srcref, r_null);
@@ -430,17 +1226,29 @@ r_obj* rlang_tilde_eval(r_obj* tilde, r_obj* current_frame, r_obj* caller_frame)
     r_abort("Internal error: Can't find the data mask");
   }
 
-  // Unless the quosure was created in the mask, swap lexical contexts
+  // Unless the quosure was created in the mask or the mask is already
+  // chained to the quosure environment, swap lexical contexts
   // temporarily by rechaining the top of the mask to the quosure
   // environment
-  if (!r_env_inherits(info.mask, quo_env, top)) {
-    // Unwind-protect the restoration of original parents
-    on_exit_restore_lexical_env(info.mask, r_env_parent(top), current_frame);
-    r_env_poke_parent(top, quo_env);
+  r_obj* old = r_env_parent(top);
+  if (old == quo_env || r_env_inherits(info.mask, quo_env, top)) {
+    FREE(n_kept);
+    return mask_eval(expr, info.mask);
   }
 
+  r_env_poke_parent(top, quo_env);
+
+  // Unwind-protect the restoration of original parents
+  struct tilde_eval_data data = {
+    .expr = expr,
+    .mask = info.mask,
+    .top = top,
+    .old = old
+  };
+  r_obj* out = R_ExecWithCleanup(tilde_eval_impl, &data, tilde_eval_cleanup, &data);
+
   FREE(n_kept);
-  return r_eval(expr, info.mask);
+  return out;
 }
 
 r_obj* ffi_tilde_eval(r_obj* call, r_obj* op, r_obj* args, r_obj* rho) {
@@ -451,14 +1259,19 @@ r_obj* ffi_tilde_eval(r_obj* call, r_obj* op, r_obj* args, r_obj* rho) {
   return rlang_tilde_eval(tilde, current_frame, caller_frame);
 }
 
-static const char* data_mask_objects_names[4] = {
-  ".__tidyeval_data_mask__.", "~", ".top_env", ".env"
+// Includes the `.top_env` and `.__tidyeval_data_names__.` bindings of
+// masks created by older versions
+static const char* data_mask_objects_names[5] = {
+  ".__tidyeval_data_mask__.", "~", ".top_env", ".env", ".__tidyeval_data_names__."
 };
 
 // Soft-deprecated in rlang 0.2.0
 r_obj* rlang_data_mask_clean(r_obj* mask) {
   r_obj* bottom = r_env_parent(mask);
-  r_obj* top = r_eval(data_mask_top_env_sym, mask);
+
+  // Overscopes created by older versions bind `.top_env`
+  r_obj* slot = mask_slot(mask);
+  r_obj* top = slot ? r_list_get(slot, MASK_SLOT_top) : r_eval(data_mask_top_env_sym, mask);
 
   KEEP(top); // Help rchk
 
@@ -475,9 +1288,7 @@ r_obj* rlang_data_mask_clean(r_obj* mask) {
   r_obj* env = bottom;
   r_obj* parent = r_env_parent(top);
   while (env != parent) {
-    r_obj* nms = KEEP(r_env_names(env));
-    r_env_unbind_names(env, nms);
-    FREE(1);
+    r_env_clear(env);
     env = r_env_parent(env);
   }
 
@@ -495,6 +1306,7 @@ static r_obj* new_quosure_mask(r_obj* env) {
 }
 
 r_obj* rlang_eval_tidy(r_obj* expr, r_obj* data, r_obj* env) {
+  RLANG_EVENT_ENTER(eval_tidy, r_length(data));
   int n_kept = 0;
 
   if (rlang_is_quosure(expr)) {
@@ -507,7 +1319,8 @@ r_obj* rlang_eval_tidy(r_obj* expr, r_obj* data, r_obj* env) {
   // all the masking objects, data pronouns, etc.
   if (data == r_null) {
     r_obj* mask = KEEP_N(new_quosure_mask(env), &n_kept);
-    r_obj* out = r_eval(expr, mask);
+    r_obj* out = mask_eval(expr, mask);
+    RLANG_EVENT_EXIT(eval_tidy, r_length(out));
     FREE(n_kept);
     return out;
   }
@@ -535,11 +1348,61 @@ r_obj* rlang_eval_tidy(r_obj* expr, r_obj* data, r_obj* env) {
     r_env_poke_parent(top, env);
   }
 
-  r_obj* out = r_eval(expr, mask);
+  r_obj* out = mask_eval(expr, mask);
+  RLANG_EVENT_EXIT(eval_tidy, r_length(out));
   FREE(n_kept);
   return out;
 }
 
+// Evaluates each element of `xs` as `eval_tidy()` would, but in a
+// data mask created once for all of them. Assignments in the mask are
+// therefore visible to the next elements, as with a mask supplied as
+// `data`. The top of the mask is only rechained when an element has a
+// different environment than the current parent of the top.
+r_obj* ffi_eval_tidy_list(r_obj* xs, r_obj* data, r_obj* env) {
+  if (r_typeof(xs) != R_TYPE_list) {
+    r_abort("`quos` must be a list.");
+  }
+
+  r_ssize n = r_length(xs);
+  r_obj* const * v_xs = r_list_cbegin(xs);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+  r_attrib_poke_names(out, r_names(xs));
+
+  if (data == r_null) {
+    for (r_ssize i = 0; i < n; ++i) {
+      r_list_poke(out, i, rlang_eval_tidy(v_xs[i], r_null, env));
+    }
+    FREE(1);
+    return out;
+  }
+
+  r_obj* mask = KEEP(rlang_as_data_mask(data));
+  r_obj* top = KEEP(env_get_top_binding(mask));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* expr = v_xs[i];
+    r_obj* expr_env = env;
+
+    if (rlang_is_quosure(expr)) {
+      expr_env = r_quo_get_env(expr);
+      expr = r_quo_get_expr(expr);
+    }
+
+    // Same rechaining as in `rlang_eval_tidy()`
+    if (r_env_parent(top) != expr_env && !r_env_inherits(mask, expr_env, top)) {
+      poke_ctxt_env(mask, expr_env);
+      r_env_poke_parent(top, expr_env);
+    }
+
+    r_list_poke(out, i, mask_eval(expr, mask));
+  }
+
+  FREE(3);
+  return out;
+}
+
 r_obj* ffi_eval_tidy(r_obj* call, r_obj* op, r_obj* args, r_obj* rho) {
   args = r_node_cdr(args);
   r_obj* expr = r_node_car(args); args = r_node_cdr(args);
@@ -565,6 +1428,8 @@ void rlang_init_eval_tidy() {
   r_chr_poke(empty_names_chr, 0, r_str(""));
   r_chr_poke(empty_names_chr, 1, r_globals.na_str);
 
+  unique_names_cache = r_preserve_global(r_alloc_list(UNIQUE_NAMES_CACHE_SIZE));
+
   quo_mask_flag_sym = r_sym(".__tidyeval_quosure_mask__.");
   data_mask_flag_sym = r_sym(".__tidyeval_data_mask__.");
   data_mask_env_sym = r_sym(".env");
@@ -575,27 +1440,16 @@ void rlang_init_eval_tidy() {
   env_poke_parent_fn = rlang_ns_get("env_poke_parent");
   env_poke_fn = rlang_ns_get("env_poke");
 
-  env_sym = r_sym("env");
-  old_sym = r_sym("old");
-  mask_sym = r_sym("mask");
-
-  restore_mask_fn = r_parse_eval(
-    "function() {                          \n"
-    "  ctxt_pronoun <- `mask`$.env         \n"
-    "  if (!is.null(ctxt_pronoun)) {       \n"
-    "    parent.env(ctxt_pronoun) <- `old` \n"
-    "  }                                   \n"
-    "                                      \n"
-    "  top <- `mask`$.top_env              \n"
-    "  if (is.null(top)) {                 \n"
-    "    top <- `mask`                     \n"
-    "  }                                   \n"
-    "                                      \n"
-    "  parent.env(top) <- `old`            \n"
-    "}                                     \n",
-    r_base_env
-  );
-  r_preserve(restore_mask_fn);
+  ctxt_pronoun_promise_call = r_call2(rlang_ns_get("mask_ctxt_pronoun"), data_mask_flag_sym);
+  r_preserve(ctxt_pronoun_promise_call);
+
+  mask_code_cache = r_alloc_list(1);
+  r_preserve(mask_code_cache);
+  mask_code_cache_flush();
+
+  compile_quosures_sym = r_sym("rlang_compile_quosures");
+  compile_quosure_fn = r_parse("rlang:::compile_quosure(x, y)");
+  r_preserve(compile_quosure_fn);
 
   FREE(1);
 }
@@ -1,33 +1,109 @@
 #include <rlang.h>
 #include "internal.h"
+#include "nse-inject.h"
 
 // From call.c
 r_obj* rlang_call2(r_obj* fn, r_obj* args, r_obj* ns);
 
+// From capture.c
+r_obj* capturedots_compact(r_obj* frame, r_obj** p_envs);
+
+// From dots.c
+r_obj* big_bang_coerce_pairlist(r_obj* x, bool deep);
+
+static r_obj* exec_spliced_args(r_obj* rho);
+
 
 r_obj* rlang_ext2_exec(r_obj* call, r_obj* op, r_obj* args, r_obj* rho) {
   args = r_node_cdr(args);
 
   r_obj* fn = KEEP(r_eval(r_sym(".fn"), rho));
   r_obj* env = KEEP(r_eval(r_sym(".env"), rho));
-  r_obj* dots = KEEP(rlang_dots(rho));
+
+  r_obj* dots = exec_spliced_args(rho);
+  if (dots) {
+    KEEP(dots);
+  } else {
+    dots = KEEP(rlang_dots(rho));
+
+    // Protect all symbolic arguments from being evaluated
+    for (r_obj* node = dots; node != r_null; node = r_node_cdr(node)) {
+      r_obj* arg = r_node_car(node);
+      if (r_is_symbolic(arg)) {
+        r_node_poke_car(node, r_call2(fns_quote, arg));
+      }
+    }
+  }
 
   r_obj* exec_call = KEEP(rlang_call2(fn, dots, r_null));
+  r_obj* out = r_eval(exec_call, env);
 
-  r_obj* node = r_node_cdr(exec_call);
-  while (node != r_null) {
-    r_obj* arg = r_node_car(node);
+  FREE(4);
+  return out;
+}
 
-    // Protect all symbolic arguments from being evaluated
+/*
+ * Fast path for `exec(fn, !!!args)` with a bare list. The arguments of
+ * the call are created from the list in a single pass, with one node
+ * per element, instead of being spliced through the dots machinery.
+ * Returns `NULL` when the dots have another shape, in which case they
+ * haven't been evaluated.
+ */
+static
+r_obj* exec_spliced_args(r_obj* rho) {
+  r_obj* envs;
+  r_obj* dots = KEEP(capturedots_compact(rho, &envs));
+  KEEP(envs);
+
+  if (dots == r_null || r_node_cdr(dots) != r_null || r_node_tag(dots) != r_null) {
+    FREE(2);
+    return NULL;
+  }
+
+  struct injection_info info = which_expansion_op_impl(r_node_car(dots), false, false);
+  r_obj* env = r_list_get(envs, 0);
+
+  if (info.op != INJECTION_OP_uqs || env == r_empty_env) {
+    FREE(2);
+    return NULL;
+  }
+
+  r_obj* x = KEEP(r_eval(info.operand, env));
+
+  if (r_typeof(x) != R_TYPE_list || r_is_object(x)) {
+    // Same coercion as `!!!` in dots
+    r_obj* out = KEEP(big_bang_coerce_pairlist(x, false));
+    for (r_obj* node = out; node != r_null; node = r_node_cdr(node)) {
+      r_obj* arg = r_node_car(node);
+      if (r_is_symbolic(arg)) {
+        r_node_poke_car(node, r_call2(fns_quote, arg));
+      }
+    }
+    FREE(4);
+    return out;
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  r_obj* names = r_names(x);
+  r_obj* const * v_names = names == r_null ? NULL : r_chr_cbegin(names);
+
+  r_obj* out = KEEP(r_alloc_pairlist(n));
+  r_obj* node = out;
+
+  for (r_ssize i = 0; i < n; ++i, node = r_node_cdr(node)) {
+    r_obj* arg = v_x[i];
     if (r_is_symbolic(arg)) {
-      r_node_poke_car(node, r_call2(fns_quote, arg));
+      arg = r_call2(fns_quote, arg);
     }
+    r_node_poke_car(node, arg);
 
-    node = r_node_cdr(node);
+    if (v_names && v_names[i] != r_globals.empty_str) {
+      r_node_poke_tag(node, r_str_as_symbol(v_names[i]));
+    }
   }
 
-  r_obj* out = r_eval(exec_call, env);
-
   FREE(4);
   return out;
 }
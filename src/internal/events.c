@@ -0,0 +1,149 @@
+#include <rlang.h>
+#include <stdlib.h>
+#include "events.h"
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+/*
+ * The buffer is allocated by `events_enable()` and holds the last
+ * `events_capacity` records. Older records are overwritten. Pushing a
+ * record doesn't allocate and can't fail.
+ */
+
+struct event_record {
+  double time;
+  r_ssize size;
+  int id;
+  int phase;
+};
+
+bool rlang_events_enabled = false;
+
+static struct event_record* v_events = NULL;
+static r_ssize events_capacity = 0;
+
+// Total number of records pushed since the last drain
+static r_ssize events_n = 0;
+
+static double events_start = 0;
+
+static const char* event_names[RLANG_EVENT_SIZE] = {
+  "eval_tidy",
+  "as_data_mask",
+  "call_interp",
+  "dots_values",
+  "hash",
+  "abort"
+};
+
+static inline
+double events_now(void) {
+#ifndef _WIN32
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+  return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void rlang_events_push(enum rlang_event id,
+                       enum rlang_event_phase phase,
+                       r_ssize size) {
+  struct event_record* p_record = v_events + (events_n % events_capacity);
+  p_record->time = events_now() - events_start;
+  p_record->size = size;
+  p_record->id = id;
+  p_record->phase = phase;
+  ++events_n;
+}
+
+r_obj* ffi_events_enable(r_obj* enable, r_obj* size) {
+  if (!r_is_bool(enable)) {
+    r_stop_internal("ffi_events_enable", "`enable` must be a logical value.");
+  }
+  bool old = rlang_events_enabled;
+
+  if (!r_lgl_get(enable, 0)) {
+    rlang_events_enabled = false;
+    return r_lgl(old);
+  }
+
+  r_ssize c_size = r_as_ssize(size);
+  if (c_size < 1) {
+    r_abort("`size` must be a positive number.");
+  }
+
+  if (c_size != events_capacity) {
+    rlang_events_enabled = false;
+
+    struct event_record* v_new = malloc(c_size * sizeof(struct event_record));
+    if (!v_new) {
+      r_abort("Can't allocate a buffer of %.0f events.", (double) c_size);
+    }
+
+    free(v_events);
+    v_events = v_new;
+    events_capacity = c_size;
+    events_n = 0;
+  }
+
+  if (events_n == 0) {
+    events_start = events_now();
+  }
+
+  rlang_events_enabled = true;
+  return r_lgl(old);
+}
+
+// Called from `abort()`, which only records its entry
+r_obj* ffi_events_push_abort(r_obj* size) {
+  RLANG_EVENT_ENTER(abort, r_as_ssize(size));
+  return r_null;
+}
+
+enum events_col {
+  EVENTS_COL_time = 0,
+  EVENTS_COL_event,
+  EVENTS_COL_phase,
+  EVENTS_COL_size,
+  EVENTS_COL_SIZE
+};
+
+// Returns the buffered records from oldest to newest and empties the
+// buffer
+r_obj* ffi_events_drain(void) {
+  r_ssize n = r_ssize_min(events_n, events_capacity);
+  r_ssize start = events_n - n;
+
+  const char* nms[EVENTS_COL_SIZE] = { "time", "event", "phase", "size" };
+  const enum r_type types[EVENTS_COL_SIZE] = {
+    R_TYPE_double, R_TYPE_character, R_TYPE_character, R_TYPE_double
+  };
+  r_obj* df_nms = KEEP(r_chr_n(nms, EVENTS_COL_SIZE));
+  r_obj* out = KEEP(r_alloc_df_list(n, df_nms, types, EVENTS_COL_SIZE));
+  r_init_data_frame(out, n);
+
+  double* v_time = r_dbl_begin(r_list_get(out, EVENTS_COL_time));
+  r_obj* event = r_list_get(out, EVENTS_COL_event);
+  r_obj* phase = r_list_get(out, EVENTS_COL_phase);
+  double* v_size = r_dbl_begin(r_list_get(out, EVENTS_COL_size));
+
+  r_obj* enter = KEEP(r_str("enter"));
+  r_obj* exit = KEEP(r_str("exit"));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    const struct event_record* p_record = v_events + ((start + i) % events_capacity);
+    v_time[i] = p_record->time;
+    r_chr_poke(event, i, r_str(event_names[p_record->id]));
+    r_chr_poke(phase, i, p_record->phase == RLANG_EVENT_PHASE_enter ? enter : exit);
+    v_size[i] = p_record->size;
+  }
+
+  events_n = 0;
+
+  FREE(4);
+  return out;
+}
@@ -0,0 +1,50 @@
+#ifndef RLANG_INTERNAL_EVENTS_H
+#define RLANG_INTERNAL_EVENTS_H
+
+#include <rlang.h>
+
+/*
+ * Ring buffer of timestamped events recorded at the entry and exit of
+ * hot paths, see `events_enable()`. Recording is disabled by default
+ * and then costs a single branch per event. The size arguments of
+ * `RLANG_EVENT_ENTER()` and `RLANG_EVENT_EXIT()` are only evaluated
+ * while recording.
+ *
+ * Exits are not recorded when a path unwinds with a longjump.
+ */
+
+enum rlang_event {
+  RLANG_EVENT_eval_tidy = 0,
+  RLANG_EVENT_as_data_mask,
+  RLANG_EVENT_call_interp,
+  RLANG_EVENT_dots_values,
+  RLANG_EVENT_hash,
+  RLANG_EVENT_abort,
+  RLANG_EVENT_SIZE
+};
+
+enum rlang_event_phase {
+  RLANG_EVENT_PHASE_enter = 0,
+  RLANG_EVENT_PHASE_exit
+};
+
+extern bool rlang_events_enabled;
+
+void rlang_events_push(enum rlang_event id,
+                       enum rlang_event_phase phase,
+                       r_ssize size);
+
+#define RLANG_EVENT_ENTER(ID, SIZE) do {                                \
+    if (rlang_events_enabled) {                                         \
+      rlang_events_push(RLANG_EVENT_##ID, RLANG_EVENT_PHASE_enter, SIZE); \
+    }                                                                   \
+  } while (0)
+
+#define RLANG_EVENT_EXIT(ID, SIZE) do {                                 \
+    if (rlang_events_enabled) {                                         \
+      rlang_events_push(RLANG_EVENT_##ID, RLANG_EVENT_PHASE_exit, SIZE); \
+    }                                                                   \
+  } while (0)
+
+
+#endif
@@ -1,6 +1,7 @@
 #include <rlang.h>
 
 #include "internal.h"
+#include "memo.h"
 
 
 r_obj* rlang_new_function(r_obj* args, r_obj* body, r_obj* env) {
@@ -8,7 +9,11 @@ r_obj* rlang_new_function(r_obj* args, r_obj* body, r_obj* env) {
     r_abort("`env` must be an environment");
   }
 
-  args = KEEP(r_vec_coerce(args, R_TYPE_pairlist));
+  if (r_typeof(args) == R_TYPE_list) {
+    args = KEEP(r_list_as_pairlist(args));
+  } else {
+    args = KEEP(r_vec_coerce(args, R_TYPE_pairlist));
+  }
 
   r_obj* node = args;
   while (node != r_null) {
@@ -33,7 +38,42 @@ r_obj* rlang_as_function(r_obj* x, r_obj* env) {
   return r_eval_with_xy(as_function_call, x, env, rlang_ns_env);
 }
 
+
+/*
+ * Cache of the lambdas created by `as_function()`, keyed by formula
+ * identity. Returning the same closure for the same formula means
+ * that the closure is only byte-compiled once by the JIT, which
+ * stores the compiled body in the closure.
+ *
+ * The cache keeps a reference to its formulas, which increases
+ * their reference count. R therefore duplicates cached formulas
+ * before modifying them and a cached formula object can't change.
+ *
+ * Formulas can't be weakly referenced so the cache is dropped at the
+ * next garbage collection, see `struct rlang_addr_cache`.
+ */
+
+#define LAMBDA_CACHE_MAX_SIZE 1024
+
+static struct rlang_addr_cache* p_lambda_cache = NULL;
+
+r_obj* ffi_lambda_cache_get(r_obj* x) {
+  r_obj* fn = rlang_addr_cache_get0(p_lambda_cache, x);
+  return fn ? fn : r_null;
+}
+
+r_obj* ffi_lambda_cache_put(r_obj* x, r_obj* fn) {
+  if (!r_is_function(fn)) {
+    r_stop_internal("ffi_lambda_cache_put", "`fn` must be a function.");
+  }
+  rlang_addr_cache_put(p_lambda_cache, x, fn);
+  return fn;
+}
+
 void rlang_init_fn() {
   as_function_call = r_parse("as_function(x, env = y)");
   r_preserve(as_function_call);
+
+  p_lambda_cache = rlang_new_addr_cache(LAMBDA_CACHE_MAX_SIZE, true);
+  r_preserve(p_lambda_cache->shelter);
 }
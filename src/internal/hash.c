@@ -1,4 +1,6 @@
 #include <rlang.h>
+#include "events.h"
+#include "memo.h"
 
 /*
  * Using the standard xxhash defines, as seen in:
@@ -7,9 +9,32 @@
 #define XXH_STATIC_LINKING_ONLY
 #define XXH_IMPLEMENTATION
 
+/*
+ * The vector width of xxHash is fixed at compile time, which is SSE2
+ * for most x86-64 binaries. On x86-64 we also compile the AVX2 and
+ * AVX512 kernels with function target attributes, in the style of
+ * `xxh_x86dispatch.c`, and select them at load time based on the CPU.
+ * This is disabled on Windows because GCC doesn't align the stack for
+ * AVX variables there.
+ */
+#if defined(__x86_64__) && !defined(_WIN32) && !defined(__AVX512F__) && \
+  (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#  define HASH_X86_DISPATCH 1
+#else
+#  define HASH_X86_DISPATCH 0
+#endif
+
+#if HASH_X86_DISPATCH
+#  include <immintrin.h>
+#  define XXH_X86DISPATCH
+#  define XXH_TARGET_AVX512 __attribute__((__target__("avx512f")))
+#  define XXH_TARGET_AVX2 __attribute__((__target__("avx2")))
+#endif
+
 #include "xxhash/xxhash.h"
 
-#include <stdio.h> // sprintf()
+#include <stdio.h> // sprintf(), fopen(), fread()
+#include <stdlib.h> // malloc(), free()
 #include <inttypes.h> // PRIx64
 
 /*
@@ -58,25 +83,635 @@
 
 // -----------------------------------------------------------------------------
 
+/*
+ * Entry points of XXH3 used for hashing payloads. The digests don't
+ * depend on the kernel. `XXH3_128bits_digest()` always uses the
+ * compile time kernel, which only processes the last stripes.
+ */
+typedef XXH_errorcode (*hash_xxh3_update_fn)(XXH3_state_t* p_state, const void* p_input, size_t n);
+typedef XXH128_hash_t (*hash_xxh3_128_fn)(const void* p_input, size_t n);
+
+static hash_xxh3_update_fn hash_xxh3_update = &XXH3_128bits_update;
+static hash_xxh3_128_fn hash_xxh3_128 = &XXH3_128bits;
+
+#if XXH_VECTOR == XXH_AVX512
+static const char* hash_xxh3_kernel = "avx512";
+#elif XXH_VECTOR == XXH_AVX2
+static const char* hash_xxh3_kernel = "avx2";
+#elif XXH_VECTOR == XXH_SSE2
+static const char* hash_xxh3_kernel = "sse2";
+#elif XXH_VECTOR == XXH_NEON
+static const char* hash_xxh3_kernel = "neon";
+#elif XXH_VECTOR == XXH_VSX
+static const char* hash_xxh3_kernel = "vsx";
+#else
+static const char* hash_xxh3_kernel = "scalar";
+#endif
+
+#if HASH_X86_DISPATCH
+
+#define HASH_DEFINE_DISPATCH(SUFFIX, TARGET)                            \
+  XXH_NO_INLINE TARGET XXH128_hash_t                                    \
+  hash_xxh3_long_##SUFFIX(const void* XXH_RESTRICT p_input,             \
+                          size_t n,                                     \
+                          XXH64_hash_t seed,                            \
+                          const void* XXH_RESTRICT p_secret,            \
+                          size_t secret_size) {                         \
+    (void) seed; (void) p_secret; (void) secret_size;                   \
+    return XXH3_hashLong_128b_internal(p_input, n,                      \
+                                       XXH3_kSecret, sizeof(XXH3_kSecret), \
+                                       XXH3_accumulate_512_##SUFFIX,    \
+                                       XXH3_scrambleAcc_##SUFFIX);      \
+  }                                                                     \
+  static TARGET                                                         \
+  XXH128_hash_t hash_xxh3_128_##SUFFIX(const void* p_input, size_t n) { \
+    return XXH3_128bits_internal(p_input, n, 0,                         \
+                                 XXH3_kSecret, sizeof(XXH3_kSecret),    \
+                                 &hash_xxh3_long_##SUFFIX);             \
+  }                                                                     \
+  static TARGET                                                         \
+  XXH_errorcode hash_xxh3_update_##SUFFIX(XXH3_state_t* p_state,        \
+                                          const void* p_input,          \
+                                          size_t n) {                   \
+    return XXH3_update(p_state, (const xxh_u8*) p_input, n,             \
+                       XXH3_accumulate_512_##SUFFIX,                    \
+                       XXH3_scrambleAcc_##SUFFIX);                      \
+  }
+
+HASH_DEFINE_DISPATCH(avx2, XXH_TARGET_AVX2)
+HASH_DEFINE_DISPATCH(avx512, XXH_TARGET_AVX512)
+
+#undef HASH_DEFINE_DISPATCH
+
+static
+void hash_xxh3_dispatch() {
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx512f")) {
+    hash_xxh3_update = &hash_xxh3_update_avx512;
+    hash_xxh3_128 = &hash_xxh3_128_avx512;
+    hash_xxh3_kernel = "avx512";
+  } else if (__builtin_cpu_supports("avx2")) {
+    hash_xxh3_update = &hash_xxh3_update_avx2;
+    hash_xxh3_128 = &hash_xxh3_128_avx2;
+    hash_xxh3_kernel = "avx2";
+  }
+}
+
+#else
+
+static
+void hash_xxh3_dispatch() { }
+
+#endif
+
+r_obj* ffi_hash_kernel() {
+  return r_chr(hash_xxh3_kernel);
+}
+
+enum hash_method {
+  HASH_METHOD_serialize = 0,
+  HASH_METHOD_native
+};
+
+enum hash_format {
+  HASH_FORMAT_string = 0,
+  HASH_FORMAT_raw
+};
+
 struct exec_data {
   r_obj* x;
+  enum hash_method method;
+  enum hash_format format;
+  int n_threads;
   XXH3_state_t* p_xx_state;
 };
 
 static r_obj* hash_impl(void* p_data);
 static void hash_cleanup(void* p_data);
+static enum hash_method arg_match_hash_method(r_obj* method);
+static enum hash_format arg_match_hash_format(r_obj* format);
+static int as_hash_n_threads(r_obj* n_threads);
+static bool hash_is_cacheable(r_obj* x);
+static r_obj* hash_cached(r_obj* x,
+                          enum hash_method method,
+                          enum hash_format format,
+                          int n_threads);
+static r_obj* hash_exec(r_obj* x,
+                        enum hash_method method,
+                        enum hash_format format,
+                        int n_threads);
+
+r_obj* rlang_hash(r_obj* x,
+                  r_obj* method,
+                  r_obj* format,
+                  r_obj* n_threads,
+                  r_obj* cache) {
+  // Match before allocating the state so it can't leak on error
+  enum hash_method c_method = arg_match_hash_method(method);
+  enum hash_format c_format = arg_match_hash_format(format);
+  int c_n_threads = as_hash_n_threads(n_threads);
+
+  if (!r_is_bool(cache)) {
+    r_abort("`cache` must be `TRUE` or `FALSE`.");
+  }
+
+  RLANG_EVENT_ENTER(hash, r_length(x));
 
-r_obj* rlang_hash(r_obj* x) {
+  r_obj* out;
+  if (r_lgl_get(cache, 0) && c_method == HASH_METHOD_native && hash_is_cacheable(x)) {
+    out = hash_cached(x, c_method, c_format, c_n_threads);
+  } else {
+    out = hash_exec(x, c_method, c_format, c_n_threads);
+  }
+
+  RLANG_EVENT_EXIT(hash, r_length(out));
+  return out;
+}
+
+static
+r_obj* hash_exec(r_obj* x,
+                 enum hash_method c_method,
+                 enum hash_format c_format,
+                 int c_n_threads) {
   XXH3_state_t* p_xx_state = XXH3_createState();
 
   struct exec_data data = {
     .x = x,
+    .method = c_method,
+    .format = c_format,
+    .n_threads = c_n_threads,
     .p_xx_state = p_xx_state
   };
 
   return R_ExecWithCleanup(hash_impl, &data, hash_cleanup, &data);
 }
 
+static
+enum hash_method arg_match_hash_method(r_obj* method) {
+  if (r_typeof(method) != R_TYPE_character || r_length(method) == 0) {
+    r_abort("`method` must be a character vector.");
+  }
+  const char* arg = r_chr_get_c_string(method, 0);
+  switch (arg[0]) {
+  case 's': if (!strcmp(arg, "serialize")) return HASH_METHOD_serialize; else break;
+  case 'n': if (!strcmp(arg, "native")) return HASH_METHOD_native; else break;
+  }
+  r_abort("`method` must be one of: \"serialize\" or \"native\".");
+}
+
+static
+enum hash_format arg_match_hash_format(r_obj* format) {
+  if (r_typeof(format) != R_TYPE_character || r_length(format) == 0) {
+    r_abort("`format` must be a character vector.");
+  }
+  const char* arg = r_chr_get_c_string(format, 0);
+  switch (arg[0]) {
+  case 's': if (!strcmp(arg, "string")) return HASH_FORMAT_string; else break;
+  case 'r': if (!strcmp(arg, "raw")) return HASH_FORMAT_raw; else break;
+  }
+  r_abort("`format` must be one of: \"string\" or \"raw\".");
+}
+
+static
+int as_hash_n_threads(r_obj* n_threads) {
+  r_ssize out = r_as_ssize(n_threads);
+  if (out < 1 || out > INT_MAX) {
+    r_abort("`n_threads` must be a positive integer.");
+  }
+  return (int) out;
+}
+
+static void hash_serialize(r_obj* x, XXH3_state_t* p_xx_state);
+static void hash_native(r_obj* x, XXH3_state_t* p_xx_state, int n_threads);
+static r_obj* hash_digest(r_obj* x,
+                          enum hash_method method,
+                          enum hash_format format,
+                          int n_threads,
+                          XXH3_state_t* p_xx_state);
+static r_obj* hash_state_str(XXH3_state_t* p_xx_state);
+static r_obj* hash_state_raw(XXH3_state_t* p_xx_state);
+static r_obj* hash_as_str(XXH128_hash_t hash);
+
+static
+r_obj* hash_impl(void* p_data) {
+  struct exec_data* p_exec_data = (struct exec_data*) p_data;
+  enum hash_format format = p_exec_data->format;
+
+  r_obj* out = hash_digest(p_exec_data->x,
+                           p_exec_data->method,
+                           format,
+                           p_exec_data->n_threads,
+                           p_exec_data->p_xx_state);
+
+  switch (format) {
+  case HASH_FORMAT_string: return r_str_as_character(out);
+  case HASH_FORMAT_raw: return out;
+  default: r_stop_unreached("hash_impl");
+  }
+}
+
+static r_obj* hash_list_impl(void* p_data);
+
+r_obj* rlang_hash_list(r_obj* x, r_obj* method, r_obj* format) {
+  if (r_typeof(x) != R_TYPE_list) {
+    r_abort("`x` must be a list.");
+  }
+  enum hash_method c_method = arg_match_hash_method(method);
+  enum hash_format c_format = arg_match_hash_format(format);
+
+  // A single state is reset and reused for all elements
+  XXH3_state_t* p_xx_state = XXH3_createState();
+
+  struct exec_data data = {
+    .x = x,
+    .method = c_method,
+    .format = c_format,
+    .n_threads = 1,
+    .p_xx_state = p_xx_state
+  };
+
+  return R_ExecWithCleanup(hash_list_impl, &data, hash_cleanup, &data);
+}
+
+static
+r_obj* hash_list_impl(void* p_data) {
+  struct exec_data* p_exec_data = (struct exec_data*) p_data;
+  r_obj* x = p_exec_data->x;
+  enum hash_method method = p_exec_data->method;
+  enum hash_format format = p_exec_data->format;
+  XXH3_state_t* p_xx_state = p_exec_data->p_xx_state;
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  // Raw digests are collected in a list so that no strings are
+  // interned in the global CHARSXP cache
+  enum r_type out_type = (format == HASH_FORMAT_raw) ? R_TYPE_list : R_TYPE_character;
+  r_obj* out = KEEP(r_alloc_vector(out_type, n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (i % 1024 == 0) {
+      r_yield_interrupt();
+    }
+    r_obj* digest = hash_digest(v_x[i], method, format, 1, p_xx_state);
+
+    if (format == HASH_FORMAT_raw) {
+      r_list_poke(out, i, digest);
+    } else {
+      r_chr_poke(out, i, digest);
+    }
+  }
+
+  r_obj* nms = r_names(x);
+  if (nms != r_null) {
+    r_attrib_poke_names(out, nms);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Resets the state, hashes `x`, and returns the digest as a CHARSXP
+// or as a raw vector depending on `format`
+static
+r_obj* hash_digest(r_obj* x,
+                   enum hash_method method,
+                   enum hash_format format,
+                   int n_threads,
+                   XXH3_state_t* p_xx_state) {
+  XXH_errorcode err = XXH3_128bits_reset(p_xx_state);
+  if (err == XXH_ERROR) {
+    r_abort("Couldn't initialize hash state.");
+  }
+
+  switch (method) {
+  case HASH_METHOD_serialize: hash_serialize(x, p_xx_state); break;
+  case HASH_METHOD_native: hash_native(x, p_xx_state, n_threads); break;
+  default: r_stop_unreached("hash_digest");
+  }
+
+  switch (format) {
+  case HASH_FORMAT_string: return hash_state_str(p_xx_state);
+  case HASH_FORMAT_raw: return hash_state_raw(p_xx_state);
+  default: r_stop_unreached("hash_digest");
+  }
+}
+
+// Formats the digest of the current state as a CHARSXP
+static
+r_obj* hash_state_str(XXH3_state_t* p_xx_state) {
+  return hash_as_str(XXH3_128bits_digest(p_xx_state));
+}
+
+static
+r_obj* hash_as_str(XXH128_hash_t hash) {
+  // R assumes C99, so these are always defined as `uint64_t` in xxhash.h
+  XXH64_hash_t high = hash.high64;
+  XXH64_hash_t low = hash.low64;
+
+  // 32 for hash, 1 for terminating null added by `sprintf()`
+  char out[32 + 1];
+
+  sprintf(out, "%016" PRIx64 "%016" PRIx64, high, low);
+
+  return r_str(out);
+}
+
+// Returns the digest of the current state as a 16-byte raw vector.
+// The canonical representation is big-endian so the bytes are in the
+// same order as the digits of the string format.
+static
+r_obj* hash_state_raw(XXH3_state_t* p_xx_state) {
+  XXH128_hash_t hash = XXH3_128bits_digest(p_xx_state);
+
+  XXH128_canonical_t canonical;
+  XXH128_canonicalFromHash(&canonical, hash);
+
+  return r_copy_in_raw(canonical.digest, sizeof(canonical.digest));
+}
+
+static
+void hash_cleanup(void* p_data) {
+  struct exec_data* p_exec_data = (struct exec_data*) p_data;
+  XXH3_state_t* p_xx_state = p_exec_data->p_xx_state;
+  XXH3_freeState(p_xx_state);
+}
+
+// -----------------------------------------------------------------------------
+// Memoisation
+
+/*
+ * Digests of objects that can't be modified are cached by address,
+ * one cache per hashing method. The caches compare keys by
+ * pointer so a lookup doesn't touch the contents of the object.
+ *
+ * Only native digests are cached. Serialised objects include the
+ * contents of the environments they reach, which may change while
+ * the object itself can't. Native digests hash these environments by
+ * identity or by name.
+ *
+ * Only objects marked as not mutable are cached. `MARK_NOT_MUTABLE()`
+ * sets the namedness of an object (its reference count with R >= 4.0.0)
+ * to a maximum that sticks, so R duplicates these objects before any
+ * modification. R doesn't export that maximum, so we record it from an
+ * object marked at load time.
+ *
+ * The cache is flushed when it reaches `HASH_CACHE_MAX_SIZE` entries
+ * to bound the memory it retains, see `struct rlang_addr_cache`.
+ */
+
+#define HASH_CACHE_MAX_SIZE 1024
+#define HASH_CACHE_N_METHODS (HASH_METHOD_native + 1)
+
+static int not_mutable_named = -1;
+static r_obj* hash_caches = NULL;
+static struct rlang_addr_cache* p_hash_caches[HASH_CACHE_N_METHODS];
+
+static
+bool hash_is_cacheable(r_obj* x) {
+  return NAMED(x) == not_mutable_named;
+}
+
+static
+r_obj* hash_cached(r_obj* x,
+                   enum hash_method method,
+                   enum hash_format format,
+                   int n_threads) {
+  struct rlang_addr_cache* p_cache = p_hash_caches[method];
+  r_obj* digest = rlang_addr_cache_get0(p_cache, x);
+
+  if (digest == NULL) {
+    digest = hash_exec(x, method, HASH_FORMAT_raw, n_threads);
+    KEEP(digest);
+
+    // Cached digests may be returned several times
+    r_mark_shared(digest);
+
+    rlang_addr_cache_put(p_cache, x, digest);
+  } else {
+    KEEP(digest);
+  }
+
+  r_obj* out = r_null;
+
+  switch (format) {
+  case HASH_FORMAT_string: {
+    XXH128_hash_t hash = XXH128_hashFromCanonical((XXH128_canonical_t*) r_raw_begin(digest));
+    out = r_str_as_character(hash_as_str(hash));
+    break;
+  }
+  case HASH_FORMAT_raw:
+    out = digest;
+    break;
+  default:
+    r_stop_unreached("hash_cached");
+  }
+
+  FREE(1);
+  return out;
+}
+
+// -----------------------------------------------------------------------------
+// Incremental hashing
+
+/*
+ * A hasher is an external pointer to a hash state. Its protected
+ * slot holds the hashing method as an integer. Objects passed to
+ * `hasher_update()` are hashed in sequence as if they formed a single
+ * stream of data.
+ */
+
+static r_obj* hasher_class = NULL;
+static void hasher_finalize(r_obj* hasher);
+static XXH3_state_t* hasher_deref(r_obj* hasher);
+
+r_obj* rlang_hasher_new(r_obj* method) {
+  enum hash_method c_method = arg_match_hash_method(method);
+
+  r_obj* method_int = KEEP(r_int(c_method));
+  r_obj* hasher = KEEP(R_MakeExternalPtr(NULL, r_null, method_int));
+  r_attrib_poke(hasher, r_syms.class, hasher_class);
+
+  // Register the finalizer before allocating the state so it can't leak
+  R_RegisterCFinalizerEx(hasher, &hasher_finalize, TRUE);
+
+  XXH3_state_t* p_xx_state = XXH3_createState();
+  if (!p_xx_state) {
+    r_abort("Can't allocate hash state.");
+  }
+  R_SetExternalPtrAddr(hasher, p_xx_state);
+
+  XXH_errorcode err = XXH3_128bits_reset(p_xx_state);
+  if (err == XXH_ERROR) {
+    r_abort("Couldn't initialize hash state.");
+  }
+
+  FREE(2);
+  return hasher;
+}
+
+r_obj* rlang_hasher_update(r_obj* hasher, r_obj* x) {
+  XXH3_state_t* p_xx_state = hasher_deref(hasher);
+  enum hash_method method = r_int_get(R_ExternalPtrProtected(hasher), 0);
+
+  switch (method) {
+  case HASH_METHOD_serialize: hash_serialize(x, p_xx_state); break;
+  case HASH_METHOD_native: hash_native(x, p_xx_state, 1); break;
+  default: r_stop_unreached("rlang_hasher_update");
+  }
+
+  return hasher;
+}
+
+// The digest doesn't modify the state. The hasher can still be
+// updated afterwards.
+r_obj* rlang_hasher_digest(r_obj* hasher, r_obj* format) {
+  enum hash_format c_format = arg_match_hash_format(format);
+  XXH3_state_t* p_xx_state = hasher_deref(hasher);
+
+  switch (c_format) {
+  case HASH_FORMAT_string: return r_str_as_character(hash_state_str(p_xx_state));
+  case HASH_FORMAT_raw: return hash_state_raw(p_xx_state);
+  default: r_stop_unreached("rlang_hasher_digest");
+  }
+}
+
+static
+XXH3_state_t* hasher_deref(r_obj* hasher) {
+  if (r_typeof(hasher) != R_TYPE_pointer || !r_inherits(hasher, "rlang_hasher")) {
+    r_abort("`hasher` must be a hasher created with `hasher_new()`.");
+  }
+
+  XXH3_state_t* p_xx_state = R_ExternalPtrAddr(hasher);
+
+  // External pointers are reset to `NULL` when serialized
+  if (!p_xx_state) {
+    r_abort("`hasher` is no longer valid.");
+  }
+
+  return p_xx_state;
+}
+
+static
+void hasher_finalize(r_obj* hasher) {
+  XXH3_state_t* p_xx_state = R_ExternalPtrAddr(hasher);
+  if (p_xx_state) {
+    XXH3_freeState(p_xx_state);
+    R_ClearExternalPtr(hasher);
+  }
+}
+
+
+// -----------------------------------------------------------------------------
+// File hashing
+
+// Files are streamed into the hash state in blocks of this size so
+// that memory usage doesn't depend on the size of the file
+#define HASH_FILE_BUFFER_SIZE (1024 * 512)
+
+struct hash_file_data {
+  r_obj* path;
+  XXH3_state_t* p_xx_state;
+  void* p_buffer;
+  FILE* fp;
+};
+
+static r_obj* hash_file_impl(void* p_data);
+static void hash_file_cleanup(void* p_data);
+
+r_obj* rlang_hash_file(r_obj* path) {
+  if (r_typeof(path) != R_TYPE_character) {
+    r_abort("`path` must be a character vector.");
+  }
+
+  struct hash_file_data data = {
+    .path = path,
+    .p_xx_state = NULL,
+    .p_buffer = NULL,
+    .fp = NULL
+  };
+
+  return R_ExecWithCleanup(hash_file_impl, &data, hash_file_cleanup, &data);
+}
+
+static
+r_obj* hash_file_impl(void* p_data) {
+  struct hash_file_data* p_file_data = (struct hash_file_data*) p_data;
+  r_obj* path = p_file_data->path;
+
+  // Allocated here so the cleanup handler frees them on error
+  p_file_data->p_xx_state = XXH3_createState();
+  p_file_data->p_buffer = malloc(HASH_FILE_BUFFER_SIZE);
+
+  XXH3_state_t* p_xx_state = p_file_data->p_xx_state;
+  void* p_buffer = p_file_data->p_buffer;
+
+  if (!p_xx_state || !p_buffer) {
+    r_abort("Can't allocate memory to hash file.");
+  }
+
+  r_ssize n = r_length(path);
+  r_obj* const * v_path = r_chr_cbegin(path);
+
+  r_obj* out = KEEP(r_alloc_character(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_path[i] == r_globals.na_str) {
+      r_abort("`path` can't contain missing values.");
+    }
+    const char* c_path = Rf_translateChar(v_path[i]);
+
+    XXH_errorcode err = XXH3_128bits_reset(p_xx_state);
+    if (err == XXH_ERROR) {
+      r_abort("Couldn't initialize hash state.");
+    }
+
+    FILE* fp = fopen(c_path, "rb");
+    if (fp == NULL) {
+      r_abort("Can't open file `%s`.", c_path);
+    }
+    p_file_data->fp = fp;
+
+    size_t n_read;
+    while ((n_read = fread(p_buffer, 1, HASH_FILE_BUFFER_SIZE, fp)) > 0) {
+      err = hash_xxh3_update(p_xx_state, p_buffer, n_read);
+      if (err == XXH_ERROR) {
+        r_abort("Couldn't update hash state.");
+      }
+      r_yield_interrupt();
+    }
+
+    if (ferror(fp)) {
+      r_abort("Can't read file `%s`.", c_path);
+    }
+
+    fclose(fp);
+    p_file_data->fp = NULL;
+
+    r_chr_poke(out, i, hash_state_str(p_xx_state));
+  }
+
+  FREE(1);
+  return out;
+}
+
+static
+void hash_file_cleanup(void* p_data) {
+  struct hash_file_data* p_file_data = (struct hash_file_data*) p_data;
+
+  if (p_file_data->fp) {
+    fclose(p_file_data->fp);
+  }
+  free(p_file_data->p_buffer);
+  if (p_file_data->p_xx_state) {
+    XXH3_freeState(p_file_data->p_xx_state);
+  }
+}
+
+#undef HASH_FILE_BUFFER_SIZE
+
+
 struct hash_state_t {
   bool skip;
   int n_skipped;
@@ -92,16 +727,7 @@ static inline void hash_bytes(R_outpstream_t stream, void* p_input, int n);
 static inline void hash_char(R_outpstream_t stream, int input);
 
 static
-r_obj* hash_impl(void* p_data) {
-  struct exec_data* p_exec_data = (struct exec_data*) p_data;
-  r_obj* x = p_exec_data->x;
-  XXH3_state_t* p_xx_state = p_exec_data->p_xx_state;
-
-  XXH_errorcode err = XXH3_128bits_reset(p_xx_state);
-  if (err == XXH_ERROR) {
-    r_abort("Couldn't initialize hash state.");
-  }
-
+void hash_serialize(r_obj* x, XXH3_state_t* p_xx_state) {
   struct hash_state_t state = new_hash_state(p_xx_state);
 
   int version = hash_version();
@@ -129,26 +755,6 @@ r_obj* hash_impl(void* p_data) {
   );
 
   R_Serialize(x, &stream);
-
-  XXH128_hash_t hash = XXH3_128bits_digest(p_xx_state);
-
-  // R assumes C99, so these are always defined as `uint64_t` in xxhash.h
-  XXH64_hash_t high = hash.high64;
-  XXH64_hash_t low = hash.low64;
-
-  // 32 for hash, 1 for terminating null added by `sprintf()`
-  char out[32 + 1];
-
-  sprintf(out, "%016" PRIx64 "%016" PRIx64, high, low);
-
-  return r_chr(out);
-}
-
-static
-void hash_cleanup(void* p_data) {
-  struct exec_data* p_exec_data = (struct exec_data*) p_data;
-  XXH3_state_t* p_xx_state = p_exec_data->p_xx_state;
-  XXH3_freeState(p_xx_state);
 }
 
 static inline
@@ -184,7 +790,7 @@ void hash_bytes(R_outpstream_t stream, void* p_input, int n) {
   }
 
   XXH3_state_t* p_xx_state = p_state->p_xx_state;
-  XXH_errorcode err = XXH3_128bits_update(p_xx_state, p_input, n);
+  XXH_errorcode err = hash_xxh3_update(p_xx_state, p_input, n);
 
   if (err == XXH_ERROR) {
     r_abort("Couldn't update hash state.");
@@ -245,4 +851,272 @@ void hash_skip(struct hash_state_t* p_state, void* p_input, int n) {
 
 #endif // USE_VERSION_3
 
+// -----------------------------------------------------------------------------
+// Native hashing
+
+/*
+ * The native method walks the object with `r_sexp_iterator` and feeds
+ * vector payloads directly into the hash state, bypassing the
+ * serialization machinery.
+ *
+ * Stability contract:
+ * - Hashes only depend on the structure and contents of the object,
+ *   not on the R version. They are reproducible across sessions and
+ *   platforms that have the same endianness, for a given version of
+ *   rlang. They are unrelated to the hashes of the serialize method.
+ * - Every node contributes its type, its relation to its parent, and
+ *   its iteration direction, so that structurally different trees
+ *   can't produce the same stream of bytes.
+ * - Strings are hashed as UTF-8, so that the same text in different
+ *   encodings produces the same hash. Bytes strings can't be
+ *   translated and are hashed by their raw bytes.
+ * - ALTREP vectors are hashed by their contents, e.g. `1:3` and
+ *   `c(1L, 2L, 3L)` have the same hash.
+ * - Atomic payloads larger than `HASH_NATIVE_CHUNK_SIZE` are split in
+ *   chunks of that size. The chunks are hashed independently (in
+ *   parallel when `n_threads > 1`) and their canonical digests are
+ *   fed to the hash state in order. Since the chunk size is fixed,
+ *   the hash doesn't depend on the number of threads.
+ * - Closures are hashed by their formals, body (byte-compiled or not),
+ *   and environment. Their attributes (e.g. srcrefs) are ignored.
+ * - The global, base, and empty environments are hashed by name, as
+ *   are namespaces and attached package environments. This keeps the
+ *   hashes of package functions and of quosures that refer to them
+ *   stable across sessions, and avoids walking their contents.
+ *   Other reference objects (environments, promises, external
+ *   pointers, weak references, primitive functions and bytecode) are
+ *   hashed by identity. Hashes that involve these objects are only
+ *   stable within a session.
+ */
+
+enum hash_native_tag {
+  HASH_NATIVE_TAG_identity = 0,
+  HASH_NATIVE_TAG_global_env,
+  HASH_NATIVE_TAG_base_env,
+  HASH_NATIVE_TAG_empty_env,
+  HASH_NATIVE_TAG_namespace,
+  HASH_NATIVE_TAG_package_env
+};
+
+// 1 MiB
+#define HASH_NATIVE_CHUNK_SIZE ((size_t) 1 << 20)
+
+static inline void hash_native_update(XXH3_state_t* p_xx_state, const void* p_input, size_t n);
+static void hash_native_payload(XXH3_state_t* p_xx_state, const void* p_input, size_t n, int n_threads);
+static inline void hash_native_length(XXH3_state_t* p_xx_state, r_ssize n);
+static inline void hash_native_string(XXH3_state_t* p_xx_state, r_obj* str);
+static inline void hash_native_identity(XXH3_state_t* p_xx_state, r_obj* x);
+
+static
+void hash_native(r_obj* x, XXH3_state_t* p_xx_state, int n_threads) {
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator(x);
+  KEEP(p_it->shelter);
+
+  while (r_sexp_next(p_it)) {
+    r_obj* x = p_it->x;
+    enum r_type type = p_it->type;
+    enum r_sexp_it_direction dir = p_it->dir;
+
+    unsigned char header[3] = {
+      (unsigned char) type,
+      (unsigned char) p_it->rel,
+      (unsigned char) dir
+    };
+    hash_native_update(p_xx_state, header, sizeof(header));
+
+    if (dir == R_SEXP_IT_DIRECTION_outgoing) {
+      continue;
+    }
+
+    switch (type) {
+    case R_TYPE_null:
+    case R_TYPE_pairlist:
+    case R_TYPE_call:
+    case R_TYPE_dots:
+    case R_TYPE_s4:
+      // Only described by their header. Their children are visited
+      // next by the iterator.
+      break;
+
+    case R_TYPE_logical:
+    case R_TYPE_integer:
+    case R_TYPE_double:
+    case R_TYPE_complex:
+    case R_TYPE_raw: {
+      r_ssize n = r_length(x);
+      hash_native_length(p_xx_state, n);
+      hash_native_payload(p_xx_state, r_vec_cbegin(x), n * r_vec_elt_sizeof0(type), n_threads);
+      break;
+    }
+
+    case R_TYPE_character:
+    case R_TYPE_list:
+    case R_TYPE_expression:
+      hash_native_length(p_xx_state, r_length(x));
+      break;
+
+    case R_TYPE_string:
+      hash_native_string(p_xx_state, x);
+      break;
+
+    case R_TYPE_symbol:
+      hash_native_string(p_xx_state, PRINTNAME(x));
+      break;
+
+    case R_TYPE_closure:
+      // Hash the body expression rather than the bytecode, and skip
+      // attributes (srcrefs)
+      hash_native(FORMALS(x), p_xx_state, n_threads);
+      hash_native(r_fn_body(x), p_xx_state, n_threads);
+      hash_native(r_fn_env(x), p_xx_state, n_threads);
+      p_it->skip_incoming = true;
+      break;
+
+    default:
+      hash_native_identity(p_xx_state, x);
+      p_it->skip_incoming = true;
+      break;
+    }
+  }
+
+  FREE(1);
+}
+
+static inline
+void hash_native_update(XXH3_state_t* p_xx_state, const void* p_input, size_t n) {
+  XXH_errorcode err = hash_xxh3_update(p_xx_state, p_input, n);
+
+  if (err == XXH_ERROR) {
+    r_abort("Couldn't update hash state.");
+  }
+}
+
+// Must not call the R API (except for the final update) as it runs
+// on multiple threads
+static
+void hash_native_payload(XXH3_state_t* p_xx_state,
+                         const void* p_input,
+                         size_t n,
+                         int n_threads) {
+  if (n <= HASH_NATIVE_CHUNK_SIZE) {
+    hash_native_update(p_xx_state, p_input, n);
+    return;
+  }
+
+  r_ssize n_chunks = (n + HASH_NATIVE_CHUNK_SIZE - 1) / HASH_NATIVE_CHUNK_SIZE;
+
+  r_obj* digests = KEEP(r_alloc_raw(n_chunks * sizeof(XXH128_canonical_t)));
+  XXH128_canonical_t* v_digests = r_raw_begin(digests);
+  const unsigned char* v_input = p_input;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize i = 0; i < n_chunks; ++i) {
+    size_t offset = (size_t) i * HASH_NATIVE_CHUNK_SIZE;
+    size_t size = n - offset;
+    if (size > HASH_NATIVE_CHUNK_SIZE) {
+      size = HASH_NATIVE_CHUNK_SIZE;
+    }
+
+    XXH128_hash_t hash = hash_xxh3_128(v_input + offset, size);
+    XXH128_canonicalFromHash(v_digests + i, hash);
+  }
+
+  hash_native_update(p_xx_state, v_digests, n_chunks * sizeof(XXH128_canonical_t));
+  FREE(1);
+}
+
+// Lengths are always hashed as 64 bit so that hashes don't depend on
+// the width of `r_ssize`
+static inline
+void hash_native_length(XXH3_state_t* p_xx_state, r_ssize n) {
+  int64_t n_64 = n;
+  hash_native_update(p_xx_state, &n_64, sizeof(n_64));
+}
+
+static inline
+void hash_native_string(XXH3_state_t* p_xx_state, r_obj* str) {
+  if (str == r_globals.na_str) {
+    hash_native_length(p_xx_state, -1);
+    return;
+  }
+
+  // Bytes strings can't be translated. Their raw bytes are hashed
+  // after a tag that distinguishes them from UTF-8 strings.
+  if (Rf_getCharCE(str) == CE_BYTES) {
+    size_t n = r_length(str);
+    hash_native_length(p_xx_state, -2);
+    hash_native_length(p_xx_state, n);
+    hash_native_update(p_xx_state, r_str_c_string(str), n);
+    return;
+  }
+
+  const char* c_str = Rf_translateCharUTF8(str);
+  size_t n = strlen(c_str);
+
+  hash_native_length(p_xx_state, n);
+  hash_native_update(p_xx_state, c_str, n);
+}
+
+static inline
+void hash_native_identity(XXH3_state_t* p_xx_state, r_obj* x) {
+  unsigned char tag;
+  r_obj* name = r_null;
+
+  if (x == r_global_env) {
+    tag = HASH_NATIVE_TAG_global_env;
+  } else if (x == r_base_env) {
+    tag = HASH_NATIVE_TAG_base_env;
+  } else if (x == r_empty_env) {
+    tag = HASH_NATIVE_TAG_empty_env;
+  } else if (x == R_BaseNamespace) {
+    name = PRINTNAME(r_sym("base"));
+    tag = HASH_NATIVE_TAG_namespace;
+  } else if (r_typeof(x) == R_TYPE_environment && R_IsNamespaceEnv(x)) {
+    name = r_chr_get(R_NamespaceEnvSpec(x), 0);
+    tag = HASH_NATIVE_TAG_namespace;
+  } else if (r_typeof(x) == R_TYPE_environment && R_IsPackageEnv(x)) {
+    name = r_chr_get(R_PackageEnvName(x), 0);
+    tag = HASH_NATIVE_TAG_package_env;
+  } else {
+    tag = HASH_NATIVE_TAG_identity;
+  }
+  hash_native_update(p_xx_state, &tag, sizeof(tag));
+
+  switch (tag) {
+  case HASH_NATIVE_TAG_identity: {
+    uintptr_t addr = (uintptr_t) x;
+    hash_native_update(p_xx_state, &addr, sizeof(addr));
+    break;
+  }
+  case HASH_NATIVE_TAG_namespace:
+  case HASH_NATIVE_TAG_package_env:
+    hash_native_string(p_xx_state, name);
+    break;
+  default:
+    break;
+  }
+}
+
+#undef HASH_NATIVE_CHUNK_SIZE
+
+void rlang_init_hash() {
+  hash_xxh3_dispatch();
+
+  hasher_class = r_preserve_global(r_chr("rlang_hasher"));
+
+  r_obj* not_mutable = KEEP(r_alloc_raw(0));
+  r_mark_shared(not_mutable);
+  not_mutable_named = NAMED(not_mutable);
+  FREE(1);
+
+  hash_caches = r_preserve_global(r_alloc_list(HASH_CACHE_N_METHODS));
+  for (int i = 0; i < HASH_CACHE_N_METHODS; ++i) {
+    p_hash_caches[i] = rlang_new_addr_cache(HASH_CACHE_MAX_SIZE, false);
+    r_list_poke(hash_caches, i, p_hash_caches[i]->shelter);
+  }
+}
+
 #undef USE_VERSION_3
+#undef HASH_X86_DISPATCH
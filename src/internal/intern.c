@@ -0,0 +1,420 @@
+#include <rlang.h>
+#include "intern.h"
+
+#include <string.h> // memcmp()
+
+/*
+ * Canonical objects are stored in an integer dictionary keyed by
+ * their structural hash. Each entry is a pairlist of the canonical
+ * objects that share this hash. Expressions are interned bottom-up:
+ * a node is hashed and compared through the addresses of its interned
+ * children, so that interning a node takes constant time regardless
+ * of the size of the tree below it. Pairlists are walked iteratively
+ * from their tail, only the nesting of calls recurses.
+ *
+ * Atomic vectors are compared bit for bit and strings by address.
+ * This is stricter than `identical()`, e.g. `0` and `-0` or strings
+ * in different encodings are interned separately, but objects
+ * interned together are always identical. Symbols, environments,
+ * functions and other objects without structure of their own are
+ * interned by identity.
+ *
+ * The interned object is its own canonical object when its children
+ * already are canonical. Otherwise a new object pointing to the
+ * canonical children is allocated.
+ */
+
+#define INTERN_INIT_SIZE 64
+
+static r_obj* intern_table_class = NULL;
+static r_obj* intern_stats_nms = NULL;
+
+static r_obj* intern_node(struct rlang_intern_table* p_table, r_obj* x);
+static r_obj* intern_vector(struct rlang_intern_table* p_table, r_obj* x);
+
+
+struct rlang_intern_table* rlang_new_intern_table(void) {
+  r_obj* shelter = KEEP(r_alloc_list(2));
+
+  r_obj* table_raw = r_alloc_raw0(sizeof(struct rlang_intern_table));
+  r_list_poke(shelter, 0, table_raw);
+  struct rlang_intern_table* p_table = r_raw_begin(table_raw);
+
+  p_table->p_dict = r_new_int_dict(INTERN_INIT_SIZE);
+  r_list_poke(shelter, 1, p_table->p_dict->shelter);
+
+  p_table->shelter = shelter;
+  p_table->n_hits = 0;
+  p_table->n_misses = 0;
+  p_table->n_entries = 0;
+
+  r_attrib_poke(shelter, r_syms.class, intern_table_class);
+
+  FREE(1);
+  return p_table;
+}
+
+r_obj* rlang_intern(struct rlang_intern_table* p_table, r_obj* x) {
+  switch (r_typeof(x)) {
+  case R_TYPE_pairlist:
+  case R_TYPE_call:
+    return intern_node(p_table, x);
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_character:
+  case R_TYPE_raw:
+  case R_TYPE_list:
+  case R_TYPE_expression:
+    return intern_vector(p_table, x);
+  default:
+    return x;
+  }
+}
+
+r_ssize rlang_intern_table_size(struct rlang_intern_table* p_table) {
+  return p_table->n_entries;
+}
+
+
+// Returns the canonical objects of hash `hash` as a pairlist
+static inline
+r_obj* intern_chain(struct rlang_intern_table* p_table, uint64_t hash) {
+  r_obj* chain = r_int_dict_get0(p_table->p_dict, (r_ssize) hash);
+  return chain ? chain : r_null;
+}
+
+// `x` must be protected by the caller
+static
+void intern_add(struct rlang_intern_table* p_table,
+                uint64_t hash,
+                r_obj* chain,
+                r_obj* x) {
+  r_mark_shared(x);
+
+  if (chain == r_null) {
+    chain = KEEP(r_new_node(x, r_null));
+    r_int_dict_put(p_table->p_dict, (r_ssize) hash, chain);
+    FREE(1);
+  } else {
+    r_node_poke_cdr(chain, r_new_node(x, r_node_cdr(chain)));
+  }
+
+  ++p_table->n_entries;
+  ++p_table->n_misses;
+}
+
+
+static inline
+bool intern_is_node(r_obj* x) {
+  enum r_type type = r_typeof(x);
+  return type == R_TYPE_pairlist || type == R_TYPE_call;
+}
+
+static inline
+uint64_t intern_node_hash(enum r_type type,
+                          r_obj* car,
+                          r_obj* tag,
+                          r_obj* cdr,
+                          r_obj* attrib) {
+  const uintptr_t v_key[] = {
+    (uintptr_t) type,
+    (uintptr_t) car,
+    (uintptr_t) tag,
+    (uintptr_t) cdr,
+    (uintptr_t) attrib
+  };
+  return XXH3_64bits(v_key, sizeof(v_key));
+}
+
+static
+r_obj* intern_node_find(r_obj* chain,
+                        enum r_type type,
+                        r_obj* car,
+                        r_obj* tag,
+                        r_obj* cdr,
+                        r_obj* attrib) {
+  for (; chain != r_null; chain = r_node_cdr(chain)) {
+    r_obj* node = r_node_car(chain);
+
+    if (r_typeof(node) == type &&
+        r_node_car(node) == car &&
+        r_node_tag(node) == tag &&
+        r_node_cdr(node) == cdr &&
+        r_attrib(node) == attrib) {
+      return node;
+    }
+  }
+
+  return NULL;
+}
+
+static
+r_obj* intern_node(struct rlang_intern_table* p_table, r_obj* x) {
+  r_ssize n = 0;
+  r_obj* tail = x;
+
+  while (intern_is_node(tail)) {
+    ++n;
+    tail = r_node_cdr(tail);
+  }
+
+  r_obj* nodes = KEEP(r_alloc_list(n));
+  r_obj* cars = KEEP(r_alloc_list(n));
+  r_obj* attribs = KEEP(r_alloc_list(n));
+
+  r_obj* node = x;
+  for (r_ssize i = 0; i < n; ++i, node = r_node_cdr(node)) {
+    r_list_poke(nodes, i, node);
+    r_list_poke(cars, i, rlang_intern(p_table, r_node_car(node)));
+    r_list_poke(attribs, i, rlang_intern(p_table, r_attrib(node)));
+  }
+
+  // Interned objects are protected by the table or by `x`
+  r_obj* cdr = rlang_intern(p_table, tail);
+
+  for (r_ssize i = n - 1; i >= 0; --i) {
+    node = r_list_get(nodes, i);
+
+    enum r_type type = r_typeof(node);
+    r_obj* car = r_list_get(cars, i);
+    r_obj* tag = r_node_tag(node);
+    r_obj* attrib = r_list_get(attribs, i);
+
+    uint64_t hash = intern_node_hash(type, car, tag, cdr, attrib);
+    r_obj* chain = intern_chain(p_table, hash);
+    r_obj* out = intern_node_find(chain, type, car, tag, cdr, attrib);
+
+    if (out) {
+      ++p_table->n_hits;
+    } else {
+      if (r_node_car(node) == car &&
+          r_node_cdr(node) == cdr &&
+          r_attrib(node) == attrib) {
+        out = node;
+      } else {
+        out = (type == R_TYPE_call) ? r_new_call(car, cdr) : r_new_node(car, cdr);
+        r_node_poke_tag(out, tag);
+        r_poke_attrib(out, attrib);
+      }
+
+      KEEP(out);
+      intern_add(p_table, hash, chain, out);
+      FREE(1);
+    }
+
+    cdr = out;
+  }
+
+  FREE(3);
+  return cdr;
+}
+
+
+static
+r_obj* intern_elts(struct rlang_intern_table* p_table, r_obj* x) {
+  r_ssize n = r_length(x);
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i, rlang_intern(p_table, r_list_get(x, i)));
+  }
+
+  FREE(1);
+  return out;
+}
+
+static
+bool intern_elts_equal(r_obj* x, r_obj* elts) {
+  r_ssize n = r_length(elts);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (r_list_get(x, i) != r_list_get(elts, i)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// The elements of lists are hashed and compared through the list of
+// their interned elements
+static
+r_obj* intern_vector(struct rlang_intern_table* p_table, r_obj* x) {
+  enum r_type type = r_typeof(x);
+  r_ssize n = r_length(x);
+  bool is_list = type == R_TYPE_list || type == R_TYPE_expression;
+
+  r_obj* attrib = rlang_intern(p_table, r_attrib(x));
+
+  r_obj* data = is_list ? intern_elts(p_table, x) : x;
+  KEEP(data);
+
+  const void* v_data = r_vec_cbegin(data);
+  size_t n_bytes = n * r_vec_elt_sizeof(data);
+
+  const uintptr_t v_header[] = {
+    (uintptr_t) type,
+    (uintptr_t) n,
+    (uintptr_t) attrib
+  };
+  uint64_t seed = XXH3_64bits(v_header, sizeof(v_header));
+  uint64_t hash = XXH3_64bits_withSeed(v_data, n_bytes, seed);
+
+  r_obj* chain = intern_chain(p_table, hash);
+  r_obj* out = NULL;
+
+  for (r_obj* node = chain; node != r_null; node = r_node_cdr(node)) {
+    r_obj* candidate = r_node_car(node);
+
+    if (r_typeof(candidate) != type ||
+        r_length(candidate) != n ||
+        r_attrib(candidate) != attrib) {
+      continue;
+    }
+
+    bool equal = is_list ?
+      intern_elts_equal(candidate, data) :
+      memcmp(r_vec_cbegin(candidate), v_data, n_bytes) == 0;
+
+    if (equal) {
+      out = candidate;
+      break;
+    }
+  }
+
+  if (out) {
+    ++p_table->n_hits;
+    FREE(1);
+    return out;
+  }
+
+  if (r_attrib(x) == attrib && (!is_list || intern_elts_equal(x, data))) {
+    out = x;
+  } else if (is_list) {
+    out = r_alloc_vector(type, n);
+    for (r_ssize i = 0; i < n; ++i) {
+      r_list_poke(out, i, r_list_get(data, i));
+    }
+    r_poke_attrib(out, attrib);
+  } else {
+    out = r_clone(x);
+    r_poke_attrib(out, attrib);
+  }
+
+  KEEP(out);
+  intern_add(p_table, hash, chain, out);
+
+  FREE(2);
+  return out;
+}
+
+
+// R interface -----------------------------------------------------
+
+static
+struct rlang_intern_table* intern_table_deref(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_list ||
+      r_length(x) != 2 ||
+      !r_inherits(x, "rlang_intern_table") ||
+      r_typeof(r_list_get(x, 0)) != R_TYPE_raw) {
+    r_abort("`table` must be an intern table.");
+  }
+  return (struct rlang_intern_table*) r_raw_begin(r_list_get(x, 0));
+}
+
+r_obj* ffi_new_intern_table(void) {
+  return rlang_new_intern_table()->shelter;
+}
+
+r_obj* ffi_intern_expr(r_obj* table, r_obj* x) {
+  return rlang_intern(intern_table_deref(table), x);
+}
+
+r_obj* ffi_intern_exprs(r_obj* table, r_obj* xs, r_obj* unique) {
+  struct rlang_intern_table* p_table = intern_table_deref(table);
+
+  enum r_type type = r_typeof(xs);
+  if (type != R_TYPE_list && type != R_TYPE_expression) {
+    r_abort("`xs` must be a list of expressions.");
+  }
+  if (!r_is_bool(unique)) {
+    r_stop_internal("ffi_intern_exprs", "`unique` must be a logical value.");
+  }
+
+  r_ssize n = r_length(xs);
+  r_obj* elts = KEEP(intern_elts(p_table, xs));
+
+  r_obj* keep = KEEP(r_alloc_logical(n));
+  int* v_keep = r_lgl_begin(keep);
+  r_ssize n_keep = n;
+
+  if (r_lgl_get(unique, 0)) {
+    // Interned expressions are equal if and only if they are the same
+    // object, so duplicates are detected by address
+    struct r_dict* p_seen = r_new_dict(n ? n : 1);
+    KEEP(p_seen->shelter);
+
+    n_keep = 0;
+    for (r_ssize i = 0; i < n; ++i) {
+      v_keep[i] = r_dict_put(p_seen, r_list_get(elts, i), r_null);
+      n_keep += v_keep[i];
+    }
+
+    FREE(1);
+  } else {
+    for (r_ssize i = 0; i < n; ++i) {
+      v_keep[i] = 1;
+    }
+  }
+
+  r_obj* nms = r_names(xs);
+  r_obj* out = KEEP(r_alloc_vector(type, n_keep));
+  r_obj* out_nms = r_null;
+
+  if (nms != r_null) {
+    out_nms = r_alloc_character(n_keep);
+  }
+  KEEP(out_nms);
+
+  for (r_ssize i = 0, j = 0; i < n; ++i) {
+    if (!v_keep[i]) {
+      continue;
+    }
+    r_list_poke(out, j, r_list_get(elts, i));
+    if (nms != r_null) {
+      r_chr_poke(out_nms, j, r_chr_get(nms, i));
+    }
+    ++j;
+  }
+
+  if (nms != r_null) {
+    r_attrib_poke_names(out, out_nms);
+  }
+
+  FREE(4);
+  return out;
+}
+
+r_obj* ffi_intern_stats(r_obj* table) {
+  struct rlang_intern_table* p_table = intern_table_deref(table);
+
+  r_obj* out = KEEP(r_alloc_list(3));
+  r_attrib_poke_names(out, intern_stats_nms);
+
+  r_list_poke(out, 0, r_int(rlang_intern_table_size(p_table)));
+  r_list_poke(out, 1, r_dbl(p_table->n_hits));
+  r_list_poke(out, 2, r_dbl(p_table->n_misses));
+
+  FREE(1);
+  return out;
+}
+
+
+void rlang_init_intern(r_obj* ns) {
+  intern_table_class = r_preserve_global(r_chr("rlang_intern_table"));
+
+  const char* nms[] = { "size", "hits", "misses" };
+  intern_stats_nms = r_preserve_global(r_chr_n(nms, R_ARR_SIZEOF(nms)));
+}
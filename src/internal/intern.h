@@ -0,0 +1,36 @@
+#ifndef RLANG_INTERNAL_INTERN_H
+#define RLANG_INTERNAL_INTERN_H
+
+#include <rlang.h>
+
+
+/*
+ * Table of canonical expressions. Interning an expression returns the
+ * canonical object of the table that is structurally equal to it, so
+ * that equal expressions interned in the same table share the same
+ * address. Subexpressions are interned too and are shared across the
+ * canonical objects of the table.
+ *
+ * Canonical objects are marked as shared so that R copies them before
+ * modifying them. C code must not modify them in place.
+ */
+
+struct rlang_intern_table {
+  r_obj* shelter;
+
+  r_ssize n_hits;
+  r_ssize n_misses;
+
+  /* private: */
+  struct r_int_dict* p_dict;
+  r_ssize n_entries;
+};
+
+struct rlang_intern_table* rlang_new_intern_table(void);
+
+r_obj* rlang_intern(struct rlang_intern_table* p_table, r_obj* x);
+
+r_ssize rlang_intern_table_size(struct rlang_intern_table* p_table);
+
+
+#endif
@@ -5,21 +5,30 @@
 #include "arg.c"
 #include "attr.c"
 #include "call.c"
+#include "cnd-message.c"
+#include "defer.c"
+#include "deparse.c"
 #include "dots.c"
 #include "env.c"
 #include "env-binding.c"
 #include "eval.c"
 #include "eval-tidy.c"
+#include "events.c"
 #include "nse-inject.c"
 #include "ast-rotate.c"
 #include "fn.c"
 #include "hash.c"
+#include "intern.c"
+#include "memo.c"
 #include "nse-defuse.c"
+#include "obj-size.c"
 #include "parse.c"
+#include "prof.c"
 #include "quo.c"
 #include "replace-na.c"
 #include "squash.c"
 #include "sym-unescape.c"
+#include "trace.c"
 #include "utils.c"
 #include "vec.c"
 #include "vec-raw.c"
@@ -34,15 +43,24 @@ r_obj* fns_function = NULL;
 r_obj* fns_quote = NULL;
 
 void rlang_init_arg(r_obj* ns);
+void rlang_init_defer(r_obj* ns);
 
 void rlang_init_internal(r_obj* ns) {
-  rlang_init_utils();
-  rlang_init_arg(ns);
-  rlang_init_attr(ns);
-  rlang_init_dots(ns);
-  rlang_init_expr_interp();
-  rlang_init_eval_tidy();
-  rlang_init_fn();
+  R_INIT_TIMED("rlang_init_utils", rlang_init_utils());
+  R_INIT_TIMED("rlang_init_arg", rlang_init_arg(ns));
+  R_INIT_TIMED("rlang_init_attr", rlang_init_attr(ns));
+  R_INIT_TIMED("rlang_init_call", rlang_init_call(ns));
+  R_INIT_TIMED("rlang_init_defer", rlang_init_defer(ns));
+  R_INIT_TIMED("rlang_init_deparse", rlang_init_deparse(ns));
+  R_INIT_TIMED("rlang_init_dots", rlang_init_dots(ns));
+  R_INIT_TIMED("rlang_init_expr_interp", rlang_init_expr_interp());
+  R_INIT_TIMED("rlang_init_eval_tidy", rlang_init_eval_tidy());
+  R_INIT_TIMED("rlang_init_fn", rlang_init_fn());
+  R_INIT_TIMED("rlang_init_hash", rlang_init_hash());
+  R_INIT_TIMED("rlang_init_intern", rlang_init_intern(ns));
+  R_INIT_TIMED("rlang_init_memo", rlang_init_memo(ns));
+  R_INIT_TIMED("init_parse", init_parse(ns));
+  R_INIT_TIMED("rlang_init_trace", rlang_init_trace(ns));
 
   rlang_zap = rlang_ns_get("zap!");
 
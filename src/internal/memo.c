@@ -0,0 +1,375 @@
+#include <rlang.h>
+#include "memo.h"
+
+#include <stdlib.h> // qsort()
+
+/*
+ * Entries are stored in an integer dictionary keyed by the address of
+ * the key, so that the dictionary doesn't reference the keys. Each
+ * entry is a list of the key, the value, and the tick of its last
+ * access. Weak entries store a weak reference of the key and the value
+ * in place of the key, and `memo_weak_value` in place of the value.
+ *
+ * A weak entry whose key is collected stays in the dictionary until it
+ * is swept or until its address is reused by a new key. This is
+ * detected on lookup by comparing the key of the entry with the
+ * looked up object.
+ */
+
+#define MEMO_INIT_SIZE 32
+
+// Fraction of the entries evicted when the cache is full
+#define MEMO_EVICT_DENOMINATOR 8
+
+enum memo_entry {
+  MEMO_ENTRY_key = 0,
+  MEMO_ENTRY_value,
+  MEMO_ENTRY_tick,
+  MEMO_ENTRY_SIZE
+};
+
+static r_obj* memo_class = NULL;
+static r_obj* memo_weak_value = NULL;
+static r_obj* memo_stats_nms = NULL;
+
+static r_obj* memo_key(struct rlang_memo* p_memo, r_obj* key);
+static void memo_evict(struct rlang_memo* p_memo);
+
+static inline
+r_ssize memo_addr(r_obj* key) {
+  return (r_ssize) (intptr_t) key;
+}
+
+static inline
+bool memo_entry_is_weak(r_obj* entry) {
+  return r_list_get(entry, MEMO_ENTRY_value) == memo_weak_value;
+}
+static inline
+r_obj* memo_entry_key(r_obj* entry) {
+  r_obj* key = r_list_get(entry, MEMO_ENTRY_key);
+  return memo_entry_is_weak(entry) ? R_WeakRefKey(key) : key;
+}
+static inline
+r_obj* memo_entry_value(r_obj* entry) {
+  if (memo_entry_is_weak(entry)) {
+    return R_WeakRefValue(r_list_get(entry, MEMO_ENTRY_key));
+  } else {
+    return r_list_get(entry, MEMO_ENTRY_value);
+  }
+}
+static inline
+bool memo_entry_is_dead(r_obj* entry) {
+  return memo_entry_is_weak(entry) && memo_entry_key(entry) == r_null;
+}
+
+
+struct rlang_memo* rlang_new_memo(r_ssize max_size, bool hash_keys) {
+  if (max_size <= 0) {
+    r_abort("`size` of memoisation cache must be positive.");
+  }
+
+  r_obj* shelter = KEEP(r_alloc_list(2));
+
+  r_obj* memo_raw = r_alloc_raw0(sizeof(struct rlang_memo));
+  r_list_poke(shelter, 0, memo_raw);
+  struct rlang_memo* p_memo = r_raw_begin(memo_raw);
+
+  p_memo->p_dict = r_new_int_dict(MEMO_INIT_SIZE);
+  r_list_poke(shelter, 1, p_memo->p_dict->shelter);
+
+  p_memo->shelter = shelter;
+  p_memo->max_size = max_size;
+  p_memo->hash_keys = hash_keys;
+  p_memo->n_hits = 0;
+  p_memo->n_misses = 0;
+  p_memo->n_evictions = 0;
+  p_memo->tick = 0;
+
+  r_attrib_poke(shelter, r_syms.class, memo_class);
+
+  FREE(1);
+  return p_memo;
+}
+
+r_obj* rlang_memo_get0(struct rlang_memo* p_memo, r_obj* key) {
+  key = KEEP(memo_key(p_memo, key));
+  r_ssize addr = memo_addr(key);
+
+  r_obj* entry = r_int_dict_get0(p_memo->p_dict, addr);
+  r_obj* out = NULL;
+
+  if (entry) {
+    if (memo_entry_key(entry) == key) {
+      out = memo_entry_value(entry);
+      r_dbl_begin(r_list_get(entry, MEMO_ENTRY_tick))[0] = ++p_memo->tick;
+    } else {
+      // The address of a collected weak key was reused
+      r_int_dict_del(p_memo->p_dict, addr);
+    }
+  }
+
+  if (out) {
+    ++p_memo->n_hits;
+  } else {
+    ++p_memo->n_misses;
+  }
+
+  FREE(1);
+  return out;
+}
+
+void rlang_memo_put(struct rlang_memo* p_memo, r_obj* key, r_obj* value) {
+  key = KEEP(memo_key(p_memo, key));
+  r_ssize addr = memo_addr(key);
+
+  r_int_dict_del(p_memo->p_dict, addr);
+
+  if (p_memo->p_dict->n_entries >= p_memo->max_size) {
+    memo_evict(p_memo);
+  }
+
+  r_obj* entry = KEEP(r_alloc_list(MEMO_ENTRY_SIZE));
+
+  enum r_type type = r_typeof(key);
+  bool weak = !p_memo->hash_keys && (type == R_TYPE_environment || type == R_TYPE_pointer);
+
+  if (weak) {
+    r_list_poke(entry, MEMO_ENTRY_key, R_MakeWeakRef(key, value, r_null, FALSE));
+    r_list_poke(entry, MEMO_ENTRY_value, memo_weak_value);
+  } else {
+    r_list_poke(entry, MEMO_ENTRY_key, key);
+    r_list_poke(entry, MEMO_ENTRY_value, value);
+  }
+  r_list_poke(entry, MEMO_ENTRY_tick, r_dbl(++p_memo->tick));
+
+  r_int_dict_put(p_memo->p_dict, addr, entry);
+
+  FREE(2);
+}
+
+bool rlang_memo_del(struct rlang_memo* p_memo, r_obj* key) {
+  key = KEEP(memo_key(p_memo, key));
+  r_ssize addr = memo_addr(key);
+
+  r_obj* entry = r_int_dict_get0(p_memo->p_dict, addr);
+  bool out = entry && memo_entry_key(entry) == key;
+
+  if (entry) {
+    r_int_dict_del(p_memo->p_dict, addr);
+  }
+
+  FREE(1);
+  return out;
+}
+
+r_ssize rlang_memo_size(struct rlang_memo* p_memo) {
+  return p_memo->p_dict->n_entries;
+}
+
+
+// Address caches --------------------------------------------------
+
+#define ADDR_CACHE_INIT_SIZE 32
+
+struct rlang_addr_cache* rlang_new_addr_cache(r_ssize max_size, bool drop_at_gc) {
+  r_obj* shelter = KEEP(r_alloc_list(2));
+
+  r_obj* cache_raw = r_alloc_raw0(sizeof(struct rlang_addr_cache));
+  r_list_poke(shelter, 0, cache_raw);
+  struct rlang_addr_cache* p_cache = r_raw_begin(cache_raw);
+
+  p_cache->shelter = shelter;
+  p_cache->max_size = max_size;
+  p_cache->drop_at_gc = drop_at_gc;
+  p_cache->p_dict = NULL;
+
+  FREE(1);
+  return p_cache;
+}
+
+// The sentinel refers to the dictionary it was created with, so that
+// the sentinels of previous flushes don't drop the current one
+static
+void addr_cache_drop(r_obj* sentinel) {
+  struct rlang_addr_cache* p_cache = R_ExternalPtrAddr(sentinel);
+  if (p_cache->p_dict && p_cache->p_dict->shelter == R_ExternalPtrTag(sentinel)) {
+    r_list_poke(p_cache->shelter, 1, r_null);
+    p_cache->p_dict = NULL;
+  }
+}
+
+static
+void addr_cache_flush(struct rlang_addr_cache* p_cache) {
+  p_cache->p_dict = r_new_dict(ADDR_CACHE_INIT_SIZE);
+  r_list_poke(p_cache->shelter, 1, p_cache->p_dict->shelter);
+
+  if (p_cache->drop_at_gc) {
+    // The sentinel is unreachable and collected at the next gc. It
+    // protects the cache until its finalizer has run.
+    r_obj* sentinel = KEEP(R_MakeExternalPtr(p_cache,
+                                             p_cache->p_dict->shelter,
+                                             p_cache->shelter));
+    R_RegisterCFinalizerEx(sentinel, &addr_cache_drop, FALSE);
+    FREE(1);
+  }
+}
+
+r_obj* rlang_addr_cache_get0(struct rlang_addr_cache* p_cache, r_obj* key) {
+  if (!p_cache->p_dict) {
+    return NULL;
+  }
+  return r_dict_get0(p_cache->p_dict, key);
+}
+
+void rlang_addr_cache_put(struct rlang_addr_cache* p_cache, r_obj* key, r_obj* value) {
+  if (!p_cache->p_dict || p_cache->p_dict->n_entries >= p_cache->max_size) {
+    addr_cache_flush(p_cache);
+  }
+
+  // Protected in case the cache is dropped while the dictionary grows
+  struct r_dict* p_dict = p_cache->p_dict;
+  KEEP(p_dict->shelter);
+  r_dict_put(p_dict, key, value);
+  FREE(1);
+}
+
+
+static
+r_obj* memo_key(struct rlang_memo* p_memo, r_obj* key) {
+  if (!p_memo->hash_keys) {
+    return key;
+  }
+
+  // Strings are interned so equal hashes share the same address
+  r_obj* hash = KEEP(hash_exec(key, HASH_METHOD_serialize, HASH_FORMAT_string, 1));
+  r_obj* out = r_chr_get(hash, 0);
+
+  FREE(1);
+  return out;
+}
+
+static
+int memo_tick_compare(const void* x, const void* y) {
+  double x_tick = *((const double*) x);
+  double y_tick = *((const double*) y);
+  return (x_tick > y_tick) - (x_tick < y_tick);
+}
+
+// Sweeps dead weak entries and evicts the least recently used
+// entries. Dead entries are given a tick of 0 so that they are
+// evicted first.
+static
+void memo_evict(struct rlang_memo* p_memo) {
+  struct r_int_dict* p_dict = p_memo->p_dict;
+  r_ssize n = p_dict->n_entries;
+
+  r_obj* addrs = KEEP(r_alloc_raw(r_ssize_mult(n, sizeof(r_ssize))));
+  r_ssize* v_addrs = (r_ssize*) r_raw_begin(addrs);
+
+  r_obj* ticks = KEEP(r_alloc_double(n));
+  double* v_ticks = r_dbl_begin(ticks);
+
+  struct r_int_dict_iterator* p_it = r_new_int_dict_iterator(p_dict);
+  KEEP(p_it->shelter);
+
+  for (r_ssize i = 0; r_int_dict_next(p_it); ++i) {
+    v_addrs[i] = p_it->key;
+
+    if (memo_entry_is_dead(p_it->value)) {
+      v_ticks[i] = 0;
+    } else {
+      v_ticks[i] = r_dbl_get(r_list_get(p_it->value, MEMO_ENTRY_tick), 0);
+    }
+  }
+
+  r_ssize n_evict = p_memo->max_size / MEMO_EVICT_DENOMINATOR;
+  if (n_evict < 1) {
+    n_evict = 1;
+  }
+  if (n_evict > n) {
+    n_evict = n;
+  }
+
+  r_obj* sorted = KEEP(r_clone(ticks));
+  double* v_sorted = r_dbl_begin(sorted);
+  qsort(v_sorted, n, sizeof(double), &memo_tick_compare);
+
+  // Ticks of live entries are unique
+  double threshold = v_sorted[n_evict - 1];
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_ticks[i] <= threshold) {
+      r_int_dict_del(p_dict, v_addrs[i]);
+      p_memo->n_evictions += v_ticks[i] > 0;
+    }
+  }
+
+  FREE(4);
+}
+
+
+// R interface -----------------------------------------------------
+
+static
+struct rlang_memo* memo_deref(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_list ||
+      r_length(x) != 2 ||
+      !r_inherits(x, "rlang_memo") ||
+      r_typeof(r_list_get(x, 0)) != R_TYPE_raw) {
+    r_abort("`memo` must be a memoisation cache.");
+  }
+  return (struct rlang_memo*) r_raw_begin(r_list_get(x, 0));
+}
+
+r_obj* ffi_new_memo(r_obj* size, r_obj* hash_keys) {
+  if (!r_is_int(size)) {
+    r_stop_internal("ffi_new_memo", "`size` must be an integer.");
+  }
+  if (!r_is_bool(hash_keys)) {
+    r_stop_internal("ffi_new_memo", "`hash_keys` must be a logical value.");
+  }
+
+  struct rlang_memo* p_memo = rlang_new_memo(r_int_get(size, 0), r_lgl_get(hash_keys, 0));
+  return p_memo->shelter;
+}
+
+r_obj* ffi_memo_get(r_obj* memo, r_obj* key, r_obj* default_) {
+  r_obj* out = rlang_memo_get0(memo_deref(memo), key);
+  return out ? out : default_;
+}
+
+r_obj* ffi_memo_put(r_obj* memo, r_obj* key, r_obj* value) {
+  rlang_memo_put(memo_deref(memo), key, value);
+  return r_null;
+}
+
+r_obj* ffi_memo_del(r_obj* memo, r_obj* key) {
+  return r_lgl(rlang_memo_del(memo_deref(memo), key));
+}
+
+r_obj* ffi_memo_stats(r_obj* memo) {
+  struct rlang_memo* p_memo = memo_deref(memo);
+
+  r_obj* out = KEEP(r_alloc_list(5));
+  r_attrib_poke_names(out, memo_stats_nms);
+
+  r_list_poke(out, 0, r_int(rlang_memo_size(p_memo)));
+  r_list_poke(out, 1, r_int(p_memo->max_size));
+  r_list_poke(out, 2, r_dbl(p_memo->n_hits));
+  r_list_poke(out, 3, r_dbl(p_memo->n_misses));
+  r_list_poke(out, 4, r_dbl(p_memo->n_evictions));
+
+  FREE(1);
+  return out;
+}
+
+
+void rlang_init_memo(r_obj* ns) {
+  memo_class = r_preserve_global(r_chr("rlang_memo"));
+
+  // A unique object that can't be a cached value
+  memo_weak_value = r_preserve_global(r_alloc_raw(0));
+
+  const char* nms[] = { "size", "max_size", "hits", "misses", "evictions" };
+  memo_stats_nms = r_preserve_global(r_chr_n(nms, R_ARR_SIZEOF(nms)));
+}
@@ -0,0 +1,73 @@
+#ifndef RLANG_INTERNAL_MEMO_H
+#define RLANG_INTERNAL_MEMO_H
+
+#include <rlang.h>
+
+
+/*
+ * Memoisation cache keyed by R objects. With address keys, entries
+ * keyed by environments or external pointers are weak: the key and
+ * the value are released when the key is no longer reachable. Other
+ * keys are kept alive by the cache. With hash keys, objects are
+ * keyed by the `hash()` of their contents.
+ *
+ * The cache holds at most `max_size` entries. When it is full, dead
+ * weak entries are swept and then the least recently used entries
+ * are evicted.
+ */
+
+struct rlang_memo {
+  r_obj* shelter;
+
+  r_ssize max_size;
+  bool hash_keys;
+
+  r_ssize n_hits;
+  r_ssize n_misses;
+  r_ssize n_evictions;
+
+  /* private: */
+  struct r_int_dict* p_dict;
+  double tick;
+};
+
+struct rlang_memo* rlang_new_memo(r_ssize max_size, bool hash_keys);
+
+// Returns `NULL` when `key` is not in the cache
+r_obj* rlang_memo_get0(struct rlang_memo* p_memo, r_obj* key);
+void rlang_memo_put(struct rlang_memo* p_memo, r_obj* key, r_obj* value);
+bool rlang_memo_del(struct rlang_memo* p_memo, r_obj* key);
+
+r_ssize rlang_memo_size(struct rlang_memo* p_memo);
+
+
+/*
+ * Cache keyed by the address of objects that can't be weakly
+ * referenced. R weak references only accept environments and
+ * external pointers as keys, so the cache holds its keys strongly,
+ * which also prevents their addresses from being reused.
+ *
+ * The cache is flushed when it reaches `max_size` entries. With
+ * `drop_at_gc`, it is also dropped at the next garbage collection by
+ * the finalizer of a sentinel created along with each flush, so that
+ * it doesn't keep its keys alive for long.
+ */
+
+struct rlang_addr_cache {
+  r_obj* shelter;
+
+  r_ssize max_size;
+  bool drop_at_gc;
+
+  /* private: */
+  struct r_dict* p_dict;
+};
+
+struct rlang_addr_cache* rlang_new_addr_cache(r_ssize max_size, bool drop_at_gc);
+
+// Returns `NULL` when `key` is not in the cache
+r_obj* rlang_addr_cache_get0(struct rlang_addr_cache* p_cache, r_obj* key);
+void rlang_addr_cache_put(struct rlang_addr_cache* p_cache, r_obj* key, r_obj* value);
+
+
+#endif
@@ -1,4 +1,6 @@
 #include <rlang.h>
+#include "events.h"
+#include "memo.h"
 #include "nse-inject.h"
 #include "ast-rotate.h"
 #include "utils.h"
@@ -134,7 +136,15 @@ void signal_namespaced_uqs_deprecation() {
   );
 }
 
+static
+void maybe_poke_big_bang_op_impl(r_obj* x, struct injection_info* info, bool signal);
+
 void maybe_poke_big_bang_op(r_obj* x, struct injection_info* info) {
+  maybe_poke_big_bang_op_impl(x, info, true);
+}
+
+static
+void maybe_poke_big_bang_op_impl(r_obj* x, struct injection_info* info, bool signal) {
   if (r_is_call(x, "!!!")) {
     if (r_node_cddr(x) != r_null) {
       r_abort("Can't supply multiple arguments to `!!!`");
@@ -151,7 +161,7 @@ void maybe_poke_big_bang_op(r_obj* x, struct injection_info* info) {
   }
 
   bool namespaced_uqs = r_is_namespaced_call(x, "rlang", "UQS");
-  if (namespaced_uqs) {
+  if (namespaced_uqs && signal) {
     signal_namespaced_uqs_deprecation();
   }
   if (namespaced_uqs || r_is_call(x, "UQS")) {
@@ -165,6 +175,12 @@ void maybe_poke_big_bang_op(r_obj* x, struct injection_info* info) {
 static r_obj* dot_data_sym = NULL;
 
 struct injection_info which_expansion_op(r_obj* x, bool unquote_names) {
+  return which_expansion_op_impl(x, unquote_names, true);
+}
+
+// With `signal = false`, deprecation warnings are not signalled. This
+// is for detecting injection sites ahead of the actual injection.
+struct injection_info which_expansion_op_impl(r_obj* x, bool unquote_names, bool signal) {
   struct injection_info info = which_uq_op(x);
 
   if (r_typeof(x) != R_TYPE_call) {
@@ -200,7 +216,7 @@ struct injection_info which_expansion_op(r_obj* x, bool unquote_names) {
     return info;
   }
 
-  maybe_poke_big_bang_op(x, &info);
+  maybe_poke_big_bang_op_impl(x, &info, signal);
   if (info.op == INJECTION_OP_uqs) {
     return info;
   }
@@ -215,7 +231,9 @@ struct injection_info which_expansion_op(r_obj* x, bool unquote_names) {
     info.operand = r_node_cadr(x);
 
     if (r_is_namespaced_call(x, "rlang", NULL)) {
-      signal_namespaced_uq_deprecation();
+      if (signal) {
+        signal_namespaced_uq_deprecation();
+      }
     } else {
       info.parent = r_node_cdr(r_node_cdar(x));
       info.root = r_node_car(x);
@@ -237,10 +255,12 @@ struct injection_info which_expansion_op(r_obj* x, bool unquote_names) {
     info.operand = r_node_car(info.parent);
 
     // User had to unquote operand manually before .data[[ was unquote syntax
-    struct injection_info nested = which_expansion_op(info.operand, false);
+    struct injection_info nested = which_expansion_op_impl(info.operand, false, signal);
     if (nested.op == INJECTION_OP_uq) {
-      const char* msg = "It is no longer necessary to unquote within the `.data` pronoun";
-      signal_soft_deprecated(msg, msg, r_empty_env);
+      if (signal) {
+        const char* msg = "It is no longer necessary to unquote within the `.data` pronoun";
+        signal_soft_deprecated(msg, msg, r_empty_env);
+      }
       info.operand = nested.operand;
     }
 
@@ -274,8 +294,54 @@ static r_obj* bang_bang_teardown(r_obj* value, struct injection_info info) {
     return info.root;
   }
 }
+
+/*
+ * Memoisation of injected symbols across a batch of expressions, see
+ * `ffi_exprs_interp()`. While a batch is active, the values of `!!sym`
+ * and the quosures of `{{sym}}` in the batch environment are looked
+ * up once and reused for all expressions. Injected values are marked
+ * as shared so they can be inserted in several expressions.
+ */
+struct interp_memo {
+  r_obj* env;
+  struct r_dict* p_values;
+  struct r_dict* p_quos;
+};
+
+static struct interp_memo* p_interp_memo = NULL;
+
+static
+r_obj* interp_memo_get(struct r_dict* p_dict,
+                       r_obj* sym,
+                       r_obj* env,
+                       r_obj* (*fn)(r_obj*, r_obj*)) {
+  r_obj* value = r_dict_get0(p_dict, sym);
+  if (value) {
+    return value;
+  }
+
+  value = KEEP(fn(sym, env));
+  r_dict_put(p_dict, sym, value);
+
+  FREE(1);
+  return value;
+}
+
+static inline
+bool interp_is_memoised(r_obj* operand, r_obj* env) {
+  return
+    p_interp_memo &&
+    p_interp_memo->env == env &&
+    r_typeof(operand) == R_TYPE_symbol;
+}
+
 static r_obj* bang_bang(struct injection_info info, r_obj* env) {
-  r_obj* value = r_eval(info.operand, env);
+  r_obj* value;
+  if (interp_is_memoised(info.operand, env)) {
+    value = interp_memo_get(p_interp_memo->p_values, info.operand, env, &r_eval);
+  } else {
+    value = r_eval(info.operand, env);
+  }
   return bang_bang_teardown(value, info);
 }
 
@@ -303,19 +369,36 @@ r_obj* big_bang(r_obj* operand, r_obj* env, r_obj* prev, r_obj* node) {
 }
 
 static r_obj* curly_curly(struct injection_info info, r_obj* env) {
-  r_obj* value = rlang_enquo(info.operand, env);
+  r_obj* value;
+  if (interp_is_memoised(info.operand, env)) {
+    value = interp_memo_get(p_interp_memo->p_quos, info.operand, env, &rlang_enquo);
+  } else {
+    value = rlang_enquo(info.operand, env);
+  }
   return bang_bang_teardown(value, info);
 }
 
 
 // Defined below
-static r_obj* call_list_interp(r_obj* x, r_obj* env);
-static r_obj* node_list_interp(r_obj* x, r_obj* env);
 static void call_maybe_poke_string_head(r_obj* call);
+static bool expr_has_injection(r_obj* x);
+static bool interp_is_cacheable(r_obj* x);
+static r_obj* interp_sites(r_obj* x);
+static r_obj* interp_sites_cached(r_obj* x);
+static void interp_sites_push(struct r_dyn_array* p_path,
+                              struct r_dyn_array* p_sites,
+                              int pos);
+static r_obj* call_interp_sites(r_obj* x,
+                                r_obj* env,
+                                r_obj* const * v_sites,
+                                r_ssize n);
 
 r_obj* call_interp(r_obj* x, r_obj* env)  {
+  RLANG_EVENT_ENTER(call_interp, r_length(x));
   struct injection_info info = which_expansion_op(x, false);
-  return call_interp_impl(x, env, info);
+  r_obj* out = call_interp_impl(x, env, info);
+  RLANG_EVENT_EXIT(call_interp, r_length(out));
+  return out;
 }
 
 r_obj* call_interp_impl(r_obj* x, r_obj* env, struct injection_info info) {
@@ -328,9 +411,7 @@ r_obj* call_interp_impl(r_obj* x, r_obj* env, struct injection_info info) {
     if (r_typeof(x) != R_TYPE_call) {
       return x;
     } else {
-      r_obj* out = call_list_interp(x, env);
-      call_maybe_poke_string_head(out);
-      return out;
+      return call_interp_cow(x, env);
     }
   case INJECTION_OP_uq:
     return bang_bang(info, env);
@@ -384,31 +465,360 @@ static void call_maybe_poke_string_head(r_obj* call) {
   r_node_poke_car(call, r_sym(r_chr_get_c_string(head, 0)));
 }
 
-static r_obj* call_list_interp(r_obj* x, r_obj* env) {
-  r_node_poke_car(x, call_interp(r_node_car(x), env));
-  r_node_poke_cdr(x, node_list_interp(r_node_cdr(x), env));
+// Injection sites are rearranged in place
+static r_obj* call_interp_copy(r_obj* x, r_obj* env) {
+  x = KEEP(r_copy(x));
+  x = call_interp(x, env);
+
+  FREE(1);
   return x;
 }
-static r_obj* node_list_interp(r_obj* node, r_obj* env) {
-  r_obj* prev = KEEP(r_new_node(r_null, node));
-  r_obj* out = prev;
 
-  while (node != r_null) {
-    r_obj* arg = r_node_car(node);
-    struct injection_info info = which_expansion_op(arg, false);
+r_obj* call_interp_cow(r_obj* x, r_obj* env) {
+  if (r_typeof(x) != R_TYPE_call) {
+    return x;
+  }
+
+  // Protect the sites in case the cache is flushed by a nested
+  // injection, e.g. while capturing the argument of `{{`
+  r_obj* sites = interp_is_cacheable(x) ? interp_sites_cached(x) : interp_sites(x);
+  KEEP(sites);
+
+  r_ssize n = r_length(sites);
+  r_obj* const * v_sites = r_list_cbegin(sites);
+
+  r_obj* out;
+  if (n == 0 && r_typeof(r_node_car(x)) != R_TYPE_character) {
+    out = x;
+  } else if (n == 1 && r_length(v_sites[0]) == 0) {
+    out = call_interp_copy(x, env);
+  } else {
+    out = call_interp_sites(x, env, v_sites, n);
+  }
+
+  FREE(1);
+  return out;
+}
+
 
-    if (info.op == INJECTION_OP_uqs) {
-      node = big_bang(info.operand, env, prev, node);
+/*
+ * The copy-on-write interpolation happens in two passes. The first
+ * collects the paths to the injection sites and the second rebuilds
+ * the spines of the calls along these paths. Both passes keep their
+ * state on an explicit stack so that deep expressions don't overflow
+ * the C stack.
+ *
+ * A path is an integer vector of the positions of the nodes leading
+ * to a site, where 0 is the head of a call and 1 is its first
+ * argument. The last position of a path to a `!!!` argument is
+ * negated because the site is spliced in the parent. An empty path
+ * means that the expression is itself a site. Paths are collected
+ * depth-first so paths through the same nodes are contiguous.
+ *
+ * Operators whose precedence might need an AST fixup (e.g. `+`) are
+ * only sites when they contain an injection. Long chains of
+ * arithmetic are then shared as is and don't go through the
+ * recursive fixup code.
+ */
+
+enum interp_site {
+  INTERP_SITE_none = 0,
+  INTERP_SITE_inject,
+  INTERP_SITE_splice,
+  INTERP_SITE_skip
+};
+
+static
+enum interp_site interp_which_site(r_obj* x, int pos) {
+  if (r_typeof(x) != R_TYPE_call) {
+    return INTERP_SITE_skip;
+  }
+
+  struct injection_info info = which_expansion_op_impl(x, false, false);
+
+  switch (info.op) {
+  case INJECTION_OP_none:
+    if (r_typeof(r_node_car(x)) == R_TYPE_character) {
+      return INTERP_SITE_inject;
     } else {
-      r_node_poke_car(node, call_interp_impl(arg, env, info));
+      return INTERP_SITE_none;
+    }
+  case INJECTION_OP_uqs:
+    return pos > 0 ? INTERP_SITE_splice : INTERP_SITE_inject;
+  case INJECTION_OP_fixup:
+    if (info.operand == r_null) {
+      return expr_has_injection(x) ? INTERP_SITE_inject : INTERP_SITE_skip;
+    }
+    return INTERP_SITE_inject;
+  default:
+    return INTERP_SITE_inject;
+  }
+}
+
+// Is there any injection site within `x`, including `x` itself?
+static
+bool expr_has_injection(r_obj* x) {
+  struct r_dyn_array* p_stack = r_new_dyn_array(sizeof(r_obj*), 16);
+  KEEP(p_stack->shelter);
+
+  r_arr_push_back(p_stack, &x);
+  bool out = false;
+
+  while (p_stack->count) {
+    r_obj* call = *(r_obj**) r_arr_pop_back(p_stack);
+
+    struct injection_info info = which_expansion_op_impl(call, false, false);
+    bool plain_fixup = info.op == INJECTION_OP_fixup && info.operand == r_null;
+
+    if ((info.op != INJECTION_OP_none && !plain_fixup) ||
+        r_typeof(r_node_car(call)) == R_TYPE_character) {
+      out = true;
+      break;
     }
 
-    prev = node;
-    node = r_node_cdr(node);
+    for (r_obj* node = call; node != r_null; node = r_node_cdr(node)) {
+      r_obj* arg = r_node_car(node);
+      if (r_typeof(arg) == R_TYPE_call) {
+        r_arr_push_back(p_stack, &arg);
+      }
+    }
   }
 
   FREE(1);
-  return r_node_cdr(out);
+  return out;
+}
+
+struct interp_sites_frame {
+  r_obj* node;
+  int pos;
+};
+
+static
+r_obj* interp_sites(r_obj* x) {
+  struct r_dyn_array* p_sites = r_new_dyn_vector(R_TYPE_list, 4);
+  KEEP(p_sites->shelter);
+
+  switch (interp_which_site(x, 0)) {
+  case INTERP_SITE_inject:
+    r_list_push_back(p_sites, r_globals.empty_int);
+    FREE(1);
+    return r_arr_unwrap(p_sites);
+  case INTERP_SITE_skip:
+    FREE(1);
+    return r_arr_unwrap(p_sites);
+  default:
+    break;
+  }
+
+  // Positions of the calls leading to the current frame
+  struct r_dyn_array* p_path = r_new_dyn_vector(R_TYPE_integer, 8);
+  KEEP(p_path->shelter);
+
+  struct r_dyn_array* p_stack = r_new_dyn_array(sizeof(struct interp_sites_frame), 8);
+  KEEP(p_stack->shelter);
+
+  struct interp_sites_frame root = { .node = x, .pos = 0 };
+  r_arr_push_back(p_stack, &root);
+
+  while (p_stack->count) {
+    struct interp_sites_frame* p_frame = r_arr_last(p_stack);
+
+    if (p_frame->node == r_null) {
+      r_arr_pop_back(p_stack);
+      if (p_path->count) {
+        r_arr_pop_back(p_path);
+      }
+      continue;
+    }
+
+    r_obj* arg = r_node_car(p_frame->node);
+    int pos = p_frame->pos;
+
+    p_frame->node = r_node_cdr(p_frame->node);
+    ++p_frame->pos;
+
+    switch (interp_which_site(arg, pos)) {
+    case INTERP_SITE_inject:
+      interp_sites_push(p_path, p_sites, pos);
+      break;
+    case INTERP_SITE_splice:
+      interp_sites_push(p_path, p_sites, -pos);
+      break;
+    case INTERP_SITE_none: {
+      r_int_push_back(p_path, pos);
+      struct interp_sites_frame frame = { .node = arg, .pos = 0 };
+      r_arr_push_back(p_stack, &frame);
+      break;
+    }
+    case INTERP_SITE_skip:
+      break;
+    }
+  }
+
+  r_obj* out = r_arr_unwrap(p_sites);
+  FREE(3);
+  return out;
+}
+
+static
+void interp_sites_push(struct r_dyn_array* p_path,
+                       struct r_dyn_array* p_sites,
+                       int pos) {
+  r_ssize n = p_path->count;
+
+  r_obj* site = KEEP(r_alloc_integer(n + 1));
+  int* v_site = r_int_begin(site);
+
+  memcpy(v_site, p_path->v_data, n * sizeof(int));
+  v_site[n] = pos;
+
+  r_list_push_back(p_sites, site);
+  FREE(1);
+}
+
+struct interp_spine_frame {
+  // Clone of the call being rebuilt and current node within it
+  r_obj* out;
+  r_obj* node;
+  r_obj* prev;
+  int pos;
+
+  // Range of the sites that lead to this call
+  r_ssize k;
+  r_ssize end;
+  r_ssize depth;
+};
+
+// `x` is not itself a site. Each frame rebuilds the clone of a call
+// with the sites in the range `[k, end)`. The clones are protected
+// in `p_outs` while on the stack.
+static
+r_obj* call_interp_sites(r_obj* x,
+                         r_obj* env,
+                         r_obj* const * v_sites,
+                         r_ssize n) {
+  struct r_dyn_array* p_outs = r_new_dyn_vector(R_TYPE_list, 8);
+  KEEP(p_outs->shelter);
+
+  struct r_dyn_array* p_stack = r_new_dyn_array(sizeof(struct interp_spine_frame), 8);
+  KEEP(p_stack->shelter);
+
+  r_obj* out = r_clone(x);
+  r_list_push_back(p_outs, out);
+
+  struct interp_spine_frame root = {
+    .out = out, .node = out, .prev = r_null, .pos = 0,
+    .k = 0, .end = n, .depth = 0
+  };
+  r_arr_push_back(p_stack, &root);
+
+  while (true) {
+    struct interp_spine_frame* p_frame = r_arr_last(p_stack);
+
+    if (p_frame->k == p_frame->end) {
+      call_maybe_poke_string_head(p_frame->out);
+      out = p_frame->out;
+
+      r_arr_pop_back(p_stack);
+      if (!p_stack->count) {
+        break;
+      }
+
+      // Attach the rebuilt call to its parent. It is now protected by
+      // the parent clone.
+      p_frame = r_arr_last(p_stack);
+      r_node_poke_car(p_frame->node, out);
+      r_arr_pop_back(p_outs);
+
+      p_frame->prev = p_frame->node;
+      p_frame->node = r_node_cdr(p_frame->node);
+      ++p_frame->pos;
+      continue;
+    }
+
+    r_obj* site = v_sites[p_frame->k];
+    int pos = r_int_begin(site)[p_frame->depth];
+    bool splice = pos < 0;
+    int target = splice ? -pos : pos;
+
+    for (; p_frame->pos < target; ++p_frame->pos) {
+      p_frame->prev = p_frame->node;
+      p_frame->node = r_node_cdr(p_frame->node);
+    }
+
+    if (splice) {
+      struct injection_info info = which_expansion_op(r_node_car(p_frame->node), false);
+      p_frame->node = big_bang(info.operand, env, p_frame->prev, p_frame->node);
+      ++p_frame->k;
+    } else if (r_length(site) == p_frame->depth + 1) {
+      r_obj* value = call_interp_copy(r_node_car(p_frame->node), env);
+      r_node_poke_car(p_frame->node, value);
+      ++p_frame->k;
+    } else {
+      r_ssize end = p_frame->k + 1;
+      while (end < p_frame->end && r_int_begin(v_sites[end])[p_frame->depth] == pos) {
+        ++end;
+      }
+
+      r_obj* child = r_clone(r_node_car(p_frame->node));
+      r_list_push_back(p_outs, child);
+
+      struct interp_spine_frame frame = {
+        .out = child, .node = child, .prev = r_null, .pos = 0,
+        .k = p_frame->k, .end = end, .depth = p_frame->depth + 1
+      };
+      p_frame->k = end;
+
+      // Invalidates `p_frame`. The parent moves past this node once
+      // the child is attached.
+      r_arr_push_back(p_stack, &frame);
+      continue;
+    }
+
+    p_frame->prev = p_frame->node;
+    p_frame->node = r_node_cdr(p_frame->node);
+    ++p_frame->pos;
+  }
+
+  FREE(2);
+  return out;
+}
+
+
+/*
+ * Templates are often injected into repeatedly, e.g. `expr(mean(!!col))`
+ * in a loop captures the same promise expression every time. The
+ * paths to their injection sites are cached by address so that
+ * repeated injections jump straight to the sites, and templates
+ * without sites are returned without being scanned.
+ *
+ * Only shared expressions are cached since R duplicates them before
+ * any modification. The cache is flushed when it reaches
+ * `INTERP_CACHE_MAX_SIZE` entries, see `struct rlang_addr_cache`.
+ */
+
+#define INTERP_CACHE_MAX_SIZE 1024
+
+static struct rlang_addr_cache* p_interp_cache = NULL;
+
+static
+bool interp_is_cacheable(r_obj* x) {
+  return MAYBE_SHARED(x) && r_typeof(r_node_car(x)) != R_TYPE_character;
+}
+
+static
+r_obj* interp_sites_cached(r_obj* x) {
+  r_obj* sites = rlang_addr_cache_get0(p_interp_cache, x);
+  if (sites) {
+    return sites;
+  }
+
+  sites = KEEP(interp_sites(x));
+
+  rlang_addr_cache_put(p_interp_cache, x, sites);
+
+  FREE(1);
+  return sites;
 }
 
 r_obj* rlang_interp(r_obj* x, r_obj* env) {
@@ -419,15 +829,97 @@ r_obj* rlang_interp(r_obj* x, r_obj* env) {
     return x;
   }
 
-  // FIXME: Only duplicate the call tree, not the leaves
-  x = KEEP(r_copy(x));
-  x = call_interp(x, env);
+  return call_interp_cow(x, env);
+}
+
+
+struct exprs_interp_data {
+  r_obj* xs;
+  r_obj* env;
+  struct interp_memo* p_prev_memo;
+};
+
+static
+r_obj* exprs_interp_impl(void* p_data) {
+  struct exprs_interp_data* p_exec = (struct exprs_interp_data*) p_data;
+  r_obj* xs = p_exec->xs;
+  r_obj* env = p_exec->env;
+
+  r_ssize n = r_length(xs);
+
+  // The list is only cloned once an expression has been injected
+  r_obj* out = xs;
+  r_keep_t out_pi;
+  KEEP_HERE(out, &out_pi);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* x = r_list_get(xs, i);
+    if (r_typeof(x) != R_TYPE_call) {
+      continue;
+    }
+
+    r_obj* x_out = call_interp_cow(x, env);
+    if (x_out == x) {
+      continue;
+    }
+    KEEP(x_out);
+
+    if (out == xs) {
+      out = r_clone(xs);
+      KEEP_AT(out, out_pi);
+    }
+    r_list_poke(out, i, x_out);
+
+    FREE(1);
+  }
 
   FREE(1);
-  return x;
+  return out;
+}
+
+static
+void exprs_interp_cleanup(void* p_data) {
+  struct exprs_interp_data* p_exec = (struct exprs_interp_data*) p_data;
+  p_interp_memo = p_exec->p_prev_memo;
+}
+
+r_obj* ffi_exprs_interp(r_obj* xs, r_obj* env) {
+  if (r_typeof(xs) != R_TYPE_list) {
+    r_abort("`xs` must be a list.");
+  }
+  if (!r_is_environment(env)) {
+    r_abort("`env` must be an environment");
+  }
+
+  struct r_dict* p_values = r_new_dict(16);
+  KEEP(p_values->shelter);
+
+  struct r_dict* p_quos = r_new_dict(16);
+  KEEP(p_quos->shelter);
+
+  struct interp_memo memo = {
+    .env = env,
+    .p_values = p_values,
+    .p_quos = p_quos
+  };
+
+  struct exprs_interp_data data = {
+    .xs = xs,
+    .env = env,
+    .p_prev_memo = p_interp_memo
+  };
+
+  p_interp_memo = &memo;
+  r_obj* out = R_ExecWithCleanup(exprs_interp_impl, &data, exprs_interp_cleanup, &data);
+
+  FREE(2);
+  return out;
 }
 
 
 void rlang_init_expr_interp() {
   dot_data_sym = r_sym(".data");
+
+  p_interp_cache = rlang_new_addr_cache(INTERP_CACHE_MAX_SIZE, false);
+  r_preserve(p_interp_cache->shelter);
 }
@@ -57,6 +57,7 @@ static inline struct injection_info init_expansion_info() {
 
 struct injection_info which_uq_op(r_obj* x);
 struct injection_info which_expansion_op(r_obj* x, bool unquote_names);
+struct injection_info which_expansion_op_impl(r_obj* x, bool unquote_names, bool signal);
 struct injection_info is_big_bang_op(r_obj* x);
 
 r_obj* big_bang_coerce(r_obj* expr);
@@ -65,6 +66,11 @@ r_obj* rlang_interp(r_obj* x, r_obj* env);
 r_obj* call_interp(r_obj* x, r_obj* env);
 r_obj* call_interp_impl(r_obj* x, r_obj* env, struct injection_info info);
 
+// Variant of `call_interp()` that doesn't modify `x`. Subexpressions
+// without injection sites are shared with `x`, and `x` itself is
+// returned when it doesn't contain any.
+r_obj* call_interp_cow(r_obj* x, r_obj* env);
+
 
 static inline r_obj* forward_quosure(r_obj* x, r_obj* env) {
   switch (r_typeof(x)) {
@@ -0,0 +1,370 @@
+#include <rlang.h>
+#include "walk.h"
+
+/*
+ * Estimates the memory retained by an object by walking it with the
+ * sexp iterator and summing the allocation size of each node. Shared
+ * nodes are counted once. The allocation sizes follow the layout of
+ * R's memory manager on the current platform:
+ *
+ * - Non-vector nodes hold a header and three pointers.
+ * - Vectors hold a header, a length and a true length, followed by
+ *   their data. Small vectors are allocated in size classes of 8,
+ *   16, 32, 48, 64 and 128 bytes, larger ones are rounded up to a
+ *   multiple of 8 bytes.
+ *
+ * Symbols and the global, base, and empty environments, as well as
+ * package environments and namespaces, are not counted since they
+ * are shared by the whole session.
+ *
+ * ALTREP objects are not materialised. They are counted as a node
+ * plus the size of their data and attributes.
+ */
+
+#define OBJ_SIZE_NODE (sizeof(void*) * 4 + sizeof(void*) * 3)
+#define OBJ_SIZE_VEC_HEADER (sizeof(void*) * 4 + sizeof(r_ssize) * 2)
+#define OBJ_SIZE_N_TYPES 32
+
+struct obj_size_info {
+  struct r_dict* p_seen;
+  struct r_dyn_array* p_roots;
+  double total;
+  double by_type[OBJ_SIZE_N_TYPES];
+};
+
+static
+double vec_data_size(r_ssize n_bytes) {
+  if (n_bytes <= 0) {
+    return 0;
+  }
+
+  const r_ssize classes[] = { 8, 16, 32, 48, 64, 128 };
+  for (size_t i = 0; i < R_ARR_SIZEOF(classes); ++i) {
+    if (n_bytes <= classes[i]) {
+      return classes[i];
+    }
+  }
+
+  return 8 * ((n_bytes + 7) / 8);
+}
+
+static
+double obj_node_size(r_obj* x, enum r_type type) {
+  switch (type) {
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_raw:
+    return OBJ_SIZE_VEC_HEADER + vec_data_size(r_length(x) * r_vec_elt_sizeof0(type));
+
+  case R_TYPE_character:
+  case R_TYPE_list:
+  case R_TYPE_expression:
+    return OBJ_SIZE_VEC_HEADER + vec_data_size(r_length(x) * sizeof(r_obj*));
+
+  case R_TYPE_string:
+    // Strings are null-terminated
+    return OBJ_SIZE_VEC_HEADER + vec_data_size(r_length(x) + 1);
+
+  default:
+    return OBJ_SIZE_NODE;
+  }
+}
+
+static
+bool is_session_env(r_obj* x) {
+  return
+    x == r_global_env ||
+    x == r_base_env ||
+    x == r_empty_env ||
+    R_IsPackageEnv(x) ||
+    R_IsNamespaceEnv(x);
+}
+
+static
+void obj_size_walk(struct obj_size_info* p_info, r_obj* root) {
+  int flags = R_SEXP_IT_FLAGS_preorder | R_SEXP_IT_FLAGS_skip_altrep;
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator_opts(root, flags, -1);
+  KEEP(p_it->shelter);
+
+  for (int i = 0; r_sexp_next(p_it); ++i) {
+    if (i % 10000 == 0) {
+      r_yield_interrupt();
+    }
+
+    r_obj* x = p_it->x;
+    enum r_type type = p_it->type;
+
+    // Skip nodes that were already counted along with their children
+    bool skip =
+      x == r_null ||
+      type == R_TYPE_symbol ||
+      (type == R_TYPE_environment && is_session_env(x)) ||
+      !r_dict_put(p_info->p_seen, x, r_null);
+
+    if (skip) {
+      p_it->skip_incoming = true;
+      continue;
+    }
+
+    double size = obj_node_size(x, type);
+
+    if (ALTREP(x)) {
+#if R_HAS_ALTREP
+      r_list_push_back(p_info->p_roots, R_altrep_data1(x));
+      r_list_push_back(p_info->p_roots, R_altrep_data2(x));
+      r_list_push_back(p_info->p_roots, r_attrib(x));
+#endif
+      size = OBJ_SIZE_NODE;
+    }
+
+    p_info->total += size;
+    p_info->by_type[type % OBJ_SIZE_N_TYPES] += size;
+  }
+
+  FREE(1);
+}
+
+r_obj* ffi_obj_size(r_obj* x, r_obj* by_type) {
+  if (!r_is_bool(by_type)) {
+    r_abort("`by_type` must be `TRUE` or `FALSE`.");
+  }
+
+  struct obj_size_info info = { 0 };
+
+  info.p_seen = r_new_dict(1024);
+  KEEP(info.p_seen->shelter);
+
+  // ALTREP data are walked after the main object. They are kept in a
+  // stack rather than walked recursively since they can themselves
+  // be ALTREP objects.
+  info.p_roots = r_new_dyn_vector(R_TYPE_list, 16);
+  KEEP(info.p_roots->shelter);
+
+  r_list_push_back(info.p_roots, x);
+
+  while (info.p_roots->count) {
+    r_obj* root = KEEP(r_list_get(info.p_roots->data, info.p_roots->count - 1));
+    r_arr_pop_back(info.p_roots);
+
+    obj_size_walk(&info, root);
+    FREE(1);
+  }
+
+  if (!r_lgl_get(by_type, 0)) {
+    FREE(2);
+    return r_dbl(info.total);
+  }
+
+  r_ssize n = 0;
+  for (int i = 0; i < OBJ_SIZE_N_TYPES; ++i) {
+    n += info.by_type[i] != 0;
+  }
+
+  r_obj* out = KEEP(r_alloc_double(n));
+  r_obj* nms = r_alloc_character(n);
+  r_attrib_poke_names(out, nms);
+
+  double* v_out = r_dbl_begin(out);
+
+  for (int i = 0, j = 0; i < OBJ_SIZE_N_TYPES; ++i) {
+    if (info.by_type[i] != 0) {
+      v_out[j] = info.by_type[i];
+      r_chr_poke(nms, j, r_str(r_type_as_c_string(i)));
+      ++j;
+    }
+  }
+
+  FREE(3);
+  return out;
+}
+
+
+/*
+ * Copies `x` so that it no longer retains local environments, such
+ * as the frames of the functions on the call stack when an error was
+ * thrown. Environments that aren't session-wide are replaced by the
+ * empty environment, including the environments of closures,
+ * formulas and quosures. Vectors whose own allocation exceeds
+ * `max_size` bytes are replaced by a symbol describing their type
+ * and length. Attributes are stripped of environments but not capped
+ * since they must keep their type.
+ *
+ * Parts of `x` that don't change are shared with the copy.
+ */
+
+static r_obj* obj_strip(r_obj* x, double max_size);
+
+static
+r_obj* obj_strip_placeholder(r_obj* x, enum r_type type) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "<%s[%lld]>", r_type_as_c_string(type), (long long) r_length(x));
+  return r_sym(buf);
+}
+
+static
+r_obj* obj_strip_attrib(r_obj* x, r_obj* out) {
+  r_obj* attrib = r_attrib(x);
+  if (attrib == r_null) {
+    return out;
+  }
+
+  KEEP(out);
+  r_obj* new_attrib = KEEP(obj_strip(attrib, R_PosInf));
+
+  if (new_attrib != attrib) {
+    if (out == x) {
+      out = r_clone(x);
+    }
+    r_poke_attrib(out, new_attrib);
+  }
+
+  FREE(2);
+  return out;
+}
+
+static
+r_obj* obj_strip_node(r_obj* x, double max_size) {
+  // Only copied if an element needs to be stripped
+  r_obj* out = x;
+  r_keep_t out_pi;
+  KEEP_HERE(out, &out_pi);
+
+  r_obj* out_node = r_null;
+
+  for (r_obj* node = x; node != r_null; node = r_node_cdr(node)) {
+    r_obj* car = r_node_car(node);
+    r_obj* new_car = obj_strip(car, max_size);
+
+    if (new_car != car && out == x) {
+      KEEP(new_car);
+      out = r_clone(x);
+      KEEP_AT(out, out_pi);
+      FREE(1);
+
+      // Catch up with the current node in the copied spine
+      out_node = out;
+      for (r_obj* it = x; it != node; it = r_node_cdr(it)) {
+        out_node = r_node_cdr(out_node);
+      }
+    }
+
+    if (out != x) {
+      r_node_poke_car(out_node, new_car);
+      out_node = r_node_cdr(out_node);
+    }
+  }
+
+  out = obj_strip_attrib(x, out);
+
+  FREE(1);
+  return out;
+}
+
+static
+r_obj* obj_strip_list(r_obj* x, double max_size) {
+  r_obj* out = x;
+  r_keep_t out_pi;
+  KEEP_HERE(out, &out_pi);
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* elt = v_x[i];
+    r_obj* new_elt = obj_strip(elt, max_size);
+
+    if (new_elt == elt) {
+      continue;
+    }
+    KEEP(new_elt);
+
+    if (out == x) {
+      out = r_clone(x);
+      KEEP_AT(out, out_pi);
+    }
+    r_list_poke(out, i, new_elt);
+
+    FREE(1);
+  }
+
+  out = obj_strip_attrib(x, out);
+
+  FREE(1);
+  return out;
+}
+
+static
+r_obj* obj_strip_closure(r_obj* x) {
+  r_obj* env = r_fn_env(x);
+  if (is_session_env(env)) {
+    return x;
+  }
+
+  r_obj* formals = KEEP(obj_strip(FORMALS(x), R_PosInf));
+  r_obj* body = KEEP(obj_strip(r_fn_body(x), R_PosInf));
+  r_obj* out = KEEP(r_new_function(formals, body, r_empty_env));
+
+  out = obj_strip_attrib(x, out);
+
+  FREE(3);
+  return out;
+}
+
+static
+r_obj* obj_strip(r_obj* x, double max_size) {
+  enum r_type type = r_typeof(x);
+
+  switch (type) {
+  case R_TYPE_null:
+  case R_TYPE_symbol:
+  case R_TYPE_special:
+  case R_TYPE_builtin:
+  case R_TYPE_string:
+    return x;
+
+  case R_TYPE_environment:
+    return is_session_env(x) ? x : r_empty_env;
+
+  case R_TYPE_closure:
+    return obj_strip_closure(x);
+
+  case R_TYPE_pairlist:
+  case R_TYPE_call:
+  case R_TYPE_dots:
+    return obj_strip_node(x, max_size);
+
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+  case R_TYPE_raw:
+  case R_TYPE_character:
+    if (obj_node_size(x, type) > max_size) {
+      return obj_strip_placeholder(x, type);
+    }
+    return obj_strip_attrib(x, x);
+
+  case R_TYPE_list:
+  case R_TYPE_expression:
+    if (obj_node_size(x, type) > max_size) {
+      return obj_strip_placeholder(x, type);
+    }
+    return obj_strip_list(x, max_size);
+
+  default:
+    return obj_strip_attrib(x, x);
+  }
+}
+
+r_obj* ffi_obj_strip(r_obj* x, r_obj* max_size) {
+  if (r_typeof(max_size) != R_TYPE_double || r_length(max_size) != 1) {
+    r_stop_internal("ffi_obj_strip", "`max_size` must be a double value.");
+  }
+  return obj_strip(x, r_dbl_get(max_size, 0));
+}
+
+#undef OBJ_SIZE_NODE
+#undef OBJ_SIZE_VEC_HEADER
+#undef OBJ_SIZE_N_TYPES
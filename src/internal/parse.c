@@ -1,4 +1,6 @@
 #include <rlang.h>
+#include <R_ext/Parse.h>
+#include "memo.h"
 #include "parse.h"
 
 
@@ -52,299 +54,90 @@ const struct r_op_precedence r_ops_precedence[R_OP_MAX] = {
   [R_OP_BRACES]         = { .power = 200,  .assoc =  0,  .unary = false,  .delimited =  true }
 };
 
-enum r_operator r_which_operator(r_obj* call) {
-  if (r_typeof(call) != R_TYPE_call) {
-    return R_OP_NONE;
-  }
-
-  r_obj* head = r_node_car(call);
-  if (r_typeof(head) != R_TYPE_symbol) {
-    return R_OP_NONE;
-  }
-
-  const char* name = r_sym_c_string(head);
-  int len = strlen(name);
-  bool is_unary = r_node_cddr(call) == r_null;
-
-  switch (name[0]) {
-  case 'b':
-    if (strcmp(name, "break") == 0) {
-      return R_OP_BREAK;
-    } else {
-      goto none;
-    }
-  case 'f':
-    if (strcmp(name, "for") == 0) {
-      return R_OP_FOR;
-    } else if (strcmp(name, "function") == 0) {
-      return R_OP_FUNCTION;
-    } else {
-      goto none;
-    }
-  case 'i':
-    if (strcmp(name, "if") == 0) {
-      return R_OP_IF;
-    } else {
-      goto none;
-    }
-  case 'n':
-    if (strcmp(name, "next") == 0) {
-      return R_OP_NEXT;
-    } else {
-      goto none;
-    }
-  case 'r':
-    if (strcmp(name, "repeat") == 0) {
-      return R_OP_REPEAT;
-    } else {
-      goto none;
-    }
-  case 'w':
-    if (strcmp(name, "while") == 0) {
-      return R_OP_WHILE;
-    } else {
-      goto none;
-    }
-
-  case '?':
-    if (len == 1) {
-      if (is_unary) {
-        return R_OP_QUESTION_UNARY;
-      } else {
-        return R_OP_QUESTION;
-      }
-    } else {
-      goto none;
-    }
-
-  case '<':
-    switch (len) {
-    case 1:
-      return R_OP_LESS;
-    case 2:
-      switch (name[1]) {
-      case '-': return R_OP_ASSIGN1;
-      case '=': return R_OP_LESS_EQUAL;
-      default: goto none;
-      }
-    case 3:
-      if (name[1] == '<' && name[2] == '-') {
-        return R_OP_ASSIGN2;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
-    }
-
-  case '>':
-    switch (len) {
-    case 1:
-      return R_OP_GREATER;
-    case 2:
-      if (name[1] == '=') {
-        return R_OP_GREATER_EQUAL;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
-    }
+// Operators are looked up by the address of their symbol in an open
+// addressing table filled at load time. Symbols are interned so pointer
+// equality is name equality. Operators like `-` that have a unary form
+// store both variants.
+struct op_entry {
+  r_obj* sym;
+  enum r_operator binary;
+  enum r_operator unary;
+};
 
-  case '=':
-    switch (len) {
-    case 1:
-      return R_OP_ASSIGN_EQUAL;
-    case 2:
-      if (name[1] == '=') {
-        return R_OP_EQUAL;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
-    }
+#define OP_TABLE_SIZE 128
 
-  case ':':
-    switch (len) {
-    case 1:
-      return R_OP_COLON1;
-    case 2:
-      switch (name[1]) {
-      case '=': return R_OP_COLON_EQUAL;
-      case ':': return R_OP_COLON2;
-      default: goto none;
-      }
-    case 3:
-      if (name[1] == ':' && name[2] == ':') {
-        return R_OP_COLON3;
-      } else {
-        goto none;
-      }
-    default: goto none;
-    }
+static struct op_entry op_table[OP_TABLE_SIZE];
 
-  case '~':
-    if (len == 1) {
-      if (is_unary) {
-        return R_OP_TILDE_UNARY;
-      } else {
-        return R_OP_TILDE;
-      }
-    } else {
-      goto none;
-    }
+static inline
+size_t op_table_hash(r_obj* sym) {
+  uintptr_t addr = (uintptr_t) sym;
+  return (addr ^ (addr >> 7)) >> 3;
+}
 
-  case '|':
-    switch (len) {
-    case 1:
-      return R_OP_OR1;
-    case 2:
-      if (name[1] == '|') {
-        return R_OP_OR2;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
+static
+void op_table_add(const char* name,
+                  enum r_operator binary,
+                  enum r_operator unary) {
+  r_obj* sym = r_sym(name);
+  size_t i = op_table_hash(sym);
+
+  while (true) {
+    i &= OP_TABLE_SIZE - 1;
+    if (op_table[i].sym == NULL) {
+      break;
     }
-
-  case '&':
-    switch (len) {
-    case 1:
-      return R_OP_AND1;
-    case 2:
-      if (name[1] == '&') {
-        return R_OP_AND2;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
+    if (op_table[i].sym == sym) {
+      r_stop_internal("op_table_add", "Operator `%s` is already registered.", name);
     }
+    ++i;
+  }
 
-  case '!':
-    switch (len) {
-    case 1:
-      return R_OP_BANG1;
-    case 2:
-      switch (name[1]) {
-      case '!': return R_OP_BANG2;
-      case '=': return R_OP_NOT_EQUAL;
-      default: goto none;
-      }
-    case 3:
-      if (name[1] == '!' && name[2] == '!') {
-        return R_OP_BANG3;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
-    }
+  op_table[i] = (struct op_entry) {
+    .sym = sym,
+    .binary = binary,
+    .unary = unary
+  };
+}
 
-  case '+':
-    if (len == 1) {
-      if (is_unary) {
-        return R_OP_PLUS_UNARY;
-      } else {
-        return R_OP_PLUS;
-      }
-    } else {
-      goto none;
-    }
+enum r_operator r_which_operator(r_obj* call) {
+  if (r_typeof(call) != R_TYPE_call) {
+    return R_OP_NONE;
+  }
 
-  case '-':
-    if (len == 1) {
-      if (is_unary) {
-        return R_OP_MINUS_UNARY;
-      } else {
-        return R_OP_MINUS;
-      }
-    } else {
-      goto none;
-    }
+  r_obj* head = r_node_car(call);
+  if (r_typeof(head) != R_TYPE_symbol) {
+    return R_OP_NONE;
+  }
 
-  case '*':
-    if (len == 1) {
-      return R_OP_TIMES;
-    } else {
-      goto none;
-    }
+  size_t i = op_table_hash(head);
 
-  case '/':
-    if (len == 1) {
-      return R_OP_RATIO;
-    } else {
-      goto none;
-    }
+  while (true) {
+    i &= OP_TABLE_SIZE - 1;
+    const struct op_entry* p_entry = op_table + i;
 
-  case '%':
-    switch (len) {
-    case 1:
-      goto none;
-    case 2:
-      if (name[1] == '%') {
-        return R_OP_MODULO;
+    if (p_entry->sym == head) {
+      if (r_node_cddr(call) == r_null) {
+        return p_entry->unary;
       } else {
-        goto none;
-      }
-    default:
-      if (name[len - 1] == '%') {
-        return R_OP_SPECIAL;
-      } else {
-        goto none;
+        return p_entry->binary;
       }
     }
-
-  case '^':
-    if (len == 1) {
-      return R_OP_HAT;
-    } else {
-      goto none;
-    }
-  case '$':
-    if (len == 1) {
-      return R_OP_DOLLAR;
-    } else {
-      goto none;
-    }
-  case '@':
-    if (len == 1) {
-      return R_OP_AT;
-    } else {
-      goto none;
-    }
-  case '(':
-    if (len == 1) {
-      return R_OP_PARENTHESES;
-    } else {
-      goto none;
-    }
-
-  case '[':
-    switch (len) {
-    case 1:
-      return R_OP_BRACKETS1;
-    case 2:
-      if (name[1] == '[') {
-        return R_OP_BRACKETS2;
-      } else {
-        goto none;
-      }
-    default:
-      goto none;
+    if (p_entry->sym == NULL) {
+      break;
     }
+    ++i;
+  }
 
-  case '{':
-    if (len == 1) {
-      return R_OP_BRACES;
-    } else {
-      goto none;
-    }
+  // Infix operators like `%in%` can't be enumerated ahead of time
+  const char* name = r_sym_c_string(head);
+  if (name[0] != '%') {
+    return R_OP_NONE;
+  }
 
-  none:
-  default:
+  int len = strlen(name);
+  if (len > 2 && name[len - 1] == '%') {
+    return R_OP_SPECIAL;
+  } else {
     return R_OP_NONE;
   }
 }
@@ -450,6 +243,110 @@ bool r_rhs_op_has_precedence(enum r_operator rhs, enum r_operator parent) {
 }
 
 
+/*
+ * Parsed strings are cached by the address of their CHARSXP. Equal
+ * strings share a CHARSXP, so repeated strings are parsed once. The
+ * cached expressions are marked as shared and are returned to all
+ * callers. They must not be modified in place.
+ *
+ * Native strings are parsed with `R_ParseVector()` without srcrefs.
+ * Other strings, and those that fail to parse, go through `parse()`
+ * with `keep.source = FALSE` so that encodings are handled and parse
+ * errors are reported as usual.
+ */
+
+#define PARSE_CACHE_SIZE 4096
+
+static struct rlang_memo* p_parse_cache = NULL;
+static r_obj* parse_text_call = NULL;
+
+static
+r_obj* parse_str(r_obj* str) {
+  r_obj* text = KEEP(r_str_as_character(str));
+  r_obj* out = r_null;
+  bool parsed = false;
+
+  if (str != r_globals.na_str && Rf_getCharCE(str) == CE_NATIVE) {
+    ParseStatus status;
+    out = R_ParseVector(text, -1, &status, r_null);
+    parsed = status == PARSE_OK;
+  }
+  if (!parsed) {
+    out = r_eval_with_x(parse_text_call, text, r_base_env);
+  }
+  KEEP(out);
+
+  // Convert the expression vector to a list
+  r_ssize n = r_length(out);
+  r_obj* list = KEEP(r_alloc_list(n));
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* expr = r_list_get(out, i);
+    r_mark_shared(expr);
+    r_list_poke(list, i, expr);
+  }
+
+  FREE(3);
+  return list;
+}
+
+static
+r_obj* parse_str_cached(r_obj* str) {
+  r_obj* out = rlang_memo_get0(p_parse_cache, str);
+  if (out) {
+    return out;
+  }
+
+  out = KEEP(parse_str(str));
+  rlang_memo_put(p_parse_cache, str, out);
+
+  FREE(1);
+  return out;
+}
+
+r_obj* ffi_parse_exprs_chr(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_character) {
+    r_stop_internal("ffi_parse_exprs_chr", "`x` must be a character vector.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_chr_cbegin(x);
+
+  r_obj* parsed = KEEP(r_alloc_list(n));
+  r_ssize n_out = 0;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* exprs = parse_str_cached(v_x[i]);
+    r_list_poke(parsed, i, exprs);
+    n_out += r_length(exprs);
+  }
+
+  r_obj* names = r_names(x);
+  r_obj* const * v_names = names == r_null ? NULL : r_chr_cbegin(names);
+
+  r_obj* out = KEEP(r_alloc_list(n_out));
+  r_obj* out_names = r_null;
+  if (v_names) {
+    out_names = r_alloc_character(n_out);
+    r_attrib_poke_names(out, out_names);
+  }
+
+  r_ssize k = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* exprs = r_list_get(parsed, i);
+    r_ssize n_exprs = r_length(exprs);
+
+    for (r_ssize j = 0; j < n_exprs; ++j, ++k) {
+      r_list_poke(out, k, r_list_get(exprs, j));
+      if (v_names) {
+        r_chr_poke(out_names, k, v_names[i]);
+      }
+    }
+  }
+
+  FREE(2);
+  return out;
+}
+
 void init_parse(r_obj* ns) {
   RLANG_ASSERT((sizeof(r_ops_precedence) / sizeof(struct r_op_precedence)) == R_OP_MAX);
 
@@ -458,4 +355,52 @@ void init_parse(r_obj* ns) {
       Rf_error("Internal error: `r_ops_precedence` is not fully initialised");
     }
   }
+
+  op_table_add("break",    R_OP_BREAK,          R_OP_BREAK);
+  op_table_add("next",     R_OP_NEXT,           R_OP_NEXT);
+  op_table_add("function", R_OP_FUNCTION,       R_OP_FUNCTION);
+  op_table_add("while",    R_OP_WHILE,          R_OP_WHILE);
+  op_table_add("for",      R_OP_FOR,            R_OP_FOR);
+  op_table_add("repeat",   R_OP_REPEAT,         R_OP_REPEAT);
+  op_table_add("if",       R_OP_IF,             R_OP_IF);
+  op_table_add("?",        R_OP_QUESTION,       R_OP_QUESTION_UNARY);
+  op_table_add("<-",       R_OP_ASSIGN1,        R_OP_ASSIGN1);
+  op_table_add("<<-",      R_OP_ASSIGN2,        R_OP_ASSIGN2);
+  op_table_add("=",        R_OP_ASSIGN_EQUAL,   R_OP_ASSIGN_EQUAL);
+  op_table_add(":=",       R_OP_COLON_EQUAL,    R_OP_COLON_EQUAL);
+  op_table_add("~",        R_OP_TILDE,          R_OP_TILDE_UNARY);
+  op_table_add("|",        R_OP_OR1,            R_OP_OR1);
+  op_table_add("||",       R_OP_OR2,            R_OP_OR2);
+  op_table_add("&",        R_OP_AND1,           R_OP_AND1);
+  op_table_add("&&",       R_OP_AND2,           R_OP_AND2);
+  op_table_add("!",        R_OP_BANG1,          R_OP_BANG1);
+  op_table_add("!!!",      R_OP_BANG3,          R_OP_BANG3);
+  op_table_add(">",        R_OP_GREATER,        R_OP_GREATER);
+  op_table_add(">=",       R_OP_GREATER_EQUAL,  R_OP_GREATER_EQUAL);
+  op_table_add("<",        R_OP_LESS,           R_OP_LESS);
+  op_table_add("<=",       R_OP_LESS_EQUAL,     R_OP_LESS_EQUAL);
+  op_table_add("==",       R_OP_EQUAL,          R_OP_EQUAL);
+  op_table_add("!=",       R_OP_NOT_EQUAL,      R_OP_NOT_EQUAL);
+  op_table_add("+",        R_OP_PLUS,           R_OP_PLUS_UNARY);
+  op_table_add("-",        R_OP_MINUS,          R_OP_MINUS_UNARY);
+  op_table_add("*",        R_OP_TIMES,          R_OP_TIMES);
+  op_table_add("/",        R_OP_RATIO,          R_OP_RATIO);
+  op_table_add("%%",       R_OP_MODULO,         R_OP_MODULO);
+  op_table_add(":",        R_OP_COLON1,         R_OP_COLON1);
+  op_table_add("!!",       R_OP_BANG2,          R_OP_BANG2);
+  op_table_add("^",        R_OP_HAT,            R_OP_HAT);
+  op_table_add("$",        R_OP_DOLLAR,         R_OP_DOLLAR);
+  op_table_add("@",        R_OP_AT,             R_OP_AT);
+  op_table_add("::",       R_OP_COLON2,         R_OP_COLON2);
+  op_table_add(":::",      R_OP_COLON3,         R_OP_COLON3);
+  op_table_add("(",        R_OP_PARENTHESES,    R_OP_PARENTHESES);
+  op_table_add("[",        R_OP_BRACKETS1,      R_OP_BRACKETS1);
+  op_table_add("[[",       R_OP_BRACKETS2,      R_OP_BRACKETS2);
+  op_table_add("{",        R_OP_BRACES,         R_OP_BRACES);
+
+  p_parse_cache = rlang_new_memo(PARSE_CACHE_SIZE, false);
+  r_preserve_global(p_parse_cache->shelter);
+
+  parse_text_call = r_parse("parse(text = x, keep.source = FALSE)");
+  r_preserve_global(parse_text_call);
 }
@@ -0,0 +1,78 @@
+#include <rlang.h>
+#include <time.h>
+
+/*
+ * Sampling profiler for `trace_prof_start()`.
+ *
+ * R is not reentrant so stacks can't be captured from a signal
+ * handler or from a hook called by R at arbitrary points of the
+ * evaluation. The timer is instead a deadline that is only checked at
+ * safe points rlang controls, the calls to `trace_prof_sample()`. When
+ * the sampling interval has elapsed, the tick returns the number of
+ * intervals since the last sample and `trace_prof_sample()` records
+ * the stack with the same capture as `trace_back()`.
+ *
+ * Time spent between safe points is attributed to the next sample
+ * through its weight.
+ */
+
+static bool prof_running = false;
+static double prof_interval = 0;
+static double prof_last = 0;
+
+static
+double prof_now(void) {
+#ifdef _WIN32
+  // `clock()` measures wall time on Windows
+  return (double) clock() / CLOCKS_PER_SEC;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+r_obj* ffi_trace_prof_start(r_obj* interval) {
+  if (prof_running) {
+    r_abort("The profiler is already running.");
+  }
+  if (r_typeof(interval) != R_TYPE_double || r_length(interval) != 1) {
+    r_stop_internal("ffi_trace_prof_start", "`interval` must be a double.");
+  }
+
+  prof_interval = r_dbl_get(interval, 0);
+  prof_last = prof_now();
+  prof_running = true;
+
+  return r_null;
+}
+
+r_obj* ffi_trace_prof_stop() {
+  if (!prof_running) {
+    return r_false;
+  }
+  prof_running = false;
+  return r_true;
+}
+
+// Returns the weight of the sample to record, or 0 when the profiler
+// is not running or the interval has not elapsed
+r_obj* ffi_trace_prof_tick() {
+  if (!prof_running) {
+    return r_int(0);
+  }
+
+  double now = prof_now();
+  double elapsed = now - prof_last;
+  if (elapsed < prof_interval) {
+    return r_int(0);
+  }
+
+  int weight = 1;
+  if (prof_interval > 0) {
+    weight = (int) (elapsed / prof_interval);
+  }
+
+  prof_last = now;
+  return r_int(weight);
+}
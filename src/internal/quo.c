@@ -1,4 +1,5 @@
 #include <rlang.h>
+#include "walk.h"
 
 static
 const char* quo_tags[2] = { "quosure", "formula" };
@@ -86,3 +87,275 @@ bool quo_is_symbolic(r_obj* quo) {
 bool quo_is_null(r_obj* quo) {
   return r_node_cadr(quo) == r_null;
 }
+
+
+/*
+ * Compact storage for large lists of quosures. A list of quosures
+ * allocates a formula call and an attribute list for each element.
+ * From `QUOSURES_COMPACT_MIN_SIZE` elements, `quos()` returns an
+ * ALTREP list that stores the expressions and the environments in
+ * two parallel lists in `data1`. Quosures are created on access and
+ * are not cached. The list is materialised in `data2` when it is
+ * modified or when its data pointer is requested, after which
+ * `data1` is set to `NULL`.
+ *
+ * Native consumers can read the expressions and environments without
+ * materialising quosures with `rlang_quosures_get_expr()` and
+ * `rlang_quosures_get_env()`.
+ */
+
+#define QUOSURES_COMPACT_MIN_SIZE 64
+
+enum quosures_data {
+  QUOSURES_exprs = 0,
+  QUOSURES_envs,
+  QUOSURES_SIZE
+};
+
+#if R_HAS_ALTLIST
+
+static
+R_altrep_class_t quosures_class;
+
+static inline
+r_obj* quosures_compact_data(r_obj* x) {
+  if (ALTREP(x) && R_altrep_inherits(x, quosures_class)) {
+    return R_altrep_data1(x);
+  } else {
+    return r_null;
+  }
+}
+
+static
+R_xlen_t quosures_length(r_obj* x) {
+  r_obj* data = R_altrep_data1(x);
+  if (data == r_null) {
+    return r_length(R_altrep_data2(x));
+  }
+  return r_length(r_list_get(data, QUOSURES_exprs));
+}
+
+static
+r_obj* quosures_elt(r_obj* x, R_xlen_t i) {
+  r_obj* data = R_altrep_data1(x);
+  if (data == r_null) {
+    return r_list_get(R_altrep_data2(x), i);
+  }
+
+  r_obj* expr = r_list_get(r_list_get(data, QUOSURES_exprs), i);
+  r_obj* env = r_list_get(r_list_get(data, QUOSURES_envs), i);
+  return rlang_new_quosure(expr, env);
+}
+
+static
+r_obj* quosures_materialise(r_obj* x) {
+  if (R_altrep_data1(x) == r_null) {
+    return R_altrep_data2(x);
+  }
+
+  r_ssize n = quosures_length(x);
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i, quosures_elt(x, i));
+  }
+
+  R_set_altrep_data2(x, out);
+  R_set_altrep_data1(x, r_null);
+
+  FREE(1);
+  return out;
+}
+
+static
+void quosures_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_list_poke(quosures_materialise(x), i, value);
+}
+
+static
+void* quosures_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(quosures_materialise(x));
+}
+
+static
+const void* quosures_dataptr_or_null(r_obj* x) {
+  if (R_altrep_data1(x) == r_null) {
+    return DATAPTR_RO(R_altrep_data2(x));
+  } else {
+    return NULL;
+  }
+}
+
+static
+Rboolean quosures_inspect(r_obj* x,
+                          int pre,
+                          int deep,
+                          int pvec,
+                          void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_quosures (len=%ld, materialised=%s)\n",
+          (long) quosures_length(x),
+          R_altrep_data1(x) == r_null ? "T" : "F");
+  return TRUE;
+}
+
+// Returns `x` when it is too small or contains quosures with
+// additional attributes
+r_obj* rlang_quosures_compact(r_obj* x) {
+  r_ssize n = r_length(x);
+  if (n < QUOSURES_COMPACT_MIN_SIZE) {
+    return x;
+  }
+
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  r_obj* data = KEEP(r_alloc_list(QUOSURES_SIZE));
+
+  r_obj* exprs = r_alloc_list(n);
+  r_list_poke(data, QUOSURES_exprs, exprs);
+
+  r_obj* envs = r_alloc_list(n);
+  r_list_poke(data, QUOSURES_envs, envs);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* quo = v_x[i];
+
+    // Quosures only have a class and an environment
+    if (!rlang_is_quosure(quo) || r_length(r_attrib(quo)) != 2) {
+      FREE(1);
+      return x;
+    }
+
+    r_list_poke(exprs, i, rlang_quo_get_expr_(quo));
+    r_list_poke(envs, i, rlang_quo_get_env(quo));
+  }
+
+  r_obj* out = R_new_altrep(quosures_class, data, r_null);
+
+  FREE(1);
+  return out;
+}
+
+bool rlang_quosures_is_compact(r_obj* x) {
+  return quosures_compact_data(x) != r_null;
+}
+
+void rlang_init_quo_altrep(DllInfo* dll) {
+  quosures_class = R_make_altlist_class("rlang_quosures", "rlang", dll);
+
+  R_set_altrep_Length_method(quosures_class, &quosures_length);
+  R_set_altrep_Inspect_method(quosures_class, &quosures_inspect);
+  R_set_altvec_Dataptr_method(quosures_class, &quosures_dataptr);
+  R_set_altvec_Dataptr_or_null_method(quosures_class, &quosures_dataptr_or_null);
+  R_set_altlist_Elt_method(quosures_class, &quosures_elt);
+  R_set_altlist_Set_elt_method(quosures_class, &quosures_set_elt);
+}
+
+#else
+
+// ALTREP lists require R 4.3.0
+static inline
+r_obj* quosures_compact_data(r_obj* x) {
+  return r_null;
+}
+
+r_obj* rlang_quosures_compact(r_obj* x) {
+  return x;
+}
+bool rlang_quosures_is_compact(r_obj* x) {
+  return false;
+}
+void rlang_init_quo_altrep(DllInfo* dll) { }
+
+#endif
+
+r_obj* rlang_quosures_get_expr(r_obj* x, r_ssize i) {
+  r_obj* data = quosures_compact_data(x);
+  if (data != r_null) {
+    return r_list_get(r_list_get(data, QUOSURES_exprs), i);
+  }
+  return rlang_quo_get_expr(r_list_get(x, i));
+}
+r_obj* rlang_quosures_get_env(r_obj* x, r_ssize i) {
+  r_obj* data = quosures_compact_data(x);
+  if (data != r_null) {
+    return r_list_get(r_list_get(data, QUOSURES_envs), i);
+  }
+  return rlang_quo_get_env(r_list_get(x, i));
+}
+
+
+/*
+ * Squashes nested quosures with a postorder walk of the calls and
+ * pairlists of `x`. The results of the children of each node are
+ * pushed on a stack of values. On the outgoing visit of a node, the
+ * node is rebuilt only if its CAR or CDR has changed, so that only
+ * the spines leading to quosures are duplicated. Expressions without
+ * quosures are returned as is. Other objects, such as inlined
+ * vectors or functions, are not walked.
+ */
+
+static
+r_obj* quo_squash(r_obj* x) {
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator_opts(x, R_SEXP_IT_FLAGS_skip_attrib, -1);
+  KEEP(p_it->shelter);
+
+  struct r_dyn_array* p_values = r_new_dyn_vector(R_TYPE_list, 64);
+  KEEP(p_values->shelter);
+
+  while (r_sexp_next(p_it)) {
+    r_obj* node = p_it->x;
+    enum r_type type = p_it->type;
+
+    switch (p_it->dir) {
+    case R_SEXP_IT_DIRECTION_leaf:
+      // Tags are never rebuilt
+      if (p_it->rel != R_SEXP_IT_RELATION_node_tag) {
+        r_list_push_back(p_values, node);
+      }
+      break;
+
+    case R_SEXP_IT_DIRECTION_incoming:
+      if (type == R_TYPE_call && rlang_is_quosure(node)) {
+        while (rlang_is_quosure(node)) {
+          node = rlang_quo_get_expr_(node);
+        }
+        r_list_push_back(p_values, quo_squash(node));
+        p_it->skip_incoming = true;
+      } else if (type != R_TYPE_call && type != R_TYPE_pairlist) {
+        r_list_push_back(p_values, node);
+        p_it->skip_incoming = true;
+      }
+      break;
+
+    case R_SEXP_IT_DIRECTION_outgoing: {
+      r_obj* const * v_values = r_arr_cbegin(p_values);
+      r_obj* car = v_values[p_values->count - 2];
+      r_obj* cdr = v_values[p_values->count - 1];
+
+      if (car != r_node_car(node) || cdr != r_node_cdr(node)) {
+        r_obj* out = r_new_node(car, cdr);
+        r_poke_type(out, type);
+        r_node_poke_tag(out, r_node_tag(node));
+        r_poke_attrib(out, r_attrib(node));
+        node = out;
+      }
+
+      // Replaces the CAR and CDR, which are no longer needed
+      r_arr_pop_back(p_values);
+      r_list_poke(p_values->data, p_values->count - 1, node);
+      break;
+    }}
+  }
+
+  if (p_values->count != 1) {
+    r_stop_internal("quo_squash", "Unbalanced stack of values.");
+  }
+  r_obj* out = r_list_get(p_values->data, 0);
+
+  FREE(2);
+  return out;
+}
+
+r_obj* ffi_quo_squash(r_obj* x) {
+  return quo_squash(x);
+}
@@ -21,5 +21,10 @@ bool quo_is_call(r_obj* quo);
 bool quo_is_symbolic(r_obj* quo);
 bool quo_is_null(r_obj* quo);
 
+r_obj* rlang_quosures_compact(r_obj* x);
+bool rlang_quosures_is_compact(r_obj* x);
+r_obj* rlang_quosures_get_expr(r_obj* x, r_ssize i);
+r_obj* rlang_quosures_get_env(r_obj* x, r_ssize i);
+
 
 #endif
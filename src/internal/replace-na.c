@@ -1,15 +1,111 @@
 #include <rlang.h>
 #include "vec.h"
 
-static r_obj* replace_na_(r_obj* x, r_obj* replacement, int start);
-static r_obj* replace_na_vec_(r_obj* x, r_obj* replacement, int start);
+/*
+ * Large logical, integer, double and complex vectors can be scanned
+ * and filled by several threads, see `r_vec_n_threads()`. The
+ * parallel loops only access data pointers. The scan reuses the
+ * region kernels of `vec.c`, which stop all workers as soon as one of
+ * them finds a missing value. The fill then selects between the
+ * original and the replacement values without branching, from the
+ * first element. Missing values are detected with the same
+ * predicates as the serial path, so `NaN` is not replaced.
+ */
+
+#define INT_IS_NA(X) ((X) == na_int)
+#define DBL_IS_NA(X) dbl_is_na(X)
+#define CPL_IS_NA(X) cpl_is_na(X)
+
+static inline
+bool replace_na_has_par_type(enum r_type type) {
+  switch (type) {
+  case R_TYPE_logical:
+  case R_TYPE_integer:
+  case R_TYPE_double:
+  case R_TYPE_complex:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static inline
+const void* replace_na_data_or_null(r_obj* x) {
+#if R_HAS_ALTREP
+  if (ALTREP(x)) {
+    return DATAPTR_OR_NULL(x);
+  }
+#endif
+  return r_vec_cbegin(x);
+}
+
+#ifdef _OPENMP
+# define REPLACE_NA_PARALLEL_FOR _Pragma("omp parallel for num_threads(n_threads) schedule(static)")
+#else
+# define REPLACE_NA_PARALLEL_FOR
+#endif
+
+static
+bool replace_na_has_na_par(enum r_type type,
+                           const void* p_x,
+                           r_ssize n,
+                           int n_threads) {
+  switch (type) {
+  case R_TYPE_logical:
+  case R_TYPE_integer: return int_has_na_par(p_x, n, n_threads);
+  case R_TYPE_double: return dbl_has_na_par(p_x, n, n_threads);
+  case R_TYPE_complex: return cpl_has_na_par(p_x, n, n_threads);
+  default: r_stop_unimplemented_type("replace_na_has_na_par", type);
+  }
+}
+
+#define FILL_PAR(CTYPE, IS_NA) do {                                     \
+    CTYPE* v_x = (CTYPE*) r_vec_begin(x);                               \
+    const CTYPE* v_values = (const CTYPE*) r_vec_cbegin(replacement);   \
+                                                                        \
+    if (n_values == 1) {                                                \
+      CTYPE value = v_values[0];                                        \
+      REPLACE_NA_PARALLEL_FOR                                           \
+      for (r_ssize j = 0; j < n; ++j) {                                 \
+        v_x[j] = IS_NA(v_x[j]) ? value : v_x[j];                        \
+      }                                                                 \
+    } else {                                                            \
+      REPLACE_NA_PARALLEL_FOR                                           \
+      for (r_ssize j = 0; j < n; ++j) {                                 \
+        v_x[j] = IS_NA(v_x[j]) ? v_values[j] : v_x[j];                  \
+      }                                                                 \
+    }                                                                   \
+  } while (0)
+
+// `x` must be writable
+static
+void replace_na_fill_par(r_obj* x, r_obj* replacement, int n_threads) {
+  int na_int = r_globals.na_int;
+  r_ssize n = r_length(x);
+  r_ssize n_values = r_length(replacement);
+
+  switch (r_typeof(x)) {
+  case R_TYPE_logical:
+  case R_TYPE_integer: FILL_PAR(int, INT_IS_NA); break;
+  case R_TYPE_double: FILL_PAR(double, DBL_IS_NA); break;
+  case R_TYPE_complex: FILL_PAR(r_complex_t, CPL_IS_NA); break;
+  default: r_stop_unimplemented_type("replace_na_fill_par", r_typeof(x));
+  }
+}
+
+#undef FILL_PAR
+#undef REPLACE_NA_PARALLEL_FOR
+#undef CPL_IS_NA
+#undef DBL_IS_NA
+#undef INT_IS_NA
+
 
 r_obj* rlang_replace_na(r_obj* x, r_obj* replacement) {
   const enum r_type x_type = r_typeof(x);
   const enum r_type replacement_type = r_typeof(replacement);
 
-  int n = r_length(x);
-  int n_replacement = r_length(replacement);
+  r_ssize n = r_length(x);
+  r_ssize n_replacement = r_length(replacement);
 
   if (!r_is_atomic(x, -1)) {
     r_abort("Cannot replace missing values in an object of type %s", Rf_type2char(x_type));
@@ -21,206 +117,40 @@ r_obj* rlang_replace_na(r_obj* x, r_obj* replacement) {
 
   if (n_replacement != 1 && n_replacement != n) {
     if (n == 1) {
-      r_abort("The replacement values must have size 1, not %i", n_replacement);
+      r_abort("The replacement values must have size 1, not %i", (int) n_replacement);
     } else {
-      r_abort("The replacement values must have size 1 or %i, not %i", n, n_replacement);
-    }
-  }
-
-  int i = 0;
-
-  switch(x_type) {
-  case R_TYPE_logical: {
-    int* arr = r_lgl_begin(x);
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_lgl) {
-        break;
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_integer: {
-    int* arr = r_int_begin(x);
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_int) {
-        break;
-      }
+      r_abort("The replacement values must have size 1 or %i, not %i", (int) n, (int) n_replacement);
     }
-    break;
   }
 
-  case R_TYPE_double: {
-    double* arr = r_dbl_begin(x);
-    for (; i < n; ++i) {
-      if (ISNA(arr[i])) {
-        break;
-      }
-    }
-    break;
-  }
+  int n_threads = replace_na_has_par_type(x_type) ? r_vec_n_threads(n) : 1;
+  const void* p_data = (n_threads > 1) ? replace_na_data_or_null(x) : NULL;
 
-  case R_TYPE_character: {
-    for (; i < n; ++i) {
-      if (r_chr_get(x, i) == r_globals.na_str) {
-        break;
-      }
+  r_ssize i = 0;
+  if (p_data) {
+    if (!replace_na_has_na_par(x_type, p_data, n, n_threads)) {
+      return x;
     }
-    break;
-  }
-
-  case R_TYPE_complex: {
-    r_complex_t* arr = r_cpl_begin(x);
-
-    for (; i < n; ++i) {
-      if (ISNA(arr[i].r)) {
-        break;
-      }
-    }
-    break;
-  }
-
-  default: {
-    r_abort("Internal error: Don't know how to handle object of type %s", Rf_type2char(x_type));
-  }
-  }
-
-  if (i == n) {
-    return x;
-  } else if (n_replacement == 1) {
-    return replace_na_(x, replacement, i);
   } else {
-    return replace_na_vec_(x, replacement, i);
-  }
-}
-
-static r_obj* replace_na_(r_obj* x, r_obj* replacement, int i) {
-  KEEP(x = r_copy(x));
-  int n = r_length(x);
-
-  switch(r_typeof(x)) {
-  case R_TYPE_logical: {
-    int* arr = r_lgl_begin(x);
-    int new_value = r_lgl_begin(replacement)[0];
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_lgl) {
-        arr[i] = new_value;
-      }
+    i = r_vec_find_na(x, 0);
+    if (i == n) {
+      return x;
     }
-    break;
   }
 
-  case R_TYPE_integer: {
-    int* arr = r_int_begin(x);
-    int new_value = r_int_begin(replacement)[0];
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_int) {
-        arr[i] = new_value;
-      }
-    }
-    break;
+  // Fill in place when `x` is only referenced by the promise of the
+  // calling closure, e.g. the result of a function call passed to
+  // `%|%`. ALTREP vectors are copied because their data pointer may
+  // be a materialised view that is not owned by the object.
+  if (MAYBE_SHARED(x) || ALTREP(x)) {
+    x = r_copy(x);
   }
+  KEEP(x);
 
-  case R_TYPE_double: {
-    double* arr = r_dbl_begin(x);
-    double new_value = r_dbl_begin(replacement)[0];
-    for (; i < n; ++i) {
-      if (ISNA(arr[i])) {
-        arr[i] = new_value;
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_character: {
-    r_obj* new_value = r_chr_get(replacement, 0);
-    for (; i < n; ++i) {
-      if (r_chr_get(x, i) == r_globals.na_str) {
-        r_chr_poke(x, i, new_value);
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_complex: {
-    r_complex_t* arr = r_cpl_begin(x);
-    r_complex_t new_value = r_cpl_get(replacement, 0);
-
-    for (; i < n; ++i) {
-      if (ISNA(arr[i].r)) {
-        arr[i] = new_value;
-      }
-    }
-    break;
-  }
-
-  default: {
-    r_abort("Internal error: Don't know how to handle object of type %s", Rf_type2char(r_typeof(x)));
-  }
-  }
-
-  FREE(1);
-  return x;
-}
-
-
-static r_obj* replace_na_vec_(r_obj* x, r_obj* replacement, int i) {
-  KEEP(x = r_copy(x));
-  int n = r_length(x);
-
-  switch(r_typeof(x)) {
-  case R_TYPE_logical: {
-    int* arr = r_lgl_begin(x);
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_lgl) {
-        arr[i] = r_lgl_get(replacement, i);
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_integer: {
-    int* arr = r_int_begin(x);
-    for (; i < n; ++i) {
-      if (arr[i] == r_globals.na_int) {
-        arr[i] = r_int_get(replacement, i);
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_double: {
-    double* arr = r_dbl_begin(x);
-    for (; i < n; ++i) {
-      if (ISNA(arr[i])) {
-        arr[i] = r_dbl_get(replacement, i);
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_character: {
-    for (; i < n; ++i) {
-      if (r_chr_get(x, i) == r_globals.na_str) {
-        r_chr_poke(x, i, r_chr_get(replacement, i));
-      }
-    }
-    break;
-  }
-
-  case R_TYPE_complex: {
-    r_complex_t* arr = r_cpl_begin(x);
-    for (; i < n; ++i) {
-      if (ISNA(arr[i].r)) {
-        arr[i] = r_cpl_get(replacement, i);
-      }
-    }
-    break;
-  }
-
-  default: {
-    r_abort("Internal error: Don't know how to handle object of type %s", Rf_type2char(r_typeof(x)));
-  }
+  if (p_data) {
+    replace_na_fill_par(x, replacement, n_threads);
+  } else {
+    r_vec_replace_na(x, replacement, i);
   }
 
   FREE(1);
@@ -9,9 +9,10 @@ void r_vec_poke_n(r_obj* x, r_ssize offset,
                   r_obj* y, r_ssize from, r_ssize n);
 
 
-// The vector to splice might be boxed in a sentinel wrapper
-static r_obj* maybe_unbox(r_obj* x, bool (*is_spliceable)(r_obj*)) {
-  if (is_spliceable(x) && is_splice_box(x)) {
+// The vector to splice might be boxed in a sentinel wrapper. Only
+// called on inputs that the predicate has already accepted.
+static r_obj* maybe_unbox(r_obj* x) {
+  if (is_splice_box(x)) {
     return r_vec_coerce(rlang_unbox(x), R_TYPE_list);
   } else {
     return x;
@@ -33,6 +34,40 @@ typedef struct {
   bool recursive;
 } squash_info_t;
 
+/*
+ * Results of R predicates are recorded during the first pass and
+ * replayed in the second pass, which visits the same elements in the
+ * same order. This way predicate closures are called at most once
+ * per element. `p_arr` is `NULL` when the predicate is called
+ * directly.
+ */
+struct squash_preds {
+  struct r_dyn_array* p_arr;
+  r_ssize i;
+};
+
+static inline
+bool squash_pred_record(struct squash_preds* p_preds,
+                        bool (*is_spliceable)(r_obj*),
+                        r_obj* x) {
+  bool out = is_spliceable(x);
+  if (p_preds->p_arr) {
+    r_arr_push_back(p_preds->p_arr, &out);
+  }
+  return out;
+}
+static inline
+bool squash_pred_replay(struct squash_preds* p_preds,
+                        bool (*is_spliceable)(r_obj*),
+                        r_obj* x) {
+  if (p_preds->p_arr) {
+    const bool* v_preds = r_arr_cbegin(p_preds->p_arr);
+    return v_preds[p_preds->i++];
+  } else {
+    return is_spliceable(x);
+  }
+}
+
 static squash_info_t squash_info_init(bool recursive) {
   squash_info_t info;
   info.size = 0;
@@ -45,52 +80,417 @@ static squash_info_t squash_info_init(bool recursive) {
 
 // Atomic squashing ---------------------------------------------------
 
-static r_ssize atom_squash(enum r_type kind, squash_info_t info,
-                           r_obj* outer, r_obj* out, r_ssize count,
-                           bool (*is_spliceable)(r_obj*), int depth) {
-  if (r_typeof(outer) != VECSXP) {
-    r_abort("Only lists can be spliced");
+// Atomic vectors are squashed in two phases. The first pass in
+// `squash_info()` collects the inner vectors in DFS order along with
+// their position in their outer list. The second pass copies them to
+// the output without calling the predicate again, with `memcpy()`
+// when the inner vector has the output type.
+struct squash_leaf {
+  r_obj* x;
+  r_obj* outer;
+  r_ssize i;
+};
+
+static void atom_squash_leaves(enum r_type kind, squash_info_t info,
+                               struct r_dyn_array* p_leaves, r_obj* out) {
+  r_obj* out_names = r_names(out);
+  const struct squash_leaf* v_leaves = r_arr_cbegin(p_leaves);
+  r_ssize n_leaves = p_leaves->count;
+
+  bool memcpyable = kind != R_TYPE_character;
+  r_ssize elt_size = r_vec_elt_sizeof0(kind);
+  unsigned char* v_out = memcpyable ? (unsigned char*) r_vec_begin(out) : NULL;
+
+  r_ssize count = 0;
+
+  for (r_ssize k = 0; k < n_leaves; ++k) {
+    r_obj* inner = v_leaves[k].x;
+    r_ssize n_inner = r_vec_length(inner);
+
+    if (!n_inner) {
+      continue;
+    }
+
+    if (memcpyable && r_typeof(inner) == kind) {
+      memcpy(v_out + count * elt_size, r_vec_begin(inner), n_inner * elt_size);
+    } else {
+      r_vec_poke_coerce_n(out, count, inner, 0, n_inner);
+    }
+
+    if (info.named) {
+      r_obj* nms = r_names(inner);
+      if (r_typeof(nms) == R_TYPE_character) {
+        r_vec_poke_n(out_names, count, nms, 0, n_inner);
+      } else if (n_inner == 1 && has_name_at(v_leaves[k].outer, v_leaves[k].i)) {
+        r_chr_poke(out_names, count, r_chr_get(r_names(v_leaves[k].outer), v_leaves[k].i));
+      }
+    }
+
+    count += n_inner;
   }
+}
 
-  r_obj* inner;
-  r_obj* out_names = KEEP(r_names(out));
-  r_ssize n_outer = r_length(outer);
-  r_ssize n_inner;
 
-  for (r_ssize i = 0; i != n_outer; ++i) {
-    inner = r_list_get(outer, i);
-    n_inner = r_vec_length(maybe_unbox(inner, is_spliceable));
 
-    if (depth != 0 && is_spliceable(inner)) {
-      inner = PROTECT(maybe_unbox(inner, is_spliceable));
-      count = atom_squash(kind, info, inner, out, count, is_spliceable, depth - 1);
-      UNPROTECT(1);
-    } else if (n_inner) {
-      r_vec_poke_coerce_n(out, count, inner, 0, n_inner);
+// Lazy views --------------------------------------------------------
 
-      if (info.named) {
-        r_obj* nms = r_names(inner);
-        if (r_typeof(nms) == R_TYPE_character) {
-          r_vec_poke_n(out_names, count, nms, 0, n_inner);
-        } else if (n_inner == 1 && has_name_at(outer, i)) {
-          r_chr_poke(out_names, count, r_chr_get(r_names(outer), i));
-        }
-      }
+/*
+ * With `lazy`, atomic outputs are returned as ALTREP views over their
+ * pieces when all pieces have the output type and no names need to
+ * be copied. Otherwise the output is materialised as usual.
+ *
+ * Views store in `data1` the list of pieces and a raw vector of the
+ * `n + 1` offsets of the `n` pieces in the output. Elements and
+ * regions are read from the pieces. The output is only materialised
+ * in `data2` when its data pointer is requested, for instance before
+ * it is modified, and is read from there afterwards.
+ */
+
+#if R_HAS_ALTREP
+
+static R_altrep_class_t view_lgl_class;
+static R_altrep_class_t view_int_class;
+static R_altrep_class_t view_dbl_class;
+static R_altrep_class_t view_cpl_class;
+static R_altrep_class_t view_raw_class;
+static R_altrep_class_t view_chr_class;
+
+static
+R_altrep_class_t view_class(enum r_type type) {
+  switch (type) {
+  case R_TYPE_logical: return view_lgl_class;
+  case R_TYPE_integer: return view_int_class;
+  case R_TYPE_double: return view_dbl_class;
+  case R_TYPE_complex: return view_cpl_class;
+  case R_TYPE_raw: return view_raw_class;
+  case R_TYPE_character: return view_chr_class;
+  default: r_stop_unimplemented_type("view_class", type);
+  }
+}
 
-      count += n_inner;
+static inline
+r_obj* view_pieces(r_obj* x) {
+  return r_list_get(R_altrep_data1(x), 0);
+}
+static inline
+const r_ssize* view_offsets(r_obj* x) {
+  return (const r_ssize*) r_raw_cbegin(r_list_get(R_altrep_data1(x), 1));
+}
+
+static
+R_xlen_t view_length(r_obj* x) {
+  return view_offsets(x)[r_length(view_pieces(x))];
+}
+
+// Returns the index of the piece holding element `i`. Pieces are
+// never empty so offsets are strictly increasing.
+static
+r_ssize view_locate(r_obj* x, r_ssize i) {
+  const r_ssize* v_offsets = view_offsets(x);
+  r_ssize lo = 0;
+  r_ssize hi = r_length(view_pieces(x)) - 1;
+
+  while (lo < hi) {
+    r_ssize mid = lo + (hi - lo + 1) / 2;
+    if (v_offsets[mid] <= i) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
     }
   }
 
+  return lo;
+}
+
+static
+r_obj* view_collect(r_obj* x) {
+  r_obj* pieces = view_pieces(x);
+  const r_ssize* v_offsets = view_offsets(x);
+  r_ssize n = r_length(pieces);
+
+  r_obj* out = KEEP(r_alloc_vector(r_typeof(x), v_offsets[n]));
+  for (r_ssize k = 0; k < n; ++k) {
+    r_vec_poke_n(out, v_offsets[k], r_list_get(pieces, k), 0, v_offsets[k + 1] - v_offsets[k]);
+  }
+
   FREE(1);
+  return out;
+}
+
+static
+r_obj* view_materialise(r_obj* x) {
+  r_obj* out = R_altrep_data2(x);
+  if (out == r_null) {
+    out = KEEP(view_collect(x));
+    R_set_altrep_data2(x, out);
+    FREE(1);
+  }
+  return out;
+}
+
+// Returns the vector holding element `i` and its index in that vector
+static
+r_obj* view_elt_vector(r_obj* x, r_ssize i, r_ssize* p_i) {
+  r_obj* data = R_altrep_data2(x);
+  if (data != r_null) {
+    *p_i = i;
+    return data;
+  }
+
+  r_ssize k = view_locate(x, i);
+  *p_i = i - view_offsets(x)[k];
+  return r_list_get(view_pieces(x), k);
+}
+
+static
+int view_lgl_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return LOGICAL_ELT(vec, j);
+}
+static
+int view_int_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return INTEGER_ELT(vec, j);
+}
+static
+double view_dbl_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return REAL_ELT(vec, j);
+}
+static
+Rcomplex view_cpl_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return COMPLEX_ELT(vec, j);
+}
+static
+Rbyte view_raw_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return RAW_ELT(vec, j);
+}
+static
+r_obj* view_chr_elt(r_obj* x, R_xlen_t i) {
+  r_ssize j;
+  r_obj* vec = view_elt_vector(x, i, &j);
+  return r_chr_get(vec, j);
+}
+
+static
+void view_chr_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_chr_poke(view_materialise(x), i, value);
+}
+
+static
+r_ssize vec_get_region(r_obj* x, r_ssize i, r_ssize n, void* buf) {
+  switch (r_typeof(x)) {
+  case R_TYPE_logical: return LOGICAL_GET_REGION(x, i, n, buf);
+  case R_TYPE_integer: return INTEGER_GET_REGION(x, i, n, buf);
+  case R_TYPE_double: return REAL_GET_REGION(x, i, n, buf);
+  case R_TYPE_complex: return COMPLEX_GET_REGION(x, i, n, buf);
+  case R_TYPE_raw: return RAW_GET_REGION(x, i, n, buf);
+  default: r_stop_unimplemented_type("vec_get_region", r_typeof(x));
+  }
+}
+
+// Copies the region from the pieces it spans
+static
+R_xlen_t view_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, void* buf) {
+  r_obj* data = R_altrep_data2(x);
+  if (data != r_null) {
+    return vec_get_region(data, i, n, buf);
+  }
+
+  n = r_ssize_min(n, view_length(x) - i);
+  if (n <= 0) {
+    return 0;
+  }
+
+  r_obj* pieces = view_pieces(x);
+  const r_ssize* v_offsets = view_offsets(x);
+  r_ssize elt_size = r_vec_elt_sizeof0(r_typeof(x));
+  unsigned char* v_buf = buf;
+
+  r_ssize count = 0;
+  for (r_ssize k = view_locate(x, i); count < n; ++k) {
+    r_ssize j = i + count - v_offsets[k];
+    r_ssize m = r_ssize_min(n - count, v_offsets[k + 1] - v_offsets[k] - j);
+    vec_get_region(r_list_get(pieces, k), j, m, v_buf + count * elt_size);
+    count += m;
+  }
+
   return count;
 }
 
+static
+R_xlen_t view_lgl_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, int* buf) {
+  return view_get_region(x, i, n, buf);
+}
+static
+R_xlen_t view_int_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, int* buf) {
+  return view_get_region(x, i, n, buf);
+}
+static
+R_xlen_t view_dbl_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, double* buf) {
+  return view_get_region(x, i, n, buf);
+}
+static
+R_xlen_t view_cpl_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, Rcomplex* buf) {
+  return view_get_region(x, i, n, buf);
+}
+static
+R_xlen_t view_raw_get_region(r_obj* x, R_xlen_t i, R_xlen_t n, Rbyte* buf) {
+  return view_get_region(x, i, n, buf);
+}
+
+static
+void* view_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(view_materialise(x));
+}
+
+static
+const void* view_dataptr_or_null(r_obj* x) {
+  r_obj* data = R_altrep_data2(x);
+  if (data == r_null) {
+    return NULL;
+  }
+  return DATAPTR_RO(data);
+}
+
+// Unmaterialised copies share the pieces
+static
+r_obj* view_duplicate(r_obj* x, Rboolean deep) {
+  if (R_altrep_data2(x) != r_null) {
+    return NULL;
+  }
+  return R_new_altrep(view_class(r_typeof(x)), R_altrep_data1(x), r_null);
+}
+
+static
+Rboolean view_inspect(r_obj* x,
+                      int pre,
+                      int deep,
+                      int pvec,
+                      void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_squash_view (len=%ld, pieces=%ld, materialised=%s)\n",
+          (long) view_length(x),
+          (long) r_length(view_pieces(x)),
+          R_altrep_data2(x) == r_null ? "F" : "T");
+  return TRUE;
+}
+
+static
+bool squash_has_view(enum r_type kind,
+                     squash_info_t info,
+                     struct r_dyn_array* p_leaves) {
+  if (info.named || !info.size) {
+    return false;
+  }
+
+  const struct squash_leaf* v_leaves = r_arr_cbegin(p_leaves);
+  for (r_ssize k = 0; k < p_leaves->count; ++k) {
+    if (r_typeof(v_leaves[k].x) != kind) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static
+r_obj* squash_view(enum r_type kind, struct r_dyn_array* p_leaves) {
+  const struct squash_leaf* v_leaves = r_arr_cbegin(p_leaves);
+  r_ssize n = p_leaves->count;
+
+  r_obj* data1 = KEEP(r_alloc_list(2));
+
+  r_obj* pieces = r_alloc_list(n);
+  r_list_poke(data1, 0, pieces);
+
+  r_obj* offsets = r_alloc_raw((n + 1) * sizeof(r_ssize));
+  r_list_poke(data1, 1, offsets);
+  r_ssize* v_offsets = (r_ssize*) r_raw_begin(offsets);
+
+  r_ssize count = 0;
+  for (r_ssize k = 0; k < n; ++k) {
+    r_list_poke(pieces, k, v_leaves[k].x);
+    v_offsets[k] = count;
+    count += r_length(v_leaves[k].x);
+  }
+  v_offsets[n] = count;
+
+  r_obj* out = R_new_altrep(view_class(kind), data1, r_null);
+
+  FREE(1);
+  return out;
+}
+
+static
+void init_view_class(R_altrep_class_t cls) {
+  R_set_altrep_Length_method(cls, &view_length);
+  R_set_altrep_Inspect_method(cls, &view_inspect);
+  R_set_altrep_Duplicate_method(cls, &view_duplicate);
+  R_set_altvec_Dataptr_method(cls, &view_dataptr);
+  R_set_altvec_Dataptr_or_null_method(cls, &view_dataptr_or_null);
+}
+
+void rlang_init_squash_altrep(DllInfo* dll) {
+  view_lgl_class = R_make_altlogical_class("rlang_squash_view_lgl", "rlang", dll);
+  view_int_class = R_make_altinteger_class("rlang_squash_view_int", "rlang", dll);
+  view_dbl_class = R_make_altreal_class("rlang_squash_view_dbl", "rlang", dll);
+  view_cpl_class = R_make_altcomplex_class("rlang_squash_view_cpl", "rlang", dll);
+  view_raw_class = R_make_altraw_class("rlang_squash_view_raw", "rlang", dll);
+  view_chr_class = R_make_altstring_class("rlang_squash_view_chr", "rlang", dll);
+
+  init_view_class(view_lgl_class);
+  init_view_class(view_int_class);
+  init_view_class(view_dbl_class);
+  init_view_class(view_cpl_class);
+  init_view_class(view_raw_class);
+  init_view_class(view_chr_class);
+
+  R_set_altlogical_Elt_method(view_lgl_class, &view_lgl_elt);
+  R_set_altinteger_Elt_method(view_int_class, &view_int_elt);
+  R_set_altreal_Elt_method(view_dbl_class, &view_dbl_elt);
+  R_set_altcomplex_Elt_method(view_cpl_class, &view_cpl_elt);
+  R_set_altraw_Elt_method(view_raw_class, &view_raw_elt);
+  R_set_altstring_Elt_method(view_chr_class, &view_chr_elt);
+  R_set_altstring_Set_elt_method(view_chr_class, &view_chr_set_elt);
+
+  R_set_altlogical_Get_region_method(view_lgl_class, &view_lgl_get_region);
+  R_set_altinteger_Get_region_method(view_int_class, &view_int_get_region);
+  R_set_altreal_Get_region_method(view_dbl_class, &view_dbl_get_region);
+  R_set_altcomplex_Get_region_method(view_cpl_class, &view_cpl_get_region);
+  R_set_altraw_Get_region_method(view_raw_class, &view_raw_get_region);
+}
+
+#else
+
+static
+bool squash_has_view(enum r_type kind,
+                     squash_info_t info,
+                     struct r_dyn_array* p_leaves) {
+  return false;
+}
+static
+r_obj* squash_view(enum r_type kind, struct r_dyn_array* p_leaves) {
+  r_stop_internal("squash_view", "ALTREP is not available.");
+}
+void rlang_init_squash_altrep(DllInfo* dll) { }
+
+#endif
+
 
 // List squashing -----------------------------------------------------
 
 static r_ssize list_squash(squash_info_t info, r_obj* outer,
                            r_obj* out, r_ssize count,
-                           bool (*is_spliceable)(r_obj*), int depth) {
+                           bool (*is_spliceable)(r_obj*),
+                           struct squash_preds* p_preds,
+                           int depth) {
   if (r_typeof(outer) != VECSXP) {
     r_abort("Only lists can be spliced");
   }
@@ -102,9 +502,9 @@ static r_ssize list_squash(squash_info_t info, r_obj* outer,
   for (r_ssize i = 0; i != n_outer; ++i) {
     inner = r_list_get(outer, i);
 
-    if (depth != 0 && is_spliceable(inner)) {
-      inner = PROTECT(maybe_unbox(inner, is_spliceable));
-      count = list_squash(info, inner, out, count, is_spliceable, depth - 1);
+    if (depth != 0 && squash_pred_replay(p_preds, is_spliceable, inner)) {
+      inner = PROTECT(maybe_unbox(inner));
+      count = list_squash(info, inner, out, count, is_spliceable, p_preds, depth - 1);
       UNPROTECT(1);
     } else {
       r_list_poke(out, count, inner);
@@ -165,8 +565,14 @@ static void update_info_inner(squash_info_t* info, r_obj* outer, r_ssize i, r_ob
   }
 }
 
+// When `p_leaves` is supplied, the inner vectors are pushed to it and
+// the unboxed lists they belong to are protected in `p_unboxed`
 static void squash_info(squash_info_t* info, r_obj* outer,
-                        bool (*is_spliceable)(r_obj*), int depth) {
+                        bool (*is_spliceable)(r_obj*),
+                        struct squash_preds* p_preds,
+                        int depth,
+                        struct r_dyn_array* p_leaves,
+                        struct r_dyn_array* p_unboxed) {
   if (r_typeof(outer) != R_TYPE_list) {
     r_abort("Only lists can be spliced");
   }
@@ -177,24 +583,58 @@ static void squash_info(squash_info_t* info, r_obj* outer,
   for (r_ssize i = 0; i != n_outer; ++i) {
     inner = r_list_get(outer, i);
 
-    if (depth != 0 && is_spliceable(inner)) {
+    if (depth != 0 && squash_pred_record(p_preds, is_spliceable, inner)) {
       update_info_outer(info, outer, i);
-      inner = PROTECT(maybe_unbox(inner, is_spliceable));
-      squash_info(info, inner, is_spliceable, depth - 1);
+      r_obj* unboxed = PROTECT(maybe_unbox(inner));
+      if (p_unboxed && unboxed != inner) {
+        r_list_push_back(p_unboxed, unboxed);
+      }
+      squash_info(info, unboxed, is_spliceable, p_preds, depth - 1, p_leaves, p_unboxed);
       UNPROTECT(1);
     } else if (info->recursive || r_vec_length(inner)) {
       update_info_inner(info, outer, i, inner);
+      if (p_leaves) {
+        struct squash_leaf leaf = { .x = inner, .outer = outer, .i = i };
+        r_arr_push_back(p_leaves, &leaf);
+      }
     }
   }
 }
 
-static r_obj* squash(enum r_type kind, r_obj* dots, bool (*is_spliceable)(r_obj*), int depth) {
+static bool is_spliceable_closure(r_obj* x);
+
+static r_obj* squash(enum r_type kind, r_obj* dots, bool (*is_spliceable)(r_obj*), int depth, bool lazy) {
   bool recursive = kind == VECSXP;
+  int n_kept = 0;
+
+  // Atomic squashing never calls the predicate in the second pass
+  struct squash_preds preds = { .p_arr = NULL, .i = 0 };
+  if (recursive && is_spliceable == &is_spliceable_closure) {
+    preds.p_arr = r_new_dyn_array(sizeof(bool), r_length(dots));
+    KEEP_N(preds.p_arr->shelter, &n_kept);
+  }
+
+  struct r_dyn_array* p_leaves = NULL;
+  struct r_dyn_array* p_unboxed = NULL;
+
+  if (!recursive) {
+    p_leaves = r_new_dyn_array(sizeof(struct squash_leaf), r_length(dots));
+    KEEP_N(p_leaves->shelter, &n_kept);
+
+    p_unboxed = r_new_dyn_vector(R_TYPE_list, 0);
+    KEEP_N(p_unboxed->shelter, &n_kept);
+  }
 
   squash_info_t info = squash_info_init(recursive);
-  squash_info(&info, dots, is_spliceable, depth);
+  squash_info(&info, dots, is_spliceable, &preds, depth, p_leaves, p_unboxed);
+
+  if (lazy && !recursive && squash_has_view(kind, info, p_leaves)) {
+    r_obj* out = squash_view(kind, p_leaves);
+    FREE(n_kept);
+    return out;
+  }
 
-  r_obj* out = KEEP(r_alloc_vector(kind, info.size));
+  r_obj* out = KEEP_N(r_alloc_vector(kind, info.size), &n_kept);
   if (info.named) {
     r_obj* nms = KEEP(r_alloc_character(info.size));
     r_attrib_poke_names(out, nms);
@@ -202,12 +642,12 @@ static r_obj* squash(enum r_type kind, r_obj* dots, bool (*is_spliceable)(r_obj*
   }
 
   if (recursive) {
-    list_squash(info, dots, out, 0, is_spliceable, depth);
+    list_squash(info, dots, out, 0, is_spliceable, &preds, depth);
   } else {
-    atom_squash(kind, info, dots, out, 0, is_spliceable, depth);
+    atom_squash_leaves(kind, info, p_leaves, out);
   }
 
-  FREE(1);
+  FREE(n_kept);
   return out;
 }
 
@@ -246,15 +686,25 @@ static is_spliceable_t predicate_pointer(r_obj* x) {
   return NULL;
 }
 
+static bool is_list_native(r_obj* x) {
+  return r_typeof(x) == R_TYPE_list;
+}
+static bool is_bare_list_native(r_obj* x) {
+  return r_typeof(x) == R_TYPE_list && !r_is_object(x);
+}
+
+// Recognises the predicates of rlang that have a native equivalent
 static is_spliceable_t predicate_internal(r_obj* x) {
   static r_obj* is_spliced_clo = NULL;
+  static r_obj* is_spliceable_clo = NULL;
+  static r_obj* is_list_clo = NULL;
+  static r_obj* is_bare_list_clo = NULL;
+
   if (!is_spliced_clo) {
     is_spliced_clo = rlang_ns_get("is_spliced");
-  }
-
-  static r_obj* is_spliceable_clo = NULL;
-  if (!is_spliceable_clo) {
     is_spliceable_clo = rlang_ns_get("is_spliced_bare");
+    is_list_clo = rlang_ns_get("is_list");
+    is_bare_list_clo = rlang_ns_get("is_bare_list");
   }
 
   if (x == is_spliced_clo) {
@@ -263,6 +713,12 @@ static is_spliceable_t predicate_internal(r_obj* x) {
   if (x == is_spliceable_clo) {
     return &is_spliced_bare;
   }
+  if (x == is_list_clo) {
+    return &is_list_native;
+  }
+  if (x == is_bare_list_clo) {
+    return &is_bare_list_native;
+  }
   return NULL;
 }
 
@@ -282,7 +738,8 @@ static bool is_spliceable_closure(r_obj* x) {
 
 // Export ------------------------------------------------------------
 
-r_obj* r_squash_if(r_obj* dots, enum r_type kind, bool (*is_spliceable)(r_obj*), int depth) {
+static
+r_obj* squash_if(r_obj* dots, enum r_type kind, bool (*is_spliceable)(r_obj*), int depth, bool lazy) {
   switch (kind) {
   case R_TYPE_logical:
   case R_TYPE_integer:
@@ -291,26 +748,30 @@ r_obj* r_squash_if(r_obj* dots, enum r_type kind, bool (*is_spliceable)(r_obj*),
   case R_TYPE_character:
   case RAWSXP:
   case VECSXP:
-    return squash(kind, dots, is_spliceable, depth);
+    return squash(kind, dots, is_spliceable, depth, lazy);
   default:
     r_abort("Splicing is not implemented for this type");
     return r_null;
   }
 }
-r_obj* rlang_squash_closure(r_obj* dots, enum r_type kind, r_obj* pred, int depth) {
+r_obj* r_squash_if(r_obj* dots, enum r_type kind, bool (*is_spliceable)(r_obj*), int depth) {
+  return squash_if(dots, kind, is_spliceable, depth, false);
+}
+r_obj* rlang_squash_closure(r_obj* dots, enum r_type kind, r_obj* pred, int depth, bool lazy) {
   r_obj* prev_pred = clo_spliceable;
   clo_spliceable = KEEP(Rf_lang2(pred, Rf_list2(r_null, r_null)));
 
-  r_obj* out = r_squash_if(dots, kind, &is_spliceable_closure, depth);
+  r_obj* out = squash_if(dots, kind, &is_spliceable_closure, depth, lazy);
 
   clo_spliceable = prev_pred;
   FREE(1);
 
   return out;
 }
-r_obj* rlang_squash(r_obj* dots, r_obj* type, r_obj* pred, r_obj* depth_) {
+r_obj* rlang_squash(r_obj* dots, r_obj* type, r_obj* pred, r_obj* depth_, r_obj* lazy_) {
   enum r_type kind = Rf_str2type(CHAR(r_chr_get(type, 0)));
   int depth = Rf_asInteger(depth_);
+  bool lazy = r_as_bool(lazy_);
 
   is_spliceable_t is_spliceable;
 
@@ -318,14 +779,14 @@ r_obj* rlang_squash(r_obj* dots, r_obj* type, r_obj* pred, r_obj* depth_) {
   case R_TYPE_closure:
     is_spliceable = predicate_internal(pred);
     if (is_spliceable) {
-      return r_squash_if(dots, kind, is_spliceable, depth);
+      return squash_if(dots, kind, is_spliceable, depth, lazy);
     } // else fallthrough
   case R_TYPE_builtin:
   case R_TYPE_special:
-    return rlang_squash_closure(dots, kind, pred, depth);
+    return rlang_squash_closure(dots, kind, pred, depth, lazy);
   default:
     is_spliceable = predicate_pointer(pred);
-    return r_squash_if(dots, kind, is_spliceable, depth);
+    return squash_if(dots, kind, is_spliceable, depth, lazy);
   }
 }
 
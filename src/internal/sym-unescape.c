@@ -22,6 +22,78 @@ r_obj* rlang_sym_as_character(r_obj* sym) {
   return out;
 }
 
+// Vectorised `sym()`. The empty string is converted to the missing
+// argument.
+r_obj* ffi_syms(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_character) {
+    r_stop_internal("ffi_syms", "`x` must be a character vector.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_chr_cbegin(x);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* str = v_x[i];
+
+    if (str == r_globals.na_str) {
+      r_abort("Only strings can be converted to symbols");
+    }
+
+    r_obj* sym = (str == r_globals.empty_str) ? r_syms.missing : r_str_as_symbol(str);
+    r_list_poke(out, i, sym);
+  }
+
+  r_obj* nms = r_names(x);
+  if (nms != r_null) {
+    r_attrib_poke_names(out, nms);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Vectorised `as_string()` for lists of symbols and strings. Only
+// the names that contain unicode tags are unescaped, the others are
+// reused as is.
+r_obj* ffi_syms_as_strings(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_list) {
+    r_stop_internal("ffi_syms_as_strings", "`x` must be a list.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  r_obj* out = KEEP(r_alloc_character(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* elt = v_x[i];
+
+    switch (r_typeof(elt)) {
+    case R_TYPE_symbol:
+      r_chr_poke(out, i, str_unserialise_unicode(PRINTNAME(elt)));
+      break;
+    case R_TYPE_character:
+      if (r_length(elt) == 1 && r_chr_get(elt, 0) != r_globals.na_str) {
+        r_chr_poke(out, i, r_chr_get(elt, 0));
+        break;
+      }
+      // else fallthrough
+    default:
+      r_abort("Element %d of `x` must be a symbol or a string.", (int) i + 1);
+    }
+  }
+
+  r_obj* nms = r_names(x);
+  if (nms != r_null) {
+    r_attrib_poke_names(out, nms);
+  }
+
+  FREE(1);
+  return out;
+}
+
 r_obj* rlang_unescape_character(r_obj* chr) {
   R_xlen_t len = Rf_xlength(chr);
   R_xlen_t i = unescape_character_in_copy(r_null, chr, 0);
@@ -37,7 +109,7 @@ r_obj* rlang_unescape_character(r_obj* chr) {
 // Private functions -----------------------------------------------------------
 
 static r_obj* unescape_char_to_sexp(char* tmp);
-static bool has_unicode_escape(const char* chr);
+static bool has_unicode_escape(const char* chr, r_ssize len);
 static int unescape_char(char* chr);
 static int unescape_char_found(char* chr);
 static int process_byte(char* tgt, char* const src, int* len_processed);
@@ -71,7 +143,7 @@ r_obj* str_unserialise_unicode(r_obj* r_string) {
   int ce = Rf_getCharCE(r_string);
   const char* src = CHAR(r_string);
 
-  if (!has_unicode_escape(src)) {
+  if (!has_unicode_escape(src, r_length(r_string))) {
     return r_string;
   }
 
@@ -97,13 +169,25 @@ r_obj* unescape_char_to_sexp(char* tmp) {
   return Rf_mkCharLenCE(tmp, len, CE_UTF8);
 }
 
+// Jumps between opening angle brackets with `memchr()`, which is
+// vectorised by the C library. The ASCII flag of a CHARSXP can't be
+// used to skip it since escapes are ASCII themselves.
 static
-bool has_unicode_escape(const char* chr) {
-  while (*chr) {
-    if (has_codepoint(chr)) {
+bool has_unicode_escape(const char* chr, r_ssize len) {
+  const char* end = chr + len;
+  const int escape_len = strlen("<U+xxxx>");
+
+  while (end - chr >= escape_len) {
+    const char* open = memchr(chr, '<', end - chr - escape_len + 1);
+
+    if (!open) {
+      return false;
+    }
+    if (has_codepoint(open)) {
       return true;
     }
-    ++chr;
+
+    chr = open + 1;
   }
 
   return false;
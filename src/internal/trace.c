@@ -0,0 +1,396 @@
+#include <rlang.h>
+#include "parse.h"
+#include "quo.h"
+#include "vec.h"
+
+/*
+ * Captures the frames of a backtrace in a single pass over the
+ * context stack. The stack is read with `sys.frames()`,
+ * `sys.parents()` and `sys.calls()` evaluated in the frame of
+ * `trace_back()`, which is the last frame of the stack.
+ *
+ * Returns a list of:
+ * - `calls`: The frame calls.
+ * - `parents`: The parent indices, normalised so that recursive
+ *   frames have a parent of 0.
+ * - `frames`: The frame environments.
+ * - `pipes`: The indices of magrittr calls that need a pipe pointer.
+ * - `namespaces`: For each frame, the namespace of its function, the
+ *   global environment, or `NULL`.
+ *
+ * When `budget` is an integer vector of the number of innermost and
+ * outermost frames to keep, the frames in between are replaced by a
+ * single `...()` call with an `elided` attribute counting them. The
+ * parents of kept frames that pointed into the elided region are
+ * redirected to that marker.
+ *
+ * The calls are prefixed with their namespace lazily, when the trace
+ * is formatted or its calls are inspected, with
+ * `ffi_trace_add_namespaces()`. Only namespaces and the global
+ * environment are kept so that traces don't retain frames.
+ */
+
+static r_obj* trace_capture_nms = NULL;
+static r_obj* sym_pipe = NULL;
+static r_obj* sym_package_name = NULL;
+static r_obj* sym_namespace = NULL;
+static r_obj* sym_exports = NULL;
+static r_obj* sym_elided = NULL;
+
+static r_ssize trace_bottom(r_obj* bottom, r_obj* const * v_frames, const int* v_parents, r_ssize n);
+static r_obj* trace_frame_namespace(r_obj* frame, r_obj* call, r_ssize i, r_obj* stack_frame);
+static r_obj* trace_call_add_namespace(r_obj* call, r_obj* ns);
+static r_obj* trace_elided_call(r_ssize n);
+
+static inline
+int trace_elided_parent(int parent, r_ssize n_outer, r_ssize n_elided) {
+  if (parent <= n_outer) {
+    return parent;
+  }
+  if (parent <= n_outer + n_elided) {
+    return n_outer + 1;
+  }
+  return parent - n_elided + 1;
+}
+
+r_obj* ffi_trace_back(r_obj* frame, r_obj* bottom, r_obj* top, r_obj* budget) {
+  r_obj* frames_node = KEEP(r_sys_frames(frame));
+  r_obj* parents = KEEP(r_sys_parents(frame));
+  r_obj* calls = KEEP(r_sys_calls(frame));
+
+  r_ssize n = r_length(frames_node);
+
+  r_obj* frames = KEEP(r_alloc_list(n));
+  for (r_ssize i = 0; i < n; ++i, frames_node = r_node_cdr(frames_node)) {
+    r_list_poke(frames, i, r_node_car(frames_node));
+  }
+
+  r_obj* const * v_frames = r_list_cbegin(frames);
+  const int* v_parents = r_int_cbegin(parents);
+
+  n = trace_bottom(bottom, v_frames, v_parents, n);
+
+  // Frames up to the last occurrence of `top` are trimmed
+  r_ssize start = 0;
+  if (top != r_null) {
+    for (r_ssize i = n - 1; i >= 0; --i) {
+      if (v_frames[i] == top) {
+        start = i + 1;
+        break;
+      }
+    }
+  }
+
+  r_ssize n_outer = n - start;
+  r_ssize n_elided = 0;
+
+  if (budget != r_null) {
+    if (r_typeof(budget) != R_TYPE_integer || r_length(budget) != 2) {
+      r_stop_internal("ffi_trace_back", "`budget` must be an integer vector of size 2.");
+    }
+    r_ssize n_inner = r_int_get(budget, 0);
+    r_ssize n_budget_outer = r_int_get(budget, 1);
+
+    // Eliding a single frame would not make the trace any shorter
+    if (n - start > n_inner + n_budget_outer + 1) {
+      n_outer = n_budget_outer;
+      n_elided = n - start - n_inner - n_outer;
+    }
+  }
+
+  r_ssize out_n = n - start - n_elided + (n_elided > 0);
+
+  r_obj* out = KEEP(r_alloc_list(5));
+  r_attrib_poke_names(out, trace_capture_nms);
+
+  r_obj* out_calls = r_alloc_list(out_n);
+  r_list_poke(out, 0, out_calls);
+
+  r_obj* out_parents = r_alloc_integer(out_n);
+  r_list_poke(out, 1, out_parents);
+  int* v_out_parents = r_int_begin(out_parents);
+
+  r_obj* out_frames = r_alloc_list(out_n);
+  r_list_poke(out, 2, out_frames);
+
+  r_obj* out_nss = r_alloc_list(out_n);
+  r_list_poke(out, 4, out_nss);
+
+  struct r_dyn_array* p_pipes = r_new_dyn_vector(R_TYPE_integer, 4);
+  KEEP(p_pipes->shelter);
+
+  for (r_ssize i = 0; i < start; ++i) {
+    calls = r_node_cdr(calls);
+  }
+
+  for (r_ssize i = start, j = 0; i < n; ++i, ++j, calls = r_node_cdr(calls)) {
+    if (j == n_outer && n_elided) {
+      r_list_poke(out_calls, j, trace_elided_call(n_elided));
+
+      int parent = v_parents[i];
+      parent = (parent == i + 1 || parent <= start) ? 0 : parent - start;
+      v_out_parents[j] = trace_elided_parent(parent, n_outer, n_elided);
+
+      // Skip the elided frames. The loop increments move past the last one.
+      for (r_ssize k = 1; k < n_elided; ++k) {
+        calls = r_node_cdr(calls);
+      }
+      i += n_elided - 1;
+      continue;
+    }
+
+    r_obj* call = r_node_car(calls);
+    r_obj* env = v_frames[i];
+
+    // Work around R bug causing promises to leak in frame calls
+    r_obj* head = r_node_car(call);
+    if (r_typeof(head) == R_TYPE_promise) {
+      r_node_poke_car(call, r_eval(head, r_empty_env));
+      head = r_node_car(call);
+    }
+
+    if (head == sym_pipe) {
+      r_int_push_back(p_pipes, j + 1);
+    }
+
+    r_list_poke(out_calls, j, call);
+    r_list_poke(out_frames, j, env);
+    r_list_poke(out_nss, j, trace_frame_namespace(env, call, i, frame));
+
+    // Recursive frames occur with quosures and are normalised to a
+    // parent of 0. Parents that are trimmed become 0 as well.
+    int parent = v_parents[i];
+    if (parent == i + 1 || parent <= start) {
+      parent = 0;
+    } else {
+      parent -= start;
+    }
+    v_out_parents[j] = trace_elided_parent(parent, n_outer, n_elided);
+  }
+
+  r_list_poke(out, 3, r_arr_unwrap(p_pipes));
+
+  FREE(6);
+  return out;
+}
+
+static
+r_obj* trace_elided_call(r_ssize n) {
+  r_obj* call = KEEP(r_call(r_syms.dots));
+
+  r_obj* n_elided = r_int(n);
+  r_attrib_poke(call, sym_elided, n_elided);
+
+  FREE(1);
+  return call;
+}
+
+// Reproduces the frame selection of `sys.parent(bottom + 1)` called
+// from a helper of `trace_back()`
+static
+r_ssize trace_bottom(r_obj* bottom,
+                     r_obj* const * v_frames,
+                     const int* v_parents,
+                     r_ssize n) {
+  if (bottom == r_null) {
+    return v_parents[n - 1];
+  }
+
+  if (r_typeof(bottom) == R_TYPE_environment) {
+    for (r_ssize i = 0; i < n; ++i) {
+      if (v_frames[i] == bottom) {
+        return i + 1;
+      }
+    }
+    if (bottom == r_global_env) {
+      return 0;
+    }
+    r_abort("Can't find `bottom` on the call tree");
+  }
+
+  if (r_is_integerish(bottom, 1, true)) {
+    r_ssize n_up = r_as_ssize(bottom);
+    if (n_up < 0) {
+      r_abort("`bottom` can't be negative.");
+    }
+    if (n_up == 0) {
+      return n;
+    }
+
+    r_ssize pos = n + 1 - n_up;
+    if (pos < 1) {
+      return 0;
+    }
+    return v_parents[pos - 1];
+  }
+
+  r_abort("`bottom` must be `NULL`, a frame environment, or an integer");
+}
+
+
+// Same as `topenv()`
+static
+r_obj* trace_topenv(r_obj* env) {
+  while (env != r_empty_env) {
+    if (env == r_global_env ||
+        env == r_base_env ||
+        env == R_BaseNamespace ||
+        R_IsPackageEnv(env) ||
+        R_IsNamespaceEnv(env) ||
+        r_env_has(env, sym_package_name)) {
+      return env;
+    }
+    env = r_env_parent(env);
+  }
+
+  return r_global_env;
+}
+
+static
+bool trace_ns_exports_has(r_obj* ns, r_obj* sym) {
+  if (ns == R_BaseNamespace) {
+    return r_env_has(r_base_env, sym);
+  }
+
+  r_obj* info = r_env_find(ns, sym_namespace);
+  if (r_typeof(info) != R_TYPE_environment) {
+    return false;
+  }
+
+  r_obj* exports = r_env_find(info, sym_exports);
+  if (r_typeof(exports) != R_TYPE_environment) {
+    return false;
+  }
+
+  return r_env_has(exports, sym);
+}
+
+/*
+ * The function of a closure frame is looked up under the call head
+ * from the enclosure of the frame environment rather than with
+ * `sys.function()`, which would require an R call per frame. The
+ * lookup is only trusted when the function found is a closure of
+ * that enclosure. Other frames, such as the context of `eval()`
+ * whose frame is `envir`, fall back to `sys.function()`.
+ */
+static
+r_obj* trace_frame_fn(r_obj* frame, r_obj* call, r_ssize i, r_obj* stack_frame) {
+  r_obj* head = r_node_car(call);
+
+  if (r_typeof(head) == R_TYPE_symbol) {
+    r_obj* enclos = r_env_parent(frame);
+
+    for (r_obj* env = enclos; env != r_empty_env; env = r_env_parent(env)) {
+      r_obj* fn = r_env_find(env, head);
+
+      if (fn == r_syms.unbound) {
+        continue;
+      }
+      if (r_typeof(fn) == R_TYPE_closure && r_fn_env(fn) == enclos) {
+        return fn;
+      }
+      if (r_is_function(fn) || r_typeof(fn) == R_TYPE_promise) {
+        break;
+      }
+    }
+  }
+
+  return r_sys_function(i + 1, stack_frame);
+}
+
+static
+r_obj* trace_frame_namespace(r_obj* frame, r_obj* call, r_ssize i, r_obj* stack_frame) {
+  r_obj* fn = KEEP(trace_frame_fn(frame, call, i, stack_frame));
+
+  // Same as `fn_env()`
+  r_obj* env;
+  switch (r_typeof(fn)) {
+  case R_TYPE_closure: env = r_fn_env(fn); break;
+  case R_TYPE_builtin:
+  case R_TYPE_special: env = R_BaseNamespace; break;
+  default: FREE(1); return r_null;
+  }
+  FREE(1);
+
+  if (env == r_global_env) {
+    return env;
+  }
+
+  r_obj* top = trace_topenv(env);
+  if (R_IsNamespaceEnv(top)) {
+    return top;
+  } else {
+    return r_null;
+  }
+}
+
+r_obj* ffi_trace_add_namespaces(r_obj* calls, r_obj* nss) {
+  r_ssize n = r_length(calls);
+  if (r_typeof(calls) != R_TYPE_list || r_typeof(nss) != R_TYPE_list || r_length(nss) != n) {
+    r_stop_internal("ffi_trace_add_namespaces", "Unexpected trace columns.");
+  }
+
+  r_obj* out = KEEP(r_alloc_list(n));
+  r_obj* const * v_calls = r_list_cbegin(calls);
+  r_obj* const * v_nss = r_list_cbegin(nss);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i, trace_call_add_namespace(v_calls[i], v_nss[i]));
+  }
+
+  r_attrib_poke_names(out, r_names(calls));
+
+  FREE(1);
+  return out;
+}
+
+// Same as `maybe_add_namespace()`
+static
+r_obj* trace_call_add_namespace(r_obj* call, r_obj* ns) {
+  if (rlang_is_quosure(call)) {
+    call = rlang_quo_get_expr_(call);
+  }
+
+  if (r_typeof(call) != R_TYPE_call || r_which_operator(call) != R_OP_NONE) {
+    return call;
+  }
+
+  // Checking for bare symbols covers the `::` and `:::` cases
+  r_obj* sym = r_node_car(call);
+  if (r_typeof(sym) != R_TYPE_symbol) {
+    return call;
+  }
+
+  r_obj* prefix;
+  r_obj* op;
+
+  if (ns == r_global_env) {
+    prefix = r_sym("global");
+    op = r_syms.colon2;
+  } else if (r_typeof(ns) == R_TYPE_environment) {
+    r_obj* spec = R_NamespaceEnvSpec(ns);
+    prefix = r_str_as_symbol(r_chr_get(spec, 0));
+    op = trace_ns_exports_has(ns, sym) ? r_syms.colon2 : r_syms.colon3;
+  } else {
+    return call;
+  }
+
+  call = KEEP(r_clone(call));
+
+  r_obj* ns_sym = r_call3(op, prefix, sym);
+  r_node_poke_car(call, ns_sym);
+
+  FREE(1);
+  return call;
+}
+
+void rlang_init_trace(r_obj* ns) {
+  const char* nms[] = { "calls", "parents", "frames", "pipes", "namespaces" };
+  trace_capture_nms = r_preserve_global(r_chr_n(nms, R_ARR_SIZEOF(nms)));
+
+  sym_pipe = r_sym("%>%");
+  sym_package_name = r_sym(".packageName");
+  sym_namespace = r_sym(".__NAMESPACE__.");
+  sym_exports = r_sym("exports");
+  sym_elided = r_sym("elided");
+}
@@ -41,6 +41,39 @@ void rlang_print_backtrace(bool full) {
 }
 
 
+/*
+ * Deprecation ids already signalled from C are recorded in
+ * dictionaries so that repeated signals, e.g. from deprecated code
+ * paths called in a loop, return without evaluating R code. The
+ * options controlling lifecycle verbosity are checked first so that
+ * changing them takes effect immediately.
+ */
+static struct r_str_dict* p_deprecation_warned = NULL;
+static struct r_str_dict* p_deprecation_soft_signalled = NULL;
+
+static r_obj* sym_lifecycle_disable_warnings = NULL;
+static r_obj* sym_lifecycle_repeat_warnings = NULL;
+static r_obj* sym_lifecycle_verbose_soft_deprecation = NULL;
+
+static inline
+bool peek_lifecycle_option(r_obj* sym) {
+  return r_is_true(Rf_GetOption1(sym));
+}
+
+// Returns `true` if `id` was already recorded
+static
+bool deprecation_record(struct r_str_dict* p_dict, const char* id) {
+  if (r_str_dict_has_c(p_dict, id, strlen(id))) {
+    return true;
+  }
+
+  r_obj* key = KEEP(r_str(id));
+  r_str_dict_put(p_dict, key, r_true);
+
+  FREE(1);
+  return false;
+}
+
 static r_obj* signal_soft_deprecated_call = NULL;
 void signal_soft_deprecated(const char* msg,
                             const char* id,
@@ -51,6 +84,23 @@ void signal_soft_deprecated(const char* msg,
     r_abort("Internal error: NULL `msg` in r_signal_soft_deprecated()");
   }
 
+  if (peek_lifecycle_option(sym_lifecycle_disable_warnings)) {
+    return;
+  }
+
+  // With the empty env the soft-deprecation is never promoted based
+  // on the caller, only by the verbosity option
+  if (env == r_empty_env) {
+    if (peek_lifecycle_option(sym_lifecycle_verbose_soft_deprecation)) {
+      warn_deprecated(id, "%s", msg);
+      return;
+    }
+    if (!peek_lifecycle_option(sym_lifecycle_repeat_warnings) &&
+        deprecation_record(p_deprecation_soft_signalled, id)) {
+      return;
+    }
+  }
+
   r_obj* msg_ = KEEP(r_chr(msg));
   r_obj* id_ = KEEP(r_chr(id));
 
@@ -74,11 +124,26 @@ static void signal_retirement(const char* source, const char* buf);
 static r_obj* warn_deprecated_call = NULL;
 
 void warn_deprecated(const char* id, const char* fmt, ...) {
+  if (peek_lifecycle_option(sym_lifecycle_disable_warnings)) {
+    return;
+  }
+
+  bool repeat = peek_lifecycle_option(sym_lifecycle_repeat_warnings);
+
+  // Check before formatting the message when the id is known
+  if (id && !repeat && r_str_dict_has_c(p_deprecation_warned, id, strlen(id))) {
+    return;
+  }
+
   char buf[BUFSIZE];
   INTERP(buf, fmt, ...);
-  r_obj* msg_ = KEEP(r_chr(buf));
 
   id = id ? id : buf;
+  if (!repeat && deprecation_record(p_deprecation_warned, id)) {
+    return;
+  }
+
+  r_obj* msg_ = KEEP(r_chr(buf));
   r_obj* id_ = KEEP(r_chr(id));
 
   r_eval_with_xy(warn_deprecated_call, msg_, id_, r_base_env);
@@ -165,23 +230,103 @@ bool r_is_namespaced_call_any(r_obj* x, const char* ns,
   return r_is_symbol_any(sym, names, n);
 }
 
-r_obj* nms_are_duplicated(r_obj* nms, bool from_last) {
+#define NMS_DUPLICATED_QUADRATIC_MAX 16
+
+static
+bool nms_need_translation(r_obj* const * v_nms, r_ssize n) {
+  for (r_ssize i = 0; i < n; ++i) {
+    if (Rf_getCharCE(v_nms[i]) != CE_NATIVE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Compares CHARSXP pointers, which is equivalent to comparing strings
+// as long as all of them are in the native encoding. Otherwise the
+// same string may have several representations and we fall back to
+// `Rf_duplicated()`.
+r_obj* nms_which_duplicated(r_obj* nms, bool from_last) {
   if (r_typeof(nms) != R_TYPE_character) {
     r_abort("Internal error: Expected a character vector of names for checking duplication");
   }
-  r_obj* dups = KEEP(Rf_duplicated(nms, from_last));
+  if (rlang_is_empty_names(nms)) {
+    return r_null;
+  }
 
-  r_ssize n = r_length(dups);
-  int* p_dups = r_lgl_begin(dups);
-  r_obj* const * p_nms = r_chr_cbegin(nms);
+  r_ssize n = r_length(nms);
+  r_obj* const * v_nms = r_chr_cbegin(nms);
 
-  for (r_ssize i = 0; i < n; ++i) {
-    if (p_nms[i] == r_globals.empty_str || p_nms[i] == r_globals.na_str) {
-      p_dups[i] = false;
+  if (nms_need_translation(v_nms, n)) {
+    r_obj* dups = KEEP(Rf_duplicated(nms, from_last));
+    int* v_dups = r_lgl_begin(dups);
+
+    bool any = false;
+    for (r_ssize i = 0; i < n; ++i) {
+      if (v_nms[i] == r_globals.empty_str || v_nms[i] == r_globals.na_str) {
+        v_dups[i] = false;
+      }
+      any = any || v_dups[i];
     }
+
+    FREE(1);
+    return any ? dups : r_null;
   }
 
-  FREE(1);
+  int n_kept = 0;
+  struct r_flat_dict* p_seen = NULL;
+  if (n > NMS_DUPLICATED_QUADRATIC_MAX) {
+    p_seen = r_new_flat_dict(n);
+    KEEP_N(p_seen->shelter, &n_kept);
+  }
+
+  r_obj* dups = r_null;
+  int* v_dups = NULL;
+
+  r_ssize start = from_last ? n - 1 : 0;
+  r_ssize step = from_last ? -1 : 1;
+
+  for (r_ssize k = 0, i = start; k < n; ++k, i += step) {
+    r_obj* nm = v_nms[i];
+    if (nm == r_globals.empty_str || nm == r_globals.na_str) {
+      continue;
+    }
+
+    bool dup = false;
+    if (p_seen) {
+      dup = !r_flat_dict_put(p_seen, nm, r_null);
+    } else {
+      for (r_ssize j = start; j != i; j += step) {
+        if (v_nms[j] == nm) {
+          dup = true;
+          break;
+        }
+      }
+    }
+
+    if (dup) {
+      if (dups == r_null) {
+        dups = KEEP_N(r_alloc_logical(n), &n_kept);
+        v_dups = r_lgl_begin(dups);
+        memset(v_dups, 0, n * sizeof(int));
+      }
+      v_dups[i] = true;
+    }
+  }
+
+  FREE(n_kept);
+  return dups;
+}
+
+r_obj* nms_are_duplicated(r_obj* nms, bool from_last) {
+  r_obj* dups = nms_which_duplicated(nms, from_last);
+  if (dups != r_null) {
+    return dups;
+  }
+
+  r_ssize n = r_length(nms);
+  dups = r_alloc_logical(n);
+  memset(r_lgl_begin(dups), 0, n * sizeof(int));
   return dups;
 }
 
@@ -210,4 +355,14 @@ void rlang_init_utils() {
 
   signal_soft_deprecated_call = r_parse("rlang:::signal_soft_deprecated(x, id = y, env = z)");
   r_preserve(signal_soft_deprecated_call);
+
+  p_deprecation_warned = r_new_str_dict(64);
+  r_preserve_global(p_deprecation_warned->shelter);
+
+  p_deprecation_soft_signalled = r_new_str_dict(64);
+  r_preserve_global(p_deprecation_soft_signalled->shelter);
+
+  sym_lifecycle_disable_warnings = r_sym("lifecycle_disable_warnings");
+  sym_lifecycle_repeat_warnings = r_sym("lifecycle_repeat_warnings");
+  sym_lifecycle_verbose_soft_deprecation = r_sym("lifecycle_verbose_soft_deprecation");
 }
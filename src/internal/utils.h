@@ -25,8 +25,16 @@ r_obj* r_nms_get(r_obj* nms, r_ssize i) {
   }
 }
 
+// Unnamed vectors have empty names of the same length. Large ones are
+// ALTREP vectors that are only materialised on demand.
+r_obj* rlang_new_empty_names(r_ssize n);
+bool rlang_is_empty_names(r_obj* x);
+
 r_obj* nms_are_duplicated(r_obj* nms, bool from_last);
 
+// Same but returns `NULL` when no name is duplicated
+r_obj* nms_which_duplicated(r_obj* nms, bool from_last);
+
 bool vec_find_first_duplicate(r_obj* x, r_obj* except, r_ssize* index);
 
 static inline
@@ -1,6 +1,22 @@
 #include <string.h>
 #include "rlang.h"
 
+#if defined(__SSE2__)
+# include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+#endif
+
+static void hex_encode(char* p_out, const unsigned char* p_x, r_ssize n);
+
+// Returns a value above 15 for invalid digits
+static inline
+unsigned int hex_value(unsigned char c) {
+  unsigned int digit = c - '0';
+  unsigned int alpha = (c | 0x20) - 'a';
+  return digit < 10 ? digit : (alpha < 6 ? alpha + 10 : 0x10);
+}
+
 r_obj* rlang_raw_deparse_str(r_obj* x, r_obj* prefix, r_obj* suffix) {
   if (r_typeof(x) != R_TYPE_raw) {
     r_abort("`x` must be a raw vector.");
@@ -36,13 +52,8 @@ r_obj* rlang_raw_deparse_str(r_obj* x, r_obj* prefix, r_obj* suffix) {
   memcpy(p_buf, s_prefix, len_prefix);
   p_buf += len_prefix;
 
-  const char* lookup = "0123456789abcdef";
-
-  for (r_ssize i = 0; i < len_data; ++i) {
-    unsigned char value = p_x[i];
-    *p_buf++ = lookup[value / 16];
-    *p_buf++ = lookup[value % 16];
-  }
+  hex_encode(p_buf, p_x, len_data);
+  p_buf += 2 * len_data;
 
   memcpy(p_buf, s_suffix, len_suffix);
   p_buf += len_suffix;
@@ -55,3 +66,110 @@ r_obj* rlang_raw_deparse_str(r_obj* x, r_obj* prefix, r_obj* suffix) {
   FREE(3);
   return(out);
 }
+
+r_obj* ffi_raw_parse_str(r_obj* x) {
+  if (!r_is_string(x)) {
+    r_abort("`x` must be a string.");
+  }
+
+  r_obj* str = r_chr_get(x, 0);
+  const unsigned char* p_str = (const unsigned char*) r_str_c_string(str);
+  r_ssize len = r_length(str);
+
+  if (len % 2) {
+    r_abort("`x` must have an even number of hexadecimal digits.");
+  }
+
+  r_ssize n = len / 2;
+  r_obj* out = KEEP(r_alloc_raw(n));
+  unsigned char* p_out = r_raw_begin(out);
+
+  // Invalid digits set a bit above the nibble. They are detected once
+  // at the end so the loop doesn't branch.
+  unsigned int invalid = 0;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    unsigned int hi = hex_value(p_str[2 * i]);
+    unsigned int lo = hex_value(p_str[2 * i + 1]);
+    invalid |= hi | lo;
+    p_out[i] = (unsigned char) ((hi << 4) | (lo & 0x0F));
+  }
+
+  if (invalid & ~0x0Fu) {
+    r_abort("`x` must only contain hexadecimal digits.");
+  }
+
+  FREE(1);
+  return out;
+}
+
+
+// Encoding ----------------------------------------------------------
+
+static const char hex_digits[] = "0123456789abcdef";
+
+static inline
+void hex_encode_scalar(char* p_out, const unsigned char* p_x, r_ssize n) {
+  for (r_ssize i = 0; i < n; ++i) {
+    unsigned char value = p_x[i];
+    *p_out++ = hex_digits[value >> 4];
+    *p_out++ = hex_digits[value & 0x0F];
+  }
+}
+
+#if defined(__SSE2__)
+
+// Maps nibbles to digits with arithmetic since SSE2 has no byte shuffle
+static inline
+__m128i hex_nibbles_sse2(__m128i nibbles) {
+  __m128i is_alpha = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  __m128i offset = _mm_and_si128(is_alpha, _mm_set1_epi8('a' - '0' - 10));
+  return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), offset);
+}
+
+static
+void hex_encode(char* p_out, const unsigned char* p_x, r_ssize n) {
+  const __m128i mask = _mm_set1_epi8(0x0F);
+  r_ssize i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*) (p_x + i));
+    __m128i hi = hex_nibbles_sse2(_mm_and_si128(_mm_srli_epi16(x, 4), mask));
+    __m128i lo = hex_nibbles_sse2(_mm_and_si128(x, mask));
+
+    _mm_storeu_si128((__m128i*) (p_out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i*) (p_out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+
+  hex_encode_scalar(p_out + 2 * i, p_x + i, n - i);
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+static
+void hex_encode(char* p_out, const unsigned char* p_x, r_ssize n) {
+  const uint8x16_t table = vld1q_u8((const uint8_t*) hex_digits);
+  const uint8x16_t mask = vdupq_n_u8(0x0F);
+  r_ssize i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t x = vld1q_u8(p_x + i);
+
+    // `vst2q_u8()` interleaves the high and low digits
+    uint8x16x2_t digits;
+    digits.val[0] = vqtbl1q_u8(table, vshrq_n_u8(x, 4));
+    digits.val[1] = vqtbl1q_u8(table, vandq_u8(x, mask));
+    vst2q_u8((uint8_t*) (p_out + 2 * i), digits);
+  }
+
+  hex_encode_scalar(p_out + 2 * i, p_x + i, n - i);
+}
+
+#else
+
+static
+void hex_encode(char* p_out, const unsigned char* p_x, r_ssize n) {
+  hex_encode_scalar(p_out, p_x, n);
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include <rlang.h>
+#include "vec.h"
 
 
 static
@@ -39,42 +40,415 @@ bool r_is_logical(r_obj* x, r_ssize n) {
   return r_typeof(x) == R_TYPE_logical && has_correct_length(x, n);
 }
 
-bool r_is_finite(r_obj* x) {
+// Numeric vectors are scanned by regions so that ALTREP vectors, like
+// compact sequences, are not materialised. Each region is checked
+// without branching so the compiler can vectorise the loop, and we
+// only bail out between regions, see `VEC_REGION_SIZE`.
+
+static inline
+const int* int_region(r_obj* x, r_ssize i, r_ssize n, int* buf) {
+#if R_HAS_ALTREP
+  if (ALTREP(x)) {
+    const int* p_x = (const int*) DATAPTR_OR_NULL(x);
+    if (p_x) {
+      return p_x + i;
+    }
+    INTEGER_GET_REGION(x, i, n, buf);
+    return buf;
+  }
+#endif
+  return r_int_cbegin(x) + i;
+}
+static inline
+const double* dbl_region(r_obj* x, r_ssize i, r_ssize n, double* buf) {
+#if R_HAS_ALTREP
+  if (ALTREP(x)) {
+    const double* p_x = (const double*) DATAPTR_OR_NULL(x);
+    if (p_x) {
+      return p_x + i;
+    }
+    REAL_GET_REGION(x, i, n, buf);
+    return buf;
+  }
+#endif
+  return r_dbl_cbegin(x) + i;
+}
+
+// Non-finite doubles are those with all exponent bits set
+#define DBL_EXP_MASK 0x7FF0000000000000ULL
+
+static inline
+bool dbl_is_finite(double x) {
+  uint64_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return (bits & DBL_EXP_MASK) != DBL_EXP_MASK;
+}
+
+// Allow integers up to 2^52, same as R_XLEN_T_MAX when long vector
+// support is enabled
+#define RLANG_MAX_DOUBLE_INT 4503599627370496
+
+// Region kernels. They only read `p_x` and can run on any thread.
+
+static inline
+int int_region_has_na(const int* p_x, r_ssize n, int na) {
+  int hit = 0;
+  for (r_ssize j = 0; j < n; ++j) {
+    hit |= p_x[j] == na;
+  }
+  return hit;
+}
+static inline
+int dbl_region_has_na(const double* p_x, r_ssize n) {
+  int hit = 0;
+  for (r_ssize j = 0; j < n; ++j) {
+    hit |= dbl_is_na(p_x[j]);
+  }
+  return hit;
+}
+static inline
+int cpl_region_has_na(const r_complex_t* p_x, r_ssize n) {
+  int hit = 0;
+  for (r_ssize j = 0; j < n; ++j) {
+    hit |= cpl_is_na(p_x[j]);
+  }
+  return hit;
+}
+static inline
+int dbl_region_has_non_finite(const double* p_x, r_ssize n) {
+  int hit = 0;
+  for (r_ssize j = 0; j < n; ++j) {
+    hit |= !dbl_is_finite(p_x[j]);
+  }
+  return hit;
+}
+static inline
+void dbl_region_integerish(const double* p_x,
+                           r_ssize n,
+                           int* p_non_finite,
+                           int* p_non_integerish) {
+  int non_finite = 0;
+  int non_integerish = 0;
+
+  for (r_ssize j = 0; j < n; ++j) {
+    double elt = p_x[j];
+    int elt_finite = dbl_is_finite(elt);
+
+    // `floor()` rather than a cast to `int_least64_t` because
+    // converting non-finite or out of range doubles to integers is
+    // undefined behaviour
+    non_finite |= !elt_finite;
+    non_integerish |= elt_finite & ((elt > RLANG_MAX_DOUBLE_INT) | (elt != floor(elt)));
+  }
+
+  *p_non_finite = non_finite;
+  *p_non_integerish = non_integerish;
+}
+
+
+// Very large vectors can be scanned by several OpenMP threads. This
+// is opt-in with the `rlang_vec_n_threads` global option, which is
+// only looked up for vectors above `VEC_PAR_MIN_SIZE`. Like the R-free
+// core (see `c-core.h`), the parallel loops only access data
+// pointers and never call the R API. ALTREP vectors without a data
+// pointer are scanned serially. Workers stop as soon as one of them
+// has found an element that determines the result.
+#define VEC_PAR_MIN_SIZE ((r_ssize) 1 << 20)
+
+int r_vec_n_threads(r_ssize n) {
+#ifdef _OPENMP
+  if (n < VEC_PAR_MIN_SIZE) {
+    return 1;
+  }
+
+  r_obj* opt = r_peek_option("rlang_vec_n_threads");
+  if (opt == r_null) {
+    return 1;
+  }
+
+  if (!r_is_integerish(opt, 1, true) || r_as_ssize(opt) < 1 || r_as_ssize(opt) > INT_MAX) {
+    r_abort("The `rlang_vec_n_threads` option must be a positive integer.");
+  }
+  return (int) r_as_ssize(opt);
+#else
+  return 1;
+#endif
+}
+
+static inline
+const int* int_data_or_null(r_obj* x) {
+#if R_HAS_ALTREP
+  if (ALTREP(x)) {
+    return (const int*) DATAPTR_OR_NULL(x);
+  }
+#endif
+  return r_int_cbegin(x);
+}
+static inline
+const double* dbl_data_or_null(r_obj* x) {
+#if R_HAS_ALTREP
+  if (ALTREP(x)) {
+    return (const double*) DATAPTR_OR_NULL(x);
+  }
+#endif
+  return r_dbl_cbegin(x);
+}
+
+bool int_has_na_par(const int* p_x, r_ssize n, int n_threads) {
+  int na = r_globals.na_int;
+  r_ssize n_regions = (n + VEC_REGION_SIZE - 1) / VEC_REGION_SIZE;
+  int stop = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize k = 0; k < n_regions; ++k) {
+    int stopped;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stopped = stop;
+    if (stopped) {
+      continue;
+    }
+
+    r_ssize i = k * VEC_REGION_SIZE;
+    if (int_region_has_na(p_x + i, r_ssize_min(n - i, VEC_REGION_SIZE), na)) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  return stop;
+}
+
+bool dbl_has_na_par(const double* p_x, r_ssize n, int n_threads) {
+  r_ssize n_regions = (n + VEC_REGION_SIZE - 1) / VEC_REGION_SIZE;
+  int stop = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize k = 0; k < n_regions; ++k) {
+    int stopped;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stopped = stop;
+    if (stopped) {
+      continue;
+    }
+
+    r_ssize i = k * VEC_REGION_SIZE;
+    if (dbl_region_has_na(p_x + i, r_ssize_min(n - i, VEC_REGION_SIZE))) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  return stop;
+}
+
+bool cpl_has_na_par(const r_complex_t* p_x, r_ssize n, int n_threads) {
+  r_ssize n_regions = (n + VEC_REGION_SIZE - 1) / VEC_REGION_SIZE;
+  int stop = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize k = 0; k < n_regions; ++k) {
+    int stopped;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stopped = stop;
+    if (stopped) {
+      continue;
+    }
+
+    r_ssize i = k * VEC_REGION_SIZE;
+    if (cpl_region_has_na(p_x + i, r_ssize_min(n - i, VEC_REGION_SIZE))) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  return stop;
+}
+
+static
+bool dbl_has_non_finite_par(const double* p_x, r_ssize n, int n_threads) {
+  r_ssize n_regions = (n + VEC_REGION_SIZE - 1) / VEC_REGION_SIZE;
+  int stop = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize k = 0; k < n_regions; ++k) {
+    int stopped;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stopped = stop;
+    if (stopped) {
+      continue;
+    }
+
+    r_ssize i = k * VEC_REGION_SIZE;
+    if (dbl_region_has_non_finite(p_x + i, r_ssize_min(n - i, VEC_REGION_SIZE))) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  return stop;
+}
+
+// Non-integerish elements always stop the workers. Non-finite elements
+// only stop them when `finite` is 1.
+static
+void dbl_integerish_par(const double* p_x,
+                        r_ssize n,
+                        int finite,
+                        int n_threads,
+                        int* p_non_finite,
+                        int* p_non_integerish) {
+  r_ssize n_regions = (n + VEC_REGION_SIZE - 1) / VEC_REGION_SIZE;
+  int stop = 0;
+  int any_non_finite = 0;
+  int any_non_integerish = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+#endif
+  for (r_ssize k = 0; k < n_regions; ++k) {
+    int stopped;
+#ifdef _OPENMP
+#pragma omp atomic read
+#endif
+    stopped = stop;
+    if (stopped) {
+      continue;
+    }
+
+    r_ssize i = k * VEC_REGION_SIZE;
+    int non_finite;
+    int non_integerish;
+    dbl_region_integerish(p_x + i, r_ssize_min(n - i, VEC_REGION_SIZE), &non_finite, &non_integerish);
+
+    if (non_finite) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      any_non_finite = 1;
+    }
+    if (non_integerish) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      any_non_integerish = 1;
+    }
+    if (non_integerish || (non_finite && finite == 1)) {
+#ifdef _OPENMP
+#pragma omp atomic write
+#endif
+      stop = 1;
+    }
+  }
+
+  *p_non_finite = any_non_finite;
+  *p_non_integerish = any_non_integerish;
+}
+
+
+static
+bool int_is_finite(r_obj* x) {
+#if R_HAS_ALTREP
+  if (INTEGER_NO_NA(x)) {
+    return true;
+  }
+#endif
+
   r_ssize n = r_length(x);
 
-  switch(r_typeof(x)) {
-  case R_TYPE_integer: {
-    const int* p_x = r_int_cbegin(x);
-    for (r_ssize i = 0; i < n; ++i) {
-      if (p_x[i] == r_globals.na_int) {
-        return false;
-      }
+  int n_threads = r_vec_n_threads(n);
+  const int* p_data = (n_threads > 1) ? int_data_or_null(x) : NULL;
+  if (p_data) {
+    return !int_has_na_par(p_data, n, n_threads);
+  }
+
+  int buf[VEC_REGION_SIZE];
+
+  for (r_ssize i = 0; i < n; i += VEC_REGION_SIZE) {
+    r_ssize n_region = r_ssize_min(n - i, VEC_REGION_SIZE);
+    const int* p_x = int_region(x, i, n_region, buf);
+
+    if (int_region_has_na(p_x, n_region, r_globals.na_int)) {
+      return false;
     }
-    break;
   }
-  case R_TYPE_double: {
-    const double* p_x = r_dbl_cbegin(x);
-    for (r_ssize i = 0; i < n; ++i) {
-      if (!isfinite(p_x[i])) {
-        return false;
-      }
+
+  return true;
+}
+
+static
+bool dbl_is_finite_vec(r_obj* x) {
+  r_ssize n = r_length(x);
+
+#if R_HAS_ALTREP
+  // Sorted vectors without NA or NaN are finite when their bounds are
+  if (n && REAL_NO_NA(x) && KNOWN_SORTED(REAL_IS_SORTED(x))) {
+    return dbl_is_finite(REAL_ELT(x, 0)) && dbl_is_finite(REAL_ELT(x, n - 1));
+  }
+#endif
+
+  int n_threads = r_vec_n_threads(n);
+  const double* p_data = (n_threads > 1) ? dbl_data_or_null(x) : NULL;
+  if (p_data) {
+    return !dbl_has_non_finite_par(p_data, n, n_threads);
+  }
+
+  double buf[VEC_REGION_SIZE];
+
+  for (r_ssize i = 0; i < n; i += VEC_REGION_SIZE) {
+    r_ssize n_region = r_ssize_min(n - i, VEC_REGION_SIZE);
+    const double* p_x = dbl_region(x, i, n_region, buf);
+
+    if (dbl_region_has_non_finite(p_x, n_region)) {
+      return false;
     }
-    break;
   }
+
+  return true;
+}
+
+bool r_is_finite(r_obj* x) {
+  switch(r_typeof(x)) {
+  case R_TYPE_integer:
+    return int_is_finite(x);
+  case R_TYPE_double:
+    return dbl_is_finite_vec(x);
   case R_TYPE_complex: {
+    r_ssize n = r_length(x);
     const r_complex_t* p_x = r_cpl_cbegin(x);
     for (r_ssize i = 0; i < n; ++i) {
       if (!isfinite(p_x[i].r) || !isfinite(p_x[i].i)) {
         return false;
       }
     }
-    break;
+    return true;
   }
   default:
     r_abort("Internal error: expected a numeric vector");
   }
-
-  return true;
 }
 bool r_is_integer(r_obj* x, r_ssize n, int finite) {
   if (r_typeof(x) != R_TYPE_integer || !has_correct_length(x, n)) {
@@ -104,10 +478,6 @@ bool r_is_complex(r_obj* x, r_ssize n, int finite) {
   return true;
 }
 
-// Allow integers up to 2^52, same as R_XLEN_T_MAX when long vector
-// support is enabled
-#define RLANG_MAX_DOUBLE_INT 4503599627370496
-
 bool r_is_integerish(r_obj* x, r_ssize n, int finite) {
   if (r_typeof(x) == R_TYPE_integer) {
     return r_is_integer(x, n, finite);
@@ -117,25 +487,40 @@ bool r_is_integerish(r_obj* x, r_ssize n, int finite) {
   }
 
   r_ssize actual_n = r_length(x);
-  const double* p_x = r_dbl_cbegin(x);
   bool actual_finite = true;
 
-  for (r_ssize i = 0; i < actual_n; ++i) {
-    double elt = p_x[i];
+  int n_threads = r_vec_n_threads(actual_n);
+  const double* p_data = (n_threads > 1) ? dbl_data_or_null(x) : NULL;
 
-    if (!isfinite(elt)) {
-      actual_finite = false;
-      continue;
-    }
+  if (p_data) {
+    int non_finite;
+    int non_integerish;
+    dbl_integerish_par(p_data, actual_n, finite, n_threads, &non_finite, &non_integerish);
 
-    if (elt > RLANG_MAX_DOUBLE_INT) {
+    if (non_integerish) {
       return false;
     }
+    actual_finite = !non_finite;
+  } else {
+    double buf[VEC_REGION_SIZE];
 
-    // C99 guarantees existence of the int_least_N_t types, even on
-    // machines that don't support arithmetic on width N:
-    if (elt != (int_least64_t) elt) {
-      return false;
+    for (r_ssize i = 0; i < actual_n; i += VEC_REGION_SIZE) {
+      r_ssize n_region = r_ssize_min(actual_n - i, VEC_REGION_SIZE);
+      const double* p_x = dbl_region(x, i, n_region, buf);
+
+      int non_finite;
+      int non_integerish;
+      dbl_region_integerish(p_x, n_region, &non_finite, &non_integerish);
+
+      if (non_integerish) {
+        return false;
+      }
+      if (non_finite) {
+        actual_finite = false;
+        if (finite == 1) {
+          return false;
+        }
+      }
     }
   }
 
@@ -146,7 +531,9 @@ bool r_is_integerish(r_obj* x, r_ssize n, int finite) {
   return true;
 }
 
+#undef VEC_PAR_MIN_SIZE
 #undef RLANG_MAX_DOUBLE_INT
+#undef DBL_EXP_MASK
 
 bool r_is_character(r_obj* x, r_ssize n) {
   return r_typeof(x) == R_TYPE_character && has_correct_length(x, n);
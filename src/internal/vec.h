@@ -1,6 +1,9 @@
 #ifndef RLANG_INTERNAL_VEC_H
 #define RLANG_INTERNAL_VEC_H
 
+#include <rlang.h>
+#include <string.h>
+
 
 bool r_is_vector(r_obj* x, r_ssize n);
 bool r_is_atomic(r_obj* x, r_ssize n);
@@ -14,6 +17,34 @@ bool r_is_complex(r_obj* x, r_ssize n, int finite);
 bool r_is_character(r_obj* x, r_ssize n);
 bool r_is_raw(r_obj* x, r_ssize n);
 
+// Number of threads for scanning `n` elements, see `rlang_vec_n_threads`
+int r_vec_n_threads(r_ssize n);
+
+// Number of elements scanned at once by the region kernels
+#define VEC_REGION_SIZE 512
+
+// Same as `rlang::is_na()`: doubles are missing when they are `NA`,
+// not when they are another `NaN`. Complex numbers are missing when
+// their real part is `NA`.
+static inline
+bool dbl_is_na(double x) {
+  uint64_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return
+    (bits & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL &&
+    (bits & 0x00000000FFFFFFFFULL) == 1954;
+}
+static inline
+bool cpl_is_na(r_complex_t x) {
+  return dbl_is_na(x.r);
+}
+
+// Scan data pointers on `n_threads` threads and stop all workers at
+// the first missing value
+bool int_has_na_par(const int* p_x, r_ssize n, int n_threads);
+bool dbl_has_na_par(const double* p_x, r_ssize n, int n_threads);
+bool cpl_has_na_par(const r_complex_t* p_x, r_ssize n, int n_threads);
+
 void r_vec_poke_coerce_n(r_obj* x, r_ssize offset,
                          r_obj* y, r_ssize from, r_ssize n);
 void r_vec_poke_coerce_range(r_obj* x, r_ssize offset,
@@ -13,5 +13,16 @@
 # define ALTREP(x) false
 #endif
 
+#if R_HAS_ALTREP
+# include <R_ext/Altrep.h>
+#endif
+
+// ALTREP lists were introduced in R 4.3.0
+#if R_VERSION >= R_Version(4, 3, 0)
+# define R_HAS_ALTLIST 1
+#else
+# define R_HAS_ALTLIST 0
+#endif
+
 
 #endif
@@ -0,0 +1,110 @@
+#ifndef RLANG_API_H
+#define RLANG_API_H
+
+/*
+ * Table of the C functions exported by the rlang package. Instead of
+ * one `R_GetCCallable()` lookup per function, retrieve the whole
+ * table once, typically from your init hook:
+ *
+ * ```
+ * static const struct r_api* p_rlang_api = NULL;
+ *
+ * p_rlang_api = r_peek_api();
+ * if (!p_rlang_api) {
+ *   // The table exported by rlang is incompatible
+ * }
+ * ```
+ *
+ * The lookup fails with an error when the installed rlang is
+ * too old to export the table.
+ *
+ * The table is owned by rlang and is valid as long as rlang is
+ * loaded.
+ *
+ * - `abi_version` is incremented when existing members change or when
+ *   the layout of the structs they take (such as `struct r_dict` or
+ *   `struct r_dyn_array`) changes. `r_peek_api()` returns `NULL` when
+ *   it doesn't match the `R_API_ABI_VERSION` the caller was compiled
+ *   with.
+ *
+ * - New members are only ever appended. `size` is the size of the
+ *   table exported by rlang and `features` advertises optional
+ *   capabilities, see `enum r_api_feature`. Check them with
+ *   `r_api_has()` before calling members that were added after the
+ *   first version of the table.
+ */
+
+#define R_API_ABI_VERSION 1
+
+enum r_api_feature {
+  R_API_FEATURE_dict_bulk = 1 << 0,
+  R_API_FEATURE_dyn_array_bulk = 1 << 1
+};
+
+struct r_api {
+  int abi_version;
+  size_t size;
+  uint64_t features;
+
+  // Dictionaries
+  struct r_dict* (*new_dict)(r_ssize size);
+  bool (*dict_put)(struct r_dict* p_dict, r_obj* key, r_obj* value);
+  bool (*dict_del)(struct r_dict* p_dict, r_obj* key);
+  bool (*dict_has)(struct r_dict* p_dict, r_obj* key);
+  r_obj* (*dict_get0)(struct r_dict* p_dict, r_obj* key);
+  r_obj* (*dict_put_n)(struct r_dict* p_dict, r_obj* keys, r_obj* values);
+  r_obj* (*dict_get_n)(struct r_dict* p_dict, r_obj* keys);
+
+  // Dynamic arrays
+  struct r_dyn_array* (*new_dyn_vector)(enum r_type type, r_ssize capacity);
+  struct r_dyn_array* (*new_dyn_array)(r_ssize elt_byte_size, r_ssize capacity);
+  void (*arr_push_back)(struct r_dyn_array* p_arr, const void* p_elt);
+  void (*arr_push_back_n)(struct r_dyn_array* p_arr, const void* p_elts, r_ssize n);
+  void (*arr_reserve)(struct r_dyn_array* p_arr, r_ssize capacity);
+  r_obj* (*arr_unwrap)(struct r_dyn_array* p_arr);
+
+  // Hashing
+  uint64_t (*xxh3_64bits)(const void* p_data, size_t n);
+  r_obj* (*hasher_new)(r_obj* method);
+  r_obj* (*hasher_update)(r_obj* hasher, r_obj* x);
+  r_obj* (*hasher_digest)(r_obj* hasher, r_obj* format);
+
+  // Environments
+  r_obj* (*alloc_environment)(r_ssize size, r_obj* parent);
+  r_obj* (*env_clone)(r_obj* env, r_obj* parent);
+  void (*env_poke_lazy)(r_obj* env, r_obj* sym, r_obj* expr, r_obj* eval_env);
+  bool (*env_inherits)(r_obj* env, r_obj* ancestor, r_obj* top);
+
+  // Evaluation
+  r_obj* (*eval_with_x)(r_obj* call, r_obj* x, r_obj* parent);
+  r_obj* (*eval_with_xy)(r_obj* call, r_obj* x, r_obj* y, r_obj* parent);
+  r_obj* (*eval_tidy)(r_obj* expr, r_obj* data, r_obj* env);
+  r_obj* (*as_function)(r_obj* x, const char* arg);
+
+  // Quosures
+  r_obj* (*new_quosure)(r_obj* expr, r_obj* env);
+  bool (*is_quosure)(r_obj* x);
+  r_obj* (*quo_get_expr)(r_obj* quo);
+  r_obj* (*quo_get_env)(r_obj* quo);
+};
+
+// Returns `NULL` if the table exported by rlang isn't compatible with
+// `R_API_ABI_VERSION`
+static inline
+const struct r_api* r_peek_api(void) {
+  r_void_fn get = r_peek_c_callable("rlang", "rlang_api");
+  const struct r_api* p_api = ((const struct r_api* (*)(void)) get)();
+
+  if (p_api->abi_version != R_API_ABI_VERSION) {
+    return NULL;
+  }
+  return p_api;
+}
+
+static inline
+bool r_api_has(const struct r_api* p_api, enum r_api_feature feature) {
+  return p_api->features & (uint64_t) feature;
+}
+
+
+#endif
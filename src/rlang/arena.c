@@ -0,0 +1,108 @@
+#include <rlang.h>
+#include "arena.h"
+
+#define R_ARENA_ALIGN sizeof(double)
+
+enum arena_shelter_locs {
+  ARENA_SHELTER_LOCS_raw = 0,
+  ARENA_SHELTER_LOCS_first_block,
+  ARENA_SHELTER_LOCS_blocks,
+  ARENA_SHELTER_SIZE
+};
+
+static inline
+r_ssize arena_align(r_ssize size) {
+  return (size + (R_ARENA_ALIGN - 1)) & ~((r_ssize) R_ARENA_ALIGN - 1);
+}
+
+struct r_arena* r_new_arena(r_ssize size) {
+  if (size <= 0) {
+    r_abort("`size` of arena must be positive.");
+  }
+  size = arena_align(size);
+
+  r_obj* shelter = KEEP(r_alloc_list(ARENA_SHELTER_SIZE));
+
+  r_obj* arena_raw = r_alloc_raw0(sizeof(struct r_arena));
+  r_list_poke(shelter, ARENA_SHELTER_LOCS_raw, arena_raw);
+
+  r_obj* block = r_alloc_raw(size);
+  r_list_poke(shelter, ARENA_SHELTER_LOCS_first_block, block);
+
+  struct r_arena* p_arena = r_raw_begin(arena_raw);
+  p_arena->shelter = shelter;
+  p_arena->v_first_block = r_raw_begin(block);
+  p_arena->first_block_size = size;
+
+  r_arena_release(p_arena);
+
+  FREE(1);
+  return p_arena;
+}
+
+void r_arena_release(struct r_arena* p_arena) {
+  r_list_poke(p_arena->shelter, ARENA_SHELTER_LOCS_blocks, r_null);
+
+  p_arena->v_block = p_arena->v_first_block;
+  p_arena->block_size = p_arena->first_block_size;
+  p_arena->used = 0;
+  p_arena->p_last = NULL;
+}
+
+// Additional blocks are at least as large as the first one. Large
+// requests get a block of their own.
+static
+void arena_push_block(struct r_arena* p_arena, r_ssize size) {
+  size = r_ssize_max(size, p_arena->first_block_size);
+
+  r_obj* block = KEEP(r_alloc_raw(size));
+
+  r_obj* blocks = r_list_get(p_arena->shelter, ARENA_SHELTER_LOCS_blocks);
+  blocks = r_new_node(block, blocks);
+  r_list_poke(p_arena->shelter, ARENA_SHELTER_LOCS_blocks, blocks);
+
+  p_arena->v_block = r_raw_begin(block);
+  p_arena->block_size = size;
+  p_arena->used = 0;
+
+  FREE(1);
+}
+
+void* r_arena_alloc(struct r_arena* p_arena, r_ssize size) {
+  if (size < 0) {
+    r_stop_internal("r_arena_alloc", "Can't allocate a negative size.");
+  }
+  size = arena_align(size);
+
+  if (size > p_arena->block_size - p_arena->used) {
+    arena_push_block(p_arena, size);
+  }
+
+  void* out = p_arena->v_block + p_arena->used;
+  p_arena->used += size;
+  p_arena->p_last = out;
+
+  return out;
+}
+
+void* r_arena_realloc(struct r_arena* p_arena,
+                      void* p,
+                      r_ssize old_size,
+                      r_ssize new_size) {
+  if (p && p == p_arena->p_last) {
+    r_ssize offset = (unsigned char*) p - p_arena->v_block;
+    r_ssize size = arena_align(new_size);
+
+    if (size <= p_arena->block_size - offset) {
+      p_arena->used = offset + size;
+      return p;
+    }
+  }
+
+  void* out = r_arena_alloc(p_arena, new_size);
+  if (p) {
+    memcpy(out, p, r_ssize_min(old_size, new_size));
+  }
+
+  return out;
+}
@@ -0,0 +1,43 @@
+#ifndef RLANG_ARENA_H
+#define RLANG_ARENA_H
+
+/**
+ * An arena hands out memory for non-SEXP payloads from large raw
+ * blocks by bumping a pointer. The blocks are owned by the arena's
+ * shelter, so everything allocated from an arena is released at once
+ * when the shelter is no longer protected, or explicitly with
+ * `r_arena_release()`.
+ *
+ * Memory returned by the arena is aligned for doubles. The arena must
+ * not be used to store `r_obj*` that aren't protected by other means.
+ */
+
+struct r_arena {
+  r_obj* shelter;
+
+  /* private: */
+  unsigned char* v_block;
+  r_ssize block_size;
+  r_ssize used;
+
+  unsigned char* v_first_block;
+  r_ssize first_block_size;
+
+  // The last allocation can be grown in place
+  void* p_last;
+};
+
+struct r_arena* r_new_arena(r_ssize size);
+
+void* r_arena_alloc(struct r_arena* p_arena, r_ssize size);
+void* r_arena_realloc(struct r_arena* p_arena,
+                      void* p,
+                      r_ssize old_size,
+                      r_ssize new_size);
+
+// Invalidates all allocations. The first block is kept and reused by
+// subsequent allocations, other blocks are released to the GC.
+void r_arena_release(struct r_arena* p_arena);
+
+
+#endif
@@ -15,39 +15,37 @@ r_obj* r_attrib_push(r_obj* x, r_obj* tag, r_obj* value) {
  *   but returns tail node
  */
 r_obj* r_pairlist_clone_until(r_obj* node, r_obj* sentinel, r_obj** parent_out) {
-  r_obj* parent = r_null;
-  r_obj* cur = node;
-  int n_kept = 0;
-
-  while (true) {
-    if (cur == sentinel) {
-      FREE(n_kept);
-      *parent_out = parent;
-      return node;
-    }
+  // Count the nodes to clone so they can be allocated at once
+  r_ssize n = 0;
+  for (r_obj* cur = node; cur != sentinel; cur = r_node_cdr(cur)) {
     // Return NULL if sentinel is not found
     if (cur == r_null) {
-      FREE(n_kept);
       *parent_out = r_null;
       return r_null;
     }
+    ++n;
+  }
 
-    r_obj* tag = r_node_tag(cur);
-    cur = r_new_node(r_node_car(cur), r_node_cdr(cur));
-    r_node_poke_tag(cur, tag);
+  if (n == 0) {
+    *parent_out = r_null;
+    return node;
+  }
 
-    if (parent == r_null) {
-      KEEP_N(cur, &n_kept);
-      node = cur;
-    } else {
-      r_node_poke_cdr(parent, cur);
-    }
+  r_obj* out = KEEP(r_alloc_pairlist(n));
+  r_obj* parent = r_null;
+  r_obj* out_node = out;
 
-    parent = cur;
-    cur = r_node_cdr(cur);
+  for (r_obj* cur = node; cur != sentinel; cur = r_node_cdr(cur)) {
+    r_node_poke_car(out_node, r_node_car(cur));
+    r_node_poke_tag(out_node, r_node_tag(cur));
+    parent = out_node;
+    out_node = r_node_cdr(out_node);
   }
+  r_node_poke_cdr(parent, sentinel);
 
-  r_stop_unreached("r_pairlist_clone_until");
+  FREE(1);
+  *parent_out = parent;
+  return out;
 }
 
 
@@ -90,33 +88,100 @@ r_obj* r_clone2(r_obj* x) {
 }
 
 r_obj* r_attrib_set(r_obj* x, r_obj* tag, r_obj* value) {
-  r_obj* attrs = r_attrib(x);
-  r_obj* out = KEEP(r_clone2(x));
+  return r_attrib_set_n(x, &tag, &value, 1);
+}
+
+// Sharing of pairlist nodes is only tracked with reference counting.
+// With NAMED, a node can be part of the attributes of several objects
+// without being marked.
+#define ATTRIB_HAS_REFCNT (R_VERSION >= R_Version(4, 0, 0))
+
+// Whether `x` and its attributes are referenced nowhere else, so
+// that they can be updated in place, e.g. when `x` was just allocated
+static
+bool attrib_is_owned(r_obj* x) {
+#if ATTRIB_HAS_REFCNT
+  if (!NO_REFERENCES(x)) {
+    return false;
+  }
+  for (r_obj* node = r_attrib(x); node != r_null; node = r_node_cdr(node)) {
+    if (MAYBE_SHARED(node)) {
+      return false;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+static
+bool attrib_tags_has(r_obj* const * v_tags, r_ssize n, r_obj* tag) {
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_tags[i] == tag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Assumes the attributes of `x` are not shared up to the node of `tag`
+static
+void attrib_poke_owned(r_obj* x, r_obj* tag, r_obj* value) {
+  r_obj* parent = r_null;
+  r_obj* node = r_attrib(x);
 
-  r_obj* node = attrs;
   while (node != r_null) {
     if (r_node_tag(node) == tag) {
-      if (value == r_null) {
-        attrs = r_attrs_zap_at(attrs, node, value);
+      if (value != r_null) {
+        r_node_poke_car(node, value);
+      } else if (parent == r_null) {
+        r_poke_attrib(x, r_node_cdr(node));
       } else {
-        attrs = r_attrs_set_at(attrs, node, value);
+        r_node_poke_cdr(parent, r_node_cdr(node));
       }
-      r_poke_attrib(out, attrs);
-
-      FREE(1);
-      return out;
+      return;
     }
 
+    parent = node;
     node = r_node_cdr(node);
   }
 
   if (value != r_null) {
     // Just add to the front if attribute does not exist yet
-    attrs = KEEP(r_new_node(out, attrs));
-    r_node_poke_tag(attrs, tag);
-    r_node_poke_car(attrs, value);
-    r_poke_attrib(out, attrs);
-    FREE(1);
+    r_poke_attrib(x, r_new_node3(value, r_attrib(x), tag));
+  }
+}
+
+r_obj* r_attrib_set_n(r_obj* x,
+                      r_obj* const * v_tags,
+                      r_obj* const * v_values,
+                      r_ssize n) {
+  if (attrib_is_owned(x)) {
+    for (r_ssize i = 0; i < n; ++i) {
+      attrib_poke_owned(x, v_tags[i], v_values[i]);
+    }
+    return x;
+  }
+
+  r_obj* out = KEEP(r_clone2(x));
+  r_obj* attrs = r_attrib(out);
+
+  // Clone the nodes up to the last one that is modified, once for all
+  // attributes. The nodes after it stay shared with `x`.
+  r_obj* last = r_null;
+  for (r_obj* node = attrs; node != r_null; node = r_node_cdr(node)) {
+    if (attrib_tags_has(v_tags, n, r_node_tag(node))) {
+      last = node;
+    }
+  }
+  if (last != r_null) {
+    r_obj* tail = r_null;
+    r_poke_attrib(out, r_pairlist_clone_until(attrs, r_node_cdr(last), &tail));
+  }
+
+  for (r_ssize i = 0; i < n; ++i) {
+    attrib_poke_owned(out, v_tags[i], v_values[i]);
   }
 
   FREE(1);
@@ -159,7 +224,7 @@ bool r_is_named(r_obj* x) {
     return false;
   }
 
-  if (r_chr_has(nms, "")) {
+  if (r_chr_detect_str(nms, r_globals.empty_str) >= 0) {
     return false;
   }
 
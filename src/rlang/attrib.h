@@ -27,7 +27,16 @@ void r_attrib_poke(r_obj* x, r_obj* sym, r_obj* value) {
 }
 
 r_obj* r_attrib_push(r_obj* x, r_obj* tag, r_obj* value);
+// Copy-on-write setters. A `NULL` value removes the attribute. `x` is
+// updated in place if neither `x` nor its attribute nodes are
+// referenced. Otherwise a shallow copy is returned in which only the
+// attribute nodes up to the last modified one are cloned. Prefer the
+// `_n` variant to set several attributes at once.
 r_obj* r_attrib_set(r_obj* x, r_obj* tag, r_obj* value);
+r_obj* r_attrib_set_n(r_obj* x,
+                      r_obj* const * v_tags,
+                      r_obj* const * v_values,
+                      r_ssize n);
 
 static inline
 r_obj* r_class(r_obj* x) {
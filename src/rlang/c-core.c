@@ -0,0 +1,474 @@
+#include <rlang.h>
+#include "c-core.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Nothing in this file may call into R, except the conversion
+// functions at the end
+
+
+static inline
+bool c_core_mult(r_ssize x, r_ssize y, r_ssize* p_out) {
+  if (x < 0 || y < 0 || (y && x > R_SSIZE_MAX / y)) {
+    return false;
+  }
+  *p_out = x * y;
+  return true;
+}
+
+// Dynamic arrays --------------------------------------------------
+
+bool r_c_array_init(struct r_c_array* p_arr,
+                    r_ssize elt_byte_size,
+                    r_ssize capacity) {
+  p_arr->v_data = NULL;
+  p_arr->count = 0;
+  p_arr->capacity = 0;
+  p_arr->elt_byte_size = elt_byte_size;
+
+  if (elt_byte_size <= 0) {
+    return false;
+  }
+  return r_c_array_reserve(p_arr, capacity);
+}
+
+void r_c_array_free(struct r_c_array* p_arr) {
+  free(p_arr->v_data);
+  p_arr->v_data = NULL;
+  p_arr->count = 0;
+  p_arr->capacity = 0;
+}
+
+bool r_c_array_reserve(struct r_c_array* p_arr, r_ssize capacity) {
+  if (capacity <= p_arr->capacity) {
+    return true;
+  }
+
+  r_ssize n_bytes;
+  if (!c_core_mult(capacity, p_arr->elt_byte_size, &n_bytes) ||
+      (uintmax_t) n_bytes > SIZE_MAX) {
+    return false;
+  }
+
+  void* v_data = realloc(p_arr->v_data, n_bytes);
+  if (!v_data) {
+    return false;
+  }
+
+  p_arr->v_data = v_data;
+  p_arr->capacity = capacity;
+  return true;
+}
+
+bool r_c_array_push_back_n(struct r_c_array* p_arr,
+                           const void* p_elts,
+                           r_ssize n) {
+  if (n < 0 || n > R_SSIZE_MAX - p_arr->count) {
+    return false;
+  }
+
+  r_ssize count = p_arr->count + n;
+
+  if (count > p_arr->capacity) {
+    r_ssize capacity = p_arr->capacity < R_SSIZE_MAX / 2 ? p_arr->capacity * 2 : R_SSIZE_MAX;
+    if (capacity < count) {
+      capacity = count;
+    }
+    if (!r_c_array_reserve(p_arr, capacity)) {
+      return false;
+    }
+  }
+
+  void* p_dest = r_c_array_ptr(p_arr, p_arr->count);
+  size_t n_bytes = (size_t) n * p_arr->elt_byte_size;
+
+  if (p_elts) {
+    memcpy(p_dest, p_elts, n_bytes);
+  } else {
+    memset(p_dest, 0, n_bytes);
+  }
+
+  p_arr->count = count;
+  return true;
+}
+
+
+// Hashing ---------------------------------------------------------
+
+uint64_t r_c_hash(const void* p_data, size_t n) {
+  return r_xxh3_64bits(p_data, n);
+}
+uint64_t r_c_hash_str(const char* str) {
+  return r_xxh3_64bits(str, strlen(str));
+}
+
+
+// Hash maps -------------------------------------------------------
+
+#define C_DICT_MIN_SLOTS 8
+
+// A zero hash marks an empty slot
+static inline
+uint64_t c_dict_hash(uint64_t hash) {
+  return hash ? hash : 1;
+}
+
+static
+bool c_dict_alloc_slots(struct r_c_dict* p_dict, r_ssize n_slots) {
+  bool str = p_dict->key_type == R_C_DICT_KEY_str;
+
+  uint64_t* v_hashes = calloc(n_slots, sizeof(uint64_t));
+  uint64_t* v_keys = malloc(n_slots * sizeof(uint64_t));
+  r_ssize* v_key_sizes = str ? malloc(n_slots * sizeof(r_ssize)) : NULL;
+  r_ssize* v_values = malloc(n_slots * sizeof(r_ssize));
+
+  if (!v_hashes || !v_keys || (str && !v_key_sizes) || !v_values) {
+    free(v_hashes);
+    free(v_keys);
+    free(v_key_sizes);
+    free(v_values);
+    return false;
+  }
+
+  p_dict->n_slots = n_slots;
+  p_dict->v_hashes = v_hashes;
+  p_dict->v_keys = v_keys;
+  p_dict->v_key_sizes = v_key_sizes;
+  p_dict->v_values = v_values;
+  return true;
+}
+
+bool r_c_dict_init(struct r_c_dict* p_dict,
+                   enum r_c_dict_key key_type,
+                   r_ssize size) {
+  p_dict->key_type = key_type;
+  p_dict->n_entries = 0;
+  p_dict->n_slots = 0;
+  p_dict->v_hashes = NULL;
+  p_dict->v_keys = NULL;
+  p_dict->v_key_sizes = NULL;
+  p_dict->v_values = NULL;
+
+  if (!r_c_array_init(&p_dict->strings, 1, 0)) {
+    return false;
+  }
+
+  // Power of two that keeps the load factor below 1/2
+  r_ssize n_slots = C_DICT_MIN_SLOTS;
+  while (n_slots / 2 < size) {
+    if (n_slots > R_SSIZE_MAX / 2 / (r_ssize) sizeof(uint64_t)) {
+      return false;
+    }
+    n_slots *= 2;
+  }
+
+  return c_dict_alloc_slots(p_dict, n_slots);
+}
+
+void r_c_dict_free(struct r_c_dict* p_dict) {
+  free(p_dict->v_hashes);
+  free(p_dict->v_keys);
+  free(p_dict->v_key_sizes);
+  free(p_dict->v_values);
+  r_c_array_free(&p_dict->strings);
+
+  p_dict->v_hashes = NULL;
+  p_dict->v_keys = NULL;
+  p_dict->v_key_sizes = NULL;
+  p_dict->v_values = NULL;
+  p_dict->n_slots = 0;
+  p_dict->n_entries = 0;
+}
+
+static
+bool c_dict_grow(struct r_c_dict* p_dict) {
+  if (p_dict->n_slots > R_SSIZE_MAX / 2 / (r_ssize) sizeof(uint64_t)) {
+    return false;
+  }
+
+  struct r_c_dict old = *p_dict;
+  if (!c_dict_alloc_slots(p_dict, old.n_slots * 2)) {
+    *p_dict = old;
+    return false;
+  }
+
+  // Hashes are stored so entries are moved without rehashing
+  uint64_t mask = p_dict->n_slots - 1;
+
+  for (r_ssize i = 0; i < old.n_slots; ++i) {
+    uint64_t hash = old.v_hashes[i];
+    if (!hash) {
+      continue;
+    }
+
+    uint64_t j = hash & mask;
+    while (p_dict->v_hashes[j]) {
+      j = (j + 1) & mask;
+    }
+
+    p_dict->v_hashes[j] = hash;
+    p_dict->v_keys[j] = old.v_keys[i];
+    p_dict->v_values[j] = old.v_values[i];
+    if (old.v_key_sizes) {
+      p_dict->v_key_sizes[j] = old.v_key_sizes[i];
+    }
+  }
+
+  free(old.v_hashes);
+  free(old.v_keys);
+  free(old.v_key_sizes);
+  free(old.v_values);
+  return true;
+}
+
+struct c_dict_key {
+  uint64_t hash;
+  uint64_t bits;
+  const char* str;
+  r_ssize n;
+};
+
+static inline
+struct c_dict_key c_dict_key_bits(uint64_t bits) {
+  return (struct c_dict_key) {
+    .hash = c_dict_hash(r_xxh3_64bits(&bits, sizeof(uint64_t))),
+    .bits = bits,
+    .str = NULL,
+    .n = 0
+  };
+}
+static inline
+struct c_dict_key c_dict_key_str(const char* str, r_ssize n) {
+  return (struct c_dict_key) {
+    .hash = c_dict_hash(r_xxh3_64bits(str, n)),
+    .bits = 0,
+    .str = str,
+    .n = n
+  };
+}
+
+static inline
+bool c_dict_key_equal(struct r_c_dict* p_dict, r_ssize i, struct c_dict_key key) {
+  if (p_dict->v_hashes[i] != key.hash) {
+    return false;
+  }
+  if (!key.str) {
+    return p_dict->v_keys[i] == key.bits;
+  }
+
+  const char* str = r_c_array_ptr(&p_dict->strings, p_dict->v_keys[i]);
+  return p_dict->v_key_sizes[i] == key.n && memcmp(str, key.str, key.n) == 0;
+}
+
+// Returns the slot of `key` or the empty slot where it would be
+// inserted
+static
+r_ssize c_dict_probe(struct r_c_dict* p_dict, struct c_dict_key key, bool* p_found) {
+  uint64_t mask = p_dict->n_slots - 1;
+  uint64_t i = key.hash & mask;
+
+  while (p_dict->v_hashes[i]) {
+    if (c_dict_key_equal(p_dict, i, key)) {
+      *p_found = true;
+      return i;
+    }
+    i = (i + 1) & mask;
+  }
+
+  *p_found = false;
+  return i;
+}
+
+static
+r_ssize* c_dict_emplace(struct r_c_dict* p_dict, struct c_dict_key key, bool* p_inserted) {
+  bool found;
+  r_ssize i = c_dict_probe(p_dict, key, &found);
+
+  if (p_inserted) {
+    *p_inserted = !found;
+  }
+  if (found) {
+    return &p_dict->v_values[i];
+  }
+
+  if ((p_dict->n_entries + 1) * 2 > p_dict->n_slots) {
+    if (!c_dict_grow(p_dict)) {
+      return NULL;
+    }
+    i = c_dict_probe(p_dict, key, &found);
+  }
+
+  uint64_t bits = key.bits;
+  if (key.str) {
+    bits = p_dict->strings.count;
+    if (!r_c_array_push_back_n(&p_dict->strings, key.str, key.n)) {
+      return NULL;
+    }
+    p_dict->v_key_sizes[i] = key.n;
+  }
+
+  p_dict->v_hashes[i] = key.hash;
+  p_dict->v_keys[i] = bits;
+  p_dict->v_values[i] = 0;
+  ++p_dict->n_entries;
+
+  return &p_dict->v_values[i];
+}
+
+static
+r_ssize* c_dict_find(struct r_c_dict* p_dict, struct c_dict_key key) {
+  bool found;
+  r_ssize i = c_dict_probe(p_dict, key, &found);
+  return found ? &p_dict->v_values[i] : NULL;
+}
+
+// Backward shift deletion keeps probe sequences contiguous without
+// tombstones
+static
+bool c_dict_del(struct r_c_dict* p_dict, struct c_dict_key key) {
+  bool found;
+  uint64_t i = c_dict_probe(p_dict, key, &found);
+  if (!found) {
+    return false;
+  }
+
+  uint64_t mask = p_dict->n_slots - 1;
+  uint64_t j = i;
+
+  while (true) {
+    j = (j + 1) & mask;
+
+    uint64_t hash = p_dict->v_hashes[j];
+    if (!hash) {
+      break;
+    }
+
+    // Move the entry at `j` to the hole unless its home slot lies
+    // cyclically in `(i, j]`
+    uint64_t home = hash & mask;
+    bool stays = (i < j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (stays) {
+      continue;
+    }
+
+    p_dict->v_hashes[i] = hash;
+    p_dict->v_keys[i] = p_dict->v_keys[j];
+    p_dict->v_values[i] = p_dict->v_values[j];
+    if (p_dict->v_key_sizes) {
+      p_dict->v_key_sizes[i] = p_dict->v_key_sizes[j];
+    }
+    i = j;
+  }
+
+  p_dict->v_hashes[i] = 0;
+  --p_dict->n_entries;
+  return true;
+}
+
+r_ssize* r_c_dict_emplace_ptr(struct r_c_dict* p_dict, const void* key, bool* p_inserted) {
+  return c_dict_emplace(p_dict, c_dict_key_bits((uintptr_t) key), p_inserted);
+}
+r_ssize* r_c_dict_emplace_int(struct r_c_dict* p_dict, int64_t key, bool* p_inserted) {
+  return c_dict_emplace(p_dict, c_dict_key_bits((uint64_t) key), p_inserted);
+}
+r_ssize* r_c_dict_emplace_str(struct r_c_dict* p_dict, const char* key, r_ssize n, bool* p_inserted) {
+  return c_dict_emplace(p_dict, c_dict_key_str(key, n), p_inserted);
+}
+
+r_ssize* r_c_dict_find_ptr(struct r_c_dict* p_dict, const void* key) {
+  return c_dict_find(p_dict, c_dict_key_bits((uintptr_t) key));
+}
+r_ssize* r_c_dict_find_int(struct r_c_dict* p_dict, int64_t key) {
+  return c_dict_find(p_dict, c_dict_key_bits((uint64_t) key));
+}
+r_ssize* r_c_dict_find_str(struct r_c_dict* p_dict, const char* key, r_ssize n) {
+  return c_dict_find(p_dict, c_dict_key_str(key, n));
+}
+
+bool r_c_dict_del_ptr(struct r_c_dict* p_dict, const void* key) {
+  return c_dict_del(p_dict, c_dict_key_bits((uintptr_t) key));
+}
+bool r_c_dict_del_int(struct r_c_dict* p_dict, int64_t key) {
+  return c_dict_del(p_dict, c_dict_key_bits((uint64_t) key));
+}
+bool r_c_dict_del_str(struct r_c_dict* p_dict, const char* key, r_ssize n) {
+  return c_dict_del(p_dict, c_dict_key_str(key, n));
+}
+
+
+// Conversion to R objects -----------------------------------------
+
+r_obj* r_c_array_as_vector(struct r_c_array* p_arr, enum r_type type) {
+  if (r_vec_elt_sizeof0(type) != p_arr->elt_byte_size ||
+      type == R_TYPE_character ||
+      type == R_TYPE_list) {
+    r_stop_internal("r_c_array_as_vector",
+                    "Can't convert elements of %d bytes to a vector of type `%s`.",
+                    (int) p_arr->elt_byte_size,
+                    r_type_as_c_string(type));
+  }
+
+  r_ssize n = p_arr->count;
+  r_obj* out = r_alloc_vector(type, n);
+
+  if (n) {
+    memcpy(r_vec_begin0(type, out), p_arr->v_data, n * p_arr->elt_byte_size);
+  }
+  return out;
+}
+
+r_obj* r_c_dict_keys(struct r_c_dict* p_dict) {
+  r_ssize n_slots = p_dict->n_slots;
+  const uint64_t* v_hashes = p_dict->v_hashes;
+  const uint64_t* v_keys = p_dict->v_keys;
+
+  switch (p_dict->key_type) {
+  case R_C_DICT_KEY_str: {
+    r_obj* out = KEEP(r_alloc_character(p_dict->n_entries));
+
+    for (r_ssize i = 0, j = 0; i < n_slots; ++i) {
+      if (!v_hashes[i]) {
+        continue;
+      }
+      const char* str = r_c_array_ptr(&p_dict->strings, v_keys[i]);
+      r_ssize n = p_dict->v_key_sizes[i];
+      if (n > INT_MAX) {
+        r_abort("Can't convert a key of more than %d bytes to a string.", INT_MAX);
+      }
+      r_chr_poke(out, j++, Rf_mkCharLenCE(str, (int) n, CE_UTF8));
+    }
+
+    FREE(1);
+    return out;
+  }
+
+  case R_C_DICT_KEY_int: {
+    r_obj* out = r_alloc_double(p_dict->n_entries);
+    double* v_out = r_dbl_begin(out);
+
+    for (r_ssize i = 0, j = 0; i < n_slots; ++i) {
+      if (v_hashes[i]) {
+        v_out[j++] = (double) (int64_t) v_keys[i];
+      }
+    }
+    return out;
+  }
+
+  case R_C_DICT_KEY_ptr:
+  default:
+    r_stop_internal("r_c_dict_keys", "Can't convert pointer keys to R.");
+  }
+}
+
+r_obj* r_c_dict_values(struct r_c_dict* p_dict) {
+  r_obj* out = r_alloc_double(p_dict->n_entries);
+  double* v_out = r_dbl_begin(out);
+
+  for (r_ssize i = 0, j = 0; i < p_dict->n_slots; ++i) {
+    if (p_dict->v_hashes[i]) {
+      v_out[j++] = (double) p_dict->v_values[i];
+    }
+  }
+  return out;
+}
@@ -0,0 +1,149 @@
+#ifndef RLANG_C_CORE_H
+#define RLANG_C_CORE_H
+
+#include <stdint.h>
+
+
+/*
+ * Growable arrays, hash maps and hashing that don't use the R API.
+ * Their memory is allocated with `malloc()` and they can be used from
+ * threads other than the main R thread, e.g. from worker threads of
+ * an OpenMP or RcppParallel loop.
+ *
+ * - The structs are owned by the caller, who typically allocates
+ *   them on the stack, and must be released with the corresponding
+ *   `_free()` function.
+ *
+ * - Functions that allocate return `false` (or `NULL`) when memory
+ *   can't be allocated and leave their input unchanged. They never
+ *   longjump.
+ *
+ * - Objects are not synchronised. Use one object per thread or
+ *   protect them with a lock.
+ *
+ * - The conversion functions to R objects must be called from the
+ *   main thread. They may longjump, in which case the C objects are
+ *   left intact and must still be freed.
+ *
+ * Hashing uses the XXH3 function registered by rlang. The library
+ * must have been initialised with `r_init_library()` on the main
+ * thread.
+ */
+
+
+// Dynamic arrays --------------------------------------------------
+
+struct r_c_array {
+  void* v_data;
+  r_ssize count;
+  r_ssize capacity;
+  r_ssize elt_byte_size;
+};
+
+bool r_c_array_init(struct r_c_array* p_arr,
+                    r_ssize elt_byte_size,
+                    r_ssize capacity);
+void r_c_array_free(struct r_c_array* p_arr);
+
+bool r_c_array_reserve(struct r_c_array* p_arr, r_ssize capacity);
+
+// When `p_elts` is `NULL`, the new elements are zeroed
+bool r_c_array_push_back_n(struct r_c_array* p_arr,
+                           const void* p_elts,
+                           r_ssize n);
+
+static inline
+bool r_c_array_push_back(struct r_c_array* p_arr, const void* p_elt) {
+  return r_c_array_push_back_n(p_arr, p_elt, 1);
+}
+
+static inline
+void* r_c_array_ptr(struct r_c_array* p_arr, r_ssize i) {
+  return ((unsigned char*) p_arr->v_data) + i * p_arr->elt_byte_size;
+}
+
+// Main thread only. `type` must be an atomic type whose elements have
+// the size of the elements of the array.
+r_obj* r_c_array_as_vector(struct r_c_array* p_arr, enum r_type type);
+
+
+// Hashing ---------------------------------------------------------
+
+uint64_t r_c_hash(const void* p_data, size_t n);
+uint64_t r_c_hash_str(const char* str);
+
+// Order-dependent combination of two hashes
+static inline
+uint64_t r_c_hash_combine(uint64_t x, uint64_t y) {
+  return x ^ (y + 0x9e3779b97f4a7c15 + (x << 6) + (x >> 2));
+}
+
+
+// Hash maps -------------------------------------------------------
+
+/*
+ * Open addressing hash map with linear probing, keyed by pointers,
+ * integers, or strings, and storing `r_ssize` values such as counts
+ * or indices into an array. Pointers are compared by address. String
+ * keys are compared byte by byte and copied into the map, so the
+ * caller's buffers don't need to outlive it. The bytes of deleted
+ * string keys are only released when the map is freed.
+ */
+
+enum r_c_dict_key {
+  R_C_DICT_KEY_ptr = 0,
+  R_C_DICT_KEY_int,
+  R_C_DICT_KEY_str
+};
+
+struct r_c_dict {
+  enum r_c_dict_key key_type;
+  r_ssize n_entries;
+
+  // private:
+  r_ssize n_slots;
+  uint64_t* v_hashes;
+  uint64_t* v_keys;
+  r_ssize* v_key_sizes;
+  r_ssize* v_values;
+
+  // Bytes of the string keys, referenced by offset from `v_keys`
+  struct r_c_array strings;
+};
+
+bool r_c_dict_init(struct r_c_dict* p_dict,
+                   enum r_c_dict_key key_type,
+                   r_ssize size);
+void r_c_dict_free(struct r_c_dict* p_dict);
+
+/*
+ * Returns a pointer to the value of `key`, inserting the key with a
+ * zero value if needed. `p_inserted` may be `NULL`. The pointer is
+ * valid until the next insertion or deletion. Returns `NULL` when the
+ * map can't grow.
+ */
+r_ssize* r_c_dict_emplace_ptr(struct r_c_dict* p_dict, const void* key, bool* p_inserted);
+r_ssize* r_c_dict_emplace_int(struct r_c_dict* p_dict, int64_t key, bool* p_inserted);
+r_ssize* r_c_dict_emplace_str(struct r_c_dict* p_dict, const char* key, r_ssize n, bool* p_inserted);
+
+// Returns `NULL` when `key` is not in the map
+r_ssize* r_c_dict_find_ptr(struct r_c_dict* p_dict, const void* key);
+r_ssize* r_c_dict_find_int(struct r_c_dict* p_dict, int64_t key);
+r_ssize* r_c_dict_find_str(struct r_c_dict* p_dict, const char* key, r_ssize n);
+
+// Returns `false` when `key` is not in the map
+bool r_c_dict_del_ptr(struct r_c_dict* p_dict, const void* key);
+bool r_c_dict_del_int(struct r_c_dict* p_dict, int64_t key);
+bool r_c_dict_del_str(struct r_c_dict* p_dict, const char* key, r_ssize n);
+
+/*
+ * Main thread only. Return the keys and the values in the same
+ * order. String keys are returned as a character vector of UTF-8
+ * strings and integer keys as a double vector. Pointer keys can't be
+ * converted.
+ */
+r_obj* r_c_dict_keys(struct r_c_dict* p_dict);
+r_obj* r_c_dict_values(struct r_c_dict* p_dict);
+
+
+#endif
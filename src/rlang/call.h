@@ -4,12 +4,36 @@
 #include "node.h"
 
 
-#define r_new_call Rf_lcons
-#define r_call Rf_lang1
-#define r_call2 Rf_lang2
-#define r_call3 Rf_lang3
-#define r_call4 Rf_lang4
-#define r_call5 Rf_lang5
+static inline
+r_obj* r_new_call(r_obj* car, r_obj* cdr) {
+  r_instr_count_nodes(1);
+  return Rf_lcons(car, cdr);
+}
+static inline
+r_obj* r_call(r_obj* fn) {
+  r_instr_count_nodes(1);
+  return Rf_lang1(fn);
+}
+static inline
+r_obj* r_call2(r_obj* fn, r_obj* x1) {
+  r_instr_count_nodes(2);
+  return Rf_lang2(fn, x1);
+}
+static inline
+r_obj* r_call3(r_obj* fn, r_obj* x1, r_obj* x2) {
+  r_instr_count_nodes(3);
+  return Rf_lang3(fn, x1, x2);
+}
+static inline
+r_obj* r_call4(r_obj* fn, r_obj* x1, r_obj* x2, r_obj* x3) {
+  r_instr_count_nodes(4);
+  return Rf_lang4(fn, x1, x2, x3);
+}
+static inline
+r_obj* r_call5(r_obj* fn, r_obj* x1, r_obj* x2, r_obj* x3, r_obj* x4) {
+  r_instr_count_nodes(5);
+  return Rf_lang5(fn, x1, x2, x3, x4);
+}
 
 bool r_is_call(r_obj* x, const char* name);
 bool r_is_call_any(r_obj* x, const char** names, int n);
@@ -99,9 +99,128 @@ r_obj* r_new_condition(r_obj* subclass, r_obj* msg, r_obj* data) {
 }
 
 
+struct r_cnd_template* r_new_cnd_template(r_obj* class,
+                                          r_obj* fields,
+                                          bool control_flow) {
+  if (r_typeof(class) != R_TYPE_character) {
+    r_abort("Condition class must be a character vector");
+  }
+  if (fields != r_null && r_typeof(fields) != R_TYPE_character) {
+    r_abort("Condition fields must be a character vector");
+  }
+  if (fields != r_null && r_chr_has_any(fields, (const char* []) { "message", NULL })) {
+    r_abort("Conditions can't have a `message` data field");
+  }
+
+  r_obj* shelter = KEEP(r_alloc_list(3));
+
+  r_obj* tmpl_raw = r_alloc_raw0(sizeof(struct r_cnd_template));
+  r_list_poke(shelter, 0, tmpl_raw);
+  struct r_cnd_template* p_tmpl = r_raw_begin(tmpl_raw);
+
+  p_tmpl->shelter = shelter;
+  p_tmpl->class = chr_append(class, r_str("condition"));
+  r_list_poke(shelter, 1, p_tmpl->class);
+
+  // Determine the type from the class vector
+  r_obj* proto = KEEP(r_alloc_list(0));
+  r_attrib_poke_class(proto, p_tmpl->class);
+  p_tmpl->type = r_cnd_type(proto);
+  FREE(1);
+
+  p_tmpl->control_flow = control_flow;
+  p_tmpl->n_fields = r_length(fields);
+
+  r_ssize n_prefix = (p_tmpl->type == r_cnd_type_error) ? 3 : 1;
+  p_tmpl->names = r_alloc_character(n_prefix + p_tmpl->n_fields);
+  r_list_poke(shelter, 2, p_tmpl->names);
+
+  r_chr_poke(p_tmpl->names, 0, r_str("message"));
+  if (p_tmpl->type == r_cnd_type_error) {
+    r_chr_poke(p_tmpl->names, 1, r_str("trace"));
+    r_chr_poke(p_tmpl->names, 2, r_str("parent"));
+  }
+  if (p_tmpl->n_fields) {
+    r_vec_poke_n(p_tmpl->names, n_prefix, fields, 0, p_tmpl->n_fields);
+  }
+
+  // The vectors are shared across conditions and must be duplicated
+  // on modification
+  r_mark_shared(p_tmpl->class);
+  r_mark_shared(p_tmpl->names);
+
+  FREE(1);
+  return p_tmpl;
+}
+
+r_obj* r_cnd_template_new(struct r_cnd_template* p_tmpl,
+                          r_obj* msg,
+                          r_obj* const * v_data) {
+  if (msg == r_null) {
+    msg = r_chrs.empty_string;
+  } else if (!r_is_string(msg)) {
+    r_abort("Condition message must be a string");
+  }
+
+  r_ssize n = r_length(p_tmpl->names);
+  r_ssize n_prefix = n - p_tmpl->n_fields;
+
+  r_obj* cnd = KEEP(r_alloc_list(n));
+  r_list_poke(cnd, 0, msg);
+
+  for (r_ssize i = 0; i < p_tmpl->n_fields; ++i) {
+    r_list_poke(cnd, n_prefix + i, v_data[i]);
+  }
+
+  r_attrib_poke_names(cnd, p_tmpl->names);
+  r_attrib_poke_class(cnd, p_tmpl->class);
+
+  FREE(1);
+  return cnd;
+}
+
+static r_obj* trace_back_call = NULL;
+static r_obj* cnd_signal_unmufflable_call = NULL;
+static r_obj* err_signal_call = NULL;
+
+void r_cnd_template_signal(struct r_cnd_template* p_tmpl,
+                           r_obj* msg,
+                           r_obj* const * v_data) {
+  if (p_tmpl->type == r_cnd_type_condition && !r_cnd_has_handler(p_tmpl->class)) {
+    return;
+  }
+
+  r_obj* cnd = KEEP(r_cnd_template_new(p_tmpl, msg, v_data));
+
+  if (!p_tmpl->control_flow) {
+    if (p_tmpl->type == r_cnd_type_error) {
+      r_obj* frame = KEEP(r_peek_frame());
+      r_list_poke(cnd, 1, r_eval(trace_back_call, frame));
+      FREE(1);
+    }
+    r_cnd_signal(cnd);
+    FREE(1);
+    return;
+  }
+
+  switch (p_tmpl->type) {
+  case r_cnd_type_error:
+    r_eval_with_x(err_signal_call, cnd, r_base_env);
+    r_stop_unreached("r_cnd_template_signal");
+  case r_cnd_type_condition:
+    r_eval_with_x(cnd_signal_unmufflable_call, cnd, r_base_env);
+    break;
+  default:
+    r_cnd_signal(cnd);
+    break;
+  }
+
+  FREE(1);
+}
+
+
 static r_obj* cnd_signal_call = NULL;
 static r_obj* wng_signal_call = NULL;
-static r_obj* err_signal_call = NULL;
 
 void r_cnd_signal(r_obj* cnd) {
   r_obj* call = r_null;
@@ -120,6 +239,10 @@ void r_cnd_signal(r_obj* cnd) {
     r_interrupt();
     return;
   default:
+    // Signalling a condition that no handler can catch has no effect
+    if (!r_cnd_has_handler(r_class(cnd))) {
+      return;
+    }
     call = cnd_signal_call;
     break;
   }
@@ -128,6 +251,135 @@ void r_cnd_signal(r_obj* cnd) {
 }
 
 
+/*
+ * R's handler stack is private, but the handlers established from R
+ * code all live in the frame of `withCallingHandlers()` or
+ * `tryCatch()`, which bind the handled classes to `classes`. This
+ * includes the handlers of `R_tryCatch()`. Handlers are removed when
+ * their frame exits, so no handler can match unless one of these
+ * frames on the stack lists a class of the condition. The check is
+ * conservative: frames whose handlers are disabled, e.g. while a
+ * calling handler runs, still count.
+ *
+ * The layout of these frames is checked with a probe the first time
+ * and the check always succeeds if it doesn't hold in this version
+ * of R.
+ */
+
+static r_obj* handler_frames_call = NULL;
+static r_obj* handlers_probe_call = NULL;
+static r_obj* global_handlers_call = NULL;
+static r_obj* handler_classes_sym = NULL;
+static r_obj* handler_handlers_sym = NULL;
+
+enum handlers_layout {
+  HANDLERS_LAYOUT_unknown = 0,
+  HANDLERS_LAYOUT_frames,
+  HANDLERS_LAYOUT_opaque
+};
+static enum handlers_layout handlers_layout = HANDLERS_LAYOUT_unknown;
+
+static
+bool chr_intersects(r_obj* x, r_obj* y) {
+  r_ssize n_x = r_length(x);
+  r_ssize n_y = r_length(y);
+  r_obj* const * v_x = r_chr_cbegin(x);
+  r_obj* const * v_y = r_chr_cbegin(y);
+
+  for (r_ssize i = 0; i < n_x; ++i) {
+    if (v_x[i] == r_globals.na_str) {
+      continue;
+    }
+    for (r_ssize j = 0; j < n_y; ++j) {
+      // R matches handlers by comparing the bytes of the classes
+      if (v_x[i] == v_y[j] || strcmp(r_str_c_string(v_x[i]), r_str_c_string(v_y[j])) == 0) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+static
+bool frames_have_handler(r_obj* frames, r_obj* classes) {
+  for (r_obj* node = frames; node != r_null; node = r_node_cdr(node)) {
+    r_obj* env = r_node_car(node);
+    r_obj* hnd_classes = r_env_find(env, handler_classes_sym);
+
+    if (r_typeof(hnd_classes) == R_TYPE_character &&
+        r_env_has(env, handler_handlers_sym) &&
+        chr_intersects(hnd_classes, classes)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static
+enum handlers_layout handlers_check_layout() {
+  r_obj* frames = KEEP(r_eval(handlers_probe_call, r_base_env));
+
+  const char* probe_classes[] = {
+    "rlang_handler_probe_calling",
+    "rlang_handler_probe_exiting"
+  };
+
+  bool ok = true;
+  for (r_ssize i = 0; i < R_ARR_SIZEOF(probe_classes); ++i) {
+    r_obj* class = KEEP(r_chr(probe_classes[i]));
+    ok = ok && frames_have_handler(frames, class);
+    FREE(1);
+  }
+
+  FREE(1);
+  return ok ? HANDLERS_LAYOUT_frames : HANDLERS_LAYOUT_opaque;
+}
+
+bool r_cnd_has_handler(r_obj* classes) {
+  if (r_typeof(classes) != R_TYPE_character) {
+    r_stop_internal("r_cnd_has_handler", "`classes` must be a character vector.");
+  }
+
+  if (handlers_layout == HANDLERS_LAYOUT_unknown) {
+    handlers_layout = handlers_check_layout();
+  }
+  if (handlers_layout == HANDLERS_LAYOUT_opaque) {
+    return true;
+  }
+
+  if (global_handlers_call != r_null) {
+    r_obj* global = KEEP(r_eval(global_handlers_call, r_base_env));
+    r_obj* global_classes = r_names(global);
+
+    if (global_classes != r_null && chr_intersects(global_classes, classes)) {
+      FREE(1);
+      return true;
+    }
+    FREE(1);
+  }
+
+  r_obj* frames = KEEP(r_eval(handler_frames_call, r_base_env));
+  bool out = frames_have_handler(frames, classes);
+
+  FREE(1);
+  return out;
+}
+
+void r_cnd_signal_lazy(r_obj* classes,
+                       r_obj* (*make)(void* data),
+                       void* data) {
+  if (!r_cnd_has_handler(classes)) {
+    return;
+  }
+
+  r_obj* cnd = KEEP(make(data));
+  r_cnd_signal(cnd);
+  FREE(1);
+}
+
+
 #ifdef _WIN32
 #include <Rembedded.h>
 void r_interrupt() {
@@ -212,8 +464,38 @@ void r_init_library_cnd() {
   err_signal_call = r_parse("rlang:::signal_abort(x)");
   r_preserve(err_signal_call);
 
+  cnd_signal_unmufflable_call = r_parse("signalCondition(x)");
+  r_preserve(cnd_signal_unmufflable_call);
+
+  trace_back_call = r_parse("rlang::trace_back()");
+  r_preserve(trace_back_call);
+
   const char* cnd_signal_source =
     "withRestarts(rlang_muffle = function() NULL, signalCondition(x))";
   cnd_signal_call = r_parse(cnd_signal_source);
   r_preserve(cnd_signal_call);
+
+  // `sys.frames()` must be called from a function to return the
+  // frames of the whole stack
+  r_obj* frames_fn = KEEP(r_eval(KEEP(r_parse("function() sys.frames()")), r_base_env));
+  handler_frames_call = r_preserve_global(r_call(frames_fn));
+  FREE(2);
+
+  const char* handlers_probe_source =
+    "withCallingHandlers("
+    "  tryCatch((function() sys.frames())(), rlang_handler_probe_exiting = identity),"
+    "  rlang_handler_probe_calling = identity"
+    ")";
+  handlers_probe_call = r_parse(handlers_probe_source);
+  r_preserve(handlers_probe_call);
+
+#if R_VERSION >= R_Version(4, 0, 0)
+  global_handlers_call = r_parse("globalCallingHandlers()");
+  r_preserve(global_handlers_call);
+#else
+  global_handlers_call = r_null;
+#endif
+
+  handler_classes_sym = r_sym("classes");
+  handler_handlers_sym = r_sym("handlers");
 }
@@ -37,11 +37,6 @@ bool r_is_condition(r_obj* x) {
 }
 r_obj* r_new_condition(r_obj* type, r_obj* msg, r_obj* data);
 
-void r_cnd_signal(r_obj* cnd);
-void r_cnd_inform(r_obj* cnd, bool mufflable);
-void r_cnd_warn(r_obj* cnd, bool mufflable);
-void r_cnd_abort(r_obj* cnd, bool mufflable);
-
 enum r_condition_type {
   r_cnd_type_condition = 0,
   r_cnd_type_message = 1,
@@ -50,6 +45,57 @@ enum r_condition_type {
   r_cnd_type_interrupt = 4
 };
 
+/**
+ * Condition templates create conditions of a fixed class and set of
+ * data fields without evaluating R code. The class and names vectors
+ * are built once and shared by all conditions of the template, only
+ * the message and data fields are filled for each condition.
+ *
+ * Templates marked as `control_flow` are meant for conditions that
+ * are routinely caught, e.g. recoverable errors in a loop. Errors
+ * don't record a backtrace and other conditions are signalled
+ * without a muffling restart.
+ */
+struct r_cnd_template {
+  r_obj* shelter;
+  r_obj* class;
+  r_obj* names;
+  r_ssize n_fields;
+  enum r_condition_type type;
+  bool control_flow;
+};
+
+// `class` doesn't include `"condition"`. Error templates get `trace`
+// and `parent` fields before the `fields`, like `error_cnd()`.
+struct r_cnd_template* r_new_cnd_template(r_obj* class,
+                                          r_obj* fields,
+                                          bool control_flow);
+
+// `v_data` points to `n_fields` values
+r_obj* r_cnd_template_new(struct r_cnd_template* p_tmpl,
+                          r_obj* msg,
+                          r_obj* const * v_data);
+void r_cnd_template_signal(struct r_cnd_template* p_tmpl,
+                           r_obj* msg,
+                           r_obj* const * v_data);
+
+void r_cnd_signal(r_obj* cnd);
+
+// Whether a handler for one of `classes` may be active. This never
+// returns `false` when a handler would catch a condition of these
+// classes but might return `true` when none would.
+bool r_cnd_has_handler(r_obj* classes);
+
+// Calls `make(data)` to create the condition and signals it only if a
+// handler for one of `classes` may catch it. `classes` must be the
+// class vector of the condition, including `"condition"`.
+void r_cnd_signal_lazy(r_obj* classes,
+                       r_obj* (*make)(void* data),
+                       void* data);
+void r_cnd_inform(r_obj* cnd, bool mufflable);
+void r_cnd_warn(r_obj* cnd, bool mufflable);
+void r_cnd_abort(r_obj* cnd, bool mufflable);
+
 enum r_condition_type r_cnd_type(r_obj* cnd);
 
 
@@ -1 +1,2 @@
 #include "vec.cpp"
+#include "vec-na.cpp"
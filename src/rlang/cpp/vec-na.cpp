@@ -0,0 +1,77 @@
+#include <rlang.hpp>
+
+namespace {
+
+// Blocks of elements are tested without branching so that the
+// compiler can vectorise them. Only the block containing a match is
+// rescanned element-wise.
+const int na_block_size = 16;
+
+template <typename T>
+r_ssize find_na(const T* v, r_ssize i, r_ssize n) {
+  for (; i + na_block_size <= n; i += na_block_size) {
+    bool hit = false;
+    for (int j = 0; j < na_block_size; ++j) {
+      hit |= rlang::is_na(v[i + j]);
+    }
+    if (hit) {
+      break;
+    }
+  }
+
+  for (; i < n; ++i) {
+    if (rlang::is_na(v[i])) {
+      break;
+    }
+  }
+  return i;
+}
+
+struct find_na_fn {
+  r_ssize i;
+
+  template <typename T>
+  r_ssize operator()(rlang::vec_view<T> x) const {
+    return find_na(x.begin(), i, x.size());
+  }
+};
+
+struct replace_na_fn {
+  r_obj* replacement;
+  r_ssize i;
+
+  template <typename T>
+  void operator()(rlang::vec_view<T> x) const {
+    rlang::vec_view<T> values(replacement);
+    const T* v_x = x.begin();
+    r_ssize n = x.size();
+
+    if (values.size() == 1) {
+      T value = values[0];
+      for (r_ssize j = i; j < n; j = find_na(v_x, j + 1, n)) {
+        x.set(j, value);
+      }
+    } else {
+      for (r_ssize j = i; j < n; j = find_na(v_x, j + 1, n)) {
+        x.set(j, values[j]);
+      }
+    }
+  }
+};
+
+} // namespace
+
+
+extern "C" {
+
+r_ssize r_vec_find_na(r_obj* x, r_ssize i) {
+  find_na_fn fn = { i };
+  return rlang::visit_vector<r_ssize>(x, fn);
+}
+
+void r_vec_replace_na(r_obj* x, r_obj* replacement, r_ssize i) {
+  replace_na_fn fn = { replacement, i };
+  rlang::visit_vector<void>(x, fn);
+}
+
+}
@@ -1,14 +1,181 @@
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <vector>
 #include <rlang.hpp>
 
+// Parallel algorithms are opt-in because libstdc++ implements them
+// with TBB, which must then be linked. Exceptions thrown from a
+// parallel algorithm call `std::terminate()`, so the kernels below
+// only run them on plain buffers.
+#if defined(RLANG_USE_PARALLEL_ALGORITHMS) && __cplusplus >= 201703L
+# include <execution>
+# if defined(__cpp_lib_execution) && defined(__cpp_lib_parallel_algorithm)
+#  define RLANG_HAS_PARALLEL_ALGORITHMS 1
+# endif
+#endif
+
+namespace {
+
+// Below this size the overhead of dispatching to threads dominates
+const r_ssize par_threshold = 1 << 16;
+
+// Strict weak ordering of doubles: missing values are sorted last and
+// compare equal to each other
+struct dbl_less {
+  bool operator()(double x, double y) const {
+    return x < y || (!std::isnan(x) && std::isnan(y));
+  }
+};
+struct dbl_equal {
+  bool operator()(double x, double y) const {
+    return x == y || (std::isnan(x) && std::isnan(y));
+  }
+};
+
+template <typename T> struct vec_less : std::less<T> { };
+template <> struct vec_less<double> : dbl_less { };
+
+template <typename T> struct vec_equal : std::equal_to<T> { };
+template <> struct vec_equal<double> : dbl_equal { };
+
+template <typename T>
+void vec_sort(T* v_data, r_ssize size, bool stable) {
+  T* end = v_data + size;
+  vec_less<T> less;
+
+#ifdef RLANG_HAS_PARALLEL_ALGORITHMS
+  if (size >= par_threshold) {
+    if (stable) {
+      std::stable_sort(std::execution::par_unseq, v_data, end, less);
+    } else {
+      std::sort(std::execution::par_unseq, v_data, end, less);
+    }
+    return;
+  }
+#endif
+
+  if (stable) {
+    std::stable_sort(v_data, end, less);
+  } else {
+    std::sort(v_data, end, less);
+  }
+}
+
+template <typename T>
+T* vec_unique(T* v_data, r_ssize size) {
+  return std::unique(v_data, v_data + size, vec_equal<T>());
+}
+
+// Stable, so that ties are ordered by position
+template <typename T>
+void vec_order(const T* v_data, r_ssize size, int* v_out) {
+  int* end = v_out + size;
+  std::iota(v_out, end, 0);
+
+  vec_less<T> less;
+  auto cmp = [=](int i, int j) { return less(v_data[i], v_data[j]); };
+
+#ifdef RLANG_HAS_PARALLEL_ALGORITHMS
+  if (size >= par_threshold) {
+    std::stable_sort(std::execution::par_unseq, v_out, end, cmp);
+    return;
+  }
+#endif
+
+  std::stable_sort(v_out, end, cmp);
+}
+
+// Ties get the minimum rank, as with `rank(ties.method = "min")`
+template <typename T>
+void vec_rank(const T* v_data, r_ssize size, int* v_out) {
+  if (size == 0) {
+    return;
+  }
+
+  std::vector<int> order(size);
+  vec_order(v_data, size, order.data());
+
+  vec_equal<T> equal;
+  int rank = 1;
+  v_out[order[0]] = rank;
+
+  for (r_ssize i = 1; i < size; ++i) {
+    if (!equal(v_data[order[i]], v_data[order[i - 1]])) {
+      rank = i + 1;
+    }
+    v_out[order[i]] = rank;
+  }
+}
+
+template <typename T>
+r_ssize vec_lower_bound(const T* v_data, r_ssize size, T value) {
+  return std::lower_bound(v_data, v_data + size, value, vec_less<T>()) - v_data;
+}
+
+} // namespace
+
+
 extern "C" {
 
-int* r_int_unique0(int* v_data, r_ssize size) {
-  try {
-    return std::unique(v_data, v_data + size);
-  } catch (...) {
-    rcc_abort("r_int_unique0");
+#define RCC_TRY(FN, EXPR)                       \
+  try {                                         \
+    EXPR;                                       \
+  } catch (...) {                               \
+    rcc_abort(FN);                              \
   }
+
+int* r_int_unique0(int* v_data, r_ssize size) {
+  RCC_TRY("r_int_unique0", return vec_unique(v_data, size));
+}
+double* r_dbl_unique0(double* v_data, r_ssize size) {
+  RCC_TRY("r_dbl_unique0", return vec_unique(v_data, size));
+}
+r_obj** r_ptr_unique0(r_obj** v_data, r_ssize size) {
+  RCC_TRY("r_ptr_unique0", return vec_unique(v_data, size));
+}
+
+void r_int_sort0(int* v_data, r_ssize size, bool stable) {
+  RCC_TRY("r_int_sort0", vec_sort(v_data, size, stable));
+}
+void r_dbl_sort0(double* v_data, r_ssize size, bool stable) {
+  RCC_TRY("r_dbl_sort0", vec_sort(v_data, size, stable));
+}
+void r_ptr_sort0(r_obj** v_data, r_ssize size, bool stable) {
+  RCC_TRY("r_ptr_sort0", vec_sort(v_data, size, stable));
 }
 
+void r_int_order0(const int* v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_int_order0", vec_order(v_data, size, v_out));
+}
+void r_dbl_order0(const double* v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_dbl_order0", vec_order(v_data, size, v_out));
+}
+void r_ptr_order0(r_obj* const * v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_ptr_order0", vec_order(v_data, size, v_out));
+}
+
+void r_int_rank0(const int* v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_int_rank0", vec_rank(v_data, size, v_out));
+}
+void r_dbl_rank0(const double* v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_dbl_rank0", vec_rank(v_data, size, v_out));
+}
+void r_ptr_rank0(r_obj* const * v_data, r_ssize size, int* v_out) {
+  RCC_TRY("r_ptr_rank0", vec_rank(v_data, size, v_out));
+}
+
+r_ssize r_int_lower_bound0(const int* v_data, r_ssize size, int value) {
+  return vec_lower_bound(v_data, size, value);
+}
+r_ssize r_dbl_lower_bound0(const double* v_data, r_ssize size, double value) {
+  return vec_lower_bound(v_data, size, value);
+}
+r_ssize r_ptr_lower_bound0(r_obj* const * v_data, r_ssize size, r_obj* value) {
+  return vec_lower_bound(v_data, size, value);
+}
+
+#undef RCC_TRY
+
 }
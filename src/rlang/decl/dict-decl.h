@@ -1,3 +1,6 @@
+static
+r_ssize dict_hash(const struct r_dict* p_dict, r_obj* key);
+
 static
 r_obj* dict_find_node_info(struct r_dict* dict,
                            r_obj* key,
@@ -6,3 +9,18 @@ r_obj* dict_find_node_info(struct r_dict* dict,
 
 static
 r_obj* dict_find_node(struct r_dict* dict, r_obj* key);
+
+static
+void flat_dict_alloc_slots(struct r_flat_dict* p_dict, r_ssize size);
+
+static inline
+r_ssize flat_dict_find_slot(const struct r_flat_dict* p_dict, r_obj* key);
+
+static
+void str_dict_alloc_slots(struct r_str_dict* p_dict, r_ssize size);
+
+static
+void int_dict_alloc_slots(struct r_int_dict* p_dict, r_ssize size);
+
+static inline
+r_ssize int_dict_find_slot(const struct r_int_dict* p_dict, r_ssize key);
@@ -6,3 +6,6 @@ int push_precious(r_obj* stack);
 
 static
 int pop_precious(r_obj* stack);
+
+static
+void precious_slab_grow();
@@ -27,6 +27,11 @@ static inline
 r_obj* const * sexp_node_arr(r_obj* x, enum r_type type,
                              enum r_sexp_it_relation* p_rel);
 
+static inline
+bool init_stack_info(struct r_sexp_iterator* p_it,
+                     struct sexp_stack_info* p_info,
+                     int depth);
+
 static inline
 void init_incoming_stack_info(struct sexp_stack_info* p_info,
                               enum sexp_iterator_type it_type,
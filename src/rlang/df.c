@@ -39,6 +39,116 @@ void r_init_tibble(r_obj* x, r_ssize n_rows) {
   r_attrib_poke(x, r_syms.class, r_classes.tibble);
 }
 
+
+enum dyn_df_shelter {
+  DYN_DF_SHELTER_df = 0,
+  DYN_DF_SHELTER_names,
+  DYN_DF_SHELTER_types,
+  DYN_DF_SHELTER_cols,
+  DYN_DF_SHELTER_arrays,
+  DYN_DF_SHELTER_SIZE
+};
+
+struct r_dyn_df* r_new_dyn_df(r_obj* names,
+                              const enum r_type* v_types,
+                              r_ssize types_size,
+                              r_ssize capacity) {
+  if (types_size < 0) {
+    r_abort("`types_size` can't be negative.");
+  }
+  if (r_typeof(names) != R_TYPE_character) {
+    r_abort("`names` must be a character vector.");
+  }
+  if (r_length(names) != types_size) {
+    r_abort("`names` must match the number of columns.");
+  }
+
+  r_obj* shelter = KEEP(r_alloc_list(DYN_DF_SHELTER_SIZE));
+
+  r_obj* df_raw = r_alloc_raw0(sizeof(struct r_dyn_df));
+  r_list_poke(shelter, DYN_DF_SHELTER_df, df_raw);
+  struct r_dyn_df* p_df = r_raw_begin(df_raw);
+
+  r_list_poke(shelter, DYN_DF_SHELTER_names, names);
+
+  r_ssize types_bytes = r_ssize_mult(types_size, sizeof(enum r_type));
+  r_obj* types = r_alloc_raw(types_bytes);
+  r_list_poke(shelter, DYN_DF_SHELTER_types, types);
+  enum r_type* v_types_copy = (enum r_type*) r_raw_begin(types);
+  if (types_bytes) {
+    memcpy(v_types_copy, v_types, (size_t) types_bytes);
+  }
+
+  r_obj* cols = r_alloc_raw0(r_ssize_mult(types_size, sizeof(struct r_dyn_array*)));
+  r_list_poke(shelter, DYN_DF_SHELTER_cols, cols);
+  struct r_dyn_array** v_cols = (struct r_dyn_array**) r_raw_begin(cols);
+
+  r_obj* arrays = r_alloc_list(types_size);
+  r_list_poke(shelter, DYN_DF_SHELTER_arrays, arrays);
+
+  for (r_ssize i = 0; i < types_size; ++i) {
+    enum r_type type = v_types[i];
+    if (type == R_TYPE_null) {
+      v_cols[i] = NULL;
+      continue;
+    }
+
+    struct r_dyn_array* p_col = r_new_dyn_vector(type, capacity);
+    r_list_poke(arrays, i, p_col->shelter);
+    v_cols[i] = p_col;
+  }
+
+  p_df->shelter = shelter;
+  p_df->n_rows = 0;
+  p_df->n_cols = types_size;
+  p_df->names = names;
+  p_df->v_types = v_types_copy;
+  p_df->v_cols = v_cols;
+
+  FREE(1);
+  return p_df;
+}
+
+void r_dyn_df_push_row(struct r_dyn_df* p_df, const void* const * v_elts) {
+  for (r_ssize i = 0; i < p_df->n_cols; ++i) {
+    struct r_dyn_array* p_col = p_df->v_cols[i];
+    if (p_col) {
+      r_arr_push_back(p_col, v_elts[i]);
+    }
+  }
+  ++p_df->n_rows;
+}
+
+void r_dyn_df_push_rows(struct r_dyn_df* p_df, const void* const * v_elts, r_ssize n) {
+  for (r_ssize i = 0; i < p_df->n_cols; ++i) {
+    struct r_dyn_array* p_col = p_df->v_cols[i];
+    if (p_col) {
+      r_arr_push_back_n(p_col, v_elts[i], n);
+    }
+  }
+  p_df->n_rows += n;
+}
+
+r_obj* r_dyn_df_unwrap(struct r_dyn_df* p_df) {
+  r_ssize n_cols = p_df->n_cols;
+
+  r_obj* out = KEEP(r_alloc_list(n_cols));
+  r_attrib_push(out, r_syms.names, p_df->names);
+
+  for (r_ssize i = 0; i < n_cols; ++i) {
+    struct r_dyn_array* p_col = p_df->v_cols[i];
+    if (p_col) {
+      r_list_poke(out, i, r_arr_unwrap(p_col));
+    }
+  }
+
+  r_init_data_frame(out, p_df->n_rows);
+
+  FREE(1);
+  return out;
+}
+
+
 static
 void init_compact_rownames(r_obj* x, r_ssize n_rows) {
   r_obj* rn = KEEP(new_compact_rownames(n_rows));
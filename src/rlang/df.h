@@ -11,4 +11,43 @@ void r_init_data_frame(r_obj* x, r_ssize n_nows);
 void r_init_tibble(r_obj* x, r_ssize n_rows);
 
 
+/**
+ * Column-wise data frame builder for a row count that is not known in
+ * advance. Each column is a dyn array of the corresponding type in
+ * `v_types`. As with `r_alloc_df_list()`, a nil type stands for no
+ * column allocation: its values are ignored and the column is `NULL`
+ * in the output.
+ *
+ * `r_dyn_df_push_row()` takes one pointer per column to the element
+ * of that row. `r_dyn_df_push_rows()` takes one pointer per column to
+ * `n` contiguous elements. Elements of character and list columns are
+ * `r_obj*`.
+ *
+ * `r_dyn_df_unwrap()` returns a data frame with compact row names.
+ * The columns are shrunk in place and the data is not copied, so the
+ * builder can't be used after unwrapping.
+ */
+
+struct r_dyn_df {
+  r_obj* shelter;
+  r_ssize n_rows;
+  r_ssize n_cols;
+
+  /* private: */
+  r_obj* names;
+  const enum r_type* v_types;
+  struct r_dyn_array** v_cols;
+};
+
+struct r_dyn_df* r_new_dyn_df(r_obj* names,
+                              const enum r_type* v_types,
+                              r_ssize types_size,
+                              r_ssize capacity);
+
+void r_dyn_df_push_row(struct r_dyn_df* p_df, const void* const * v_elts);
+void r_dyn_df_push_rows(struct r_dyn_df* p_df, const void* const * v_elts, r_ssize n);
+
+r_obj* r_dyn_df_unwrap(struct r_dyn_df* p_df);
+
+
 #endif
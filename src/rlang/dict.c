@@ -2,6 +2,7 @@
 #include "dict.h"
 
 #define DICT_LOAD_THRESHOLD 0.75
+#define DICT_SHRINK_THRESHOLD (DICT_LOAD_THRESHOLD / 4)
 #define DICT_GROWTH_FACTOR 2
 
 static size_t size_round_power_2(size_t size);
@@ -22,6 +23,10 @@ static size_t size_round_power_2(size_t size);
 #define V_DICT_VALUE(V) (V)[1]
 #define V_DICT_CDR(V) (V)[2]
 
+// Deleted nodes of the insertion order array are marked by their CDR,
+// which is otherwise a node or `r_null`
+#define DICT_NODE_IS_DELETED(V) (DICT_CDR(V) == r_syms.unbound)
+
 static
 r_obj* new_bucket(r_obj* key, r_obj* value) {
   r_obj* bucket = r_alloc_list(3);
@@ -36,7 +41,7 @@ struct r_dict* r_new_dict(r_ssize size) {
   }
   size = size_round_power_2(size);
 
-  r_obj* shelter = KEEP(r_alloc_list(2));
+  r_obj* shelter = KEEP(r_alloc_list(3));
 
   r_obj* dict_raw = r_alloc_raw0(sizeof(struct r_dict));
   r_list_poke(shelter, 0, dict_raw);
@@ -49,6 +54,9 @@ struct r_dict* r_new_dict(r_ssize size) {
 
   p_dict->p_buckets = r_list_cbegin(p_dict->buckets);
   p_dict->n_buckets = size;
+  p_dict->min_buckets = size;
+  p_dict->p_order = NULL;
+  p_dict->n_order_holes = 0;
 
   r_attrib_poke(shelter, r_syms.class, r_chr("rlang_dict"));
 
@@ -56,38 +64,89 @@ struct r_dict* r_new_dict(r_ssize size) {
   return p_dict;
 }
 
+void r_dict_keep_order(struct r_dict* p_dict) {
+  if (p_dict->p_order) {
+    return;
+  }
+
+  r_ssize n = p_dict->n_entries;
+  struct r_dyn_array* p_order = r_new_dyn_vector(R_TYPE_list, n ? n : 1);
+  r_list_poke(p_dict->shelter, 2, p_order->shelter);
+
+  for (r_ssize i = 0; i < p_dict->n_buckets; ++i) {
+    r_obj* node = p_dict->p_buckets[i];
+
+    while (node != r_null) {
+      r_list_push_back(p_order, node);
+      node = DICT_CDR(node);
+    }
+  }
+
+  p_dict->p_order = p_order;
+  p_dict->n_order_holes = 0;
+}
+
+// Removes the deleted nodes from the insertion order array
+static
+void dict_compact_order(struct r_dict* p_dict) {
+  struct r_dyn_array* p_order = p_dict->p_order;
+  r_obj* order = p_order->data;
+  r_obj* const * v_order = r_list_cbegin(order);
+  r_ssize n = p_order->count;
+
+  r_ssize j = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* node = v_order[i];
+    if (!DICT_NODE_IS_DELETED(node)) {
+      r_list_poke(order, j++, node);
+    }
+  }
+  for (r_ssize i = j; i < n; ++i) {
+    r_list_poke(order, i, r_null);
+  }
+
+  p_order->count = j;
+  p_dict->n_order_holes = 0;
+}
+
+// Rehashes the existing nodes into a new bucket vector. Nodes are
+// relinked rather than reallocated so resizing only allocates the
+// bucket vector.
 void r_dict_resize(struct r_dict* p_dict, r_ssize size) {
   if (size < 0) {
     size = p_dict->n_buckets * DICT_GROWTH_FACTOR;
   }
-  struct r_dict* p_new_dict = r_new_dict(size);
-  KEEP(p_new_dict->shelter);
+  if (size <= 0) {
+    r_abort("`size` of dictionary must be positive.");
+  }
+  size = size_round_power_2(size);
 
-  r_ssize n = r_length(p_dict->buckets);
-  r_obj* const * p_buckets = p_dict->p_buckets;
+  KEEP(p_dict->buckets);
+  r_obj* const * v_old_buckets = p_dict->p_buckets;
+  r_ssize n = p_dict->n_buckets;
+
+  r_obj* buckets = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 1, buckets);
+
+  p_dict->buckets = buckets;
+  p_dict->p_buckets = r_list_cbegin(buckets);
+  p_dict->n_buckets = size;
+  ++p_dict->n_resizes;
 
   for (r_ssize i = 0; i < n; ++i) {
-    r_obj* bucket = p_buckets[i];
+    r_obj* node = v_old_buckets[i];
 
-    while (bucket != r_null) {
-      r_obj* const * v_bucket = DICT_DEREF(bucket);
+    while (node != r_null) {
+      r_obj* next = DICT_CDR(node);
 
-      r_obj* key = V_DICT_KEY(v_bucket);
-      r_obj* value = V_DICT_VALUE(v_bucket);
-      r_dict_put(p_new_dict, key, value);
+      r_ssize hash = dict_hash(p_dict, DICT_KEY(node));
+      DICT_POKE_CDR(node, p_dict->p_buckets[hash]);
+      r_list_poke(buckets, hash, node);
 
-      bucket = V_DICT_CDR(v_bucket);
+      node = next;
     }
   }
 
-  // Update all data in place except the shelter and the raw sexp
-  // which must stay validly protected by the callers
-  r_obj* old_shelter = p_dict->shelter;
-  r_list_poke(old_shelter, 1, r_list_get(p_new_dict->shelter, 1));
-
-  memcpy(p_dict, p_new_dict, sizeof(*p_dict));
-  p_dict->shelter = old_shelter;
-
   FREE(1);
 }
 
@@ -127,6 +186,10 @@ bool r_dict_put(struct r_dict* p_dict, r_obj* key, r_obj* value) {
     DICT_POKE_CDR(parent, node);
   }
 
+  if (p_dict->p_order) {
+    r_list_push_back(p_dict->p_order, node);
+  }
+
   ++p_dict->n_entries;
 
   float load = (float) p_dict->n_entries / (float) p_dict->n_buckets;
@@ -150,14 +213,100 @@ bool r_dict_del(struct r_dict* p_dict, r_obj* key) {
   }
 
   if (parent == r_null) {
-    r_list_poke(p_dict->buckets, hash, r_null);
+    r_list_poke(p_dict->buckets, hash, DICT_CDR(node));
   }  else {
     DICT_POKE_CDR(parent, DICT_CDR(node));
   }
 
+  --p_dict->n_entries;
+
+  if (p_dict->p_order) {
+    DICT_POKE_CDR(node, r_syms.unbound);
+    if (++p_dict->n_order_holes * 2 > p_dict->p_order->count) {
+      dict_compact_order(p_dict);
+    }
+  }
+
+  // Shrink back after bursts but never below the initial size
+  float load = (float) p_dict->n_entries / (float) p_dict->n_buckets;
+  if (!p_dict->prevent_resize &&
+      p_dict->n_buckets > p_dict->min_buckets &&
+      load < DICT_SHRINK_THRESHOLD) {
+    r_dict_resize(p_dict, p_dict->n_buckets / DICT_GROWTH_FACTOR);
+  }
+
   return true;
 }
 
+static
+r_obj* const * dict_keys_cbegin(r_obj* keys) {
+  switch (r_typeof(keys)) {
+  case R_TYPE_list: return r_list_cbegin(keys);
+  case R_TYPE_character: return r_chr_cbegin(keys);
+  default: r_abort("`keys` must be a list or a character vector.");
+  }
+}
+
+r_obj* r_dict_put_n(struct r_dict* p_dict, r_obj* keys, r_obj* values) {
+  r_obj* const * v_keys = dict_keys_cbegin(keys);
+  r_ssize n = r_length(keys);
+
+  if (r_typeof(values) != R_TYPE_list || r_length(values) != n) {
+    r_abort("`values` must be a list as long as `keys`.");
+  }
+  r_obj* const * v_values = r_list_cbegin(values);
+
+  // Grow once upfront so the batch doesn't trigger successive resizes
+  if (!p_dict->prevent_resize) {
+    r_ssize n_buckets = (r_ssize) ((p_dict->n_entries + n) / DICT_LOAD_THRESHOLD) + 1;
+    if (n_buckets > p_dict->n_buckets) {
+      r_dict_resize(p_dict, n_buckets);
+    }
+  }
+
+  r_obj* out = KEEP(r_alloc_logical(n));
+  int* v_out = r_lgl_begin(out);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    v_out[i] = r_dict_put(p_dict, v_keys[i], v_values[i]);
+  }
+
+  FREE(1);
+  return out;
+}
+
+r_obj* r_dict_get_n(struct r_dict* p_dict, r_obj* keys) {
+  r_obj* const * v_keys = dict_keys_cbegin(keys);
+  r_ssize n = r_length(keys);
+
+  r_obj* value = KEEP(r_alloc_list(n));
+  r_obj* found = KEEP(r_alloc_logical(n));
+  int* v_found = r_lgl_begin(found);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* elt = r_dict_get0(p_dict, v_keys[i]);
+
+    if (elt) {
+      r_list_poke(value, i, elt);
+      v_found[i] = 1;
+    } else {
+      v_found[i] = 0;
+    }
+  }
+
+  r_obj* out = KEEP(r_alloc_list(2));
+  r_list_poke(out, 0, value);
+  r_list_poke(out, 1, found);
+
+  r_obj* nms = r_alloc_character(2);
+  r_attrib_poke_names(out, nms);
+  r_chr_poke(nms, 0, r_str("value"));
+  r_chr_poke(nms, 1, r_str("found"));
+
+  FREE(3);
+  return out;
+}
+
 bool r_dict_has(struct r_dict* p_dict, r_obj* key) {
   return dict_find_node(p_dict, key) != r_null;
 }
@@ -236,6 +385,15 @@ struct r_dict_iterator* r_new_dict_iterator(struct r_dict* p_dict) {
   p_it->i = 0;
   p_it->n = p_dict->n_buckets;
   p_it->v_buckets = p_dict->p_buckets;
+  p_it->v_order = NULL;
+
+  if (p_dict->p_order) {
+    p_it->n = p_dict->p_order->count;
+    p_it->v_order = r_list_cbegin(p_dict->p_order->data);
+    p_it->v_buckets = NULL;
+    p_it->node = r_null;
+    return p_it;
+  }
 
   if (p_it->n == 0) {
     r_stop_internal("r_new_dict_iterator", "Empty dictionary.");
@@ -245,7 +403,27 @@ struct r_dict_iterator* r_new_dict_iterator(struct r_dict* p_dict) {
   return p_it;
 }
 
+static
+bool dict_next_ordered(struct r_dict_iterator* p_it) {
+  while (p_it->i < p_it->n) {
+    r_obj* node = p_it->v_order[p_it->i++];
+
+    if (!DICT_NODE_IS_DELETED(node)) {
+      r_obj* const * v_node = DICT_DEREF(node);
+      p_it->key = V_DICT_KEY(v_node);
+      p_it->value = V_DICT_VALUE(v_node);
+      return true;
+    }
+  }
+
+  p_it->v_order = NULL;
+  return false;
+}
+
 bool r_dict_next(struct r_dict_iterator* p_it) {
+  if (p_it->v_order) {
+    return dict_next_ordered(p_it);
+  }
   if (p_it->v_buckets == NULL) {
     return false;
   }
@@ -295,30 +473,866 @@ r_obj* r_dict_as_df_list(struct r_dict* p_dict) {
                                     v_dict_it_df_types,
                                     DICT_IT_DF_SIZE));
 
-  r_obj* key = r_list_get(out, DICT_IT_DF_LOCS_key);
-  r_obj* value = r_list_get(out, DICT_IT_DF_LOCS_value);
+  r_dict_fill(p_dict,
+              r_list_get(out, DICT_IT_DF_LOCS_key),
+              r_list_get(out, DICT_IT_DF_LOCS_value));
+
+  FREE(2);
+  return out;
+}
+r_obj* r_dict_as_list(struct r_dict* p_dict) {
+  r_obj* out = KEEP(r_alloc_list(p_dict->n_entries));
+  r_dict_fill(p_dict, r_null, out);
+
+  FREE(1);
+  return out;
+}
+
+static
+void dict_check_column(r_obj* x, r_ssize n, const char* arg) {
+  if (x == r_null) {
+    return;
+  }
+  if (r_typeof(x) != R_TYPE_list || r_length(x) < n) {
+    r_abort("`%s` must be a list at least as long as the dictionary.", arg);
+  }
+}
+
+r_ssize r_dict_fill(struct r_dict* p_dict, r_obj* keys, r_obj* values) {
+  r_ssize n = p_dict->n_entries;
+  dict_check_column(keys, n, "keys");
+  dict_check_column(values, n, "values");
 
   struct r_dict_iterator* p_it = r_new_dict_iterator(p_dict);
   KEEP(p_it->shelter);
 
+  bool has_keys = keys != r_null;
+  bool has_values = values != r_null;
+
   for (r_ssize i = 0; r_dict_next(p_it); ++i) {
-    r_list_poke(key, i, p_it->key);
-    r_list_poke(value, i, p_it->value);
+    if (has_keys) {
+      r_list_poke(keys, i, p_it->key);
+    }
+    if (has_values) {
+      r_list_poke(values, i, p_it->value);
+    }
+  }
+
+  FREE(1);
+  return n;
+}
+
+
+static
+const char* v_dict_stats_names_c_strings[] = {
+  "n_buckets",
+  "n_entries",
+  "n_resizes",
+  "max_chain",
+  "mean_chain",
+  "chain_hist"
+};
+enum dict_stats_locs {
+  DICT_STATS_LOCS_n_buckets,
+  DICT_STATS_LOCS_n_entries,
+  DICT_STATS_LOCS_n_resizes,
+  DICT_STATS_LOCS_max_chain,
+  DICT_STATS_LOCS_mean_chain,
+  DICT_STATS_LOCS_chain_hist
+};
+#define DICT_STATS_SIZE R_ARR_SIZEOF(v_dict_stats_names_c_strings)
+
+static inline
+r_ssize dict_chain_length(r_obj* node) {
+  r_ssize n = 0;
+  while (node != r_null) {
+    ++n;
+    node = DICT_CDR(node);
+  }
+  return n;
+}
+
+r_obj* r_dict_stats(struct r_dict* p_dict) {
+  r_ssize n = p_dict->n_buckets;
+  r_obj* const * v_buckets = p_dict->p_buckets;
+
+  r_ssize max_chain = 0;
+  r_ssize n_used = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    r_ssize len = dict_chain_length(v_buckets[i]);
+    if (len > max_chain) {
+      max_chain = len;
+    }
+    n_used += len > 0;
+  }
+
+  r_obj* hist = KEEP(r_alloc_integer(max_chain + 1));
+  int* v_hist = r_int_begin(hist);
+  memset(v_hist, 0, (max_chain + 1) * sizeof(int));
+
+  r_ssize n_chained = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    r_ssize len = dict_chain_length(v_buckets[i]);
+    ++v_hist[len];
+    n_chained += len;
+  }
+
+  r_obj* out = KEEP(r_alloc_list(DICT_STATS_SIZE));
+  r_attrib_poke_names(out, r_chr_n(v_dict_stats_names_c_strings, DICT_STATS_SIZE));
+
+  double mean_chain = n_used ? (double) n_chained / (double) n_used : 0;
+
+  r_list_poke(out, DICT_STATS_LOCS_n_buckets, r_len(p_dict->n_buckets));
+  r_list_poke(out, DICT_STATS_LOCS_n_entries, r_len(p_dict->n_entries));
+  r_list_poke(out, DICT_STATS_LOCS_n_resizes, r_len(p_dict->n_resizes));
+  r_list_poke(out, DICT_STATS_LOCS_max_chain, r_len(max_chain));
+  r_list_poke(out, DICT_STATS_LOCS_mean_chain, r_dbl(mean_chain));
+  r_list_poke(out, DICT_STATS_LOCS_chain_hist, hist);
+
+  FREE(2);
+  return out;
+}
+
+
+// -----------------------------------------------------------------------------
+// Open addressing
+
+/*
+ * Slots are probed linearly from the home slot of a key. Deletion
+ * shifts the following entries of the probe sequence back into the
+ * hole, so that lookups never need tombstones to keep probing.
+ */
+
+#define FLAT_DICT_LOAD_THRESHOLD 0.7
+#define FLAT_DICT_EMPTY r_syms.unbound
+
+struct r_flat_dict* r_new_flat_dict(r_ssize size) {
+  if (size <= 0) {
+    r_abort("`size` of dictionary must be positive.");
+  }
+  size = size_round_power_2(size);
+
+  r_obj* shelter = KEEP(r_alloc_list(3));
+
+  r_obj* dict_raw = r_alloc_raw0(sizeof(struct r_flat_dict));
+  r_list_poke(shelter, 0, dict_raw);
+  struct r_flat_dict* p_dict = r_raw_begin(dict_raw);
+
+  p_dict->shelter = shelter;
+  flat_dict_alloc_slots(p_dict, size);
+
+  r_attrib_poke(shelter, r_syms.class, r_chr("rlang_flat_dict"));
+
+  FREE(1);
+  return p_dict;
+}
+
+static
+void flat_dict_alloc_slots(struct r_flat_dict* p_dict, r_ssize size) {
+  r_obj* keys = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 1, keys);
+
+  for (r_ssize i = 0; i < size; ++i) {
+    r_list_poke(keys, i, FLAT_DICT_EMPTY);
+  }
+
+  r_obj* values = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 2, values);
+
+  p_dict->keys = keys;
+  p_dict->v_keys = r_list_cbegin(keys);
+  p_dict->values = values;
+  p_dict->v_values = r_list_cbegin(values);
+
+  p_dict->n_slots = size;
+  p_dict->n_entries = 0;
+}
+
+void r_flat_dict_resize(struct r_flat_dict* p_dict, r_ssize size) {
+  if (size < 0) {
+    size = p_dict->n_slots * DICT_GROWTH_FACTOR;
+  }
+  size = size_round_power_2(size);
+
+  while ((float) p_dict->n_entries / (float) size > FLAT_DICT_LOAD_THRESHOLD) {
+    size *= DICT_GROWTH_FACTOR;
+  }
+
+  r_obj* old_keys = KEEP(p_dict->keys);
+  r_obj* old_values = KEEP(p_dict->values);
+  r_ssize n = p_dict->n_slots;
+
+  flat_dict_alloc_slots(p_dict, size);
+
+  r_obj* const * v_old_keys = r_list_cbegin(old_keys);
+  r_obj* const * v_old_values = r_list_cbegin(old_values);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* key = v_old_keys[i];
+    if (key == FLAT_DICT_EMPTY) {
+      continue;
+    }
+
+    r_ssize slot = flat_dict_find_slot(p_dict, key);
+    r_list_poke(p_dict->keys, slot, key);
+    r_list_poke(p_dict->values, slot, v_old_values[i]);
+    ++p_dict->n_entries;
+  }
+
+  FREE(2);
+}
+
+static inline
+r_ssize flat_dict_home(const struct r_flat_dict* p_dict, r_obj* key) {
+  uint64_t hash = r_xxh3_64bits(&key, sizeof(r_obj*));
+  return hash & (p_dict->n_slots - 1);
+}
+
+// Returns the slot holding `key`, or the empty slot where it should
+// be inserted. The load threshold guarantees there is an empty slot.
+static inline
+r_ssize flat_dict_find_slot(const struct r_flat_dict* p_dict, r_obj* key) {
+  r_ssize mask = p_dict->n_slots - 1;
+  r_obj* const * v_keys = p_dict->v_keys;
+
+  r_ssize i = flat_dict_home(p_dict, key);
+
+  while (true) {
+    r_obj* elt = v_keys[i];
+    if (elt == key || elt == FLAT_DICT_EMPTY) {
+      return i;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+// Returns `false` if `key` already exists in the dictionary, `true`
+// otherwise
+bool r_flat_dict_put(struct r_flat_dict* p_dict, r_obj* key, r_obj* value) {
+  if (key == FLAT_DICT_EMPTY) {
+    r_stop_internal("r_flat_dict_put", "Can't use the unbound value as key.");
+  }
+
+  r_ssize i = flat_dict_find_slot(p_dict, key);
+  if (p_dict->v_keys[i] != FLAT_DICT_EMPTY) {
+    return false;
+  }
+
+  r_list_poke(p_dict->keys, i, key);
+  r_list_poke(p_dict->values, i, value);
+  ++p_dict->n_entries;
+
+  float load = (float) p_dict->n_entries / (float) p_dict->n_slots;
+  if (load > FLAT_DICT_LOAD_THRESHOLD) {
+    r_flat_dict_resize(p_dict, -1);
+  }
+
+  return true;
+}
+
+// Returns `true` if key existed and was deleted. Returns `false` if
+// the key could not be deleted because it did not exist in the dict.
+bool r_flat_dict_del(struct r_flat_dict* p_dict, r_obj* key) {
+  r_ssize hole = flat_dict_find_slot(p_dict, key);
+
+  r_obj* const * v_keys = p_dict->v_keys;
+  r_obj* const * v_values = p_dict->v_values;
+
+  if (v_keys[hole] == FLAT_DICT_EMPTY) {
+    return false;
+  }
+
+  r_ssize mask = p_dict->n_slots - 1;
+  r_ssize i = hole;
+
+  while (true) {
+    i = (i + 1) & mask;
+
+    r_obj* elt = v_keys[i];
+    if (elt == FLAT_DICT_EMPTY) {
+      break;
+    }
+
+    // The entry can fill the hole unless its home slot lies
+    // cyclically between the hole (excluded) and its current slot
+    r_ssize home = flat_dict_home(p_dict, elt);
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      r_list_poke(p_dict->keys, hole, elt);
+      r_list_poke(p_dict->values, hole, v_values[i]);
+      hole = i;
+    }
+  }
+
+  r_list_poke(p_dict->keys, hole, FLAT_DICT_EMPTY);
+  r_list_poke(p_dict->values, hole, r_null);
+  --p_dict->n_entries;
+
+  return true;
+}
+
+bool r_flat_dict_has(struct r_flat_dict* p_dict, r_obj* key) {
+  return r_flat_dict_get0(p_dict, key) != NULL;
+}
+
+r_obj* r_flat_dict_get(struct r_flat_dict* p_dict, r_obj* key) {
+  r_obj* out = r_flat_dict_get0(p_dict, key);
+
+  if (!out) {
+    r_abort("Can't find key in dictionary.");
+  }
+
+  return out;
+}
+
+r_obj* r_flat_dict_get0(struct r_flat_dict* p_dict, r_obj* key) {
+  r_ssize i = flat_dict_find_slot(p_dict, key);
+
+  if (p_dict->v_keys[i] == FLAT_DICT_EMPTY) {
+    return NULL;
+  } else {
+    return p_dict->v_values[i];
+  }
+}
+
+
+struct r_flat_dict_iterator* r_new_flat_dict_iterator(struct r_flat_dict* p_dict) {
+  r_obj* shelter = r_alloc_raw(sizeof(struct r_flat_dict_iterator));
+  struct r_flat_dict_iterator* p_it = r_raw_begin(shelter);
+
+  p_it->shelter = shelter;
+  p_it->key = r_null;
+  p_it->value = r_null;
+  p_it->i = 0;
+  p_it->n = p_dict->n_slots;
+  p_it->v_keys = p_dict->v_keys;
+  p_it->v_values = p_dict->v_values;
+
+  return p_it;
+}
+
+bool r_flat_dict_next(struct r_flat_dict_iterator* p_it) {
+  while (p_it->i < p_it->n) {
+    r_ssize i = p_it->i++;
+    r_obj* key = p_it->v_keys[i];
+
+    if (key != FLAT_DICT_EMPTY) {
+      p_it->key = key;
+      p_it->value = p_it->v_values[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// -----------------------------------------------------------------------------
+// String keys
+
+/*
+ * Same layout as `r_flat_dict` with an additional array of hashes.
+ * The hash of each key is computed once at insertion. Probing
+ * compares hashes before comparing bytes, and resizing and deletion
+ * reuse the stored hashes instead of hashing the keys again.
+ */
+
+#define STR_DICT_EMPTY r_null
+
+struct r_str_dict* r_new_str_dict(r_ssize size) {
+  if (size <= 0) {
+    r_abort("`size` of dictionary must be positive.");
+  }
+  size = size_round_power_2(size);
+
+  r_obj* shelter = KEEP(r_alloc_list(4));
+
+  r_obj* dict_raw = r_alloc_raw0(sizeof(struct r_str_dict));
+  r_list_poke(shelter, 0, dict_raw);
+  struct r_str_dict* p_dict = r_raw_begin(dict_raw);
+
+  p_dict->shelter = shelter;
+  str_dict_alloc_slots(p_dict, size);
+
+  r_attrib_poke(shelter, r_syms.class, r_chr("rlang_str_dict"));
+
+  FREE(1);
+  return p_dict;
+}
+
+static
+void str_dict_alloc_slots(struct r_str_dict* p_dict, r_ssize size) {
+  r_obj* keys = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 1, keys);
+
+  r_obj* values = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 2, values);
+
+  r_obj* hashes = r_alloc_raw(r_ssize_mult(size, sizeof(uint64_t)));
+  r_list_poke(p_dict->shelter, 3, hashes);
+
+  p_dict->keys = keys;
+  p_dict->v_keys = r_list_cbegin(keys);
+  p_dict->values = values;
+  p_dict->v_values = r_list_cbegin(values);
+  p_dict->v_hashes = (uint64_t*) r_raw_begin(hashes);
+
+  p_dict->n_slots = size;
+  p_dict->n_entries = 0;
+}
+
+void r_str_dict_resize(struct r_str_dict* p_dict, r_ssize size) {
+  if (size < 0) {
+    size = p_dict->n_slots * DICT_GROWTH_FACTOR;
+  }
+  size = size_round_power_2(size);
+
+  while ((float) p_dict->n_entries / (float) size > FLAT_DICT_LOAD_THRESHOLD) {
+    size *= DICT_GROWTH_FACTOR;
+  }
+
+  KEEP(p_dict->keys);
+  KEEP(p_dict->values);
+  KEEP(r_list_get(p_dict->shelter, 3));
+
+  r_obj* const * v_old_keys = p_dict->v_keys;
+  r_obj* const * v_old_values = p_dict->v_values;
+  const uint64_t* v_old_hashes = p_dict->v_hashes;
+  r_ssize n = p_dict->n_slots;
+
+  str_dict_alloc_slots(p_dict, size);
+
+  r_ssize mask = size - 1;
+  r_obj* const * v_keys = p_dict->v_keys;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* key = v_old_keys[i];
+    if (key == STR_DICT_EMPTY) {
+      continue;
+    }
+
+    // Keys are unique so we only need to find an empty slot
+    uint64_t hash = v_old_hashes[i];
+    r_ssize slot = hash & mask;
+    while (v_keys[slot] != STR_DICT_EMPTY) {
+      slot = (slot + 1) & mask;
+    }
+
+    r_list_poke(p_dict->keys, slot, key);
+    r_list_poke(p_dict->values, slot, v_old_values[i]);
+    p_dict->v_hashes[slot] = hash;
+    ++p_dict->n_entries;
   }
 
   FREE(3);
+}
+
+static inline
+uint64_t str_dict_hash(const char* key, r_ssize n) {
+  return r_xxh3_64bits(key, n);
+}
+
+// Returns the slot holding `key`, or the empty slot where it should
+// be inserted
+static inline
+r_ssize str_dict_find_slot(const struct r_str_dict* p_dict,
+                           const char* key,
+                           r_ssize n,
+                           uint64_t hash) {
+  r_ssize mask = p_dict->n_slots - 1;
+  r_obj* const * v_keys = p_dict->v_keys;
+  const uint64_t* v_hashes = p_dict->v_hashes;
+
+  r_ssize i = hash & mask;
+
+  while (true) {
+    r_obj* elt = v_keys[i];
+    if (elt == STR_DICT_EMPTY) {
+      return i;
+    }
+    if (v_hashes[i] == hash &&
+        r_length(elt) == n &&
+        memcmp(r_str_c_string(elt), key, n) == 0) {
+      return i;
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+static inline
+void str_dict_check_key(r_obj* key) {
+  if (r_typeof(key) != R_TYPE_string) {
+    r_stop_internal("str_dict_check_key", "`key` must be a CHARSXP.");
+  }
+  if (key == r_globals.na_str) {
+    r_abort("Can't use `NA` as dictionary key.");
+  }
+}
+
+// Returns `false` if `key` already exists in the dictionary, `true`
+// otherwise
+bool r_str_dict_put(struct r_str_dict* p_dict, r_obj* key, r_obj* value) {
+  str_dict_check_key(key);
+
+  const char* c_key = r_str_c_string(key);
+  r_ssize n = r_length(key);
+  uint64_t hash = str_dict_hash(c_key, n);
+
+  r_ssize i = str_dict_find_slot(p_dict, c_key, n, hash);
+  if (p_dict->v_keys[i] != STR_DICT_EMPTY) {
+    return false;
+  }
+
+  r_list_poke(p_dict->keys, i, key);
+  r_list_poke(p_dict->values, i, value);
+  p_dict->v_hashes[i] = hash;
+  ++p_dict->n_entries;
+
+  float load = (float) p_dict->n_entries / (float) p_dict->n_slots;
+  if (load > FLAT_DICT_LOAD_THRESHOLD) {
+    r_str_dict_resize(p_dict, -1);
+  }
+
+  return true;
+}
+
+// Returns `true` if key existed and was deleted. Returns `false` if
+// the key could not be deleted because it did not exist in the dict.
+bool r_str_dict_del(struct r_str_dict* p_dict, r_obj* key) {
+  str_dict_check_key(key);
+
+  const char* c_key = r_str_c_string(key);
+  r_ssize n = r_length(key);
+  uint64_t hash = str_dict_hash(c_key, n);
+
+  r_ssize hole = str_dict_find_slot(p_dict, c_key, n, hash);
+
+  r_obj* const * v_keys = p_dict->v_keys;
+  r_obj* const * v_values = p_dict->v_values;
+  uint64_t* v_hashes = p_dict->v_hashes;
+
+  if (v_keys[hole] == STR_DICT_EMPTY) {
+    return false;
+  }
+
+  r_ssize mask = p_dict->n_slots - 1;
+  r_ssize i = hole;
+
+  while (true) {
+    i = (i + 1) & mask;
+
+    r_obj* elt = v_keys[i];
+    if (elt == STR_DICT_EMPTY) {
+      break;
+    }
+
+    // See `r_flat_dict_del()`
+    r_ssize home = v_hashes[i] & mask;
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      r_list_poke(p_dict->keys, hole, elt);
+      r_list_poke(p_dict->values, hole, v_values[i]);
+      v_hashes[hole] = v_hashes[i];
+      hole = i;
+    }
+  }
+
+  r_list_poke(p_dict->keys, hole, STR_DICT_EMPTY);
+  r_list_poke(p_dict->values, hole, r_null);
+  --p_dict->n_entries;
+
+  return true;
+}
+
+bool r_str_dict_has(struct r_str_dict* p_dict, r_obj* key) {
+  return r_str_dict_get0(p_dict, key) != NULL;
+}
+bool r_str_dict_has_c(struct r_str_dict* p_dict, const char* key, r_ssize n) {
+  return r_str_dict_get0_c(p_dict, key, n) != NULL;
+}
+
+r_obj* r_str_dict_get(struct r_str_dict* p_dict, r_obj* key) {
+  r_obj* out = r_str_dict_get0(p_dict, key);
+
+  if (!out) {
+    r_abort("Can't find key in dictionary.");
+  }
+
   return out;
 }
-r_obj* r_dict_as_list(struct r_dict* p_dict) {
-  r_obj* out = KEEP(r_alloc_list(p_dict->n_entries));
 
-  struct r_dict_iterator* p_it = r_new_dict_iterator(p_dict);
-  KEEP(p_it->shelter);
+r_obj* r_str_dict_get0(struct r_str_dict* p_dict, r_obj* key) {
+  str_dict_check_key(key);
+  return r_str_dict_get0_c(p_dict, r_str_c_string(key), r_length(key));
+}
 
-  for (r_ssize i = 0; r_dict_next(p_it); ++i) {
-    r_list_poke(out, i, p_it->value);
+r_obj* r_str_dict_get0_c(struct r_str_dict* p_dict, const char* key, r_ssize n) {
+  uint64_t hash = str_dict_hash(key, n);
+  r_ssize i = str_dict_find_slot(p_dict, key, n, hash);
+
+  if (p_dict->v_keys[i] == STR_DICT_EMPTY) {
+    return NULL;
+  } else {
+    return p_dict->v_values[i];
+  }
+}
+
+
+struct r_str_dict_iterator* r_new_str_dict_iterator(struct r_str_dict* p_dict) {
+  r_obj* shelter = r_alloc_raw(sizeof(struct r_str_dict_iterator));
+  struct r_str_dict_iterator* p_it = r_raw_begin(shelter);
+
+  p_it->shelter = shelter;
+  p_it->key = r_null;
+  p_it->value = r_null;
+  p_it->i = 0;
+  p_it->n = p_dict->n_slots;
+  p_it->v_keys = p_dict->v_keys;
+  p_it->v_values = p_dict->v_values;
+
+  return p_it;
+}
+
+bool r_str_dict_next(struct r_str_dict_iterator* p_it) {
+  while (p_it->i < p_it->n) {
+    r_ssize i = p_it->i++;
+    r_obj* key = p_it->v_keys[i];
+
+    if (key != STR_DICT_EMPTY) {
+      p_it->key = key;
+      p_it->value = p_it->v_values[i];
+      return true;
+    }
+  }
+
+  return false;
+}
+
+
+// -----------------------------------------------------------------------------
+// Integer keys
+
+/*
+ * Same probing scheme as `r_flat_dict`. Since all integers are valid
+ * keys, empty slots are marked in the values list instead. Keys are
+ * hashed with a multiplicative (Fibonacci) hash, which spreads
+ * sequential ids over the table without calling into xxhash.
+ */
+
+#define INT_DICT_EMPTY r_syms.unbound
+
+struct r_int_dict* r_new_int_dict(r_ssize size) {
+  if (size <= 0) {
+    r_abort("`size` of dictionary must be positive.");
+  }
+  size = size_round_power_2(size);
+
+  r_obj* shelter = KEEP(r_alloc_list(3));
+
+  r_obj* dict_raw = r_alloc_raw0(sizeof(struct r_int_dict));
+  r_list_poke(shelter, 0, dict_raw);
+  struct r_int_dict* p_dict = r_raw_begin(dict_raw);
+
+  p_dict->shelter = shelter;
+  int_dict_alloc_slots(p_dict, size);
+
+  r_attrib_poke(shelter, r_syms.class, r_chr("rlang_int_dict"));
+
+  FREE(1);
+  return p_dict;
+}
+
+static
+void int_dict_alloc_slots(struct r_int_dict* p_dict, r_ssize size) {
+  r_obj* keys = r_alloc_raw(r_ssize_mult(size, sizeof(r_ssize)));
+  r_list_poke(p_dict->shelter, 1, keys);
+
+  r_obj* values = r_alloc_list(size);
+  r_list_poke(p_dict->shelter, 2, values);
+
+  for (r_ssize i = 0; i < size; ++i) {
+    r_list_poke(values, i, INT_DICT_EMPTY);
+  }
+
+  p_dict->v_keys = (r_ssize*) r_raw_begin(keys);
+  p_dict->values = values;
+  p_dict->v_values = r_list_cbegin(values);
+
+  p_dict->n_slots = size;
+  p_dict->n_entries = 0;
+}
+
+void r_int_dict_resize(struct r_int_dict* p_dict, r_ssize size) {
+  if (size < 0) {
+    size = p_dict->n_slots * DICT_GROWTH_FACTOR;
+  }
+  size = size_round_power_2(size);
+
+  while ((float) p_dict->n_entries / (float) size > FLAT_DICT_LOAD_THRESHOLD) {
+    size *= DICT_GROWTH_FACTOR;
+  }
+
+  KEEP(r_list_get(p_dict->shelter, 1));
+  KEEP(p_dict->values);
+
+  const r_ssize* v_old_keys = p_dict->v_keys;
+  r_obj* const * v_old_values = p_dict->v_values;
+  r_ssize n = p_dict->n_slots;
+
+  int_dict_alloc_slots(p_dict, size);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* value = v_old_values[i];
+    if (value == INT_DICT_EMPTY) {
+      continue;
+    }
+
+    r_ssize key = v_old_keys[i];
+    r_ssize slot = int_dict_find_slot(p_dict, key);
+
+    p_dict->v_keys[slot] = key;
+    r_list_poke(p_dict->values, slot, value);
+    ++p_dict->n_entries;
   }
 
   FREE(2);
+}
+
+static inline
+r_ssize int_dict_home(const struct r_int_dict* p_dict, r_ssize key) {
+  uint64_t hash = (uint64_t) key * UINT64_C(0x9E3779B97F4A7C15);
+  return (hash >> 32) & (p_dict->n_slots - 1);
+}
+
+// Returns the slot holding `key`, or the empty slot where it should
+// be inserted
+static inline
+r_ssize int_dict_find_slot(const struct r_int_dict* p_dict, r_ssize key) {
+  r_ssize mask = p_dict->n_slots - 1;
+  const r_ssize* v_keys = p_dict->v_keys;
+  r_obj* const * v_values = p_dict->v_values;
+
+  r_ssize i = int_dict_home(p_dict, key);
+
+  while (v_values[i] != INT_DICT_EMPTY && v_keys[i] != key) {
+    i = (i + 1) & mask;
+  }
+
+  return i;
+}
+
+// Returns `false` if `key` already exists in the dictionary, `true`
+// otherwise
+bool r_int_dict_put(struct r_int_dict* p_dict, r_ssize key, r_obj* value) {
+  if (value == INT_DICT_EMPTY) {
+    r_stop_internal("r_int_dict_put", "Can't use the unbound value as value.");
+  }
+
+  r_ssize i = int_dict_find_slot(p_dict, key);
+  if (p_dict->v_values[i] != INT_DICT_EMPTY) {
+    return false;
+  }
+
+  p_dict->v_keys[i] = key;
+  r_list_poke(p_dict->values, i, value);
+  ++p_dict->n_entries;
+
+  float load = (float) p_dict->n_entries / (float) p_dict->n_slots;
+  if (load > FLAT_DICT_LOAD_THRESHOLD) {
+    r_int_dict_resize(p_dict, -1);
+  }
+
+  return true;
+}
+
+// Returns `true` if key existed and was deleted. Returns `false` if
+// the key could not be deleted because it did not exist in the dict.
+bool r_int_dict_del(struct r_int_dict* p_dict, r_ssize key) {
+  r_ssize hole = int_dict_find_slot(p_dict, key);
+
+  r_ssize* v_keys = p_dict->v_keys;
+  r_obj* const * v_values = p_dict->v_values;
+
+  if (v_values[hole] == INT_DICT_EMPTY) {
+    return false;
+  }
+
+  r_ssize mask = p_dict->n_slots - 1;
+  r_ssize i = hole;
+
+  while (true) {
+    i = (i + 1) & mask;
+
+    r_obj* value = v_values[i];
+    if (value == INT_DICT_EMPTY) {
+      break;
+    }
+
+    // See `r_flat_dict_del()`
+    r_ssize home = int_dict_home(p_dict, v_keys[i]);
+    if (((i - home) & mask) >= ((i - hole) & mask)) {
+      v_keys[hole] = v_keys[i];
+      r_list_poke(p_dict->values, hole, value);
+      hole = i;
+    }
+  }
+
+  r_list_poke(p_dict->values, hole, INT_DICT_EMPTY);
+  --p_dict->n_entries;
+
+  return true;
+}
+
+bool r_int_dict_has(struct r_int_dict* p_dict, r_ssize key) {
+  return r_int_dict_get0(p_dict, key) != NULL;
+}
+
+r_obj* r_int_dict_get(struct r_int_dict* p_dict, r_ssize key) {
+  r_obj* out = r_int_dict_get0(p_dict, key);
+
+  if (!out) {
+    r_abort("Can't find key in dictionary.");
+  }
+
   return out;
 }
+
+r_obj* r_int_dict_get0(struct r_int_dict* p_dict, r_ssize key) {
+  r_ssize i = int_dict_find_slot(p_dict, key);
+  r_obj* out = p_dict->v_values[i];
+
+  if (out == INT_DICT_EMPTY) {
+    return NULL;
+  } else {
+    return out;
+  }
+}
+
+
+struct r_int_dict_iterator* r_new_int_dict_iterator(struct r_int_dict* p_dict) {
+  r_obj* shelter = r_alloc_raw(sizeof(struct r_int_dict_iterator));
+  struct r_int_dict_iterator* p_it = r_raw_begin(shelter);
+
+  p_it->shelter = shelter;
+  p_it->key = 0;
+  p_it->value = r_null;
+  p_it->i = 0;
+  p_it->n = p_dict->n_slots;
+  p_it->v_keys = p_dict->v_keys;
+  p_it->v_values = p_dict->v_values;
+
+  return p_it;
+}
+
+bool r_int_dict_next(struct r_int_dict_iterator* p_it) {
+  while (p_it->i < p_it->n) {
+    r_ssize i = p_it->i++;
+    r_obj* value = p_it->v_values[i];
+
+    if (value != INT_DICT_EMPTY) {
+      p_it->key = p_it->v_keys[i];
+      p_it->value = value;
+      return true;
+    }
+  }
+
+  return false;
+}
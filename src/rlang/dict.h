@@ -17,24 +17,61 @@ struct r_dict {
   r_ssize n_buckets;
   r_ssize n_entries;
 
+  // The dictionary doesn't shrink below its initial size
+  r_ssize min_buckets;
+
+  // Number of times the buckets were reallocated
+  r_ssize n_resizes;
+
   // For testing collisions
   bool prevent_resize;
+
+  // Nodes in insertion order, see `r_dict_keep_order()`. Deleted
+  // nodes are left in place until they make up half of the array.
+  struct r_dyn_array* p_order;
+  r_ssize n_order_holes;
 };
 
 struct r_dict* r_new_dict(r_ssize size);
 
+// Keeps track of the insertion order of the entries. Iterators then
+// walk the entries in that order with a linear scan instead of
+// walking the bucket chains. Existing entries are recorded in bucket
+// order.
+void r_dict_keep_order(struct r_dict* p_dict);
+
 bool r_dict_put(struct r_dict* p_dict, r_obj* key, r_obj* value);
 bool r_dict_del(struct r_dict* p_dict, r_obj* key);
 bool r_dict_has(struct r_dict* p_dict, r_obj* key);
 r_obj* r_dict_get(struct r_dict* p_dict, r_obj* key);
 r_obj* r_dict_get0(struct r_dict* p_dict, r_obj* key);
 
+// Bulk variants. `keys` is a list or a character vector. `r_dict_put_n()`
+// returns a logical vector indicating which keys were inserted.
+// `r_dict_get_n()` returns a list of `value` (with `NULL` for missing
+// keys) and `found`.
+r_obj* r_dict_put_n(struct r_dict* p_dict, r_obj* keys, r_obj* values);
+r_obj* r_dict_get_n(struct r_dict* p_dict, r_obj* keys);
+
 // Pass a negative size to resize by the default growth factor
 void r_dict_resize(struct r_dict* p_dict, r_ssize size);
 
 r_obj* r_dict_as_df_list(struct r_dict* p_dict);
 r_obj* r_dict_as_list(struct r_dict* p_dict);
 
+// Fills the caller-provided `keys` and `values` lists with the
+// entries of the dictionary, in iteration order. Either column may
+// be `r_null` to skip it. The columns must be at least as long as the
+// number of entries, which is returned. This lets callers reuse
+// their columns across exports.
+r_ssize r_dict_fill(struct r_dict* p_dict, r_obj* keys, r_obj* values);
+
+// Returns a named list of statistics about the layout of the buckets:
+// `n_buckets`, `n_entries`, `n_resizes`, `max_chain` and `mean_chain`
+// (over non-empty buckets), and `chain_hist`, the number of buckets
+// of each chain length starting from 0.
+r_obj* r_dict_stats(struct r_dict* p_dict);
+
 
 struct r_dict_iterator {
   r_obj* shelter;
@@ -46,10 +83,162 @@ struct r_dict_iterator {
   r_ssize n;
   r_obj* const * v_buckets;
   r_obj* node;
+
+  // Non-NULL when the dictionary keeps the insertion order
+  r_obj* const * v_order;
 };
 
+// Entries are visited in insertion order if the dictionary keeps
+// track of it, and in bucket order otherwise
 struct r_dict_iterator* r_new_dict_iterator(struct r_dict* p_dict);
 bool r_dict_next(struct r_dict_iterator* p_it);
 
 
+/**
+ * Open addressing variant of `r_dict`. Keys and values are stored in
+ * two parallel lists and collisions are resolved by linear probing,
+ * so inserting doesn't allocate and lookups probe contiguous
+ * memory. Empty slots are marked with `r_syms.unbound`, which can't
+ * be used as key.
+ */
+
+struct r_flat_dict {
+  r_obj* shelter;
+
+  /* private: */
+  r_obj* keys;
+  r_obj* const * v_keys;
+  r_obj* values;
+  r_obj* const * v_values;
+
+  r_ssize n_slots;
+  r_ssize n_entries;
+};
+
+struct r_flat_dict* r_new_flat_dict(r_ssize size);
+
+bool r_flat_dict_put(struct r_flat_dict* p_dict, r_obj* key, r_obj* value);
+bool r_flat_dict_del(struct r_flat_dict* p_dict, r_obj* key);
+bool r_flat_dict_has(struct r_flat_dict* p_dict, r_obj* key);
+r_obj* r_flat_dict_get(struct r_flat_dict* p_dict, r_obj* key);
+r_obj* r_flat_dict_get0(struct r_flat_dict* p_dict, r_obj* key);
+
+// Pass a negative size to resize by the default growth factor. The
+// size is increased if needed to stay below the load threshold.
+void r_flat_dict_resize(struct r_flat_dict* p_dict, r_ssize size);
+
+
+struct r_flat_dict_iterator {
+  r_obj* shelter;
+  r_obj* key;
+  r_obj* value;
+
+  /* private: */
+  r_ssize i;
+  r_ssize n;
+  r_obj* const * v_keys;
+  r_obj* const * v_values;
+};
+
+struct r_flat_dict_iterator* r_new_flat_dict_iterator(struct r_flat_dict* p_dict);
+bool r_flat_dict_next(struct r_flat_dict_iterator* p_it);
+
+
+/**
+ * Dictionary keyed by the contents of strings rather than by
+ * pointer. Keys are stored as CHARSXP but can be looked up from a C
+ * string and its length, without allocating a CHARSXP. Strings are
+ * compared byte by byte, regardless of their declared encoding.
+ */
+
+struct r_str_dict {
+  r_obj* shelter;
+
+  /* private: */
+  r_obj* keys;
+  r_obj* const * v_keys;
+  r_obj* values;
+  r_obj* const * v_values;
+  uint64_t* v_hashes;
+
+  r_ssize n_slots;
+  r_ssize n_entries;
+};
+
+struct r_str_dict* r_new_str_dict(r_ssize size);
+
+bool r_str_dict_put(struct r_str_dict* p_dict, r_obj* key, r_obj* value);
+bool r_str_dict_del(struct r_str_dict* p_dict, r_obj* key);
+bool r_str_dict_has(struct r_str_dict* p_dict, r_obj* key);
+r_obj* r_str_dict_get(struct r_str_dict* p_dict, r_obj* key);
+r_obj* r_str_dict_get0(struct r_str_dict* p_dict, r_obj* key);
+
+// Lookup from `n` bytes of `key`, which doesn't need to be
+// null-terminated
+r_obj* r_str_dict_get0_c(struct r_str_dict* p_dict, const char* key, r_ssize n);
+bool r_str_dict_has_c(struct r_str_dict* p_dict, const char* key, r_ssize n);
+
+void r_str_dict_resize(struct r_str_dict* p_dict, r_ssize size);
+
+
+struct r_str_dict_iterator {
+  r_obj* shelter;
+  r_obj* key;
+  r_obj* value;
+
+  /* private: */
+  r_ssize i;
+  r_ssize n;
+  r_obj* const * v_keys;
+  r_obj* const * v_values;
+};
+
+struct r_str_dict_iterator* r_new_str_dict_iterator(struct r_str_dict* p_dict);
+bool r_str_dict_next(struct r_str_dict_iterator* p_it);
+
+
+/**
+ * Dictionary keyed by unboxed integers. Keys are stored in a raw
+ * vector of `r_ssize` and values in a parallel list.
+ */
+
+struct r_int_dict {
+  r_obj* shelter;
+
+  /* private: */
+  r_ssize* v_keys;
+  r_obj* values;
+  r_obj* const * v_values;
+
+  r_ssize n_slots;
+  r_ssize n_entries;
+};
+
+struct r_int_dict* r_new_int_dict(r_ssize size);
+
+bool r_int_dict_put(struct r_int_dict* p_dict, r_ssize key, r_obj* value);
+bool r_int_dict_del(struct r_int_dict* p_dict, r_ssize key);
+bool r_int_dict_has(struct r_int_dict* p_dict, r_ssize key);
+r_obj* r_int_dict_get(struct r_int_dict* p_dict, r_ssize key);
+r_obj* r_int_dict_get0(struct r_int_dict* p_dict, r_ssize key);
+
+void r_int_dict_resize(struct r_int_dict* p_dict, r_ssize size);
+
+
+struct r_int_dict_iterator {
+  r_obj* shelter;
+  r_ssize key;
+  r_obj* value;
+
+  /* private: */
+  r_ssize i;
+  r_ssize n;
+  const r_ssize* v_keys;
+  r_obj* const * v_values;
+};
+
+struct r_int_dict_iterator* r_new_int_dict_iterator(struct r_int_dict* p_dict);
+bool r_int_dict_next(struct r_int_dict_iterator* p_it);
+
+
 #endif
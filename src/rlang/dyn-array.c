@@ -1,4 +1,5 @@
 #include <rlang.h>
+#include <stdlib.h>
 #include "dyn-array.h"
 
 #define R_DYN_ARRAY_GROWTH_FACTOR 2
@@ -27,6 +28,9 @@ struct r_dyn_array* r_new_dyn_vector(enum r_type type,
   p_vec->type = type;
   p_vec->elt_byte_size = r_vec_elt_sizeof0(type);
   p_vec->data = vec_data;
+  p_vec->p_arena = NULL;
+  p_vec->v_sbo = NULL;
+  p_vec->off_heap = false;
 
   switch (type) {
   case R_TYPE_character:
@@ -48,7 +52,339 @@ struct r_dyn_array* r_new_dyn_vector(enum r_type type,
   return p_vec;
 }
 
+struct r_dyn_array* r_new_dyn_vector_in(struct r_arena* p_arena,
+                                        enum r_type type,
+                                        r_ssize capacity) {
+  switch (type) {
+  case R_TYPE_character:
+  case R_TYPE_list:
+    r_stop_internal("r_new_dyn_vector_in", "Arena arrays can't store R objects.");
+  default:
+    break;
+  }
+
+  r_ssize elt_byte_size = r_vec_elt_sizeof0(type);
+
+  struct r_dyn_array* p_vec = r_arena_alloc(p_arena, sizeof(struct r_dyn_array));
+  p_vec->shelter = p_arena->shelter;
+  p_vec->count = 0;
+  p_vec->capacity = capacity;
+  p_vec->growth_factor = R_DYN_ARRAY_GROWTH_FACTOR;
+  p_vec->type = type;
+  p_vec->elt_byte_size = elt_byte_size;
+  p_vec->data = r_null;
+  p_vec->barrier_set = NULL;
+  p_vec->p_arena = p_arena;
+  p_vec->v_sbo = NULL;
+  p_vec->off_heap = false;
+
+  p_vec->v_data = r_arena_alloc(p_arena, r_ssize_mult(capacity, elt_byte_size));
+  p_vec->v_data_const = p_vec->v_data;
+
+  return p_vec;
+}
+
+struct r_dyn_array* r_new_dyn_array_in(struct r_arena* p_arena,
+                                       r_ssize elt_byte_size,
+                                       r_ssize capacity) {
+  r_ssize arr_byte_size = r_ssize_mult(capacity, elt_byte_size);
+
+  struct r_dyn_array* p_arr = r_new_dyn_vector_in(p_arena, R_TYPE_raw, arr_byte_size);
+  p_arr->capacity = capacity;
+  p_arr->elt_byte_size = elt_byte_size;
+
+  return p_arr;
+}
+
+void r_init_dyn_vector_sbo(struct r_dyn_array* p_arr,
+                           enum r_type type,
+                           void* v_storage,
+                           r_ssize capacity,
+                           r_keep_t keep_loc) {
+  switch (type) {
+  case R_TYPE_character:
+  case R_TYPE_list:
+    r_stop_internal("r_init_dyn_vector_sbo", "Small-buffer arrays can't store R objects.");
+  default:
+    break;
+  }
+
+  p_arr->shelter = r_null;
+  p_arr->count = 0;
+  p_arr->capacity = capacity;
+  p_arr->growth_factor = R_DYN_ARRAY_GROWTH_FACTOR;
+  p_arr->type = type;
+  p_arr->elt_byte_size = r_vec_elt_sizeof0(type);
+  p_arr->data = r_null;
+  p_arr->barrier_set = NULL;
+  p_arr->p_arena = NULL;
+
+  p_arr->v_data = v_storage;
+  p_arr->v_data_const = v_storage;
+
+  p_arr->v_sbo = v_storage;
+  p_arr->sbo_capacity = capacity;
+  p_arr->sbo_keep_loc = keep_loc;
+  p_arr->off_heap = false;
+}
+
+void r_init_dyn_array_sbo(struct r_dyn_array* p_arr,
+                          r_ssize elt_byte_size,
+                          void* v_storage,
+                          r_ssize capacity,
+                          r_keep_t keep_loc) {
+  r_init_dyn_vector_sbo(p_arr, R_TYPE_raw, v_storage, capacity, keep_loc);
+  p_arr->elt_byte_size = elt_byte_size;
+}
+
+static
+void arr_resize_sbo(struct r_dyn_array* p_arr, r_ssize capacity) {
+  enum r_type type = p_arr->type;
+  r_ssize n = capacity;
+  if (type == R_TYPE_raw) {
+    n = r_ssize_mult(capacity, p_arr->elt_byte_size);
+  }
+
+  r_obj* data = p_arr->data;
+
+  if (data == r_null) {
+    // Still in the caller's storage
+    if (capacity <= p_arr->sbo_capacity) {
+      p_arr->count = r_ssize_min(p_arr->count, capacity);
+      p_arr->capacity = capacity;
+      return;
+    }
+
+    data = r_alloc_vector(type, n);
+    memcpy(r_vec_begin0(type, data),
+           p_arr->v_sbo,
+           r_ssize_mult(p_arr->count, p_arr->elt_byte_size));
+  } else {
+    data = r_vec_resize0(type, data, n);
+  }
+  KEEP_AT(data, p_arr->sbo_keep_loc);
+
+  p_arr->shelter = data;
+  p_arr->data = data;
+  p_arr->count = r_ssize_min(p_arr->count, capacity);
+  p_arr->capacity = capacity;
+  p_arr->v_data = r_vec_begin0(type, data);
+  p_arr->v_data_const = p_arr->v_data;
+}
+
+static
+void off_heap_finalize(r_obj* xptr) {
+  free(R_ExternalPtrAddr(xptr));
+  R_ClearExternalPtr(xptr);
+}
+
+static
+r_obj* off_heap_new_xptr() {
+  r_obj* xptr = KEEP(R_MakeExternalPtr(NULL, r_null, r_null));
+  R_RegisterCFinalizerEx(xptr, &off_heap_finalize, TRUE);
+  FREE(1);
+  return xptr;
+}
+
+static
+void arr_resize_off_heap(struct r_dyn_array* p_arr, r_ssize capacity) {
+  r_obj* xptr = r_list_get(p_arr->shelter, 1);
+
+  // Allocate at least one element so `realloc()` doesn't free the buffer
+  r_ssize n = r_ssize_max(capacity, 1);
+  size_t size = r_ssize_mult(n, p_arr->elt_byte_size);
+
+  void* v_data = realloc(R_ExternalPtrAddr(xptr), size);
+  if (!v_data) {
+    r_abort("Can't allocate %.0f bytes.", (double) size);
+  }
+  R_SetExternalPtrAddr(xptr, v_data);
+
+  p_arr->v_data = v_data;
+  p_arr->v_data_const = v_data;
+  p_arr->count = r_ssize_min(p_arr->count, capacity);
+  p_arr->capacity = capacity;
+}
+
+struct r_dyn_array* r_new_dyn_vector_off_heap(enum r_type type,
+                                              r_ssize capacity) {
+  switch (type) {
+  case R_TYPE_character:
+  case R_TYPE_list:
+    r_stop_internal("r_new_dyn_vector_off_heap", "Off-heap arrays can't store R objects.");
+  default:
+    break;
+  }
+
+  r_obj* shelter = KEEP(r_alloc_list(2));
+  r_poke_attrib(shelter, attribs_dyn_array);
+  r_mark_object(shelter);
+
+  r_obj* vec_raw = r_alloc_raw(sizeof(struct r_dyn_array));
+  r_list_poke(shelter, 0, vec_raw);
+  r_list_poke(shelter, 1, off_heap_new_xptr());
+
+  struct r_dyn_array* p_arr = r_raw_begin(vec_raw);
+  p_arr->shelter = shelter;
+  p_arr->count = 0;
+  p_arr->capacity = 0;
+  p_arr->growth_factor = R_DYN_ARRAY_GROWTH_FACTOR;
+  p_arr->data = r_null;
+  p_arr->v_data = NULL;
+  p_arr->v_data_const = NULL;
+  p_arr->type = type;
+  p_arr->elt_byte_size = r_vec_elt_sizeof0(type);
+  p_arr->barrier_set = NULL;
+  p_arr->p_arena = NULL;
+  p_arr->v_sbo = NULL;
+  p_arr->off_heap = true;
+
+  arr_resize_off_heap(p_arr, capacity);
+
+  FREE(1);
+  return p_arr;
+}
+
+#if R_HAS_ALTREP
+
+// Unwrapped off-heap vectors store the external pointer owning their
+// data in `data1` and their length in `data2`
+static R_altrep_class_t off_heap_lgl_class;
+static R_altrep_class_t off_heap_int_class;
+static R_altrep_class_t off_heap_dbl_class;
+static R_altrep_class_t off_heap_cpl_class;
+static R_altrep_class_t off_heap_raw_class;
+
+static
+R_altrep_class_t off_heap_class(enum r_type type) {
+  switch (type) {
+  case R_TYPE_logical: return off_heap_lgl_class;
+  case R_TYPE_integer: return off_heap_int_class;
+  case R_TYPE_double: return off_heap_dbl_class;
+  case R_TYPE_complex: return off_heap_cpl_class;
+  case R_TYPE_raw: return off_heap_raw_class;
+  default: r_stop_unimplemented_type("off_heap_class", type);
+  }
+}
+
+static
+R_xlen_t off_heap_length(r_obj* x) {
+  return r_as_ssize(R_altrep_data2(x));
+}
+
+static
+void* off_heap_dataptr(r_obj* x, Rboolean writable) {
+  return R_ExternalPtrAddr(R_altrep_data1(x));
+}
+
+static
+const void* off_heap_dataptr_or_null(r_obj* x) {
+  return R_ExternalPtrAddr(R_altrep_data1(x));
+}
+
+// Serialised as a regular vector
+static
+r_obj* off_heap_serialized_state(r_obj* x) {
+  return r_vec_n(r_typeof(x),
+                 R_ExternalPtrAddr(R_altrep_data1(x)),
+                 off_heap_length(x));
+}
+
+static
+r_obj* off_heap_unserialize(r_obj* cls, r_obj* state) {
+  return state;
+}
+
+static
+Rboolean off_heap_inspect(r_obj* x,
+                          int pre,
+                          int deep,
+                          int pvec,
+                          void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_off_heap (len=%ld)\n", (long) off_heap_length(x));
+  return TRUE;
+}
+
+static
+r_obj* arr_unwrap_off_heap(struct r_dyn_array* p_arr) {
+  r_arr_shrink_to_fit(p_arr);
+
+  r_obj* xptr = r_list_get(p_arr->shelter, 1);
+  r_obj* n = KEEP(r_len(p_arr->count));
+  r_obj* out = KEEP(R_new_altrep(off_heap_class(p_arr->type), xptr, n));
+
+  // The buffer is now owned by `out`. Start over with a new one.
+  r_list_poke(p_arr->shelter, 1, off_heap_new_xptr());
+  p_arr->v_data = NULL;
+  p_arr->count = 0;
+  arr_resize_off_heap(p_arr, 0);
+
+  FREE(2);
+  return out;
+}
+
+static
+void init_off_heap_class(R_altrep_class_t cls) {
+  R_set_altrep_Length_method(cls, &off_heap_length);
+  R_set_altrep_Inspect_method(cls, &off_heap_inspect);
+  R_set_altrep_Serialized_state_method(cls, &off_heap_serialized_state);
+  R_set_altrep_Unserialize_method(cls, &off_heap_unserialize);
+  R_set_altvec_Dataptr_method(cls, &off_heap_dataptr);
+  R_set_altvec_Dataptr_or_null_method(cls, &off_heap_dataptr_or_null);
+}
+
+void r_init_altrep_dyn_array(DllInfo* dll) {
+  off_heap_lgl_class = R_make_altlogical_class("rlang_off_heap_lgl", "rlang", dll);
+  off_heap_int_class = R_make_altinteger_class("rlang_off_heap_int", "rlang", dll);
+  off_heap_dbl_class = R_make_altreal_class("rlang_off_heap_dbl", "rlang", dll);
+  off_heap_cpl_class = R_make_altcomplex_class("rlang_off_heap_cpl", "rlang", dll);
+  off_heap_raw_class = R_make_altraw_class("rlang_off_heap_raw", "rlang", dll);
+
+  init_off_heap_class(off_heap_lgl_class);
+  init_off_heap_class(off_heap_int_class);
+  init_off_heap_class(off_heap_dbl_class);
+  init_off_heap_class(off_heap_cpl_class);
+  init_off_heap_class(off_heap_raw_class);
+}
+
+#else
+
+static
+r_obj* arr_unwrap_off_heap(struct r_dyn_array* p_arr) {
+  r_obj* out = r_vec_n(p_arr->type, p_arr->v_data, p_arr->count);
+  p_arr->count = 0;
+  return out;
+}
+
+void r_init_altrep_dyn_array(DllInfo* dll) { }
+
+#endif
+
+// Copies data that doesn't live in an R vector
+static
+r_obj* arr_unwrap_copy(struct r_dyn_array* p_arr) {
+  r_ssize n = p_arr->count;
+  if (p_arr->type == R_TYPE_raw) {
+    n = r_ssize_mult(n, p_arr->elt_byte_size);
+  }
+
+  r_obj* out = r_alloc_vector(p_arr->type, n);
+  memcpy(r_vec_begin0(p_arr->type, out),
+         p_arr->v_data_const,
+         r_ssize_mult(p_arr->count, p_arr->elt_byte_size));
+
+  return out;
+}
+
+// Returns the data as is when `count` equals `capacity`
 r_obj* r_arr_unwrap(struct r_dyn_array* p_arr) {
+  if (p_arr->off_heap) {
+    return arr_unwrap_off_heap(p_arr);
+  }
+  if (p_arr->p_arena || (p_arr->v_sbo && p_arr->data == r_null)) {
+    return arr_unwrap_copy(p_arr);
+  }
+
   if (p_arr->type == R_TYPE_raw) {
     return r_raw_resize(p_arr->data, p_arr->count * p_arr->elt_byte_size);
   } else {
@@ -68,18 +404,44 @@ struct r_dyn_array* r_new_dyn_array(r_ssize elt_byte_size,
 }
 
 
+// Grows geometrically so that at least `n` elements fit
+static inline
+void arr_grow(struct r_dyn_array* p_arr, r_ssize n) {
+  r_ssize new_capacity = r_ssize_mult(p_arr->capacity,
+                                      p_arr->growth_factor);
+  r_arr_resize(p_arr, r_ssize_max(new_capacity, n));
+}
+
+// Dispatches on the type once rather than calling `barrier_set`
+// for each element
+static
+void arr_barrier_poke_n(struct r_dyn_array* p_arr,
+                        r_ssize start,
+                        r_obj* const * v_elts,
+                        r_ssize n) {
+  r_obj* data = p_arr->data;
+
+  if (p_arr->type == R_TYPE_list) {
+    for (r_ssize i = 0; i < n; ++i) {
+      r_list_poke(data, start + i, v_elts ? v_elts[i] : r_null);
+    }
+  } else {
+    for (r_ssize i = 0; i < n; ++i) {
+      r_chr_poke(data, start + i, v_elts ? v_elts[i] : r_null);
+    }
+  }
+}
+
 void r_arr_push_back(struct r_dyn_array* p_arr,
                      const void* p_elt) {
   r_ssize count = ++p_arr->count;
   if (count > p_arr->capacity) {
-    r_ssize new_capacity = r_ssize_mult(p_arr->capacity,
-                                        p_arr->growth_factor);
-    r_arr_resize(p_arr, new_capacity);
+    arr_grow(p_arr, count);
   }
 
   if (p_arr->barrier_set) {
     r_obj* value = *((r_obj* const *) p_elt);
-    p_arr->barrier_set(p_arr->data, count - 1, value);
+    arr_barrier_poke_n(p_arr, count - 1, &value, 1);
     return;
   }
 
@@ -90,13 +452,79 @@ void r_arr_push_back(struct r_dyn_array* p_arr,
   }
 }
 
+void r_arr_push_back_n(struct r_dyn_array* p_arr,
+                       const void* p_elts,
+                       r_ssize n) {
+  if (n <= 0) {
+    return;
+  }
+
+  r_ssize count = p_arr->count;
+  r_ssize new_count = r_ssize_add(count, n);
+  if (new_count > p_arr->capacity) {
+    arr_grow(p_arr, new_count);
+  }
+  p_arr->count = new_count;
+
+  if (p_arr->barrier_set) {
+    arr_barrier_poke_n(p_arr, count, (r_obj* const *) p_elts, n);
+    return;
+  }
+
+  void* p_dest = r_arr_pointer(p_arr, count);
+  r_ssize byte_size = r_ssize_mult(n, p_arr->elt_byte_size);
+
+  if (p_elts) {
+    memcpy(p_dest, p_elts, byte_size);
+  } else {
+    memset(p_dest, 0, byte_size);
+  }
+}
+
+void r_arr_reserve(struct r_dyn_array* p_arr,
+                   r_ssize capacity) {
+  if (capacity > p_arr->capacity) {
+    r_arr_resize(p_arr, capacity);
+  }
+}
+
+void r_arr_shrink_to_fit(struct r_dyn_array* p_arr) {
+  if (p_arr->count < p_arr->capacity) {
+    r_arr_resize(p_arr, p_arr->count);
+  }
+}
+
 void r_arr_resize(struct r_dyn_array* p_arr,
                   r_ssize capacity) {
+  if (p_arr->off_heap) {
+    arr_resize_off_heap(p_arr, capacity);
+    return;
+  }
+  if (p_arr->v_sbo) {
+    arr_resize_sbo(p_arr, capacity);
+    return;
+  }
+  if (p_arr->p_arena) {
+    p_arr->v_data = r_arena_realloc(p_arr->p_arena,
+                                    p_arr->v_data,
+                                    r_ssize_mult(p_arr->capacity, p_arr->elt_byte_size),
+                                    r_ssize_mult(capacity, p_arr->elt_byte_size));
+    p_arr->v_data_const = p_arr->v_data;
+    p_arr->count = r_ssize_min(p_arr->count, capacity);
+    p_arr->capacity = capacity;
+    return;
+  }
+
   enum r_type type = p_arr->type;
 
-  r_obj* data = r_vec_resize0(type,
-                              r_list_get(p_arr->shelter, 1),
-                              p_arr->elt_byte_size * capacity);
+  // Only raw arrays are sized in bytes. Sizing the data exactly lets
+  // `r_arr_unwrap()` return it without a copy when the array is full.
+  r_ssize n = capacity;
+  if (type == R_TYPE_raw) {
+    n = r_ssize_mult(capacity, p_arr->elt_byte_size);
+  }
+
+  r_obj* data = r_vec_resize0(type, r_list_get(p_arr->shelter, 1), n);
   r_list_poke(p_arr->shelter, 1, data);
 
   p_arr->count = r_ssize_min(p_arr->count, capacity);
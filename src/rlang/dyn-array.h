@@ -16,6 +16,18 @@ struct r_dyn_array {
   enum r_type type;
   r_ssize elt_byte_size;
   void (*barrier_set)(r_obj* x, r_ssize i, r_obj* value);
+
+  // Non-NULL when the array and its data live in an arena
+  struct r_arena* p_arena;
+
+  // Non-NULL for small-buffer arrays, see `r_init_dyn_vector_sbo()`
+  void* v_sbo;
+  r_ssize sbo_capacity;
+  r_keep_t sbo_keep_loc;
+
+  // True when the data is allocated with `malloc()`. The second
+  // element of the shelter is then an external pointer owning it.
+  bool off_heap;
 };
 
 struct r_dyn_array* r_new_dyn_vector(enum r_type type,
@@ -24,14 +36,79 @@ struct r_dyn_array* r_new_dyn_vector(enum r_type type,
 struct r_dyn_array* r_new_dyn_array(r_ssize elt_byte_size,
                                     r_ssize capacity);
 
+// Variants that allocate the array and its data in `p_arena`. The
+// `shelter` of these arrays is the shelter of the arena. Only atomic
+// types are supported because the arena is not traversed by the GC.
+struct r_dyn_array* r_new_dyn_vector_in(struct r_arena* p_arena,
+                                        enum r_type type,
+                                        r_ssize capacity);
+
+struct r_dyn_array* r_new_dyn_array_in(struct r_arena* p_arena,
+                                       r_ssize elt_byte_size,
+                                       r_ssize capacity);
+
+/**
+ * Variant whose data lives off the R heap and grows with `realloc()`,
+ * so that growing doesn't leave garbage for the GC to collect. When
+ * ALTREP is available, `r_arr_unwrap()` hands the buffer over to an
+ * ALTREP vector without copying. The array is empty after unwrapping.
+ * Only atomic types are supported.
+ */
+struct r_dyn_array* r_new_dyn_vector_off_heap(enum r_type type,
+                                              r_ssize capacity);
+
+// Registers the ALTREP classes of unwrapped off-heap arrays. Must be
+// called from the package init hook.
+void r_init_altrep_dyn_array(DllInfo* dll);
+
 void r_arr_resize(struct r_dyn_array* p_arr,
                   r_ssize capacity);
 
 void r_arr_push_back(struct r_dyn_array* p_arr,
                      const void* p_elt);
 
+// Appends `n` contiguous elements at once. When `p_elts` is `NULL`,
+// they are zeroed, or set to `NULL` in barrier arrays.
+void r_arr_push_back_n(struct r_dyn_array* p_arr,
+                       const void* p_elts,
+                       r_ssize n);
+
+// Ensures that `capacity` elements fit without further resizing
+void r_arr_reserve(struct r_dyn_array* p_arr,
+                   r_ssize capacity);
+
+void r_arr_shrink_to_fit(struct r_dyn_array* p_arr);
+
 r_obj* r_arr_unwrap(struct r_dyn_array* p_arr);
 
+/**
+ * Small-buffer variants. Both the array and the storage for its first
+ * `capacity` elements are provided by the caller, typically on the
+ * stack, so that short arrays don't allocate. When the array outgrows
+ * `v_storage`, its data spills to an R vector that is protected at
+ * `keep_loc`. The caller must reserve that location beforehand:
+ *
+ *   int storage[16];
+ *   struct r_dyn_array arr;
+ *   r_keep_t loc;
+ *   KEEP_HERE(r_null, &loc);
+ *   r_init_dyn_vector_sbo(&arr, R_TYPE_integer, storage, 16, loc);
+ *
+ * The `shelter` of these arrays is `r_null` until they spill. Only
+ * atomic types are supported.
+ */
+void r_init_dyn_vector_sbo(struct r_dyn_array* p_arr,
+                           enum r_type type,
+                           void* v_storage,
+                           r_ssize capacity,
+                           r_keep_t keep_loc);
+
+void r_init_dyn_array_sbo(struct r_dyn_array* p_arr,
+                          r_ssize elt_byte_size,
+                          void* v_storage,
+                          r_ssize capacity,
+                          r_keep_t keep_loc);
+
 static inline
 void* r_arr_pointer(struct r_dyn_array* p_arr, r_ssize i) {
   if (p_arr->barrier_set) {
@@ -94,13 +171,35 @@ static inline
 void r_cpl_push_back(struct r_dyn_array* p_vec, r_complex_t elt) {
   r_arr_push_back(p_vec, &elt);
 }
+// `elt` is only protected when the array needs to grow
+static inline
+void r_chr_push_back(struct r_dyn_array* p_vec, r_obj* elt) {
+  if (p_vec->count < p_vec->capacity) {
+    SET_STRING_ELT(p_vec->data, p_vec->count++, elt);
+    return;
+  }
+  KEEP(elt);
+  r_arr_push_back(p_vec, &elt);
+  FREE(1);
+}
 static inline
 void r_list_push_back(struct r_dyn_array* p_vec, r_obj* elt) {
+  if (p_vec->count < p_vec->capacity) {
+    SET_VECTOR_ELT(p_vec->data, p_vec->count++, elt);
+    return;
+  }
   KEEP(elt);
   r_arr_push_back(p_vec, &elt);
   FREE(1);
 }
 
+// Appends `n` elements with a single capacity check. The elements
+// must be protected by the caller, e.g. as elements of a list.
+static inline
+void r_list_push_back_n(struct r_dyn_array* p_vec, r_obj* const * v_elts, r_ssize n) {
+  r_arr_push_back_n(p_vec, v_elts, n);
+}
+
 #define R_ARR_GET(TYPE, X, I) (*((TYPE*) r_arr_pointer((X), (I))))
 #define R_ARR_POKE(TYPE, X, I, VAL) (*((TYPE*) r_arr_pointer((X), (I))) = (VAL))
 
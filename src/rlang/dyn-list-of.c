@@ -97,6 +97,191 @@ r_obj* r_lof_unwrap(struct r_dyn_list_of* p_lof) {
   return out;
 }
 
+enum csr {
+  CSR_values,
+  CSR_offsets,
+  CSR_SIZE
+};
+static
+const char* v_csr_names_c_strings[CSR_SIZE] = {
+  "values",
+  "offsets"
+};
+
+r_obj* r_lof_unwrap_csr(struct r_dyn_list_of* p_lof) {
+  enum r_type type = p_lof->type;
+  r_ssize n = p_lof->count;
+  r_ssize elt_byte_size = p_lof->elt_byte_size;
+  struct r_pair_ptr_ssize* v_arrays = r_arr_begin(p_lof->p_arrays);
+
+  r_obj* offsets = KEEP(r_alloc_integer(n + 1));
+  int* v_offsets = r_int_begin(offsets);
+
+  r_ssize total = 0;
+  for (r_ssize i = 0; i < n; ++i) {
+    v_offsets[i] = total;
+    total += v_arrays[i].size;
+    if (total > INT_MAX) {
+      r_abort("Can't unwrap more than %d values.", INT_MAX);
+    }
+  }
+  v_offsets[n] = total;
+
+  r_obj* values = KEEP(r_alloc_vector(type, total));
+  unsigned char* v_values = r_vec_begin0(type, values);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    struct r_pair_ptr_ssize array = v_arrays[i];
+    memcpy(v_values + v_offsets[i] * elt_byte_size,
+           array.ptr,
+           array.size * elt_byte_size);
+  }
+
+  r_obj* out = KEEP(r_alloc_list(CSR_SIZE));
+  r_list_poke(out, CSR_values, values);
+  r_list_poke(out, CSR_offsets, offsets);
+
+  r_obj* nms = KEEP(r_chr_n(v_csr_names_c_strings, CSR_SIZE));
+  r_attrib_poke_names(out, nms);
+
+  FREE(4);
+  return out;
+}
+
+static
+r_obj* csr_elt(r_obj* csr, r_ssize i) {
+  r_obj* values = r_list_get(csr, CSR_values);
+  const int* v_offsets = r_int_cbegin(r_list_get(csr, CSR_offsets));
+
+  enum r_type type = r_typeof(values);
+  r_ssize elt_byte_size = r_vec_elt_sizeof0(type);
+
+  const unsigned char* v_values = r_vec_cbegin0(type, values);
+  v_values += v_offsets[i] * elt_byte_size;
+
+  return r_vec_n(type, (void*) v_values, v_offsets[i + 1] - v_offsets[i]);
+}
+
+#if R_HAS_ALTLIST
+
+// The CSR list is stored in `data1`. Materialised elements are cached
+// in a list stored in `data2`, allocated on first access. Once fully
+// materialised, `data1` is set to `NULL` and the cache becomes the
+// data.
+static
+R_altrep_class_t csr_list_class;
+
+static
+r_obj* csr_list_cache(r_obj* x) {
+  r_obj* cache = R_altrep_data2(x);
+  if (cache == r_null) {
+    cache = r_alloc_list(XLENGTH(x));
+    R_set_altrep_data2(x, cache);
+  }
+  return cache;
+}
+
+static
+R_xlen_t csr_list_length(r_obj* x) {
+  r_obj* csr = R_altrep_data1(x);
+  if (csr == r_null) {
+    return r_length(R_altrep_data2(x));
+  }
+  return r_length(r_list_get(csr, CSR_offsets)) - 1;
+}
+
+static
+r_obj* csr_list_elt(r_obj* x, R_xlen_t i) {
+  r_obj* csr = R_altrep_data1(x);
+  r_obj* cache = csr_list_cache(x);
+  if (csr == r_null) {
+    return r_list_get(cache, i);
+  }
+
+  r_obj* out = r_list_get(cache, i);
+  if (out == r_null) {
+    out = csr_elt(csr, i);
+    r_list_poke(cache, i, out);
+  }
+
+  return out;
+}
+
+static
+r_obj* csr_list_materialise(r_obj* x) {
+  r_obj* cache = csr_list_cache(x);
+  if (R_altrep_data1(x) == r_null) {
+    return cache;
+  }
+
+  r_ssize n = r_length(cache);
+  for (r_ssize i = 0; i < n; ++i) {
+    csr_list_elt(x, i);
+  }
+
+  R_set_altrep_data1(x, r_null);
+  return cache;
+}
+
+static
+void csr_list_set_elt(r_obj* x, R_xlen_t i, r_obj* value) {
+  r_list_poke(csr_list_materialise(x), i, value);
+}
+
+static
+void* csr_list_dataptr(r_obj* x, Rboolean writable) {
+  return r_vec_dataptr(csr_list_materialise(x));
+}
+
+static
+Rboolean csr_list_inspect(r_obj* x,
+                          int pre,
+                          int deep,
+                          int pvec,
+                          void (*inspect_subtree)(r_obj*, int, int, int)) {
+  Rprintf("rlang_csr_list (len=%ld, materialised=%s)\n",
+          (long) csr_list_length(x),
+          R_altrep_data1(x) == r_null ? "T" : "F");
+  return TRUE;
+}
+
+r_obj* r_csr_as_list(r_obj* csr) {
+  return R_new_altrep(csr_list_class, csr, r_null);
+}
+
+void r_init_altrep_dyn_list_of(DllInfo* dll) {
+  csr_list_class = R_make_altlist_class("rlang_csr_list", "rlang", dll);
+
+  R_set_altrep_Length_method(csr_list_class, &csr_list_length);
+  R_set_altrep_Inspect_method(csr_list_class, &csr_list_inspect);
+  R_set_altvec_Dataptr_method(csr_list_class, &csr_list_dataptr);
+  R_set_altlist_Elt_method(csr_list_class, &csr_list_elt);
+  R_set_altlist_Set_elt_method(csr_list_class, &csr_list_set_elt);
+}
+
+#else
+
+static
+r_obj* csr_as_list_eager(r_obj* csr) {
+  r_ssize n = r_length(r_list_get(csr, CSR_offsets)) - 1;
+  r_obj* out = KEEP(r_alloc_list(n));
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_list_poke(out, i, csr_elt(csr, i));
+  }
+
+  FREE(1);
+  return out;
+}
+
+r_obj* r_csr_as_list(r_obj* csr) {
+  return csr_as_list_eager(csr);
+}
+
+void r_init_altrep_dyn_list_of(DllInfo* dll) { }
+
+#endif
+
 static
 void r_lof_resize(struct r_dyn_list_of* p_lof, r_ssize capacity) {
   r_ssize count = p_lof->count;
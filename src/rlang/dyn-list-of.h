@@ -36,6 +36,24 @@ struct r_dyn_list_of* r_new_dyn_list_of(enum r_type type,
 
 r_obj* r_lof_unwrap(struct r_dyn_list_of* p_lof);
 
+/**
+ * Unwraps to a compressed sparse row layout: a list of a flat `values`
+ * vector containing all inner arrays back to back, and an integer
+ * vector of `count + 1` zero-based `offsets`. Array `i` spans
+ * `values[offsets[i]]` to `values[offsets[i + 1] - 1]`.
+ *
+ * This allocates two vectors instead of one per inner array.
+ */
+r_obj* r_lof_unwrap_csr(struct r_dyn_list_of* p_lof);
+
+// Returns a list over a CSR layout. On R >= 4.3.0 this is a lazy
+// ALTREP list whose elements are only materialised when accessed.
+r_obj* r_csr_as_list(r_obj* csr);
+
+// Registers the ALTREP class for `r_csr_as_list()`. Must be called
+// from the package init hook.
+void r_init_altrep_dyn_list_of(DllInfo* dll);
+
 void r_lof_push_back(struct r_dyn_list_of* p_lof);
 
 void r_lof_arr_push_back(struct r_dyn_list_of* p_lof,
@@ -48,6 +48,8 @@ static r_obj* new_env__parent_node = NULL;
 static r_obj* new_env__size_node = NULL;
 
 r_obj* r_alloc_environment(r_ssize size, r_obj* parent) {
+  r_instr_count_environment();
+
   parent = parent ? parent : r_empty_env;
   r_node_poke_car(new_env__parent_node, parent);
 
@@ -66,47 +68,92 @@ r_obj* r_alloc_environment(r_ssize size, r_obj* parent) {
 static r_obj* env2list_call = NULL;
 static r_obj* list2env_call = NULL;
 
-r_obj* r_env_as_list_compat(r_obj* env, r_obj* out);
+// Same as R's `IS_ACTIVE_BINDING()`. Checking the binding cell
+// avoids a lookup per binding.
+#define ACTIVE_BINDING_MASK (1 << 15)
+#define CELL_IS_ACTIVE(cell) (LEVELS(cell) & ACTIVE_BINDING_MASK)
 
-r_obj* r_env_as_list(r_obj* env) {
-  r_obj* out = KEEP(eval_with_x(env2list_call, env));
+static
+r_ssize env_frame_collect(r_obj* frame,
+                          r_obj* out,
+                          r_obj* nms,
+                          int* v_active,
+                          r_ssize i) {
+  r_ssize n = r_length(out);
+
+  for (; frame != r_null; frame = r_node_cdr(frame)) {
+    r_obj* value = r_node_car(frame);
+
+    // Not counted in the length of the environment
+    if (value == r_syms.unbound) {
+      continue;
+    }
+    if (i >= n) {
+      r_stop_internal("env_frame_collect", "Frame is longer than expected.");
+    }
 
-#if R_VERSION < R_Version(4, 0, 0)
-  out = r_env_as_list_compat(env, out);
-#endif
+    r_list_poke(out, i, value);
+    r_chr_poke(nms, i, PRINTNAME(r_node_tag(frame)));
+    v_active[i] = CELL_IS_ACTIVE(frame) != 0;
+    ++i;
+  }
 
-  FREE(1);
-  return out;
+  return i;
 }
 
-// On R < 4.0, the active binding function is returned instead of
-// its value. We invoke the active bindings here to get consistent
-// behaviour in all supported R versions.
-r_obj* r_env_as_list_compat(r_obj* env, r_obj* out) {
-  r_obj* nms = KEEP(r_env_names(env));
-  r_obj* types = KEEP(r_env_binding_types(env, nms));
+/*
+ * The bindings are first collected from the frame or hash table along
+ * with their active status. Promises and active bindings are then
+ * resolved by position. They can't be resolved while walking the
+ * frame because their code could modify the environment.
+ *
+ * With `eval_active = false`, the functions of active bindings are
+ * returned instead of their values. The base environment stores its
+ * bindings in the symbols and goes through `as.list()`.
+ */
+r_obj* r_env_as_list_opts(r_obj* env, bool eval_active) {
+  if (env == r_base_env || env == R_BaseNamespace) {
+    return eval_with_x(env2list_call, env);
+  }
 
-  if (types == R_NilValue) {
-    FREE(2);
-    return out;
+  r_ssize n = r_env_length(env);
+
+  r_obj* out = KEEP(r_alloc_list(n));
+  r_obj* nms = r_alloc_character(n);
+  r_attrib_poke_names(out, nms);
+
+  r_obj* active = KEEP(r_alloc_logical(n));
+  int* v_active = r_lgl_begin(active);
+
+  r_obj* table = HASHTAB(env);
+  r_ssize count = 0;
+
+  if (table == r_null) {
+    count = env_frame_collect(FRAME(env), out, nms, v_active, count);
+  } else {
+    r_ssize n_buckets = r_length(table);
+    r_obj* const * v_table = r_list_cbegin(table);
+
+    for (r_ssize i = 0; i < n_buckets; ++i) {
+      count = env_frame_collect(v_table[i], out, nms, v_active, count);
+    }
   }
 
-  r_ssize n = r_length(nms);
-  r_obj* const * p_nms = r_chr_cbegin(nms);
-  const int* p_types = r_int_cbegin(types);
+  if (count != n) {
+    r_stop_internal("r_env_as_list_opts", "Frame is shorter than expected.");
+  }
 
   for (r_ssize i = 0; i < n; ++i) {
-    enum r_env_binding_type type = p_types[i];
-    if (type == R_ENV_BINDING_ACTIVE) {
-      r_ssize fn_idx = r_chr_detect_index(nms, r_str_c_string(p_nms[i]));
-      if (fn_idx < 0) {
-        r_abort("Internal error: Can't find active binding in list");
-      }
+    r_obj* value = r_list_get(out, i);
 
-      r_obj* fn = r_list_get(out, fn_idx);
-      r_obj* value = r_eval(KEEP(r_call(fn)), r_empty_env);
-      r_list_poke(out, fn_idx, value);
-      FREE(1);
+    if (v_active[i]) {
+      if (eval_active) {
+        value = r_eval(KEEP(r_call(value)), r_empty_env);
+        r_list_poke(out, i, value);
+        FREE(1);
+      }
+    } else if (r_typeof(value) == R_TYPE_promise) {
+      r_list_poke(out, i, r_eval(value, r_empty_env));
     }
   }
 
@@ -114,18 +161,76 @@ r_obj* r_env_as_list_compat(r_obj* env, r_obj* out) {
   return out;
 }
 
+r_obj* r_env_as_list(r_obj* env) {
+  return r_env_as_list_opts(env, true);
+}
+
 r_obj* r_list_as_environment(r_obj* x, r_obj* parent) {
   parent = parent ? parent : r_empty_env;
   return eval_with_xy(list2env_call, x, parent);
 }
 
+static
+void env_clone_frame(r_obj* frame, r_obj* out) {
+  while (frame != r_null) {
+    r_obj* sym = r_node_tag(frame);
+    r_obj* value = r_node_car(frame);
+
+    if (value == r_syms.unbound) {
+      frame = r_node_cdr(frame);
+      continue;
+    }
+
+    // The function of an active binding is stored in the binding
+    // cell. Promises are copied as is and stay unforced.
+    if (CELL_IS_ACTIVE(frame)) {
+      R_MakeActiveBinding(sym, value, out);
+    } else {
+#if R_VERSION < R_Version(4, 0, 0)
+      // Without reference counting the clone might be modified in
+      // place and affect the original environment (#621)
+      r_mark_shared(value);
+#endif
+      r_env_poke(out, sym, value);
+    }
+
+    frame = r_node_cdr(frame);
+  }
+}
+
+/*
+ * Copies the bindings of the frame or hash table of `env` in a single
+ * pass, without going through a list. The base environment stores its
+ * bindings in the symbols and is cloned through `as.list()` instead.
+ */
 r_obj* r_env_clone(r_obj* env, r_obj* parent) {
   if (parent == NULL) {
     parent = r_env_parent(env);
   }
 
-  r_obj* out = KEEP(r_env_as_list(env));
-  out = r_list_as_environment(out, parent);
+  if (env == r_base_env || env == R_BaseNamespace) {
+    r_obj* out = KEEP(r_env_as_list(env));
+    out = r_list_as_environment(out, parent);
+
+    FREE(1);
+    return out;
+  }
+
+  r_ssize n = r_env_length(env);
+  r_obj* out = KEEP(r_alloc_environment(r_ssize_max(n, 29), parent));
+
+  r_obj* table = HASHTAB(env);
+
+  if (table == r_null) {
+    env_clone_frame(FRAME(env), out);
+  } else {
+    r_ssize n_buckets = r_length(table);
+    r_obj* const * v_table = r_list_cbegin(table);
+
+    for (r_ssize i = 0; i < n_buckets; ++i) {
+      env_clone_frame(v_table[i], out);
+    }
+  }
 
   FREE(1);
   return out;
@@ -146,6 +251,46 @@ void r_env_poke_lazy(r_obj* env, r_obj* sym, r_obj* expr, r_obj* eval_env) {
 }
 
 
+/*
+ * Bindings are removed through `r_env_unbind()` one symbol at a time.
+ * Editing the frame or the hash table directly would depend on
+ * private details of R's environment storage.
+ */
+r_ssize r_env_unbind_dict(r_obj* env, struct r_dict* p_syms) {
+  if (p_syms->n_entries == 0) {
+    return 0;
+  }
+
+  r_obj* syms = KEEP(r_alloc_list(p_syms->n_entries));
+  r_ssize n = r_dict_fill(p_syms, syms, r_null);
+  r_ssize n_removed = 0;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* sym = r_list_get(syms, i);
+    if (r_env_has(env, sym)) {
+      r_env_unbind(env, sym);
+      r_dict_del(p_syms, sym);
+      ++n_removed;
+    }
+  }
+
+  FREE(1);
+  return n_removed;
+}
+
+void r_env_clear(r_obj* env) {
+  r_obj* nms = KEEP(r_env_names(env));
+  r_ssize n = r_length(nms);
+  r_obj* const * v_nms = r_chr_cbegin(nms);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_env_unbind(env, r_str_as_symbol(v_nms[i]));
+  }
+
+  FREE(1);
+}
+
+
 static r_obj* remove_call = NULL;
 
 #if (R_VERSION < R_Version(4, 0, 0))
@@ -194,7 +339,8 @@ void r_init_rlang_ns_env() {
 r_obj* r_methods_ns_env = NULL;
 
 void r_init_library_env() {
-  new_env_call = r_parse_eval("as.call(list(new.env, TRUE, NULL, NULL))", r_base_env);
+  // Constructed rather than parsed to save load time
+  new_env_call = r_call4(r_base_ns_get("new.env"), r_true, r_null, r_null);
   r_preserve(new_env_call);
 
   new_env__parent_node = r_node_cddr(new_env_call);
@@ -214,5 +360,6 @@ void r_init_library_env() {
   remove_call = r_parse("remove(list = y, envir = x, inherits = z)");
   r_preserve(remove_call);
 
-  r_methods_ns_env = r_parse_eval("asNamespace('methods')", r_base_env);
+  r_methods_ns_env = R_FindNamespace(KEEP(r_chr("methods")));
+  FREE(1);
 }
@@ -67,6 +67,8 @@ r_obj* r_base_ns_get(const char* name);
 r_obj* r_alloc_environment(r_ssize size, r_obj* parent);
 
 r_obj* r_env_as_list(r_obj* x);
+// With `eval_active = false`, returns the functions of active bindings
+r_obj* r_env_as_list_opts(r_obj* env, bool eval_active);
 r_obj* r_list_as_environment(r_obj* x, r_obj* parent);
 r_obj* r_env_clone(r_obj* env, r_obj* parent);
 
@@ -88,6 +90,14 @@ r_obj* r_env_poke(r_obj* env, r_obj* sym, r_obj* value) {
 }
 void r_env_poke_lazy(r_obj* env, r_obj* sym, r_obj* expr, r_obj* eval_env);
 
+// Removes the bindings of the symbols in `p_syms`, which are deleted
+// from the dictionary as they are found. Returns the number of
+// removed bindings.
+r_ssize r_env_unbind_dict(r_obj* env, struct r_dict* p_syms);
+
+// Removes all bindings
+void r_env_clear(r_obj* env);
+
 static inline
 void r_env_poke_active(r_obj* env, r_obj* sym, r_obj* fn) {
   if (r_env_has(env, sym)) {
@@ -0,0 +1,20 @@
+#include <rlang.h>
+#include "instrument.h"
+
+bool r_instr_enabled = false;
+struct r_instr_counts r_instr_counts = { 0 };
+
+int r_instr_protect_depth(void) {
+  // The index of a protected object is its position on the stack
+  PROTECT_INDEX i;
+  PROTECT_WITH_INDEX(r_null, &i);
+  UNPROTECT(1);
+  return i;
+}
+
+void r_instr_sample_protect(void) {
+  int depth = r_instr_protect_depth();
+  if (depth > r_instr_counts.protect_max) {
+    r_instr_counts.protect_max = depth;
+  }
+}
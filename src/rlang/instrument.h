@@ -0,0 +1,54 @@
+#ifndef RLANG_INSTRUMENT_H
+#define RLANG_INSTRUMENT_H
+
+
+/*
+ * Counters of the objects allocated through the library allocators,
+ * e.g. `r_alloc_vector()`, `r_new_node()`, `r_call2()` or
+ * `r_alloc_environment()`. Allocations performed by R itself, for
+ * instance while evaluating code, are not counted.
+ *
+ * Counting is disabled by default and costs a branch per allocation.
+ * When enabled with `r_instr_enabled`, the depth of the protection
+ * stack is also sampled at each counted allocation and its maximum is
+ * recorded in `protect_max`.
+ */
+
+struct r_instr_counts {
+  r_ssize n_vectors;
+  r_ssize n_nodes;
+  r_ssize n_environments;
+  int protect_max;
+};
+
+extern bool r_instr_enabled;
+extern struct r_instr_counts r_instr_counts;
+
+// Current number of objects on the protection stack
+int r_instr_protect_depth(void);
+void r_instr_sample_protect(void);
+
+static inline
+void r_instr_count_vector(void) {
+  if (r_instr_enabled) {
+    ++r_instr_counts.n_vectors;
+    r_instr_sample_protect();
+  }
+}
+static inline
+void r_instr_count_nodes(r_ssize n) {
+  if (r_instr_enabled) {
+    r_instr_counts.n_nodes += n;
+    r_instr_sample_protect();
+  }
+}
+static inline
+void r_instr_count_environment(void) {
+  if (r_instr_enabled) {
+    ++r_instr_counts.n_environments;
+    r_instr_sample_protect();
+  }
+}
+
+
+#endif
@@ -22,6 +22,36 @@ r_obj* r_node_tree_clone(r_obj* x) {
   return x;
 }
 
+r_obj* r_alloc_pairlist(r_ssize n) {
+  r_instr_count_nodes(n);
+  return Rf_allocList(r_ssize_as_integer(n));
+}
+
+r_obj* r_list_as_pairlist(r_obj* x) {
+  if (r_typeof(x) != R_TYPE_list) {
+    r_stop_internal("r_list_as_pairlist", "Expected a list.");
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* out = KEEP(r_alloc_pairlist(n));
+
+  r_obj* const * v_x = r_list_cbegin(x);
+  r_obj* names = r_names(x);
+  r_obj* const * v_names = (names == r_null) ? NULL : r_chr_cbegin(names);
+
+  r_obj* node = out;
+  for (r_ssize i = 0; i < n; ++i, node = r_node_cdr(node)) {
+    r_node_poke_car(node, v_x[i]);
+
+    if (v_names && v_names[i] != r_globals.empty_str) {
+      r_node_poke_tag(node, r_str_as_symbol(v_names[i]));
+    }
+  }
+
+  FREE(1);
+  return out;
+}
+
 r_obj* r_pairlist_find(r_obj* node, r_obj* tag) {
   while (node != r_null) {
     if (r_node_tag(node) == tag) {
@@ -20,15 +20,24 @@ static inline void r_node_poke_cddr(r_obj* x, r_obj* newcdr) { SETCDR(CDR(x), ne
 
 static inline
 r_obj* r_new_node(r_obj* car, r_obj* cdr) {
+  r_instr_count_nodes(1);
   return Rf_cons(car, cdr);
 }
 static inline
 r_obj* r_new_node3(r_obj* car, r_obj* cdr, r_obj* tag) {
+  r_instr_count_nodes(1);
   r_obj* out = Rf_cons(car, cdr);
   SET_TAG(out, tag);
   return out;
 }
 
+// Allocates `n` linked nodes at once. Fill them by walking their CDRs
+// rather than consing nodes one by one.
+r_obj* r_alloc_pairlist(r_ssize n);
+
+// Non-empty names become tags
+r_obj* r_list_as_pairlist(r_obj* x);
+
 #define r_pairlist Rf_list1
 #define r_pairlist2 Rf_list2
 #define r_pairlist3 Rf_list3
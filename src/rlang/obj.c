@@ -1,10 +1,32 @@
 #include "rlang.h"
+#include <stdint.h>
+#include <string.h>
 
 #define PRECIOUS_DICT_INIT_SIZE 256
 
 static
 struct r_dict* p_precious_dict = NULL;
 
+#define PRECIOUS_SLAB_INIT_SIZE 256
+
+// Marks slots of the free list that are in use
+#define PRECIOUS_SLOT_USED -2
+
+enum precious_slab {
+  PRECIOUS_SLAB_slots,
+  PRECIOUS_SLAB_next,
+  PRECIOUS_SLAB_SIZE
+};
+
+// The slab is a list of preserved objects and a parallel raw vector of
+// `r_ssize` chaining the free slots. `precious_free` is the head of the
+// free list, or -1 when the slab is full.
+static r_obj* precious_slab = NULL;
+static r_obj* precious_slots = NULL;
+static r_ssize* v_precious_next = NULL;
+static r_ssize precious_size = 0;
+static r_ssize precious_free = -1;
+
 #include "decl/obj-decl.h"
 
 
@@ -39,6 +61,57 @@ void r_unpreserve(r_obj* x) {
 }
 
 
+r_ssize r_preserve_handle(r_obj* x) {
+  if (precious_free < 0) {
+    KEEP(x);
+    precious_slab_grow();
+    FREE(1);
+  }
+
+  r_ssize i = precious_free;
+  precious_free = v_precious_next[i];
+  v_precious_next[i] = PRECIOUS_SLOT_USED;
+
+  r_list_poke(precious_slots, i, x);
+  return i;
+}
+
+void r_release_handle(r_ssize handle) {
+  if (handle < 0 || handle >= precious_size || v_precious_next[handle] != PRECIOUS_SLOT_USED) {
+    r_stop_internal("r_release_handle", "Invalid handle %d.", (int) handle);
+  }
+
+  r_list_poke(precious_slots, handle, r_null);
+  v_precious_next[handle] = precious_free;
+  precious_free = handle;
+}
+
+static
+void precious_slab_grow() {
+  r_ssize size = precious_size;
+  r_ssize new_size = size ? r_ssize_mult(size, 2) : PRECIOUS_SLAB_INIT_SIZE;
+
+  r_obj* slots = r_list_resize(precious_slots, new_size);
+  r_list_poke(precious_slab, PRECIOUS_SLAB_slots, slots);
+
+  r_obj* next = r_list_get(precious_slab, PRECIOUS_SLAB_next);
+  next = r_raw_resize(next, r_ssize_mult(new_size, sizeof(r_ssize)));
+  r_list_poke(precious_slab, PRECIOUS_SLAB_next, next);
+
+  r_ssize* v_next = r_raw_begin(next);
+
+  // Chain the new slots in front of the free list
+  for (r_ssize i = size; i < new_size - 1; ++i) {
+    v_next[i] = i + 1;
+  }
+  v_next[new_size - 1] = precious_free;
+  precious_free = size;
+
+  precious_slots = slots;
+  v_precious_next = v_next;
+  precious_size = new_size;
+}
+
 static
 r_obj* new_precious_stack(r_obj* x) {
   r_obj* stack = KEEP(r_alloc_list(2));
@@ -78,12 +151,42 @@ enum r_type r_chr_as_r_type(r_obj* type) {
   return r_c_str_as_r_type(r_chr_get_c_string(type, 0));
 }
 
-const char* obj_address_formatter = "%p";
+// Addresses are formatted like `"0x%p"` without the leading `0x` of
+// platforms whose `%p` already includes it. The padding and case of
+// `%p` are detected on load so that formatting doesn't go through
+// `snprintf()`.
+static bool obj_address_upper = false;
+static bool obj_address_pad = false;
+
+int r_obj_address_c(char* buf, r_obj* x) {
+  static const char lower[] = "0123456789abcdef";
+  static const char upper[] = "0123456789ABCDEF";
+  const char* digits = obj_address_upper ? upper : lower;
+
+  uintptr_t addr = (uintptr_t) x;
+  int n_digits = 2 * sizeof(uintptr_t);
+
+  if (!obj_address_pad) {
+    while (n_digits > 1 && !(addr >> (4 * (n_digits - 1)))) {
+      --n_digits;
+    }
+  }
+
+  buf[0] = '0';
+  buf[1] = 'x';
+  for (int i = 0; i < n_digits; ++i) {
+    buf[1 + n_digits - i] = digits[addr & 0xf];
+    addr >>= 4;
+  }
+  buf[2 + n_digits] = '\0';
+
+  return 2 + n_digits;
+}
 
 r_obj* r_obj_address(r_obj* x) {
-  static char buf[1000];
-  snprintf(buf, 1000, obj_address_formatter, (void*) x);
-  return Rf_mkChar(buf);
+  char buf[R_OBJ_ADDRESS_MAX_SIZE];
+  int n = r_obj_address_c(buf, x);
+  return Rf_mkCharLenCE(buf, n, CE_NATIVE);
 }
 
 void r_init_library_obj(r_obj* ns) {
@@ -94,8 +197,23 @@ void r_init_library_obj(r_obj* ns) {
              p_precious_dict->shelter);
   FREE(1);
 
-  const char* null_addr = r_str_c_string(r_obj_address(r_null));
-  if (null_addr[0] != '0' || null_addr[1] != 'x') {
-    obj_address_formatter = "0x%p";
+  precious_slab = KEEP(r_alloc_list(PRECIOUS_SLAB_SIZE));
+  precious_slots = r_alloc_list(0);
+  r_list_poke(precious_slab, PRECIOUS_SLAB_slots, precious_slots);
+  r_list_poke(precious_slab, PRECIOUS_SLAB_next, r_alloc_raw(0));
+  r_env_poke(ns,
+             r_sym(".__rlang_lib_precious_slab__."),
+             precious_slab);
+  FREE(1);
+  precious_slab_grow();
+
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%p", (void*) (uintptr_t) 0xab);
+
+  const char* digits = buf;
+  if (digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+    digits += 2;
   }
+  obj_address_pad = digits[0] == '0';
+  obj_address_upper = strchr(digits, 'A') || strchr(digits, 'B');
 }
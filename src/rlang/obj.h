@@ -17,6 +17,12 @@ enum r_type r_typeof(r_obj* x) {
 void r_preserve(r_obj* x);
 void r_unpreserve(r_obj* x);
 
+// Preserves `x` in a slot of a global slab and returns the location
+// of that slot. Unlike `r_preserve()`, no lookup is needed and release
+// is O(1), but each handle must be released exactly once.
+r_ssize r_preserve_handle(r_obj* x);
+void r_release_handle(r_ssize handle);
+
 static inline
 void r_mark_shared(r_obj* x) {
   MARK_NOT_MUTABLE(x);
@@ -106,6 +112,15 @@ bool r_is_identical(r_obj* x, r_obj* y) {
   return R_compute_identical(x, y, 16);
 }
 
+// Large enough for `"0x"`, the hexadecimal digits of a 64-bit
+// address, and the terminating null
+#define R_OBJ_ADDRESS_MAX_SIZE 19
+
 r_obj* r_obj_address(r_obj* x);
 
+// Writes the address of `x` to `buf`, which must hold
+// `R_OBJ_ADDRESS_MAX_SIZE` bytes, and returns its length. Doesn't
+// allocate.
+int r_obj_address_c(char* buf, r_obj* x);
+
 #endif
@@ -0,0 +1,528 @@
+#include <rlang.h>
+#include "pdict.h"
+
+/*
+ * Each node is a list whose first element is an integer vector of two
+ * bitmaps, followed by the inline entries as key/value pairs, followed
+ * by the child nodes:
+ *
+ *   [maps, k0, v0, k1, v1, ..., node0, node1, ...]
+ *
+ * A node consumes `PDICT_BITS` bits of the key hash. The data bitmap
+ * flags the hash fragments that have an inline entry and the node
+ * bitmap those that have a child node. The position of an entry is
+ * the number of bits set below its own bit. Once all bits of the hash
+ * are consumed, keys of identical hashes are stored as a flat list of
+ * pairs in a collision node with empty bitmaps.
+ *
+ * Nodes are kept in canonical form: a child node that is left with a
+ * single entry after a deletion is inlined in its parent.
+ */
+
+#define PDICT_BITS 5
+#define PDICT_FRAG_MASK 0x1F
+#define PDICT_HASH_BITS 64
+
+#define PDICT_ROOT(D) r_list_get(D, 0)
+
+static inline
+uint64_t pdict_hash(r_obj* key) {
+  return r_xxh3_64bits(&key, sizeof(r_obj*));
+}
+static inline
+uint32_t pdict_bit(uint64_t hash, int shift) {
+  return (uint32_t) 1 << ((hash >> shift) & PDICT_FRAG_MASK);
+}
+
+static inline
+int pdict_popcount(uint32_t x) {
+  x = x - ((x >> 1) & 0x55555555);
+  x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+  x = (x + (x >> 4)) & 0x0F0F0F0F;
+  return (x * 0x01010101) >> 24;
+}
+static inline
+int pdict_index(uint32_t map, uint32_t bit) {
+  return pdict_popcount(map & (bit - 1));
+}
+
+static inline
+uint32_t pdict_datamap(r_obj* node) {
+  return (uint32_t) r_int_begin(r_list_get(node, 0))[0];
+}
+static inline
+uint32_t pdict_nodemap(r_obj* node) {
+  return (uint32_t) r_int_begin(r_list_get(node, 0))[1];
+}
+static inline
+r_ssize pdict_n_data(r_obj* node, int shift) {
+  if (shift >= PDICT_HASH_BITS) {
+    return (r_length(node) - 1) / 2;
+  } else {
+    return pdict_popcount(pdict_datamap(node));
+  }
+}
+
+static inline
+r_ssize pdict_data_loc(r_ssize i) {
+  return 1 + 2 * i;
+}
+static inline
+r_ssize pdict_node_loc(r_ssize n_data, r_ssize i) {
+  return 1 + 2 * n_data + i;
+}
+
+static
+r_obj* pdict_new_node(uint32_t datamap, uint32_t nodemap, r_ssize n) {
+  r_obj* node = KEEP(r_alloc_list(n + 1));
+
+  r_obj* maps = r_alloc_integer(2);
+  r_list_poke(node, 0, maps);
+
+  int* v_maps = r_int_begin(maps);
+  v_maps[0] = (int) datamap;
+  v_maps[1] = (int) nodemap;
+
+  FREE(1);
+  return node;
+}
+
+static
+r_obj* pdict_new_dict(r_obj* root, r_ssize size) {
+  r_obj* dict = KEEP(r_alloc_list(2));
+  r_list_poke(dict, 0, root);
+  r_list_poke(dict, 1, r_len(size));
+  FREE(1);
+  return dict;
+}
+
+r_obj* r_new_pdict() {
+  r_obj* root = KEEP(pdict_new_node(0, 0, 0));
+  r_obj* out = pdict_new_dict(root, 0);
+  FREE(1);
+  return out;
+}
+
+r_ssize r_pdict_size(r_obj* dict) {
+  return r_as_ssize(r_list_get(dict, 1));
+}
+
+// Copies `node` with `n_remove` elements at `loc` replaced by the
+// `n_insert` elements of `v_insert`
+static
+r_obj* pdict_splice(r_obj* node,
+                    uint32_t datamap,
+                    uint32_t nodemap,
+                    r_ssize loc,
+                    r_ssize n_remove,
+                    r_obj* const * v_insert,
+                    r_ssize n_insert) {
+  r_ssize n = r_length(node);
+  r_obj* out = KEEP(pdict_new_node(datamap, nodemap, n - 1 - n_remove + n_insert));
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  r_ssize j = 1;
+  for (r_ssize i = 1; i < loc; ++i) {
+    r_list_poke(out, j++, v_node[i]);
+  }
+  for (r_ssize i = 0; i < n_insert; ++i) {
+    r_list_poke(out, j++, v_insert[i]);
+  }
+  for (r_ssize i = loc + n_remove; i < n; ++i) {
+    r_list_poke(out, j++, v_node[i]);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Copies `node` with the entry at data location `data_loc` moved to
+// a child node at `node_loc`, expressed in the locations of the output
+static
+r_obj* pdict_data_to_node(r_obj* node,
+                          uint32_t datamap,
+                          uint32_t nodemap,
+                          r_ssize data_loc,
+                          r_ssize node_loc,
+                          r_obj* child) {
+  r_ssize n = r_length(node);
+  r_obj* out = KEEP(pdict_new_node(datamap, nodemap, n - 2));
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  r_ssize j = 1;
+  for (r_ssize i = 1; i < n; ++i) {
+    if (i == data_loc) {
+      ++i;
+      continue;
+    }
+    if (j == node_loc) {
+      r_list_poke(out, j++, child);
+    }
+    r_list_poke(out, j++, v_node[i]);
+  }
+  if (j == node_loc) {
+    r_list_poke(out, j++, child);
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Copies `node` with the child at `node_loc` replaced by an inline
+// entry. `node_loc` is a location of the input and `data_loc` a
+// location of the output.
+static
+r_obj* pdict_node_to_data(r_obj* node,
+                          uint32_t datamap,
+                          uint32_t nodemap,
+                          r_ssize node_loc,
+                          r_ssize data_loc,
+                          r_obj* key,
+                          r_obj* value) {
+  r_ssize n = r_length(node);
+  r_obj* out = KEEP(pdict_new_node(datamap, nodemap, n));
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  r_ssize j = 1;
+  for (r_ssize i = 1; i < n; ++i) {
+    if (j == data_loc) {
+      r_list_poke(out, j++, key);
+      r_list_poke(out, j++, value);
+    }
+    if (i == node_loc) {
+      continue;
+    }
+    r_list_poke(out, j++, v_node[i]);
+  }
+  if (j == data_loc) {
+    r_list_poke(out, j++, key);
+    r_list_poke(out, j++, value);
+  }
+
+  FREE(1);
+  return out;
+}
+
+static
+r_obj* pdict_merge(r_obj* k1, r_obj* v1, uint64_t h1,
+                   r_obj* k2, r_obj* v2, uint64_t h2,
+                   int shift) {
+  if (shift >= PDICT_HASH_BITS) {
+    r_obj* out = pdict_new_node(0, 0, 4);
+    r_list_poke(out, 1, k1);
+    r_list_poke(out, 2, v1);
+    r_list_poke(out, 3, k2);
+    r_list_poke(out, 4, v2);
+    return out;
+  }
+
+  uint32_t bit1 = pdict_bit(h1, shift);
+  uint32_t bit2 = pdict_bit(h2, shift);
+
+  if (bit1 == bit2) {
+    r_obj* child = KEEP(pdict_merge(k1, v1, h1, k2, v2, h2, shift + PDICT_BITS));
+    r_obj* out = pdict_new_node(0, bit1, 1);
+    r_list_poke(out, 1, child);
+    FREE(1);
+    return out;
+  }
+
+  r_obj* out = pdict_new_node(bit1 | bit2, 0, 4);
+  if (bit1 < bit2) {
+    r_list_poke(out, 1, k1);
+    r_list_poke(out, 2, v1);
+    r_list_poke(out, 3, k2);
+    r_list_poke(out, 4, v2);
+  } else {
+    r_list_poke(out, 1, k2);
+    r_list_poke(out, 2, v2);
+    r_list_poke(out, 3, k1);
+    r_list_poke(out, 4, v1);
+  }
+  return out;
+}
+
+static
+r_obj* pdict_collision_put(r_obj* node, r_obj* key, r_obj* value, bool* p_added) {
+  r_ssize n_data = (r_length(node) - 1) / 2;
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  for (r_ssize i = 0; i < n_data; ++i) {
+    r_ssize loc = pdict_data_loc(i);
+    if (v_node[loc] == key) {
+      if (v_node[loc + 1] == value) {
+        return node;
+      }
+      return pdict_splice(node, 0, 0, loc + 1, 1, &value, 1);
+    }
+  }
+
+  *p_added = true;
+  r_obj* pair[2] = { key, value };
+  return pdict_splice(node, 0, 0, r_length(node), 0, pair, 2);
+}
+
+static
+r_obj* pdict_node_put(r_obj* node,
+                      r_obj* key,
+                      r_obj* value,
+                      uint64_t hash,
+                      int shift,
+                      bool* p_added) {
+  if (shift >= PDICT_HASH_BITS) {
+    return pdict_collision_put(node, key, value, p_added);
+  }
+
+  uint32_t datamap = pdict_datamap(node);
+  uint32_t nodemap = pdict_nodemap(node);
+  uint32_t bit = pdict_bit(hash, shift);
+  r_ssize n_data = pdict_popcount(datamap);
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  if (datamap & bit) {
+    r_ssize loc = pdict_data_loc(pdict_index(datamap, bit));
+    r_obj* existing_key = v_node[loc];
+    r_obj* existing_value = v_node[loc + 1];
+
+    if (existing_key == key) {
+      if (existing_value == value) {
+        return node;
+      }
+      return pdict_splice(node, datamap, nodemap, loc + 1, 1, &value, 1);
+    }
+
+    // Push both entries down to a new child node
+    *p_added = true;
+    r_obj* child = KEEP(pdict_merge(existing_key, existing_value, pdict_hash(existing_key),
+                                    key, value, hash,
+                                    shift + PDICT_BITS));
+
+    uint32_t new_datamap = datamap ^ bit;
+    uint32_t new_nodemap = nodemap | bit;
+    r_ssize node_loc = pdict_node_loc(n_data - 1, pdict_index(new_nodemap, bit));
+
+    r_obj* out = pdict_data_to_node(node, new_datamap, new_nodemap, loc, node_loc, child);
+    FREE(1);
+    return out;
+  }
+
+  if (nodemap & bit) {
+    r_ssize loc = pdict_node_loc(n_data, pdict_index(nodemap, bit));
+    r_obj* child = v_node[loc];
+
+    r_obj* new_child = pdict_node_put(child, key, value, hash, shift + PDICT_BITS, p_added);
+    if (new_child == child) {
+      return node;
+    }
+
+    KEEP(new_child);
+    r_obj* out = pdict_splice(node, datamap, nodemap, loc, 1, &new_child, 1);
+    FREE(1);
+    return out;
+  }
+
+  *p_added = true;
+  uint32_t new_datamap = datamap | bit;
+  r_ssize loc = pdict_data_loc(pdict_index(new_datamap, bit));
+  r_obj* pair[2] = { key, value };
+  return pdict_splice(node, new_datamap, nodemap, loc, 0, pair, 2);
+}
+
+r_obj* r_pdict_put(r_obj* dict, r_obj* key, r_obj* value) {
+  r_obj* root = PDICT_ROOT(dict);
+
+  bool added = false;
+  r_obj* new_root = pdict_node_put(root, key, value, pdict_hash(key), 0, &added);
+
+  if (new_root == root) {
+    return dict;
+  }
+
+  KEEP(new_root);
+  r_obj* out = pdict_new_dict(new_root, r_pdict_size(dict) + added);
+  FREE(1);
+  return out;
+}
+
+// Whether `node` must be inlined in its parent
+static inline
+bool pdict_is_singleton(r_obj* node, int shift) {
+  if (shift >= PDICT_HASH_BITS) {
+    return r_length(node) == 3;
+  } else {
+    return pdict_nodemap(node) == 0 && pdict_popcount(pdict_datamap(node)) == 1;
+  }
+}
+
+static
+r_obj* pdict_node_del(r_obj* node, r_obj* key, uint64_t hash, int shift) {
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  if (shift >= PDICT_HASH_BITS) {
+    r_ssize n_data = (r_length(node) - 1) / 2;
+    for (r_ssize i = 0; i < n_data; ++i) {
+      r_ssize loc = pdict_data_loc(i);
+      if (v_node[loc] == key) {
+        return pdict_splice(node, 0, 0, loc, 2, NULL, 0);
+      }
+    }
+    return node;
+  }
+
+  uint32_t datamap = pdict_datamap(node);
+  uint32_t nodemap = pdict_nodemap(node);
+  uint32_t bit = pdict_bit(hash, shift);
+  r_ssize n_data = pdict_popcount(datamap);
+
+  if (datamap & bit) {
+    r_ssize loc = pdict_data_loc(pdict_index(datamap, bit));
+    if (v_node[loc] != key) {
+      return node;
+    }
+    return pdict_splice(node, datamap ^ bit, nodemap, loc, 2, NULL, 0);
+  }
+
+  if (nodemap & bit) {
+    r_ssize loc = pdict_node_loc(n_data, pdict_index(nodemap, bit));
+    r_obj* child = v_node[loc];
+
+    r_obj* new_child = pdict_node_del(child, key, hash, shift + PDICT_BITS);
+    if (new_child == child) {
+      return node;
+    }
+    KEEP(new_child);
+
+    r_obj* out;
+    if (pdict_is_singleton(new_child, shift + PDICT_BITS)) {
+      uint32_t new_datamap = datamap | bit;
+      uint32_t new_nodemap = nodemap ^ bit;
+
+      r_ssize data_loc = pdict_data_loc(pdict_index(new_datamap, bit));
+
+      r_obj* const * v_child = r_list_cbegin(new_child);
+      out = pdict_node_to_data(node, new_datamap, new_nodemap,
+                               loc, data_loc,
+                               v_child[1], v_child[2]);
+    } else {
+      out = pdict_splice(node, datamap, nodemap, loc, 1, &new_child, 1);
+    }
+
+    FREE(1);
+    return out;
+  }
+
+  return node;
+}
+
+r_obj* r_pdict_del(r_obj* dict, r_obj* key) {
+  r_obj* root = PDICT_ROOT(dict);
+  r_obj* new_root = pdict_node_del(root, key, pdict_hash(key), 0);
+
+  if (new_root == root) {
+    return dict;
+  }
+
+  KEEP(new_root);
+  r_obj* out = pdict_new_dict(new_root, r_pdict_size(dict) - 1);
+  FREE(1);
+  return out;
+}
+
+r_obj* r_pdict_get0(r_obj* dict, r_obj* key) {
+  r_obj* node = PDICT_ROOT(dict);
+  uint64_t hash = pdict_hash(key);
+
+  for (int shift = 0; ; shift += PDICT_BITS) {
+    r_obj* const * v_node = r_list_cbegin(node);
+
+    if (shift >= PDICT_HASH_BITS) {
+      r_ssize n_data = (r_length(node) - 1) / 2;
+      for (r_ssize i = 0; i < n_data; ++i) {
+        r_ssize loc = pdict_data_loc(i);
+        if (v_node[loc] == key) {
+          return v_node[loc + 1];
+        }
+      }
+      return NULL;
+    }
+
+    uint32_t datamap = pdict_datamap(node);
+    uint32_t bit = pdict_bit(hash, shift);
+
+    if (datamap & bit) {
+      r_ssize loc = pdict_data_loc(pdict_index(datamap, bit));
+      return v_node[loc] == key ? v_node[loc + 1] : NULL;
+    }
+
+    uint32_t nodemap = pdict_nodemap(node);
+    if (!(nodemap & bit)) {
+      return NULL;
+    }
+
+    r_ssize n_data = pdict_popcount(datamap);
+    node = v_node[pdict_node_loc(n_data, pdict_index(nodemap, bit))];
+  }
+}
+
+r_obj* r_pdict_get(r_obj* dict, r_obj* key) {
+  r_obj* out = r_pdict_get0(dict, key);
+
+  if (!out) {
+    r_abort("Can't find key in dictionary.");
+  }
+
+  return out;
+}
+
+bool r_pdict_has(r_obj* dict, r_obj* key) {
+  return r_pdict_get0(dict, key) != NULL;
+}
+
+
+static
+r_ssize pdict_node_collect(r_obj* node, int shift, r_obj* keys, r_obj* values, r_ssize i) {
+  r_ssize n_data = pdict_n_data(node, shift);
+  r_ssize n = r_length(node);
+  r_obj* const * v_node = r_list_cbegin(node);
+
+  for (r_ssize j = 0; j < n_data; ++j, ++i) {
+    r_ssize loc = pdict_data_loc(j);
+    r_list_poke(keys, i, v_node[loc]);
+    r_list_poke(values, i, v_node[loc + 1]);
+  }
+  for (r_ssize loc = pdict_node_loc(n_data, 0); loc < n; ++loc) {
+    i = pdict_node_collect(v_node[loc], shift + PDICT_BITS, keys, values, i);
+  }
+
+  return i;
+}
+
+static
+const char* v_pdict_df_names_c_strings[] = {
+  "key",
+  "value"
+};
+static
+const enum r_type v_pdict_df_types[] = {
+  R_TYPE_list,
+  R_TYPE_list
+};
+#define PDICT_DF_SIZE R_ARR_SIZEOF(v_pdict_df_types)
+
+r_obj* r_pdict_as_df_list(r_obj* dict) {
+  r_obj* nms = KEEP(r_chr_n(v_pdict_df_names_c_strings, PDICT_DF_SIZE));
+
+  r_obj* out = KEEP(r_alloc_df_list(r_pdict_size(dict),
+                                    nms,
+                                    v_pdict_df_types,
+                                    PDICT_DF_SIZE));
+
+  pdict_node_collect(PDICT_ROOT(dict),
+                     0,
+                     r_list_get(out, 0),
+                     r_list_get(out, 1),
+                     0);
+
+  FREE(2);
+  return out;
+}
@@ -0,0 +1,34 @@
+#ifndef RLANG_PDICT_H
+#define RLANG_PDICT_H
+
+/**
+ * A persistent dictionary of `r_obj*` keyed by pointer. It is
+ * implemented as a hash array mapped trie (HAMT) whose nodes are R
+ * lists that are never modified after creation.
+ *
+ * Updating functions return a new version of the dictionary and leave
+ * their input untouched. The new version shares all the nodes that
+ * were not on the path of the update, so updates allocate O(log n)
+ * memory and taking a snapshot is just keeping a reference to the
+ * current version.
+ *
+ * Like other R objects, dictionaries must be protected by the caller.
+ */
+
+r_obj* r_new_pdict();
+
+// Unlike `r_dict_put()`, the value of an existing key is replaced.
+// The input is returned as is when nothing changes.
+r_obj* r_pdict_put(r_obj* dict, r_obj* key, r_obj* value);
+r_obj* r_pdict_del(r_obj* dict, r_obj* key);
+bool r_pdict_has(r_obj* dict, r_obj* key);
+r_obj* r_pdict_get(r_obj* dict, r_obj* key);
+r_obj* r_pdict_get0(r_obj* dict, r_obj* key);
+
+r_ssize r_pdict_size(r_obj* dict);
+
+// Returns a list of `key` and `value` lists
+r_obj* r_pdict_as_df_list(r_obj* dict);
+
+
+#endif
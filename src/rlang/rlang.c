@@ -1,9 +1,11 @@
 #include <rlang.h>
 
+#include "arena.c"
 #include "attrib.c"
 #include "call.c"
 #include "cnd.c"
 #include "c-utils.c"
+#include "c-core.c"
 #include "debug.c"
 #include "dict.c"
 #include "df.c"
@@ -16,9 +18,11 @@
 #include "fn.c"
 #include "formula.c"
 #include "globals.c"
+#include "instrument.c"
 #include "node.c"
 #include "obj.c"
 #include "parse.c"
+#include "pdict.c"
 #include "quo.c"
 #include "session.c"
 #include "stack.c"
@@ -75,6 +79,53 @@ static r_obj* shared_x_env;
 static r_obj* shared_xy_env;
 static r_obj* shared_xyz_env;
 
+/*
+ * Load-time breakdown of the library and of the initialisation steps
+ * of the package, recorded with `R_INIT_TIMED()`. Times are CPU time
+ * in seconds. They are reset when the library is initialised again.
+ */
+
+#define R_INIT_TIMINGS_SIZE 64
+
+static const char* init_timings_nms[R_INIT_TIMINGS_SIZE];
+static double init_timings[R_INIT_TIMINGS_SIZE];
+static int n_init_timings = 0;
+
+void r_init_timing_push(const char* name, clock_t start) {
+  if (n_init_timings == R_INIT_TIMINGS_SIZE) {
+    return;
+  }
+  init_timings_nms[n_init_timings] = name;
+  init_timings[n_init_timings] = (double) (clock() - start) / CLOCKS_PER_SEC;
+  ++n_init_timings;
+}
+
+r_obj* r_init_timings() {
+  r_obj* out = KEEP(r_alloc_double(n_init_timings));
+  r_obj* nms = r_alloc_character(n_init_timings);
+  r_attrib_poke_names(out, nms);
+
+  double* v_out = r_dbl_begin(out);
+  for (int i = 0; i < n_init_timings; ++i) {
+    v_out[i] = init_timings[i];
+    r_chr_poke(nms, i, r_str(init_timings_nms[i]));
+  }
+
+  FREE(1);
+  return out;
+}
+
+// Same as `new.env(hash = FALSE, parent = baseenv(), size = 1L)`.
+// The call is constructed rather than parsed to save load time.
+static
+r_obj* new_shared_env() {
+  r_obj* size = KEEP(r_int(1));
+  r_obj* call = KEEP(r_call4(r_base_ns_get("new.env"), r_false, r_base_env, size));
+  r_obj* out = r_eval(call, r_base_env);
+  FREE(2);
+  return out;
+}
+
 // This *must* be called before making any calls to the functions
 // provided in the library. Register this function in your init file
 // and `.Call()` it from your `.onLoad()` hook.
@@ -85,6 +136,9 @@ r_obj* r_init_library(r_obj* ns) {
                  "x `ns` must be a namespace environment.");
   }
 
+  n_init_timings = 0;
+  clock_t start = clock();
+
   // Need to be first
   r_init_library_vendor(); // Needed for xxh used in `r_preserve()`
   r_init_library_globals_syms();
@@ -92,28 +146,25 @@ r_obj* r_init_library(r_obj* ns) {
   r_init_library_globals();
 
   r_init_rlang_ns_env();
-  r_init_library_call();
-  r_init_library_cnd();
-  r_init_library_dyn_array();
-  r_init_library_env();
-  r_init_library_fn();
-  r_init_library_session();
-  r_init_library_stack();
-
-  shared_x_env = r_parse_eval("new.env(hash = FALSE, parent = baseenv(), size = 1L)", r_base_env);
-  r_preserve(shared_x_env);
-
-  shared_xy_env = r_parse_eval("new.env(hash = FALSE, parent = baseenv(), size = 1L)", r_base_env);
-  r_preserve(shared_xy_env);
-
-  shared_xyz_env = r_parse_eval("new.env(hash = FALSE, parent = baseenv(), size = 1L)", r_base_env);
-  r_preserve(shared_xyz_env);
+  R_INIT_TIMED("r_init_library_call", r_init_library_call());
+  R_INIT_TIMED("r_init_library_cnd", r_init_library_cnd());
+  R_INIT_TIMED("r_init_library_dyn_array", r_init_library_dyn_array());
+  R_INIT_TIMED("r_init_library_env", r_init_library_env());
+  R_INIT_TIMED("r_init_library_fn", r_init_library_fn());
+  R_INIT_TIMED("r_init_library_session", r_init_library_session());
+  R_INIT_TIMED("r_init_library_stack", r_init_library_stack());
+
+  shared_x_env = r_preserve_global(new_shared_env());
+  shared_xy_env = r_preserve_global(new_shared_env());
+  shared_xyz_env = r_preserve_global(new_shared_env());
 
   r_quo_get_expr = (r_obj* (*)(r_obj*)) r_peek_c_callable("rlang", "rlang_quo_get_expr");
   r_quo_set_expr = (r_obj* (*)(r_obj*, r_obj*)) r_peek_c_callable("rlang", "rlang_quo_set_expr");
   r_quo_get_env = (r_obj* (*)(r_obj*)) r_peek_c_callable("rlang", "rlang_quo_get_env");
   r_quo_set_env = (r_obj* (*)(r_obj*, r_obj*)) r_peek_c_callable("rlang", "rlang_quo_set_env");
 
+  r_init_timing_push("r_init_library", start);
+
   // Return a SEXP so the init function can be called from R
   return r_null;
 }
@@ -25,21 +25,36 @@
 #include <Rversion.h>
 #include <inttypes.h>
 #include <stdbool.h>
+#include <time.h>
 #include "rlang-types.h"
 
 
 r_obj* r_init_library(r_obj* ns);
 
+// Records the load time of the initialisation step `NAME`. The
+// timings are returned by `r_init_timings()`.
+#define R_INIT_TIMED(NAME, EXPR) do {              \
+    clock_t r_init_start__ = clock();              \
+    EXPR;                                          \
+    r_init_timing_push(NAME, r_init_start__);      \
+  } while (0)
+
+void r_init_timing_push(const char* name, clock_t start);
+r_obj* r_init_timings();
+
 r_ssize r_as_ssize(r_obj* n);
 
 
 #include "obj.h"
 #include "globals.h"
+#include "instrument.h"
 
 #include "altrep.h"
+#include "arena.h"
 #include "attrib.h"
 #include "debug.h"
 #include "c-utils.h"
+#include "c-core.h"
 #include "call.h"
 #include "cnd.h"
 #include "dict.h"
@@ -54,6 +69,7 @@ r_ssize r_as_ssize(r_obj* n);
 #include "formula.h"
 #include "node.h"
 #include "parse.h"
+#include "pdict.h"
 #include "quo.h"
 #include "session.h"
 #include "stack.h"
@@ -65,5 +81,8 @@ r_ssize r_as_ssize(r_obj* n);
 #include "vendor.h"
 #include "walk.h"
 
+// Refers to the types declared above
+#include "api.h"
+
 
 #endif
@@ -1,4 +1,9 @@
+#ifndef RLANG_RLANG_HPP
+#define RLANG_RLANG_HPP
+
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 using std::isfinite;
 
 extern "C" {
@@ -29,3 +34,252 @@ void rcc_abort(const char* fn) {
    r_stop_internal(fn, "Caught unknown C++ exception.");
  }
 }
+
+
+namespace rlang {
+
+/**
+ * Typed view of a `struct r_dyn_array`. The element size is known at
+ * compile time, so element access and `push_back()` compile down to
+ * plain loads and stores that the compiler can vectorise.
+ *
+ * The wrapper doesn't own anything: the shelter of the underlying
+ * array must be protected by the caller as usual.
+ */
+template <typename T>
+class dyn_array {
+public:
+  // Creates a raw-backed array
+  explicit dyn_array(r_ssize capacity)
+    : p_arr_(r_new_dyn_array(sizeof(T), capacity)) { }
+
+  // Creates an atomic vector of `type`, e.g. `dyn_array<int>` of type
+  // `R_TYPE_integer`
+  dyn_array(enum r_type type, r_ssize capacity)
+    : p_arr_(r_new_dyn_vector(type, capacity)) {
+    check_elt_size();
+  }
+
+  explicit dyn_array(struct r_dyn_array* p_arr)
+    : p_arr_(p_arr) {
+    check_elt_size();
+  }
+
+  struct r_dyn_array* get() const { return p_arr_; }
+  r_obj* shelter() const { return p_arr_->shelter; }
+
+  r_ssize size() const { return p_arr_->count; }
+  r_ssize capacity() const { return p_arr_->capacity; }
+  bool empty() const { return p_arr_->count == 0; }
+
+  T* begin() { return static_cast<T*>(p_arr_->v_data); }
+  T* end() { return begin() + p_arr_->count; }
+  const T* begin() const { return static_cast<const T*>(p_arr_->v_data_const); }
+  const T* end() const { return begin() + p_arr_->count; }
+
+  T& operator[](r_ssize i) { return begin()[i]; }
+  const T& operator[](r_ssize i) const { return begin()[i]; }
+  T& back() { return begin()[p_arr_->count - 1]; }
+
+  void push_back(const T& elt) {
+    if (p_arr_->count == p_arr_->capacity) {
+      grow();
+    }
+    begin()[p_arr_->count++] = elt;
+  }
+  void pop_back() { --p_arr_->count; }
+
+  void push_back_n(const T* p_elts, r_ssize n) { r_arr_push_back_n(p_arr_, p_elts, n); }
+  void reserve(r_ssize capacity) { r_arr_reserve(p_arr_, capacity); }
+  void shrink_to_fit() { r_arr_shrink_to_fit(p_arr_); }
+  r_obj* unwrap() { return r_arr_unwrap(p_arr_); }
+
+private:
+  struct r_dyn_array* p_arr_;
+
+  void check_elt_size() {
+    if (p_arr_->barrier_set || p_arr_->elt_byte_size != (r_ssize) sizeof(T)) {
+      r_stop_internal("rlang::dyn_array", "Incompatible element type.");
+    }
+  }
+
+  // Kept out of line so the fast path of `push_back()` stays small
+  __attribute__((noinline))
+  void grow() {
+    r_ssize capacity = r_ssize_mult(p_arr_->capacity, p_arr_->growth_factor);
+    r_arr_reserve(p_arr_, r_ssize_max(capacity, p_arr_->count + 1));
+  }
+};
+
+// Lists and character vectors can't be written to through a pointer.
+// Elements are read from the const data pointer and set with the write
+// barrier.
+template <>
+class dyn_array<r_obj*> {
+public:
+  dyn_array(enum r_type type, r_ssize capacity)
+    : p_arr_(r_new_dyn_vector(type, capacity)) {
+    check_type();
+  }
+
+  explicit dyn_array(struct r_dyn_array* p_arr)
+    : p_arr_(p_arr) {
+    check_type();
+  }
+
+  struct r_dyn_array* get() const { return p_arr_; }
+  r_obj* shelter() const { return p_arr_->shelter; }
+
+  r_ssize size() const { return p_arr_->count; }
+  r_ssize capacity() const { return p_arr_->capacity; }
+  bool empty() const { return p_arr_->count == 0; }
+
+  r_obj* const * begin() const { return static_cast<r_obj* const *>(p_arr_->v_data_const); }
+  r_obj* const * end() const { return begin() + p_arr_->count; }
+
+  r_obj* operator[](r_ssize i) const { return begin()[i]; }
+  r_obj* back() const { return begin()[p_arr_->count - 1]; }
+
+  void set(r_ssize i, r_obj* elt) {
+    if (p_arr_->type == R_TYPE_list) {
+      r_list_poke(p_arr_->data, i, elt);
+    } else {
+      r_chr_poke(p_arr_->data, i, elt);
+    }
+  }
+
+  // As with `r_list_push_back()`, `elt` is protected while the array
+  // grows
+  void push_back(r_obj* elt) {
+    if (p_arr_->count == p_arr_->capacity) {
+      KEEP(elt);
+      grow();
+      FREE(1);
+    }
+    set(p_arr_->count++, elt);
+  }
+  void pop_back() { --p_arr_->count; }
+
+  void push_back_n(r_obj* const * p_elts, r_ssize n) { r_arr_push_back_n(p_arr_, p_elts, n); }
+  void reserve(r_ssize capacity) { r_arr_reserve(p_arr_, capacity); }
+  void shrink_to_fit() { r_arr_shrink_to_fit(p_arr_); }
+  r_obj* unwrap() { return r_arr_unwrap(p_arr_); }
+
+private:
+  struct r_dyn_array* p_arr_;
+
+  void check_type() {
+    if (!p_arr_->barrier_set) {
+      r_stop_internal("rlang::dyn_array", "Expected a list or character array.");
+    }
+  }
+
+  __attribute__((noinline))
+  void grow() {
+    r_ssize capacity = r_ssize_mult(p_arr_->capacity, p_arr_->growth_factor);
+    r_arr_reserve(p_arr_, r_ssize_max(capacity, p_arr_->count + 1));
+  }
+};
+
+
+/**
+ * Missing value traits of the element types of atomic vectors.
+ * Logical and integer vectors share `int` elements and their missing
+ * value. Double and complex missing values are tested on the bits of
+ * the payload, as with `R_IsNA()`, so that `NaN` is not missing and
+ * the tests compile to integer comparisons.
+ */
+template <typename T> T na();
+template <> inline int na<int>() { return r_globals.na_int; }
+template <> inline double na<double>() { return r_globals.na_dbl; }
+template <> inline r_complex_t na<r_complex_t>() {
+  r_complex_t out = { r_globals.na_dbl, r_globals.na_dbl };
+  return out;
+}
+template <> inline r_obj* na<r_obj*>() { return r_globals.na_str; }
+
+namespace detail {
+// Exponent bits all set and low word of 1954
+inline bool dbl_bits_is_na(const double* p_x) {
+  uint64_t bits;
+  memcpy(&bits, p_x, sizeof(bits));
+  return
+    (bits & 0x7FF0000000000000ULL) == 0x7FF0000000000000ULL &&
+    (bits & 0x00000000FFFFFFFFULL) == 1954;
+}
+} // namespace detail
+
+inline bool is_na(int x) { return x == r_globals.na_int; }
+inline bool is_na(double x) { return detail::dbl_bits_is_na(&x); }
+inline bool is_na(const r_complex_t& x) { return detail::dbl_bits_is_na(&x.r); }
+inline bool is_na(r_obj* x) { return x == r_globals.na_str; }
+
+/**
+ * Typed view of an atomic vector. Reads go through the const data
+ * pointer. Writes go through `set()`, which uses the write barrier
+ * for character vectors. As with `dyn_array`, the view doesn't
+ * protect `x`.
+ *
+ * Writing to a view of an ALTREP vector is only valid if its data
+ * pointer is owned by the object, so kernels that modify their input
+ * should copy ALTREP vectors first.
+ */
+template <typename T>
+class vec_view {
+public:
+  explicit vec_view(r_obj* x)
+    : x_(x),
+      v_(static_cast<const T*>(r_vec_cbegin(x))),
+      size_(r_length(x)) { }
+
+  r_obj* get() const { return x_; }
+  r_ssize size() const { return size_; }
+
+  const T* begin() const { return v_; }
+  const T* end() const { return v_ + size_; }
+  T operator[](r_ssize i) const { return v_[i]; }
+
+  void set(r_ssize i, T value) { const_cast<T*>(v_)[i] = value; }
+
+private:
+  r_obj* x_;
+  const T* v_;
+  r_ssize size_;
+};
+
+template <>
+inline void vec_view<r_obj*>::set(r_ssize i, r_obj* value) {
+  if (r_typeof(x_) == R_TYPE_list) {
+    r_list_poke(x_, i, value);
+  } else {
+    r_chr_poke(x_, i, value);
+  }
+}
+
+/**
+ * Calls `f(vec_view<T>(x))` with the element type of the atomic
+ * vector `x`, so that a kernel written once as a function object with
+ * a templated `operator()` is instantiated and inlined per type:
+ *
+ *   struct count_na {
+ *     template <typename T>
+ *     r_ssize operator()(rlang::vec_view<T> x) const { ... }
+ *   };
+ *   r_ssize n = rlang::visit_vector<r_ssize>(x, count_na());
+ */
+template <typename R, typename F>
+R visit_vector(r_obj* x, F f) {
+  switch (r_typeof(x)) {
+  case R_TYPE_logical:
+  case R_TYPE_integer: return f(vec_view<int>(x));
+  case R_TYPE_double: return f(vec_view<double>(x));
+  case R_TYPE_complex: return f(vec_view<r_complex_t>(x));
+  case R_TYPE_character: return f(vec_view<r_obj*>(x));
+  default: r_stop_unimplemented_type("rlang::visit_vector", r_typeof(x));
+  }
+}
+
+} // namespace rlang
+
+
+#endif
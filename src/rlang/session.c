@@ -2,13 +2,55 @@
 
 r_obj* eval_with_x(r_obj* call, r_obj* x);
 
+/*
+ * Session queries are called when formatting every condition. A
+ * package whose namespace is loaded is installed, which is checked
+ * with a lookup in the namespace registry. Packages that failed to
+ * load are cached until a namespace is loaded or unloaded, which is
+ * detected from the number of entries of the registry.
+ */
+
+#define SESSION_CACHE_INIT_SIZE 32
+
+static r_obj* session_cache = NULL;
+static struct r_str_dict* p_not_installed_cache = NULL;
+static r_ssize session_n_namespaces = -1;
+
+static
+void session_cache_check() {
+  r_ssize n = r_length(R_NamespaceRegistry);
+  if (n == session_n_namespaces && p_not_installed_cache) {
+    return;
+  }
+
+  p_not_installed_cache = r_new_str_dict(SESSION_CACHE_INIT_SIZE);
+  r_list_poke(session_cache, 0, p_not_installed_cache->shelter);
+  session_n_namespaces = n;
+}
+
 
 static r_obj* is_installed_call = NULL;
 
 bool r_is_installed(const char* pkg) {
-  r_obj* installed = eval_with_x(is_installed_call, KEEP(r_chr(pkg)));
+  if (r_env_has(R_NamespaceRegistry, r_sym(pkg))) {
+    return true;
+  }
+
+  session_cache_check();
+  if (r_str_dict_has_c(p_not_installed_cache, pkg, strlen(pkg))) {
+    return false;
+  }
+
+  r_obj* pkg_str = KEEP(r_chr(pkg));
+  r_obj* installed = eval_with_x(is_installed_call, pkg_str);
   bool out = *r_lgl_begin(installed);
 
+  if (!out) {
+    // Partially loaded namespaces might have changed the registry
+    session_cache_check();
+    r_str_dict_put(p_not_installed_cache, r_chr_get(pkg_str, 0), r_false);
+  }
+
   FREE(1);
   return out;
 }
@@ -16,6 +58,8 @@ bool r_is_installed(const char* pkg) {
 
 static r_obj* has_colour_call = NULL;
 
+// The result of `has_color()` is not cached because it depends on
+// options, environment variables and active sinks
 bool r_has_colour() {
   if (!r_is_installed("crayon")) {
     return false;
@@ -31,4 +75,7 @@ void r_init_library_session() {
 
   has_colour_call = r_parse("crayon::has_color()");
   r_preserve(has_colour_call);
+
+  session_cache = r_alloc_list(1);
+  r_preserve(session_cache);
 }
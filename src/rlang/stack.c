@@ -19,64 +19,90 @@ void r_on_exit(r_obj* expr, r_obj* frame) {
 
 static r_obj* current_frame_call = NULL;
 
-r_obj* r_peek_frame() {
+static
+r_obj* peek_frame_eval() {
   return r_eval(current_frame_call, r_empty_env);
 }
 
+// Returns the frame of the closure that called into C. On R >= 4.1
+// this is read from the context stack with `R_GetCurrentEnv()`
+// instead of evaluating `sys.frame(-1)`. Contexts of foreign calls
+// have the base env as calling environment, so that value means we
+// didn't get the closure frame and need to take the slow path.
+r_obj* r_peek_frame() {
+#if R_VERSION >= R_Version(4, 1, 0)
+  r_obj* frame = R_GetCurrentEnv();
+  if (frame != r_base_env) {
+    return frame;
+  }
+#endif
+  return peek_frame_eval();
+}
 
-static r_obj* sys_frame_call = NULL;
-static r_obj* sys_call_call = NULL;
 
-static int* sys_frame_n_addr = NULL;
-static int* sys_call_n_addr = NULL;
+static r_obj* sys_frame_fn = NULL;
+static r_obj* sys_call_fn = NULL;
+static r_obj* sys_function_fn = NULL;
 
-r_obj* r_sys_frame(int n, r_obj* frame) {
+// The frame number is supplied in a fresh call so that these
+// functions are reentrant, e.g. when called from a finalizer or a
+// condition handler while another lookup is in progress
+static
+r_obj* sys_eval(r_obj* fn, int n, r_obj* frame) {
   int n_kept = 0;
   if (!frame) {
     frame = r_peek_frame();
     KEEP_N(frame, &n_kept);
   }
 
-  *sys_frame_n_addr = n;
-  SEXP value = r_eval(sys_frame_call, frame);
+  r_obj* call = KEEP_N(r_call2(fn, r_int(n)), &n_kept);
+  r_obj* value = r_eval(call, frame);
 
   FREE(n_kept);
   return value;
 }
-r_obj* r_sys_call(int n, r_obj* frame) {
-  int n_kept = 0;
-  if (!frame) {
-    frame = r_peek_frame();
-    KEEP_N(frame, &n_kept);
-  }
-
-  *sys_call_n_addr = n;
-  SEXP value = r_eval(sys_call_call, frame);
 
-  FREE(n_kept);
-  return value;
+r_obj* r_sys_frame(int n, r_obj* frame) {
+  return sys_eval(sys_frame_fn, n, frame);
+}
+r_obj* r_sys_call(int n, r_obj* frame) {
+  return sys_eval(sys_call_fn, n, frame);
+}
+r_obj* r_sys_function(int n, r_obj* frame) {
+  return sys_eval(sys_function_fn, n, frame);
 }
 
 
-static r_obj* generate_sys_call(const char* name, int** n_addr) {
-  r_obj* sys_n = KEEP(r_int(0));
-  *n_addr = r_int_begin(sys_n);
-
-  r_obj* sys_args = KEEP(r_new_node(sys_n, r_null));
-  r_obj* sys_call = KEEP(r_new_call(r_base_ns_get(name), sys_args));
-  r_preserve(sys_call);
+static r_obj* sys_frames_call = NULL;
+static r_obj* sys_calls_call = NULL;
+static r_obj* sys_parents_call = NULL;
 
-  FREE(3);
-  return sys_call;
+// These return the whole stack up to and including the context of
+// `frame`, like calling `sys.frames()` etc from that frame
+r_obj* r_sys_frames(r_obj* frame) {
+  return r_eval(sys_frames_call, frame);
+}
+r_obj* r_sys_calls(r_obj* frame) {
+  return r_eval(sys_calls_call, frame);
+}
+r_obj* r_sys_parents(r_obj* frame) {
+  return r_eval(sys_parents_call, frame);
 }
 
+
 void r_init_library_stack() {
-  r_obj* current_frame_body = KEEP(r_parse_eval("as.call(list(sys.frame, -1))", r_base_env));
+  // Constructed rather than parsed to save load time
+  r_obj* current_frame_body = KEEP(r_call2(r_base_ns_get("sys.frame"), KEEP(r_dbl(-1))));
   r_obj* current_frame_fn = KEEP(r_new_function(r_null, current_frame_body, r_empty_env));
   current_frame_call = r_new_call(current_frame_fn, r_null);
   r_preserve(current_frame_call);
-  FREE(2);
+  FREE(3);
+
+  sys_frame_fn = r_base_ns_get("sys.frame");
+  sys_call_fn = r_base_ns_get("sys.call");
+  sys_function_fn = r_base_ns_get("sys.function");
 
-  sys_frame_call = generate_sys_call("sys.frame", &sys_frame_n_addr);
-  sys_call_call = generate_sys_call("sys.call", &sys_call_n_addr);
+  sys_frames_call = r_preserve_global(r_new_call(r_base_ns_get("sys.frames"), r_null));
+  sys_calls_call = r_preserve_global(r_new_call(r_base_ns_get("sys.calls"), r_null));
+  sys_parents_call = r_preserve_global(r_new_call(r_base_ns_get("sys.parents"), r_null));
 }
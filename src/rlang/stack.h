@@ -7,6 +7,10 @@ void r_on_exit(r_obj* expr, r_obj* frame);
 r_obj* r_peek_frame();
 r_obj* r_sys_frame(int n, r_obj* frame);
 r_obj* r_sys_call(int n, r_obj* frame);
+r_obj* r_sys_function(int n, r_obj* frame);
+r_obj* r_sys_frames(r_obj* frame);
+r_obj* r_sys_calls(r_obj* frame);
+r_obj* r_sys_parents(r_obj* frame);
 
 static inline
 void r_yield_interrupt() {
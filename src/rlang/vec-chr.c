@@ -2,46 +2,175 @@
 #include "rlang.h"
 
 
-r_ssize r_chr_detect_index(r_obj* chr, const char* c_string) {
-  r_ssize n = r_length(chr);
+static
+bool str_is_ascii(r_obj* str) {
+  const unsigned char* p = (const unsigned char*) CHAR(str);
+
+  for (; *p; ++p) {
+    if (*p > 127) {
+      return false;
+    }
+  }
 
-  for (r_ssize i = 0; i != n; ++i) {
-    const char* cur = CHAR(r_chr_get(chr, i));
-    if (strcmp(cur, c_string) == 0) {
+  return true;
+}
+
+static
+r_ssize chr_detect_c(r_obj* const * v_chr, r_ssize n, const char* c_string) {
+  for (r_ssize i = 0; i < n; ++i) {
+    const char* cur = CHAR(v_chr[i]);
+    if (cur[0] == c_string[0] && strcmp(cur, c_string) == 0) {
       return i;
     }
   }
 
   return -1;
 }
+
+r_ssize r_chr_detect_index(r_obj* chr, const char* c_string) {
+  return chr_detect_c(r_chr_cbegin(chr), r_length(chr), c_string);
+}
 bool r_chr_has(r_obj* chr, const char* c_string) {
   r_ssize idx = r_chr_detect_index(chr, c_string);
   return idx >= 0;
 }
 
 bool r_chr_has_any(r_obj* chr, const char** c_strings) {
+  r_obj* const * v_chr = r_chr_cbegin(chr);
   r_ssize n = r_length(chr);
 
-  for (r_ssize i = 0; i != n; ++i) {
-    const char* cur = CHAR(r_chr_get(chr, i));
-
-    while (*c_strings) {
-      if (strcmp(cur, *c_strings) == 0) {
-        return true;
-      }
-      ++c_strings;
+  for (; *c_strings; ++c_strings) {
+    if (chr_detect_c(v_chr, n, *c_strings) >= 0) {
+      return true;
     }
   }
 
   return false;
 }
 
+r_ssize r_chr_detect_str(r_obj* chr, r_obj* str) {
+  r_obj* const * v_chr = r_chr_cbegin(chr);
+  r_ssize n = r_length(chr);
+
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_chr[i] == str) {
+      return i;
+    }
+  }
+
+  if (str_is_ascii(str)) {
+    return -1;
+  }
+  return chr_detect_c(v_chr, n, CHAR(str));
+}
+
+
+static inline
+r_ssize chr_index_hash(struct r_chr_index* p_index, r_obj* str) {
+  uint64_t hash = r_xxh3_64bits(&str, sizeof(r_obj*));
+  return hash & (p_index->n_slots - 1);
+}
+
+struct r_chr_index* r_new_chr_index(r_obj* chr) {
+  if (r_typeof(chr) != R_TYPE_character) {
+    r_abort("`chr` must be a character vector");
+  }
+  r_ssize n = r_length(chr);
+
+  // Power of 2 keeping the load factor at or below one half
+  r_ssize n_slots = 2;
+  while (n_slots < n * 2) {
+    n_slots = r_ssize_mult(n_slots, 2);
+  }
+
+  r_obj* shelter = KEEP(r_alloc_list(3));
+
+  r_obj* index_raw = r_alloc_raw0(sizeof(struct r_chr_index));
+  r_list_poke(shelter, 0, index_raw);
+  struct r_chr_index* p_index = r_raw_begin(index_raw);
+
+  r_obj* slots = r_alloc_raw(r_ssize_mult(n_slots, sizeof(r_ssize)));
+  r_list_poke(shelter, 1, slots);
+  r_list_poke(shelter, 2, chr);
+
+  p_index->shelter = shelter;
+  p_index->chr = chr;
+  p_index->v_chr = r_chr_cbegin(chr);
+  p_index->v_slots = (r_ssize*) r_raw_begin(slots);
+  p_index->n_slots = n_slots;
+  p_index->has_non_ascii = false;
+
+  r_ssize* v_slots = p_index->v_slots;
+  for (r_ssize i = 0; i < n_slots; ++i) {
+    v_slots[i] = -1;
+  }
+
+  r_obj* const * v_chr = p_index->v_chr;
+  r_ssize mask = n_slots - 1;
+
+  for (r_ssize i = 0; i < n; ++i) {
+    r_obj* str = v_chr[i];
+    r_ssize j = chr_index_hash(p_index, str);
+
+    // Only the first occurrence of duplicates is recorded
+    while (v_slots[j] >= 0 && v_chr[v_slots[j]] != str) {
+      j = (j + 1) & mask;
+    }
+    if (v_slots[j] < 0) {
+      v_slots[j] = i;
+      p_index->has_non_ascii = p_index->has_non_ascii || !str_is_ascii(str);
+    }
+  }
+
+  FREE(1);
+  return p_index;
+}
+
+r_ssize r_chr_index_find(struct r_chr_index* p_index, r_obj* str) {
+  r_obj* const * v_chr = p_index->v_chr;
+  const r_ssize* v_slots = p_index->v_slots;
+  r_ssize mask = p_index->n_slots - 1;
+
+  r_ssize j = chr_index_hash(p_index, str);
+
+  // The load factor guarantees an empty slot
+  while (v_slots[j] >= 0) {
+    if (v_chr[v_slots[j]] == str) {
+      return v_slots[j];
+    }
+    j = (j + 1) & mask;
+  }
+
+  if (!p_index->has_non_ascii || str_is_ascii(str)) {
+    return -1;
+  }
+  return chr_detect_c(v_chr, r_length(p_index->chr), CHAR(str));
+}
+
+r_ssize r_chr_index_find_c(struct r_chr_index* p_index, const char* c_string) {
+  return r_chr_index_find(p_index, r_str(c_string));
+}
+
 void r_chr_fill(r_obj* chr, r_obj* value, r_ssize n) {
   for (r_ssize i = 0; i < n; ++i) {
     r_chr_poke(chr, i, value);
   }
 }
 
+void r_chr_push_back_c(struct r_dyn_array* p_arr, const char* c_string) {
+  r_chr_push_back(p_arr, r_str(c_string));
+}
+
+void r_chr_push_back_chr(struct r_dyn_array* p_arr, r_obj* chr) {
+  if (chr == r_null) {
+    return;
+  }
+  if (r_typeof(chr) != R_TYPE_character) {
+    r_abort("`chr` must be a character vector");
+  }
+  r_arr_push_back_n(p_arr, r_chr_cbegin(chr), r_length(chr));
+}
+
 static void validate_chr_setter(r_obj* chr, r_obj* r_string) {
   if (r_typeof(chr) != R_TYPE_character) {
     r_abort("`chr` must be a character vector");
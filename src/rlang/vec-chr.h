@@ -13,8 +13,66 @@ bool r_chr_has(r_obj* chr, const char* c_string);
 bool r_chr_has_any(r_obj* chr, const char** c_strings);
 r_ssize r_chr_detect_index(r_obj* chr, const char* c_string);
 
+// Variant taking a CHARSXP. Strings are compared by pointer, with a
+// `strcmp()` fallback when `str` is not ASCII.
+r_ssize r_chr_detect_str(r_obj* chr, r_obj* str);
+
+/*
+ * Membership index of a character vector for repeated queries. It is
+ * an open addressing table of the positions of the elements, hashed
+ * by CHARSXP pointer. Since CHARSXP are interned, an ASCII string is
+ * only ever found by pointer. Non-ASCII strings may have different
+ * pointers for the same bytes when their declared encodings differ,
+ * so their misses fall back to a linear `strcmp()` scan if `chr`
+ * contains non-ASCII elements.
+ *
+ * The index keeps a reference to `chr`, which must not be modified
+ * while the index is in use.
+ */
+struct r_chr_index {
+  r_obj* shelter;
+  r_obj* chr;
+
+  /* private: */
+  r_obj* const * v_chr;
+  r_ssize* v_slots;
+  r_ssize n_slots;
+  bool has_non_ascii;
+};
+
+struct r_chr_index* r_new_chr_index(r_obj* chr);
+
+// Return the position of the first occurrence or -1. The `_c`
+// variant interns `c_string` and thus may allocate.
+r_ssize r_chr_index_find(struct r_chr_index* p_index, r_obj* str);
+r_ssize r_chr_index_find_c(struct r_chr_index* p_index, const char* c_string);
+
+static inline
+bool r_chr_index_has(struct r_chr_index* p_index, r_obj* str) {
+  return r_chr_index_find(p_index, str) >= 0;
+}
+
 void r_chr_fill(r_obj* chr, r_obj* value, r_ssize n);
 
+/*
+ * Character vectors that are built piecewise should be accumulated
+ * in a dynamic array of CHARSXP, which grows geometrically so that
+ * appending in a loop is linear:
+ *
+ *   struct r_dyn_array* p_arr = r_new_dyn_vector(R_TYPE_character, 8);
+ *   KEEP(p_arr->shelter);
+ *   r_chr_push_back(p_arr, str);
+ *   r_chr_push_back_chr(p_arr, chr);
+ *   r_obj* out = r_arr_unwrap(p_arr);
+ *
+ * `chr_append()` and `chr_prepend()` copy their input and are only
+ * meant for one-off additions.
+ */
+void r_chr_push_back_c(struct r_dyn_array* p_arr, const char* c_string);
+
+// Appends all elements of `chr`, which may be `r_null`
+void r_chr_push_back_chr(struct r_dyn_array* p_arr, r_obj* chr);
+
 
 static inline
 r_obj* r_str_as_character(r_obj* x) {
@@ -1,6 +1,7 @@
 #include "rlang.h"
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 
 
 r_obj* r_chr_n(const char* const * strings, r_ssize n) {
@@ -20,7 +21,41 @@ r_obj* r_chr_n(const char* const * strings, r_ssize n) {
 #define HAS_VIRTUAL_SIZE 0
 #endif
 
-#define RESIZE(R_TYPE, C_TYPE, CONST_DEREF, DEREF)              \
+// Same as `IS_GROWABLE()` which is not part of the API. Vectors that
+// we shrink with `SETLENGTH()` record their allocated size in their
+// truelength and can grow back up to that size. Referenced vectors
+// are copied so that other references don't see the new length.
+static inline
+bool vec_can_grow_in_place(r_obj* x, r_ssize size) {
+#if HAS_VIRTUAL_SIZE
+  return
+    !ALTREP(x) &&
+    !r_is_shared(x) &&
+    (LEVELS(x) & (1 << 5)) &&
+    size <= (r_ssize) XTRUELENGTH(x);
+#else
+  return false;
+#endif
+}
+
+// Reads `n` elements of `y` starting at `from` into `p_dest`. ALTREP
+// sources are read by region so they are not materialised. Uses
+// `memmove()` because `y` may be the destination vector.
+#if R_HAS_ALTREP
+#define COPY_REGION(C_TYPE, CONST_DEREF, GET_REGION, p_dest, y, from, n) \
+  do {                                                                  \
+    if (ALTREP(y)) {                                                    \
+      GET_REGION(y, from, n, p_dest);                                   \
+    } else {                                                            \
+      memmove(p_dest, CONST_DEREF(y) + (from), (n) * sizeof(C_TYPE));   \
+    }                                                                   \
+  } while (0)
+#else
+#define COPY_REGION(C_TYPE, CONST_DEREF, GET_REGION, p_dest, y, from, n) \
+  memmove(p_dest, CONST_DEREF(y) + (from), (n) * sizeof(C_TYPE))
+#endif
+
+#define RESIZE(R_TYPE, C_TYPE, CONST_DEREF, DEREF, GET_REGION)  \
   do {                                                          \
     r_ssize x_size = r_length(x);                               \
     if (x_size == size) {                                       \
@@ -31,30 +66,48 @@ r_obj* r_chr_n(const char* const * strings, r_ssize n) {
       SET_TRUELENGTH(x, x_size);                                \
       SET_GROWABLE_BIT(x);                                      \
       return x;                                                 \
+    }                                                           \
+    if (vec_can_grow_in_place(x, size)) {                       \
+      SETLENGTH(x, size);                                       \
+      return x;                                                 \
     }                                                           \
                                                                 \
-    const C_TYPE* p_x = CONST_DEREF(x);                         \
     r_obj* out = KEEP(r_alloc_vector(R_TYPE, size));            \
     C_TYPE* p_out = DEREF(out);                                 \
                                                                 \
     r_ssize cpy_size = (size > x_size) ? x_size : size;         \
-    memcpy(p_out, p_x, cpy_size * sizeof(C_TYPE));              \
+    COPY_REGION(C_TYPE, CONST_DEREF, GET_REGION,                \
+                p_out, x, 0, cpy_size);                         \
                                                                 \
     FREE(1);                                                    \
     return out;                                                 \
   } while (0)
 
-#define RESIZE_BARRIER(R_TYPE, CONST_DEREF, SET)                \
+// The GC doesn't trace elements past the length of a vector. Slots
+// cut off by shrinking are reset so that they don't keep dangling
+// references, which would be released again when the slots are
+// overwritten after growing in place.
+#define RESIZE_BARRIER(R_TYPE, CONST_DEREF, SET, FILL)          \
   do {                                                          \
     r_ssize x_size = r_length(x);                               \
     if (x_size == size) {                                       \
       return x;                                                 \
     }                                                           \
     if (!ALTREP(x) && size < x_size && HAS_VIRTUAL_SIZE) {      \
+      for (r_ssize i = size; i < x_size; ++i) {                 \
+        SET(x, i, FILL);                                        \
+      }                                                         \
       SETLENGTH(x, size);                                       \
       SET_TRUELENGTH(x, x_size);                                \
       SET_GROWABLE_BIT(x);                                      \
       return x;                                                 \
+    }                                                           \
+    if (vec_can_grow_in_place(x, size)) {                       \
+      SETLENGTH(x, size);                                       \
+      for (r_ssize i = x_size; i < size; ++i) {                 \
+        SET(x, i, FILL);                                        \
+      }                                                         \
+      return x;                                                 \
     }                                                           \
                                                                 \
     r_obj* const * p_x = CONST_DEREF(x);                        \
@@ -72,56 +125,107 @@ r_obj* r_chr_n(const char* const * strings, r_ssize n) {
 // Compared to `Rf_xlengthgets()` this does not initialise the new
 // extended locations with `NA`
 r_obj* r_lgl_resize(r_obj* x, r_ssize size) {
-  RESIZE(R_TYPE_logical, int, r_lgl_cbegin, r_lgl_begin);
+  RESIZE(R_TYPE_logical, int, r_lgl_cbegin, r_lgl_begin, LOGICAL_GET_REGION);
 }
 r_obj* r_int_resize(r_obj* x, r_ssize size) {
-  RESIZE(R_TYPE_integer, int, r_int_cbegin, r_int_begin);
+  RESIZE(R_TYPE_integer, int, r_int_cbegin, r_int_begin, INTEGER_GET_REGION);
 }
 r_obj* r_dbl_resize(r_obj* x, r_ssize size) {
-  RESIZE(R_TYPE_double, double, r_dbl_cbegin, r_dbl_begin);
+  RESIZE(R_TYPE_double, double, r_dbl_cbegin, r_dbl_begin, REAL_GET_REGION);
 }
 r_obj* r_cpl_resize(r_obj* x, r_ssize size) {
-  RESIZE(R_TYPE_complex, r_complex_t, r_cpl_cbegin, r_cpl_begin);
+  RESIZE(R_TYPE_complex, r_complex_t, r_cpl_cbegin, r_cpl_begin, COMPLEX_GET_REGION);
 }
 r_obj* r_raw_resize(r_obj* x, r_ssize size) {
-  RESIZE(R_TYPE_raw, unsigned char, r_raw_cbegin, r_raw_begin);
+  RESIZE(R_TYPE_raw, unsigned char, r_raw_cbegin, r_raw_begin, RAW_GET_REGION);
 }
 r_obj* r_chr_resize(r_obj* x, r_ssize size) {
-  RESIZE_BARRIER(R_TYPE_character, r_chr_cbegin, r_chr_poke);
+  RESIZE_BARRIER(R_TYPE_character, r_chr_cbegin, r_chr_poke, r_globals.empty_str);
 }
 r_obj* r_list_resize(r_obj* x, r_ssize size) {
-  RESIZE_BARRIER(R_TYPE_list, r_list_cbegin, r_list_poke);
+  RESIZE_BARRIER(R_TYPE_list, r_list_cbegin, r_list_poke, r_null);
 }
 
 #undef RESIZE
 #undef RESIZE_BARRIER
 
 
+static inline
+r_ssize list_first_null(r_obj* const * v_x, r_ssize n) {
+  for (r_ssize i = 0; i < n; ++i) {
+    if (v_x[i] == r_null) {
+      return i;
+    }
+  }
+  return n;
+}
+
+// Moves the non-NULL elements after `first` to the front, starting
+// at `first`. Returns the compacted size.
+static
+r_ssize list_compact_from(r_obj* out, r_obj* const * v_x, r_ssize n, r_ssize first) {
+  r_ssize count = first;
+
+  for (r_ssize i = first + 1; i < n; ++i) {
+    r_obj* elt = v_x[i];
+    if (elt != r_null) {
+      r_list_poke(out, count, elt);
+      ++count;
+    }
+  }
+
+  return count;
+}
+
 r_obj* r_list_compact(r_obj* x) {
   r_ssize n = r_length(x);
-  r_obj* inc = KEEP(r_alloc_logical(n));
-
-  int* v_inc = r_int_begin(inc);
   r_obj* const * v_x = r_list_cbegin(x);
 
-  r_ssize new_n = 0;
-  for (r_ssize i = 0; i < n; ++i) {
-    v_inc[i] = v_x[i] != r_null;
-    new_n += v_inc[i];
+  r_ssize first = list_first_null(v_x, n);
+  bool bare = r_attrib(x) == r_null;
+
+  if (first == n && bare) {
+    return x;
+  }
+
+  r_ssize new_n = first;
+  for (r_ssize i = first + 1; i < n; ++i) {
+    new_n += v_x[i] != r_null;
   }
 
   r_obj* out = KEEP(r_alloc_list(new_n));
-  for (r_ssize i = 0, count = 0; i < n; ++i) {
-    if (v_inc[i]) {
-      r_list_poke(out, count, v_x[i]);
-      ++count;
-    }
+  for (r_ssize i = 0; i < first; ++i) {
+    r_list_poke(out, i, v_x[i]);
   }
+  list_compact_from(out, v_x, n, first);
 
-  FREE(2);
+  FREE(1);
   return out;
 }
 
+r_obj* r_list_compact_in_place(r_obj* x) {
+  if (r_is_shared(x) || r_attrib(x) != r_null || ALTREP(x)) {
+    return r_list_compact(x);
+  }
+
+  r_ssize n = r_length(x);
+  r_obj* const * v_x = r_list_cbegin(x);
+
+  r_ssize first = list_first_null(v_x, n);
+  if (first == n) {
+    return x;
+  }
+
+  r_ssize new_n = list_compact_from(x, v_x, n, first);
+
+  // Release the references held by the tail before truncating
+  for (r_ssize i = new_n; i < n; ++i) {
+    r_list_poke(x, i, r_null);
+  }
+
+  return r_list_resize(x, new_n);
+}
+
 r_obj* r_list_of_as_ptr_ssize(r_obj* xs,
                               enum r_type type,
                               struct r_pair_ptr_ssize** p_v_out) {
@@ -166,54 +270,43 @@ void r_vec_poke_n(r_obj* x, r_ssize offset,
   }
 
   switch (r_typeof(x)) {
-  case R_TYPE_logical: {
-    int* src_data = r_lgl_begin(y);
-    int* dest_data = r_lgl_begin(x);
-    for (r_ssize i = 0; i != n; ++i)
-      dest_data[i + offset] = src_data[i + from];
+  case R_TYPE_logical:
+    COPY_REGION(int, r_lgl_cbegin, LOGICAL_GET_REGION, r_lgl_begin(x) + offset, y, from, n);
     break;
-  }
-  case R_TYPE_integer: {
-    int* src_data = r_int_begin(y);
-    int* dest_data = r_int_begin(x);
-    for (r_ssize i = 0; i != n; ++i)
-      dest_data[i + offset] = src_data[i + from];
+  case R_TYPE_integer:
+    COPY_REGION(int, r_int_cbegin, INTEGER_GET_REGION, r_int_begin(x) + offset, y, from, n);
     break;
-  }
-  case R_TYPE_double: {
-    double* src_data = r_dbl_begin(y);
-    double* dest_data = r_dbl_begin(x);
-    for (r_ssize i = 0; i != n; ++i)
-      dest_data[i + offset] = src_data[i + from];
+  case R_TYPE_double:
+    COPY_REGION(double, r_dbl_cbegin, REAL_GET_REGION, r_dbl_begin(x) + offset, y, from, n);
     break;
-  }
-  case R_TYPE_complex: {
-    r_complex_t* src_data = r_cpl_begin(y);
-    r_complex_t* dest_data = r_cpl_begin(x);
-    for (r_ssize i = 0; i != n; ++i)
-      dest_data[i + offset] = src_data[i + from];
+  case R_TYPE_complex:
+    COPY_REGION(r_complex_t, r_cpl_cbegin, COMPLEX_GET_REGION, r_cpl_begin(x) + offset, y, from, n);
     break;
-  }
-  case R_TYPE_raw: {
-    unsigned char* src_data = RAW(y);
-    unsigned char* dest_data = RAW(x);
-    for (r_ssize i = 0; i != n; ++i)
-      dest_data[i + offset] = src_data[i + from];
+  case R_TYPE_raw:
+    COPY_REGION(unsigned char, r_raw_cbegin, RAW_GET_REGION, r_raw_begin(x) + offset, y, from, n);
     break;
-  }
   case R_TYPE_character: {
-    r_obj* elt;
-    for (r_ssize i = 0; i != n; ++i) {
-      elt = r_chr_get(y, i + from);
-      r_chr_poke(x, i + offset, elt);
+    // `memmove()` semantics when `x` and `y` overlap
+    if (x == y && offset > from) {
+      for (r_ssize i = n - 1; i >= 0; --i) {
+        r_chr_poke(x, i + offset, r_chr_get(y, i + from));
+      }
+    } else {
+      for (r_ssize i = 0; i != n; ++i) {
+        r_chr_poke(x, i + offset, r_chr_get(y, i + from));
+      }
     }
     break;
   }
   case R_TYPE_list: {
-    r_obj* elt;
-    for (r_ssize i = 0; i != n; ++i) {
-      elt = r_list_get(y, i + from);
-      r_list_poke(x, i + offset, elt);
+    if (x == y && offset > from) {
+      for (r_ssize i = n - 1; i >= 0; --i) {
+        r_list_poke(x, i + offset, r_list_get(y, i + from));
+      }
+    } else {
+      for (r_ssize i = 0; i != n; ++i) {
+        r_list_poke(x, i + offset, r_list_get(y, i + from));
+      }
     }
     break;
   }
@@ -226,3 +319,5 @@ void r_vec_poke_range(r_obj* x, r_ssize offset,
                       r_obj* y, r_ssize from, r_ssize to) {
   r_vec_poke_n(x, offset, y, from, to - from + 1);
 }
+
+#undef COPY_REGION
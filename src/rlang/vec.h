@@ -92,6 +92,21 @@ const void* r_vec_cbegin(r_obj* x) {
   return r_vec_cbegin0(r_typeof(x), x);
 }
 
+// For ALTREP `Dataptr` methods. The API only exposes read-only
+// pointers to character vectors and lists, so callers must go through
+// `Set_elt` to modify their elements.
+static inline
+void* r_vec_dataptr(r_obj* x) {
+  enum r_type type = r_typeof(x);
+  switch (type) {
+#if (R_VERSION >= R_Version(3, 5, 0))
+  case R_TYPE_character: return (void*) STRING_PTR_RO(x);
+#endif
+  case R_TYPE_list: return (void*) r_list_cbegin(x);
+  default: return r_vec_begin0(type, x);
+  }
+}
+
 static inline
 int r_vec_elt_sizeof0(enum r_type type) {
   switch (type) {
@@ -167,34 +182,42 @@ void r_list_poke(r_obj* x, r_ssize i, r_obj* y) {
 
 static inline
 r_obj* r_alloc_vector(enum r_type type, r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(type, n);
 }
 static inline
 r_obj* r_alloc_logical(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_logical, n);
 }
 static inline
 r_obj* r_alloc_integer(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_integer, n);
 }
 static inline
 r_obj* r_alloc_double(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_double, n);
 }
 static inline
 r_obj* r_alloc_complex(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_complex, n);
 }
 static inline
 r_obj* r_alloc_raw(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_raw, n);
 }
 static inline
 r_obj* r_alloc_character(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_character, n);
 }
 static inline
 r_obj* r_alloc_list(r_ssize n) {
+  r_instr_count_vector();
   return Rf_allocVector(R_TYPE_list, n);
 }
 
@@ -389,7 +412,17 @@ void r_int_fill_iota(r_obj* x) {
 }
 
 
+/*
+ * Remove the `NULL` elements of a list. `r_list_compact()` returns
+ * `x` as is when it is a bare list without `NULL` elements, and
+ * otherwise a new bare list.
+ *
+ * `r_list_compact_in_place()` compacts `x` in place and shrinks it
+ * when `x` is bare and unshared. Shared lists are copied. Use it on
+ * lists owned by the caller, as in `x = r_list_compact_in_place(x)`.
+ */
 r_obj* r_list_compact(r_obj* x);
+r_obj* r_list_compact_in_place(r_obj* x);
 
 r_obj* r_list_of_as_ptr_ssize(r_obj* xs,
                               enum r_type type,
@@ -398,7 +431,45 @@ r_obj* r_list_of_as_ptr_ssize(r_obj* xs,
 
 // From cpp/vec.cpp
 
+/*
+ * Kernels on integer, double and CHARSXP pointer buffers. Missing
+ * doubles are sorted last and compare equal to each other. Pointers
+ * are sorted by address, which groups identical strings but is not
+ * an alphabetical order.
+ *
+ * With `RLANG_USE_PARALLEL_ALGORITHMS` defined and a C++17 toolchain
+ * providing parallel algorithms, large sorts run with
+ * `std::execution::par_unseq`. They are serial otherwise.
+ */
+
+// Sorts in place. With `stable`, equal elements keep their relative
+// order, which matters for doubles where `NA` and `NaN` are equal.
+void r_int_sort0(int* v_data, r_ssize size, bool stable);
+void r_dbl_sort0(double* v_data, r_ssize size, bool stable);
+void r_ptr_sort0(r_obj** v_data, r_ssize size, bool stable);
+
+// Removes consecutive duplicates like `std::unique()` and returns the
+// new end of the buffer. Sort first to remove all duplicates.
 int* r_int_unique0(int* v_data, r_ssize size);
+double* r_dbl_unique0(double* v_data, r_ssize size);
+r_obj** r_ptr_unique0(r_obj** v_data, r_ssize size);
+
+// Writes the 0-based stable ordering permutation in `v_out`. `size`
+// must fit in an `int`.
+void r_int_order0(const int* v_data, r_ssize size, int* v_out);
+void r_dbl_order0(const double* v_data, r_ssize size, int* v_out);
+void r_ptr_order0(r_obj* const * v_data, r_ssize size, int* v_out);
+
+// Writes 1-based ranks in `v_out`. Ties get their minimum rank.
+void r_int_rank0(const int* v_data, r_ssize size, int* v_out);
+void r_dbl_rank0(const double* v_data, r_ssize size, int* v_out);
+void r_ptr_rank0(r_obj* const * v_data, r_ssize size, int* v_out);
+
+// Returns the position of the first element of the sorted buffer
+// that is not less than `value`, or `size`
+r_ssize r_int_lower_bound0(const int* v_data, r_ssize size, int value);
+r_ssize r_dbl_lower_bound0(const double* v_data, r_ssize size, double value);
+r_ssize r_ptr_lower_bound0(r_obj* const * v_data, r_ssize size, r_obj* value);
 
 static inline
 int* r_int_unique(r_obj* x) {
@@ -406,4 +477,17 @@ int* r_int_unique(r_obj* x) {
 }
 
 
+// From cpp/vec-na.cpp
+
+// Returns the location of the first missing value at or after `i`,
+// or the length of `x` if there is none. `x` must be a logical,
+// integer, double, complex or character vector.
+r_ssize r_vec_find_na(r_obj* x, r_ssize i);
+
+// Replaces the missing values of `x` in place, starting from the
+// missing value at `i`. `replacement` has the type of `x` and is
+// either recycled or as long as `x`.
+void r_vec_replace_na(r_obj* x, r_obj* replacement, r_ssize i);
+
+
 #endif
@@ -69,6 +69,12 @@ struct sexp_stack_info {
 
 
 struct r_sexp_iterator* r_new_sexp_iterator(r_obj* root) {
+  return r_new_sexp_iterator_opts(root, R_SEXP_IT_FLAGS_none, -1);
+}
+
+struct r_sexp_iterator* r_new_sexp_iterator_opts(r_obj* root,
+                                                 int flags,
+                                                 int max_depth) {
   r_obj* shelter = KEEP(r_alloc_list(2));
 
   r_obj* it = r_alloc_raw(sizeof(struct r_sexp_iterator));
@@ -78,34 +84,27 @@ struct r_sexp_iterator* r_new_sexp_iterator(r_obj* root) {
   struct r_dyn_array* p_stack = r_new_dyn_array(sizeof(struct sexp_stack_info), SEXP_STACK_INIT_SIZE);
   r_list_poke(shelter, 1, p_stack->shelter);
 
-  enum r_type type = r_typeof(root);
-  enum sexp_iterator_type it_type = sexp_iterator_type(type, root);
-  bool has_attrib = sexp_node_attrib(type, root) != r_null;
+  *p_it = (struct r_sexp_iterator) {
+    .shelter = shelter,
+    .p_stack = p_stack,
+    .x = r_null,
+    .parent = r_null,
+    .flags = flags,
+    .max_depth = max_depth
+  };
 
   struct sexp_stack_info root_info = {
     .x = root,
-    .type = type,
+    .type = r_typeof(root),
     .depth = -1,
     .parent = r_null,
     .rel = R_SEXP_IT_RELATION_root
   };
 
-  if (it_type == SEXP_ITERATOR_TYPE_atomic && !has_attrib) {
-    root_info.p_state = NULL;
-    root_info.dir = R_SEXP_IT_DIRECTION_leaf;
-  } else {
-    init_incoming_stack_info(&root_info, it_type, has_attrib);
-  }
-
+  // The root is always pushed, even when it is a leaf
+  init_stack_info(p_it, &root_info, 0);
   r_arr_push_back(p_stack, &root_info);
 
-  *p_it = (struct r_sexp_iterator) {
-    .shelter = shelter,
-    .p_stack = p_stack,
-    .x = r_null,
-    .parent = r_null,
-  };
-  
   FREE(1);
   return p_it;
 }
@@ -117,19 +116,35 @@ struct r_sexp_iterator* r_new_sexp_iterator(r_obj* root) {
  */
 bool r_sexp_next(struct r_sexp_iterator* p_it) {
   struct r_dyn_array* p_stack = p_it->p_stack;
-  if (!p_stack->count) {
-    return false;
-  }
+  bool preorder = p_it->flags & R_SEXP_IT_FLAGS_preorder;
+
+  struct sexp_stack_info* p_info;
 
-  struct sexp_stack_info* p_info = (struct sexp_stack_info*) r_arr_last(p_stack);
+  // Pop the nodes that shouldn't be visited. This is a loop rather
+  // than a recursive call because deep trees, like long pairlists,
+  // may have as many outgoing nodes as there are nodes.
+  while (true) {
+    if (!p_stack->count) {
+      return false;
+    }
 
-  if (p_it->skip_incoming) {
-    p_it->skip_incoming = false;
+    p_info = (struct sexp_stack_info*) r_arr_last(p_stack);
 
-    if (p_it->dir == R_SEXP_IT_DIRECTION_incoming) {
+    if (p_it->skip_incoming) {
+      p_it->skip_incoming = false;
+
+      if (p_it->dir == R_SEXP_IT_DIRECTION_incoming) {
+        r_arr_pop_back(p_stack);
+        continue;
+      }
+    }
+
+    if (preorder && p_info->dir == R_SEXP_IT_DIRECTION_outgoing) {
       r_arr_pop_back(p_stack);
-      return r_sexp_next(p_it);
+      continue;
     }
+
+    break;
   }
 
   // In the normal case, if we push an "incoming" node on the stack it
@@ -202,15 +217,8 @@ bool sexp_next_incoming(struct r_sexp_iterator* p_it,
   }
 
   child.type = r_typeof(child.x);
-  bool has_attrib = sexp_node_attrib(child.type, child.x) != r_null;
-  enum sexp_iterator_type it_type = sexp_iterator_type(child.type, child.x);
-
-  if (it_type == SEXP_ITERATOR_TYPE_atomic && !has_attrib) {
-    child.p_state = NULL;
-    child.dir = R_SEXP_IT_DIRECTION_leaf;
-  } else {
-    init_incoming_stack_info(&child, it_type, has_attrib);
 
+  if (init_stack_info(p_it, &child, child.depth)) {
     // Push incoming node on the stack so it can be visited again,
     // either to descend its children or to visit it again on the
     // outgoing trip
@@ -251,6 +259,38 @@ bool sexp_next_incoming(struct r_sexp_iterator* p_it,
 }
 
 
+// Returns `false` for leaves
+static inline
+bool init_stack_info(struct r_sexp_iterator* p_it,
+                     struct sexp_stack_info* p_info,
+                     int depth) {
+  enum r_type type = p_info->type;
+  r_obj* x = p_info->x;
+  int flags = p_it->flags;
+
+  bool leaf =
+    (p_it->max_depth >= 0 && depth >= p_it->max_depth) ||
+    (type == R_TYPE_environment && (flags & R_SEXP_IT_FLAGS_skip_env)) ||
+    (type == R_TYPE_closure && (flags & R_SEXP_IT_FLAGS_skip_closure)) ||
+    ((flags & R_SEXP_IT_FLAGS_skip_altrep) && ALTREP(x));
+
+  bool has_attrib =
+    !leaf &&
+    !(flags & R_SEXP_IT_FLAGS_skip_attrib) &&
+    sexp_node_attrib(type, x) != r_null;
+
+  enum sexp_iterator_type it_type = sexp_iterator_type(type, x);
+
+  if (leaf || (it_type == SEXP_ITERATOR_TYPE_atomic && !has_attrib)) {
+    p_info->p_state = NULL;
+    p_info->dir = R_SEXP_IT_DIRECTION_leaf;
+    return false;
+  }
+
+  init_incoming_stack_info(p_info, it_type, has_attrib);
+  return true;
+}
+
 static inline
 void init_incoming_stack_info(struct sexp_stack_info* p_info,
                               enum sexp_iterator_type it_type,
@@ -356,6 +396,50 @@ r_obj* sexp_node_tag(enum r_type type,
 }
 
 
+bool r_sexp_visit(r_obj* x,
+                  int flags,
+                  int max_depth,
+                  r_sexp_visitor fn,
+                  void* data) {
+  struct r_sexp_iterator* p_it = r_new_sexp_iterator_opts(x, flags, max_depth);
+  KEEP(p_it->shelter);
+
+  bool stopped = false;
+
+  while (r_sexp_next(p_it)) {
+    enum r_sexp_visit status = fn(p_it, data);
+
+    if (status == R_SEXP_VISIT_stop) {
+      stopped = true;
+      break;
+    }
+    if (status == R_SEXP_VISIT_skip) {
+      p_it->skip_incoming = true;
+    }
+  }
+
+  FREE(1);
+  return stopped;
+}
+
+static
+enum r_sexp_visit has_sym_visitor(struct r_sexp_iterator* p_it, void* data) {
+  if (p_it->x == (r_obj*) data) {
+    return R_SEXP_VISIT_stop;
+  } else {
+    return R_SEXP_VISIT_continue;
+  }
+}
+
+bool r_sexp_has_sym(r_obj* x, r_obj* sym, int flags) {
+  if (r_typeof(sym) != R_TYPE_symbol) {
+    r_stop_internal("r_sexp_has_sym", "`sym` must be a symbol.");
+  }
+  flags |= R_SEXP_IT_FLAGS_preorder;
+  return r_sexp_visit(x, flags, -1, &has_sym_visitor, sym);
+}
+
+
 const char* r_sexp_it_direction_as_c_string(enum r_sexp_it_direction dir) {
   switch (dir) {
   case R_SEXP_IT_DIRECTION_leaf: return "leaf";
@@ -68,6 +68,26 @@ enum r_sexp_it_raw_relation {
 };
 
 
+/**
+ * Iteration options
+ *
+ * - Preorder: Non-leaf nodes are only visited on the incoming trip.
+ * - Skip attrib: Attributes are not visited.
+ * - Skip env, skip closure: Environments and closures are visited as
+ *   leaves, i.e. their frame, enclosure, body, etc. are not visited.
+ * - Skip ALTREP: ALTREP objects are visited as leaves, without
+ *   attributes. Their elements are not visited, which would
+ *   materialise them.
+ */
+enum r_sexp_it_flags {
+  R_SEXP_IT_FLAGS_none         = 0,
+  R_SEXP_IT_FLAGS_preorder     = 1 << 0,
+  R_SEXP_IT_FLAGS_skip_attrib  = 1 << 1,
+  R_SEXP_IT_FLAGS_skip_env     = 1 << 2,
+  R_SEXP_IT_FLAGS_skip_closure = 1 << 3,
+  R_SEXP_IT_FLAGS_skip_altrep  = 1 << 4
+};
+
 struct r_sexp_iterator {
   r_obj* shelter;
   bool skip_incoming;
@@ -82,13 +102,54 @@ struct r_sexp_iterator {
 
   /* private: */
   struct r_dyn_array* p_stack;
+  int flags;
+  int max_depth;
 };
 
 struct r_sexp_iterator* r_new_sexp_iterator(r_obj* root);
 
+// `flags` is a combination of `enum r_sexp_it_flags`. Nodes at
+// `max_depth` are visited as leaves. Pass a negative depth to
+// visit the whole tree.
+struct r_sexp_iterator* r_new_sexp_iterator_opts(r_obj* root,
+                                                 int flags,
+                                                 int max_depth);
+
 bool r_sexp_next(struct r_sexp_iterator* p_it);
 bool r_sexp_skip(struct r_sexp_iterator* p_it);
 
+/**
+ * Visitor interface
+ *
+ * `r_sexp_visit()` iterates over `x` and calls `fn` with the
+ * iterator and `data` for each visited node. The visitor returns:
+ * - Continue: Keep iterating.
+ * - Skip: Don't visit the children of the current node. This only
+ *   has an effect on incoming nodes.
+ * - Stop: End the iteration.
+ *
+ * Returns `true` if the visitor stopped the iteration.
+ */
+enum r_sexp_visit {
+  R_SEXP_VISIT_continue = 0,
+  R_SEXP_VISIT_skip,
+  R_SEXP_VISIT_stop
+};
+
+typedef enum r_sexp_visit (*r_sexp_visitor)(struct r_sexp_iterator* p_it,
+                                            void* data);
+
+bool r_sexp_visit(r_obj* x,
+                  int flags,
+                  int max_depth,
+                  r_sexp_visitor fn,
+                  void* data);
+
+// Whether `x` refers to the symbol `sym`. Stops at the first match.
+// Pass `R_SEXP_IT_FLAGS_skip_env` to avoid searching the environments
+// of closures, formulas, etc.
+bool r_sexp_has_sym(r_obj* x, r_obj* sym, int flags);
+
 
 static inline
 enum r_sexp_it_raw_relation r_sexp_it_raw_relation(enum r_sexp_it_relation rel) {